@@ -36,6 +36,21 @@ if (FFTW_FOUND)
     endif ()
     set (LIBS ${LIBS} ${FFTW_LIBRARIES})
 
+    if (FFTW_USE_THREADS)
+        if (FFTW_USE_FLOAT)
+            set (_FFTW_THREADS_LIB ${FFTW_FLOAT_THREADS_LIB})
+        else ()
+            set (_FFTW_THREADS_LIB ${FFTW_DOUBLE_THREADS_LIB})
+        endif ()
+        if (_FFTW_THREADS_LIB)
+            message (STATUS "FFTW3 threads found.")
+            set (LIBS ${LIBS} ${_FFTW_THREADS_LIB})
+            add_compile_definitions (WITH_FFTW_THREADS)
+        else ()
+            message (WARNING "FFTW3 threads NOT found.")
+        endif ()
+    endif ()
+
 else ()
     message (FATAL_ERROR "FFTW3 not found! This will fail.")
 endif ()
@@ -0,0 +1,182 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// integration of rigid body motion over time
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "body_integrator.h"
+
+#include "error.h"
+
+#include <cmath>
+
+auto body_integrator::angular_velocity(const state& s) const -> vector3
+{
+    // w = I^-1 * L = R * I_k^-1 * R^-1 * L
+    return s.orientation.rotate(
+        inertia_tensor_inv * s.orientation.conj().rotate(s.angular_momentum));
+}
+
+auto body_integrator::advance(
+    const state& s,
+    double delta_time,
+    const vector3& v,
+    const vector3& w,
+    const vector3& force,
+    const vector3& torque) -> state
+{
+    state result = s;
+    result.position += v * delta_time;
+    const vector3 w2 = w * delta_time;
+    const double w2l = w2.length();
+    if (w2l > 1e-8)
+    {
+        // avoid too small numbers
+        result.orientation =
+            quaternion::rot_rad(w2l, w2 * (1.0 / w2l)) * s.orientation;
+        // renormalize, to avoid that orientation isn't a valid rotation
+        // after many changes.
+        if (fabs(result.orientation.square_length() - 1.0) > 1e-8)
+        {
+            result.orientation.normalize();
+        }
+    }
+    result.linear_momentum += force * delta_time;
+    result.angular_momentum += torque * delta_time;
+    return result;
+}
+
+auto body_integrator::step(
+    method m,
+    const state& s,
+    double delta_time,
+    const force_function& compute_force) const -> state
+{
+    vector3 force, torque;
+    compute_force(s, force, torque);
+    switch (m)
+    {
+        case euler:
+            return advance(
+                s,
+                delta_time,
+                s.linear_momentum * mass_inv,
+                angular_velocity(s),
+                force,
+                torque);
+        case symplectic_euler:
+        {
+            // update momenta first and move with the new ones
+            state result = s;
+            result.linear_momentum += force * delta_time;
+            result.angular_momentum += torque * delta_time;
+            return advance(
+                result,
+                delta_time,
+                result.linear_momentum * mass_inv,
+                angular_velocity(result),
+                vector3(),
+                vector3());
+        }
+        case rk4:
+        {
+            const double h = delta_time * 0.5;
+            // derivatives at start
+            const vector3 v1 = s.linear_momentum * mass_inv;
+            const vector3 w1 = angular_velocity(s);
+            const vector3 f1 = force, t1 = torque;
+            // at half step with first derivatives
+            const state s2 = advance(s, h, v1, w1, f1, t1);
+            vector3 f2, t2;
+            compute_force(s2, f2, t2);
+            const vector3 v2 = s2.linear_momentum * mass_inv;
+            const vector3 w2 = angular_velocity(s2);
+            // at half step with second derivatives
+            const state s3 = advance(s, h, v2, w2, f2, t2);
+            vector3 f3, t3;
+            compute_force(s3, f3, t3);
+            const vector3 v3 = s3.linear_momentum * mass_inv;
+            const vector3 w3 = angular_velocity(s3);
+            // at full step with third derivatives
+            const state s4 = advance(s, delta_time, v3, w3, f3, t3);
+            vector3 f4, t4;
+            compute_force(s4, f4, t4);
+            const vector3 v4 = s4.linear_momentum * mass_inv;
+            const vector3 w4 = angular_velocity(s4);
+            // weighted sum of all derivatives
+            const double k = 1.0 / 6.0;
+            return advance(
+                s,
+                delta_time,
+                (v1 + (v2 + v3) * 2.0 + v4) * k,
+                (w1 + (w2 + w3) * 2.0 + w4) * k,
+                (f1 + (f2 + f3) * 2.0 + f4) * k,
+                (t1 + (t2 + t3) * 2.0 + t4) * k);
+        }
+    }
+    return s;
+}
+
+auto body_integrator::method_from_name(const std::string& name) -> method
+{
+    if (name == "euler")
+    {
+        return euler;
+    }
+    if (name == "symplectic_euler")
+    {
+        return symplectic_euler;
+    }
+    if (name == "rk4")
+    {
+        return rk4;
+    }
+    THROW(error, std::string("unknown integration method: ") + name);
+}
+
+auto body_integrator::name_of_method(method m) -> const char*
+{
+    switch (m)
+    {
+        case euler:
+            return "euler";
+        case symplectic_euler:
+            return "symplectic_euler";
+        case rk4:
+            return "rk4";
+    }
+    return "unknown";
+}
+
+auto body_integrator::max_step_time(method m) -> double
+{
+    // measured with integratortest. Euler needs 20Hz, symplectic Euler is
+    // stable with 10Hz and then still much more accurate than euler for
+    // torpedoes, rk4 with 2Hz is more accurate than both with 20Hz.
+    switch (m)
+    {
+        case euler:
+            return 1.0 / 20.0;
+        case symplectic_euler:
+            return 1.0 / 10.0;
+        case rk4:
+            return 1.0 / 2.0;
+    }
+    return 1.0 / 20.0;
+}
@@ -0,0 +1,102 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// integration of rigid body motion over time
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "matrix3.h"
+#include "quaternion.h"
+#include "vector3.h"
+
+#include <functional>
+#include <string>
+
+///\brief Integrates the state of a rigid body with a selectable method.
+/** The state is given in world space. Forces and torques are computed by a
+    callback for any state, so higher order methods can sample them in
+    between. All methods use the orientation convention of
+    sea_object::simulate: the orientation is rotated by rot_rad(|w*dt|).
+    - euler: explicit Euler, the original method. Needs small steps.
+    - symplectic_euler: momenta first, then position/orientation with the
+      new momenta. Same cost as euler, but much more accurate for stiff
+      bodies like torpedoes and stable with larger steps.
+    - rk4: classic Runge-Kutta of fourth order, four force evaluations per
+      step, very accurate with large steps.
+*/
+class body_integrator
+{
+  public:
+    enum method
+    {
+        euler,
+        symplectic_euler,
+        rk4
+    };
+
+    /// state of a rigid body that changes over time
+    struct state
+    {
+        vector3 position;
+        quaternion orientation;
+        vector3 linear_momentum;
+        vector3 angular_momentum;
+    };
+
+    /// computes world space force and torque for a state
+    using force_function =
+        std::function<void(const state& s, vector3& force, vector3& torque)>;
+
+    /// create integrator for a body with given mass and local inertia tensor
+    body_integrator(double mass_inv_, const matrix3& inertia_tensor_inv_) :
+        mass_inv(mass_inv_), inertia_tensor_inv(inertia_tensor_inv_)
+    {
+    }
+
+    /// compute state after delta_time
+    [[nodiscard]] state step(
+        method m,
+        const state& s,
+        double delta_time,
+        const force_function& compute_force) const;
+
+    /// get world space angular velocity of state
+    [[nodiscard]] vector3 angular_velocity(const state& s) const;
+
+    /// get method by name, throws error for unknown names
+    static method method_from_name(const std::string& name);
+    /// get name of method
+    static const char* name_of_method(method m);
+    /// get largest time step the game uses with a method, see integratortest
+    static double max_step_time(method m);
+
+  protected:
+    double mass_inv;
+    matrix3 inertia_tensor_inv;
+
+    /// move state along given derivatives
+    [[nodiscard]] static state advance(
+        const state& s,
+        double delta_time,
+        const vector3& v,
+        const vector3& w,
+        const vector3& force,
+        const vector3& torque);
+};
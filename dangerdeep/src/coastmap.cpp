@@ -1368,8 +1368,7 @@ coastmap::coastmap(const string& filename)
     add_loading_screen("image transformed");
 
     // here spin off work to other thread
-    myworker.reset(new worker(*this));
-    myworker->start();
+    construction.run([this]() { construction_threaded(); });
 }
 
 coastmap::~coastmap()
@@ -1430,8 +1429,8 @@ void coastmap::construction_threaded()
 
 void coastmap::finish_construction()
 {
-    // lets the worker finish its work, then clears worker-ptr
-    myworker.reset();
+    // lets the task finish its work, throws its errors
+    construction.wait();
     add_loading_screen("coastmap created");
 }
 
@@ -23,8 +23,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "bspline.h"
+#include "task_scheduler.h"
 #include "texture.h"
-#include "thread.h"
 #include "vector2.h"
 #include "vector3.h"
 
@@ -179,20 +179,9 @@ class coastmap
     void process_coastline(int x, int y);
     void process_segment(int x, int y);
 
-    class worker : public ::thread
-    {
-        coastmap& cm;
-
-      public:
-        worker(coastmap& c) : thread("coastmap"), cm(c) { }
-        void loop() override
-        {
-            cm.construction_threaded();
-            request_abort();
-        }
-    };
-
-    ::thread::ptr<worker> myworker;
+    /// runs construction_threaded, declared after the data, so it is
+    /// destroyed (and waited for) first
+    task_group construction;
     void construction_threaded();
 
   public:
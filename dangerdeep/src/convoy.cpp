@@ -159,9 +159,7 @@ convoy::convoy(game& gm_, convoy::types type_, convoy::esctypes esct_) :
                 // hardcode them!!! each ship in data/ships stores its type. but
                 // probability can not be stored...
                 string shiptype = get_random_ship(civilships, gm);
-                xml_doc doc(data_file().get_filename(shiptype));
-                doc.load();
-                ship s(gm, doc.first_child());
+                ship s(gm, data_file().get_spec(shiptype));
                 s.set_random_skin_name(gm.get_date());
                 vector2 pos = vector2(
                     dx * intershipdist + gm.randomf() * 60.0 - 30.0,
@@ -212,9 +210,7 @@ convoy::convoy(game& gm_, convoy::types type_, convoy::esctypes esct_) :
             ny *= (int(nrescs / 4) - 1) * interescortdist
                   - int(i / 4) * interescortdist;
             string shiptype = get_random_ship(escortships, gm);
-            xml_doc doc(data_file().get_filename(shiptype));
-            doc.load();
-            ship s(gm, doc.first_child());
+            ship s(gm, data_file().get_spec(shiptype));
             s.set_random_skin_name(gm.get_date());
             vector2 pos = vector2(
                 dx + nx + gm.randomf() * 100.0 - 50.0,
@@ -122,3 +122,17 @@ auto data_file_handler::get_filename(const std::string& objectid) const
 {
     return get_data_dir() + get_rel_filename(objectid);
 }
+
+auto data_file_handler::get_document(const std::string& relfilename) const
+    -> xml_doc&
+{
+    std::lock_guard<std::mutex> lock(documents_mutex);
+    auto& doc = documents[relfilename];
+    if (!doc)
+    {
+        auto newdoc = std::make_unique<xml_doc>(get_data_dir() + relfilename);
+        newdoc->load();
+        doc = std::move(newdoc);
+    }
+    return *doc;
+}
@@ -23,9 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "singleton.h"
+#include "xml.h"
 
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 const std::string& get_data_dir();
@@ -105,6 +108,8 @@ class data_file_handler : public singleton<class data_file_handler>
     std::list<std::string> submarine_ids;
     std::list<std::string> torpedo_ids;
     std::list<std::string> prop_ids;
+    mutable std::mutex documents_mutex;
+    mutable std::map<std::string, std::unique_ptr<xml_doc>> documents;
 
   public:
     /// returns path to specfile for id "objectid", path is relative to data_dir
@@ -122,6 +127,17 @@ class data_file_handler : public singleton<class data_file_handler>
     /// returns path + filename to specfile for id "objectid", path is absolute
     [[nodiscard]] std::string get_filename(const std::string& objectid) const;
 
+    /// returns parsed data file, filename relative to data_dir. Every file is
+    /// read and parsed only once, so the document must not be modified.
+    xml_doc& get_document(const std::string& relfilename) const;
+
+    /// returns root element of the parsed specfile for id "objectid". Use it
+    /// to create objects of that type without reading the file again.
+    [[nodiscard]] xml_elem get_spec(const std::string& objectid) const
+    {
+        return get_document(get_rel_filename(objectid)).first_child();
+    }
+
     [[nodiscard]] const std::list<std::string>& get_airplane_list() const
     {
         return airplane_ids;
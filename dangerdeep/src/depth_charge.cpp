@@ -68,6 +68,8 @@ void depth_charge::simulate(double delta_time, game& gm)
 
     if (position.z < -explosion_depth)
     {
+        // a long step may have moved it deeper than the set depth
+        position.z = -explosion_depth;
         gm.dc_explosion(*this);
         kill(); // dc is "dead"
     }
@@ -0,0 +1,308 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// Cache and background loader for user display images
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "display_asset_cache.h"
+
+#include "error.h"
+#include "filehelper.h"
+#include "log.h"
+
+#include <SDL.h>
+
+unsigned display_asset_cache::budget_mb = 192;
+
+namespace
+{
+/// check that the files of an image exist, see sdl_image for the special
+/// extension combining two files
+bool image_files_exist(const std::string& filename)
+{
+    const std::string combined = ".jpg|png";
+    if (filename.size() > combined.size()
+        && filename.compare(
+               filename.size() - combined.size(), combined.size(), combined)
+               == 0)
+    {
+        const std::string base =
+            filename.substr(0, filename.size() - combined.size());
+        return is_file(base + ".jpg") && is_file(base + ".png");
+    }
+    return is_file(filename);
+}
+} // namespace
+
+display_asset_cache::display_asset_cache()
+{
+    worker.reset(new decoder(*this));
+    worker->start();
+}
+
+display_asset_cache::~display_asset_cache()
+{
+    // stop worker before textures and images are freed
+    worker.reset();
+}
+
+void display_asset_cache::decoder::loop()
+{
+    std::string filename;
+    {
+        std::unique_lock<std::mutex> ml(cache.mtx);
+        cache.work_cond.wait(ml, [this]() {
+            return !cache.urgent_queue.empty() || !cache.prefetch_queue.empty()
+                   || abort_requested();
+        });
+        if (abort_requested())
+        {
+            return;
+        }
+        const bool urgent = !cache.urgent_queue.empty();
+        auto& queue       = urgent ? cache.urgent_queue : cache.prefetch_queue;
+        filename          = queue.front();
+        queue.pop_front();
+        auto it = cache.entries.find(filename);
+        if (it == cache.entries.end() || it->second.st != load_state::queued)
+        {
+            return; // already handled by an earlier request
+        }
+        if (!it->second.urgent
+            && cache.memory_used >= size_t(budget_mb) << 20)
+        {
+            // no room for speculative loading, forget request
+            cache.entries.erase(it);
+            return;
+        }
+        it->second.st = load_state::decoding;
+    }
+    // decode without holding the lock, main thread must not wait for us
+    std::unique_ptr<sdl_image> image;
+    try
+    {
+        image = std::make_unique<sdl_image>(filename);
+    }
+    catch (std::exception& e)
+    {
+        log_warning("Could not load display image: " << e.what());
+    }
+    std::unique_lock<std::mutex> ml(cache.mtx);
+    auto& e = cache.entries[filename];
+    if (image)
+    {
+        e.bytes = size_t(image->get_SDL_Surface()->pitch) * image->get_height();
+        cache.memory_used += e.bytes;
+        e.image = std::move(image);
+        e.st    = load_state::decoded;
+    }
+    else
+    {
+        e.st = load_state::failed;
+    }
+    cache.done_cond.notify_all();
+}
+
+void display_asset_cache::decoder::request_abort()
+{
+    std::unique_lock<std::mutex> ml(cache.mtx);
+    ::thread::request_abort();
+    cache.work_cond.notify_all();
+}
+
+auto display_asset_cache::touch(const std::string& filename) -> entry&
+{
+    auto& e    = entries[filename];
+    e.last_use = ++use_counter;
+    return e;
+}
+
+void display_asset_cache::upload(
+    std::unique_lock<std::mutex>& ml,
+    const std::string& filename)
+{
+    // Only the main thread handles decoded entries, so the entry stays valid
+    // while the lock is released for the texture creation.
+    auto& e    = entries[filename];
+    auto image = std::move(e.image);
+    ml.unlock();
+    std::shared_ptr<texture> tex;
+    try
+    {
+        tex = std::make_shared<texture>(
+            *image,
+            0,
+            0,
+            image->get_width(),
+            image->get_height(),
+            texture::LINEAR);
+    }
+    catch (...)
+    {
+        ml.lock();
+        memory_used -= e.bytes;
+        entries.erase(filename);
+        throw;
+    }
+    image.reset();
+    ml.lock();
+    memory_used -= e.bytes;
+    e.bytes =
+        size_t(tex->get_gl_width()) * tex->get_gl_height() * tex->get_bpp();
+    memory_used += e.bytes;
+    e.tex = std::move(tex);
+    e.st  = load_state::uploaded;
+}
+
+void display_asset_cache::prefetch(const std::vector<std::string>& filenames)
+{
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        for (const auto& fn : filenames)
+        {
+            if (fn.empty())
+            {
+                continue;
+            }
+            const bool known = entries.count(fn) > 0;
+            touch(fn);
+            if (!known)
+            {
+                prefetch_queue.push_back(fn);
+            }
+        }
+        work_cond.notify_one();
+    }
+    make_room();
+}
+
+auto display_asset_cache::try_get(const std::string& filename)
+    -> std::shared_ptr<texture>
+{
+    std::shared_ptr<texture> result;
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        // Check files of images requested first or only prefetched so far,
+        // so the caller gets the error now and not later by the worker.
+        auto it = entries.find(filename);
+        if ((it == entries.end()
+             || (it->second.st == load_state::queued && !it->second.urgent))
+            && !image_files_exist(filename))
+        {
+            if (it != entries.end())
+            {
+                entries.erase(it);
+            }
+            THROW(file_read_error, filename);
+        }
+        auto& e = touch(filename);
+        switch (e.st)
+        {
+            case load_state::queued:
+                // move to front, even when it was queued for prefetching
+                if (!e.urgent)
+                {
+                    e.urgent = true;
+                    urgent_queue.push_back(filename);
+                    work_cond.notify_one();
+                }
+                break;
+            case load_state::decoding:
+                e.urgent = true;
+                break;
+            case load_state::decoded:
+                upload(ml, filename);
+                result = e.tex;
+                break;
+            case load_state::uploaded:
+                result = e.tex;
+                break;
+            case load_state::failed:
+                entries.erase(filename); // allow retry
+                THROW(file_read_error, filename);
+        }
+    }
+    if (result)
+    {
+        make_room();
+    }
+    return result;
+}
+
+auto display_asset_cache::get(const std::string& filename)
+    -> std::shared_ptr<texture>
+{
+    auto result = try_get(filename);
+    while (!result)
+    {
+        {
+            std::unique_lock<std::mutex> ml(mtx);
+            done_cond.wait(ml, [this, &filename]() {
+                auto it = entries.find(filename);
+                return it == entries.end()
+                       || it->second.st == load_state::decoded
+                       || it->second.st == load_state::failed;
+            });
+        }
+        result = try_get(filename);
+    }
+    return result;
+}
+
+auto display_asset_cache::get_memory_used() const -> size_t
+{
+    std::unique_lock<std::mutex> ml(mtx);
+    return memory_used;
+}
+
+void display_asset_cache::make_room()
+{
+    // textures must be freed by the main thread, so do it here and not in
+    // the worker.
+    std::vector<std::shared_ptr<texture>> unused;
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        const size_t budget = size_t(budget_mb) << 20;
+        while (memory_used > budget)
+        {
+            auto lru = entries.end();
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+            {
+                const auto& e = it->second;
+                const bool freeable =
+                    (e.st == load_state::uploaded && e.tex.use_count() == 1)
+                    || (e.st == load_state::decoded && !e.urgent);
+                if (freeable
+                    && (lru == entries.end()
+                        || e.last_use < lru->second.last_use))
+                {
+                    lru = it;
+                }
+            }
+            if (lru == entries.end())
+            {
+                break; // everything is in use
+            }
+            memory_used -= lru->second.bytes;
+            unused.push_back(std::move(lru->second.tex));
+            entries.erase(lru);
+        }
+    }
+    // unused textures are deleted here, without holding the lock
+}
@@ -0,0 +1,119 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// Cache and background loader for user display images
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "singleton.h"
+#include "texture.h"
+#include "thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///\brief Loads images of user displays in background and caches textures.
+/** Images are decoded by a worker thread, textures are created from them by
+    the main thread when they are requested. Textures stay in the cache after
+    a display has been left, until the memory budget is exceeded, then the
+    least recently used ones that are not in use are freed.
+    All functions except the worker are meant to be called by the main
+    (OpenGL) thread.
+*/
+class display_asset_cache : public singleton<class display_asset_cache>
+{
+    friend class singleton<display_asset_cache>;
+
+  public:
+    /// memory budget for decoded images and textures in MB
+    static unsigned budget_mb;
+
+    /// queue images for background decoding, if there is room in the budget
+    void prefetch(const std::vector<std::string>& filenames);
+
+    /// get texture of image if it is ready, otherwise request it with high
+    /// priority and return an empty pointer. Throws file_read_error if the
+    /// image file does not exist or could not be decoded.
+    std::shared_ptr<texture> try_get(const std::string& filename);
+
+    /// get texture of image, wait for decoding if it is not ready yet
+    std::shared_ptr<texture> get(const std::string& filename);
+
+    /// get memory currently used by decoded images and textures in bytes
+    [[nodiscard]] size_t get_memory_used() const;
+
+    ~display_asset_cache();
+
+  protected:
+    display_asset_cache();
+
+    enum class load_state
+    {
+        queued,   ///< waiting for decoding
+        decoding, ///< worker is decoding it
+        decoded,  ///< image is ready, but no texture
+        uploaded, ///< texture is ready
+        failed    ///< image could not be loaded
+    };
+
+    struct entry
+    {
+        load_state st{load_state::queued};
+        bool urgent{false}; ///< requested by a display currently shown
+        std::unique_ptr<sdl_image> image;
+        std::shared_ptr<texture> tex;
+        size_t bytes{0};       ///< memory used by image or texture
+        unsigned last_use{0};  ///< use counter value of last request
+    };
+
+    std::unordered_map<std::string, entry> entries;
+    std::deque<std::string> urgent_queue;   ///< decoded first
+    std::deque<std::string> prefetch_queue; ///< decoded when idle
+    size_t memory_used{0};
+    unsigned use_counter{0};
+    mutable std::mutex mtx;
+    std::condition_variable work_cond; ///< signals new work to the worker
+    std::condition_variable done_cond; ///< signals decoded images
+
+    class decoder : public ::thread
+    {
+        display_asset_cache& cache;
+
+      public:
+        decoder(display_asset_cache& c) : thread("dispassets"), cache(c) { }
+        void loop() override;
+        void request_abort() override;
+    };
+
+    /// get entry and mark it as used, call with mtx locked
+    entry& touch(const std::string& filename);
+    /// create texture for decoded entry, call with mtx locked
+    void upload(std::unique_lock<std::mutex>& ml, const std::string& filename);
+    /// free least recently used data until budget is met
+    void make_room();
+
+    // declared last, so the worker is stopped before its data is destroyed
+    ::thread::ptr<decoder> worker;
+};
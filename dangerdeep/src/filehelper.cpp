@@ -150,8 +150,89 @@ bool is_directory(const std::string& filename)
     return ((err & FILE_ATTRIBUTE_DIRECTORY) != 0);
 }
 
+int64_t get_file_time(const std::string& filename)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+#ifdef UNICODE
+    BOOL ok = GetFileAttributesEx(
+        convertUTF8toUTF16(filename).c_str(), GetFileExInfoStandard, &data);
+#else
+    BOOL ok =
+        GetFileAttributesEx(filename.c_str(), GetFileExInfoStandard, &data);
+#endif
+    if (ok != TRUE)
+        return 0;
+    return (int64_t(data.ftLastWriteTime.dwHighDateTime) << 32)
+           | data.ftLastWriteTime.dwLowDateTime;
+}
+
+int64_t get_file_size(const std::string& filename)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+#ifdef UNICODE
+    BOOL ok = GetFileAttributesEx(
+        convertUTF8toUTF16(filename).c_str(), GetFileExInfoStandard, &data);
+#else
+    BOOL ok =
+        GetFileAttributesEx(filename.c_str(), GetFileExInfoStandard, &data);
+#endif
+    if (ok != TRUE)
+        return -1;
+    return (int64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+}
+
+mapped_file::mapped_file(const std::string& filename)
+{
+#ifdef UNICODE
+    const std::wstring name = convertUTF8toUTF16(filename);
+#else
+    const std::string& name = filename;
+#endif
+    file = CreateFile(
+        name.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    LARGE_INTEGER filesize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &filesize))
+    {
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        THROW(file_read_error, filename);
+    }
+    length = std::size_t(filesize.QuadPart);
+    // empty files can't be mapped
+    if (length == 0)
+        return;
+    mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        ptr = static_cast<const char*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!ptr)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        THROW(file_read_error, filename);
+    }
+}
+
+mapped_file::~mapped_file()
+{
+    if (ptr)
+        UnmapViewOfFile(ptr);
+    if (mapping)
+        CloseHandle(mapping);
+    CloseHandle(file);
+}
+
 #else /* Win32 */
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -226,6 +307,68 @@ auto is_directory(const std::string& filename) -> bool
     return false;
 }
 
+auto get_file_time(const std::string& filename) -> int64_t
+{
+    struct stat fileinfo;
+    if (stat(filename.c_str(), &fileinfo) != 0)
+    {
+        return 0;
+    }
+    // with nanoseconds, a file can be changed more than once per second
+#ifdef __APPLE__
+    const struct timespec& t = fileinfo.st_mtimespec;
+#else
+    const struct timespec& t = fileinfo.st_mtim;
+#endif
+    return int64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+auto get_file_size(const std::string& filename) -> int64_t
+{
+    struct stat fileinfo;
+    if (stat(filename.c_str(), &fileinfo) != 0)
+    {
+        return -1;
+    }
+    return int64_t(fileinfo.st_size);
+}
+
+mapped_file::mapped_file(const std::string& filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    struct stat fileinfo;
+    if (fd < 0 || fstat(fd, &fileinfo) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        THROW(file_read_error, filename);
+    }
+    length = std::size_t(fileinfo.st_size);
+    // empty files can't be mapped
+    if (length > 0)
+    {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            THROW(file_read_error, filename);
+        }
+        ptr = static_cast<const char*>(p);
+    }
+    // the mapping stays valid without the file descriptor
+    close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if (ptr)
+    {
+        munmap(const_cast<char*>(ptr), length);
+    }
+}
+
 #endif /* Win32 */
 
 auto is_file(const std::string& filename) -> bool
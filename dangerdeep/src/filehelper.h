@@ -31,6 +31,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <dirent.h>
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -69,6 +71,35 @@ class directory
 #endif
 };
 
+///\brief A file mapped read-only into memory.
+/** Pages are only read when accessed, so this is the fastest way to read
+    a whole file that is parsed once.
+*/
+class mapped_file
+{
+    mapped_file()                   = delete;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+  public:
+    /// Map file, throws file_read_error if that fails.
+    mapped_file(const std::string& filename);
+
+    /// Unmap file
+    ~mapped_file();
+
+    [[nodiscard]] const char* data() const { return ptr; }
+    [[nodiscard]] std::size_t size() const { return length; }
+
+  private:
+    const char* ptr{nullptr};
+    std::size_t length{0};
+#ifdef WIN32
+    HANDLE file{INVALID_HANDLE_VALUE};
+    HANDLE mapping{nullptr};
+#endif
+};
+
 // file helper interface
 
 ///\brief Make new directory. Returns true on success.
@@ -82,3 +113,11 @@ bool is_directory(const std::string& filename);
 
 ///\brief Test if the given filename is a file (can be read by fopen())
 bool is_file(const std::string& filename);
+
+///\brief Get time of last modification of a file, 0 if it does not exist.
+///@note The unit depends on the system, use it only for comparisons. It is
+/// as fine as the file system stores it, e.g. nanoseconds.
+int64_t get_file_time(const std::string& filename);
+
+///\brief Get size of a file in bytes, -1 if it does not exist.
+int64_t get_file_size(const std::string& filename);
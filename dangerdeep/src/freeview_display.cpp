@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "freeview_display.h"
 
 #include "airplane.h"
+#include "constant.h"
 #include "depth_charge.h"
 #include "frustum.h"
 #include "game.h"
@@ -273,6 +274,11 @@ void freeview_display::draw_objects(
 
     sea_object* player = gm.get_player();
 
+    // factor to get projected size in pixels from size/distance ratio
+    const projection_data pd = get_projection_data(gm);
+    const double pixel_factor =
+        pd.w / (2.0 * std::tan(pd.fov_x * M_PI / 360.0));
+
     for (auto object : objects)
     {
         bool istorp = (dynamic_cast<const torpedo*>(object) != nullptr);
@@ -285,6 +291,12 @@ void freeview_display::draw_objects(
         {
             continue;
         }
+        // select detail level by size on screen
+        const double dist = std::max(
+            (object->get_pos() - viewpos).length(), double(pd.near_z));
+        const unsigned lod_level = model::get_lod_level_for_screen_size(
+            float(2.0 * object->get_bounding_radius() / dist * pixel_factor));
+
         glPushMatrix();
 
         if (mirrorclip && !istorp)
@@ -327,7 +339,7 @@ void freeview_display::draw_objects(
             {
                 // finished modifying tex#1 matrix
                 glMatrixMode(GL_MODELVIEW);
-                object->display_mirror_clip();
+                object->display_mirror_clip(lod_level);
             }
             // cleanup
             glActiveTexture(GL_TEXTURE1);
@@ -338,7 +350,8 @@ void freeview_display::draw_objects(
         else
         {
             object->display(
-                under_water ? ui.get_caustics().get_map() : nullptr);
+                under_water ? ui.get_caustics().get_map() : nullptr,
+                lod_level);
         }
         glPopMatrix();
     }
@@ -410,6 +423,58 @@ void freeview_display::draw_objects(
     glDepthMask(GL_TRUE);
 }
 
+auto freeview_display::cull_objects(
+    const vector<const sea_object*>& objects,
+    const frustum& viewfrustum,
+    const vector3& viewpos,
+    bool mirrored) const -> vector<const sea_object*>
+{
+    // distance to horizon for viewer, object tops have their own horizon
+    // distance that is added, so that ship masts can be seen before the hull.
+    // The earth's curvature only hides objects if viewer and object top are
+    // above the water, submerged objects are not seen along the surface.
+    const bool viewer_above_water = viewpos.z > 0.0;
+    const double viewer_horizon =
+        std::sqrt(2.0 * constant::EARTH_RADIUS * std::max(viewpos.z, 0.0));
+
+    vector<const sea_object*> result;
+    result.reserve(objects.size());
+    for (auto object : objects)
+    {
+        const vector3 pos     = object->get_pos();
+        const double radius   = object->get_bounding_radius();
+        const double top      = pos.z + radius;
+        const double distance = pos.xy().distance(viewpos.xy());
+        if (viewer_above_water && top > 0.0
+            && distance - radius
+                   > viewer_horizon
+                         + std::sqrt(2.0 * constant::EARTH_RADIUS * top))
+        {
+            continue;
+        }
+        // frustum planes point inwards. mirror image of object is at -z.
+        vector3 rel = pos - viewpos;
+        if (mirrored)
+        {
+            rel.z = -pos.z - viewpos.z;
+        }
+        bool inside = true;
+        for (const auto& pl : viewfrustum.planes)
+        {
+            if (pl.distance(rel) < -radius)
+            {
+                inside = false;
+                break;
+            }
+        }
+        if (inside)
+        {
+            result.push_back(object);
+        }
+    }
+    return result;
+}
+
 void freeview_display::draw_view(game& gm, const vector3& viewpos) const
 {
     double max_view_dist = gm.get_max_view_distance();
@@ -439,6 +504,15 @@ void freeview_display::draw_view(game& gm, const vector3& viewpos) const
     // ****************************************
     set_modelview_matrix(gm, viewpos);
 
+    // the reflection pass uses the same projection as the scene, so the
+    // view frustum for culling can be computed once for both passes.
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    SYS().gl_perspective_fovx(
+        pd.fov_x, double(pd.w) / double(pd.h), pd.near_z, pd.far_z);
+    glMatrixMode(GL_MODELVIEW);
+    const frustum viewfrustum = frustum::from_opengl();
+
     // **************** prepare drawing
     // ***************************************************
 
@@ -490,6 +564,7 @@ void freeview_display::draw_view(game& gm, const vector3& viewpos) const
     // compute visble ships/subs, needed for draw_objects and amount of foam
     // computation
     const auto& objects = player->get_visible_objects();
+    unsigned nr_of_objects_drawn = 0, nr_of_objects_culled = 0;
     // fixme: the lookout sensor must give all ships seens around, not cull away
     // ships out of the frustum, or their foam is lost as well, even it would be
     // visible...
@@ -570,17 +645,21 @@ void freeview_display::draw_view(game& gm, const vector3& viewpos) const
         // would be perfect which is highly unrealistic.
         // so remove entries that are too far away. Torpedoes can't be seen
         // so they don't need to get rendered.
-        vector<const sea_object*> objects_mirror;
-        objects_mirror.reserve(objects.size());
+        vector<const sea_object*> objects_near;
+        objects_near.reserve(objects.size());
         const double MIRROR_DIST = 1000.0; // 1km or so...
         for (auto object : objects)
         {
             if (object->get_pos().xy().square_distance(viewpos.xy())
                 < MIRROR_DIST * MIRROR_DIST)
             {
-                objects_mirror.push_back(object);
+                objects_near.push_back(object);
             }
         }
+        const auto objects_mirror =
+            cull_objects(objects_near, viewfrustum, viewpos, true);
+        nr_of_objects_drawn += objects_mirror.size();
+        nr_of_objects_culled += objects_near.size() - objects_mirror.size();
         draw_objects(
             gm,
             viewpos_mirror,
@@ -688,7 +767,6 @@ void freeview_display::draw_view(game& gm, const vector3& viewpos) const
         pd.fov_x, double(pd.w) / double(pd.h), pd.near_z, pd.far_z);
     glMatrixMode(GL_MODELVIEW);
 
-    frustum viewfrustum = frustum::from_opengl();
     matrix4 mv          = matrix4::get_gl(GL_MODELVIEW_MATRIX);
     matrix4 prj         = matrix4::get_gl(GL_PROJECTION_MATRIX);
     matrix4 mvp         = prj * mv;
@@ -811,10 +889,15 @@ void freeview_display::draw_view(game& gm, const vector3& viewpos) const
     // matrix4::get_gl(GL_MODELVIEW_MATRIX).column(3) << "\n";
 
     // substract player pos.
+    const auto objects_visible =
+        cull_objects(objects, viewfrustum, viewpos, false);
+    nr_of_objects_drawn += objects_visible.size();
+    nr_of_objects_culled += objects.size() - objects_visible.size();
+    ui.set_object_culling_counts(nr_of_objects_drawn, nr_of_objects_culled);
     draw_objects(
         gm,
         viewpos,
-        objects,
+        objects_visible,
         lightcol,
         (above_water < 0) ? true : false /* under water */,
         false /* mirrorclip */);
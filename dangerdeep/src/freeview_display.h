@@ -73,6 +73,16 @@ class freeview_display : public user_display
         const bool underwater,
         bool mirrorclip) const;
 
+    /// remove objects outside of the view frustum or behind the horizon
+    ///@param viewfrustum - frustum relative to viewpos (no translation)
+    ///@param viewpos - real viewer position
+    ///@param mirrored - test mirror images of the objects (at z=0 plane)
+    [[nodiscard]] std::vector<const sea_object*> cull_objects(
+        const std::vector<const sea_object*>& objects,
+        const class frustum& viewfrustum,
+        const vector3& viewpos,
+        bool mirrored) const;
+
     // draw the whole view
     virtual void draw_view(class game& gm, const vector3& viewpos) const;
 
@@ -32,7 +32,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "matrix4.h"
 #include "model.h"
 #include "particle.h"
+#include "point_grid.h"
+#include "profiler.h"
 #include "quaternion.h"
+#include "savegame_index.h"
 #include "sensors.h"
 #include "ship.h"
 #include "sonar.h"
@@ -44,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "water.h"
 #include "water_splash.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <mutex>
 #include <sstream>
@@ -59,6 +63,9 @@ const unsigned SAVEVERSION = 1;
 const unsigned GAMETYPE    = 0; // fixme, 0-mission , 1-patrol etc.
 
 const double game::TRAIL_TIME = 1.0;
+double game::kinematic_range  = 30000.0;
+bool game::auto_integration   = true;
+body_integrator::method game::integration = body_integrator::euler;
 
 /***************************************************************************/
 
@@ -254,10 +261,7 @@ game::game(
 
     for (unsigned i = 0; i < nr_of_players; ++i)
     {
-        xml_doc doc(data_file().get_filename(subtype));
-        doc.load();
-
-        submarine sub(*this, doc.first_child());
+        submarine sub(*this, data_file().get_spec(subtype));
 
         sub.set_skin_layout(model::default_layout);
         sub.init_fill_torpedo_tubes(currentdate);
@@ -294,7 +298,7 @@ game::game(
         // now tmpa holds the angle of the sub's position around the convoy.
         double maxt = 0;
 
-        for (auto& [id, ship] : ships)
+        for (auto& ship : ships)
         {
             double maxt1 = 0, maxt2 = get_max_view_distance() / 2,
                    maxt3 = get_max_view_distance();
@@ -329,7 +333,7 @@ game::game(
         // unrealistic to detect a convoy while moving away from it
         sub.manipulate_heading(angle(rnd() * 180.0 + 90.0) + tmpa);
 
-        auto& [id, thesub] = spawn_submarine(std::move(sub));
+        auto [id, thesub] = spawn_submarine(std::move(sub));
         if (i == 0)
         {
             player    = &thesub;
@@ -337,6 +341,8 @@ game::game(
             compute_max_view_dist();
         }
     }
+    // later spawns may have moved the player object
+    player = &get_object(player_id);
 
     my_run_state    = running;
     last_trail_time = time - TRAIL_TIME;
@@ -345,6 +351,14 @@ game::game(
     freezetime_start = 0;
 }
 
+/// id of object stored in savegame, older files and missions have none, then
+/// objects get sequential ids in order of loading.
+inline auto saved_id(const xml_elem& elem) -> sea_object_id
+{
+    return elem.has_attr("id") ? sea_object_id(elem.attru("id"))
+                               : sea_object_id();
+}
+
 //
 // Load game: savegame or mission
 //
@@ -391,18 +405,20 @@ game::game(const string& filename) :
 
     for (auto elem : sh.iterate("ship"))
     {
-        xml_doc spec(data_file().get_filename(elem.attr("type")));
-        spec.load();
-        spawn_ship(ship(*this, spec.first_child())).second.load(elem);
+        spawn_ship(
+            ship(*this, data_file().get_spec(elem.attr("type"))),
+            saved_id(elem))
+            .second.load(elem);
     }
 
     // there must be submarines in a mission...
     xml_elem su = sg.child("submarines");
     for (auto elem : su.iterate("submarine"))
     {
-        xml_doc spec(data_file().get_filename(elem.attr("type")));
-        spec.load();
-        spawn_submarine(submarine(*this, spec.first_child())).second.load(elem);
+        spawn_submarine(
+            submarine(*this, data_file().get_spec(elem.attr("type"))),
+            saved_id(elem))
+            .second.load(elem);
     }
 
     if (sg.has_child("airplanes"))
@@ -410,9 +426,23 @@ game::game(const string& filename) :
         xml_elem ap = sg.child("airplanes");
         for (auto elem : ap.iterate("airplane"))
         {
-            xml_doc spec(data_file().get_filename(elem.attr("type")));
-            spec.load();
-            spawn_airplane(airplane(*this, spec.first_child()))
+            spawn_airplane(
+                airplane(*this, data_file().get_spec(elem.attr("type"))),
+                saved_id(elem))
+                .second.load(elem);
+        }
+    }
+
+    // convoys before the other objects, so that files without ids give
+    // them the same ids as always.
+    if (sg.has_child("convoys"))
+    {
+        xml_elem cv = sg.child("convoys");
+        for (auto elem : cv.iterate("convoy"))
+        {
+            // xml_doc spec(get_convoy_dir() + elem.attr("type") + ".xml");
+            // spec.load();
+            spawn(convoy(*this /*, spec.first_child()*/), saved_id(elem))
                 .second.load(elem);
         }
     }
@@ -422,9 +452,10 @@ game::game(const string& filename) :
         xml_elem tp = sg.child("torpedoes");
         for (auto elem : tp.iterate("torpedo"))
         {
-            xml_doc spec(data_file().get_filename(elem.attr("type")));
-            spec.load();
-            spawn(torpedo(*this, spec.first_child(), torpedo::setup_data()))
+            spawn(torpedo(
+                      *this,
+                      data_file().get_spec(elem.attr("type")),
+                      torpedo::setup_data()))
                 .load(elem);
         }
     }
@@ -451,17 +482,6 @@ game::game(const string& filename) :
         }
     }
 
-    if (sg.has_child("convoys"))
-    {
-        xml_elem cv = sg.child("convoys");
-        for (auto elem : cv.iterate("convoy"))
-        {
-            // xml_doc spec(get_convoy_dir() + elem.attr("type") + ".xml");
-            // spec.load();
-            spawn(convoy(*this /*, spec.first_child()*/)).second.load(elem);
-        }
-    }
-
     // fixme: handle water splashes too.
 
 #if 0
@@ -517,42 +537,54 @@ game::~game() = default;
 // Save game
 //
 
-void game::save(const string& savefilename, const string& description) const
+void game::save(
+    const string& savefilename,
+    const string& description,
+    const std::vector<uint8_t>& thumbnail) const
 {
     xml_doc doc(savefilename);
     xml_elem sg = doc.add_child("dftd-savegame");
 
-    sg.set_attr(description, "description");
-    sg.set_attr(SAVEVERSION, "version");
+    // header must be first child, so it can be read without loading all
+    savegame_header header;
+    header.version     = SAVEVERSION;
+    header.description = description;
+    header.date        = get_date().to_str();
+    header.player      = playerinfo.name;
+    header.thumbnail   = thumbnail;
+    header.save(sg);
     sg.set_attr(GAMETYPE, "type");
 
     xml_elem sh = sg.add_child("ships");
     sh.set_attr(unsigned(ships.size()), "nr");
 
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         xml_elem e = sh.add_child("ship");
         e.set_attr(ship.get_specfilename(), "type");
+        e.set_attr(ships.key_of(ship), "id");
         ship.save(e);
     }
 
     xml_elem su = sg.add_child("submarines");
     su.set_attr(unsigned(submarines.size()), "nr");
 
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         xml_elem e = su.add_child("submarine");
         e.set_attr(submarine.get_specfilename(), "type");
+        e.set_attr(submarines.key_of(submarine), "id");
         submarine.save(e);
     }
 
     xml_elem ap = sg.add_child("airplanes");
     ap.set_attr(unsigned(airplanes.size()), "nr");
 
-    for (auto& [id, airplane] : airplanes)
+    for (auto& airplane : airplanes)
     {
         xml_elem e = ap.add_child("airplane");
         e.set_attr(airplane.get_specfilename(), "type");
+        e.set_attr(airplanes.key_of(airplane), "id");
         airplane.save(e);
     }
 
@@ -591,11 +623,12 @@ void game::save(const string& savefilename, const string& description) const
     xml_elem cv = sg.add_child("convoys");
     cv.set_attr(unsigned(convoys.size()), "nr");
 
-    for (auto& [id, convoy] : convoys)
+    for (auto& convoy : convoys)
     {
         xml_elem e = cv.add_child("convoy");
         // e.set_attr(convoy.get_specfilename(), "type");//no specfilename for
         // convoys
+        e.set_attr(convoys.key_of(convoy), "id");
         convoy.save(e);
     }
 
@@ -685,26 +718,18 @@ void game::save(const string& savefilename, const string& description) const
     doc.save();
 }
 
-auto game::read_description_of_savegame(const string& filename) -> string
+auto game::describe_savegame(const savegame_header& header) -> string
 {
-    // causes 90mb mem leak fixme
-    xml_doc doc(filename);
-    doc.load();
-    xml_elem sg = doc.child("dftd-savegame");
-
-    unsigned v = sg.attru("version");
-    if (v != SAVEVERSION)
+    if (header.version != SAVEVERSION)
     {
         return "<ERROR> Invalid version";
     }
 
-    string d = sg.attr("description");
-
-    if (d.length() == 0)
+    if (header.description.length() == 0)
     {
         return "<ERROR> Empty description";
     }
-    return d;
+    return header.description;
 }
 
 void game::compute_max_view_dist()
@@ -716,36 +741,22 @@ void game::compute_max_view_dist()
         5000.0 + compute_light_brightness(player->get_pos(), sundir) * 25000;
 }
 
-template<class T>
-void cleanup(std::unordered_map<sea_object_id, T>& s)
+void game::compute_wind()
 {
-    for (auto it = s.begin(); it != s.end();)
-    {
-        if (it->second.is_dead())
-        {
-            it = s.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    // fixme: wind should depend on weather as well. Until then it changes
+    // slowly with time, once per minute, so it needs no saving. It is used
+    // for the waves when they are synthesized at runtime.
+    const double hours  = std::floor(time / 60.0) / 60.0;
+    const double phase  = 2.0 * constant::PI * hours;
+    const double speed  = 10.0 + 3.0 * sin(phase / 7.0) + sin(phase / 2.3);
+    const vector2 direc = angle(45.0 + 40.0 * sin(phase / 11.0)).direction();
+    mywater->set_wind(vector2f(float(direc.x), float(direc.y)), float(speed));
 }
 
 template<class T>
-void cleanup(std::vector<T>& s)
+void cleanup(slot_map<T>& s)
 {
-    for (auto it = s.begin(); it != s.end();)
-    {
-        if (it->is_dead())
-        {
-            it = s.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    s.erase_if([](const T& obj) { return obj.is_dead(); });
 }
 
 void game::simulate(double delta_t)
@@ -758,9 +769,23 @@ void game::simulate(double delta_t)
         }
     }
 
+    // kill events left over from last run, events of all steps in between
+    // are kept until the next call.
+    events.clear();
+
     // protect physics simulation from bad values, simulation step must not
-    // be less than 20fps.
-    const double max_dt_rate = 1.0 / 20.0;
+    // be longer than what the integration method can handle accurately.
+    // Torpedo and shell hits are tested along the way the objects moved in
+    // a step, so they do not need shorter steps.
+    step_integration = integration;
+    if (auto_integration)
+    {
+        step_integration =
+            (delta_t > body_integrator::max_step_time(body_integrator::euler))
+                ? body_integrator::rk4
+                : body_integrator::euler;
+    }
+    const double max_dt_rate = body_integrator::max_step_time(step_integration);
 
     if (delta_t > max_dt_rate)
     {
@@ -774,15 +799,20 @@ void game::simulate(double delta_t)
                               << " steps in between.");
         for (unsigned s = 1; s < steps; ++s)
         {
-            simulate(ddt);
+            simulate_step(ddt);
             delta_t -= ddt;
+            if (!is_editor() && my_run_state != running)
+            {
+                return;
+            }
         }
-        simulate(delta_t);
-        return;
     }
+    simulate_step(delta_t);
+}
 
-    // kill events left over from last run
-    events.clear();
+void game::simulate_step(double delta_t)
+{
+    PROFILE_ZONE("game::simulate");
 
     if (!is_editor())
     {
@@ -808,6 +838,7 @@ void game::simulate(double delta_t)
     }
 
     compute_max_view_dist();
+    compute_wind();
 
     bool record = false;
     if (get_time() >= last_trail_time + TRAIL_TIME)
@@ -842,16 +873,33 @@ void game::simulate(double delta_t)
     // step 1: check for invalidity of every object and remove
     // defunct objects. do NOT mix simulate() calls with real
     // calls to delete an object.
-    cleanup(ships);
-    cleanup(submarines);
-    cleanup(airplanes);
-    cleanup(torpedoes);
-    cleanup(depth_charges);
-    cleanup(gun_shells);
-    cleanup(water_splashes);
+    {
+        PROFILE_ZONE("cleanup");
+        cleanup(ships);
+        cleanup(submarines);
+        cleanup(airplanes);
+        cleanup(torpedoes);
+        cleanup(depth_charges);
+        cleanup(gun_shells);
+        cleanup(water_splashes);
+        // cleanup moves objects in storage, so fetch player again
+        if (player != nullptr)
+        {
+            player = &get_object(player_id);
+        }
+        check_object_storage();
+        update_simulation_lod();
+    }
+    {
+        PROFILE_ZONE("detect_sea_objects");
+        detect_sea_objects(delta_t);
+    }
 
     // step 2: simulate all objects, possibly setting state to dead/defunct.
-    simulate_objects(delta_t, record, nearest_contact);
+    {
+        PROFILE_ZONE("simulate_objects");
+        simulate_objects(delta_t, record, nearest_contact);
+    }
 
     // Now check for collisions. As a result objects could be set to dead state.
     // If we would call this before simulate() an object could go from alive
@@ -870,7 +918,10 @@ void game::simulate(double delta_t)
     // can be solved by storing a list of collision partners per object,
     // that is cleared every round and generated by this check_collision()
     // function. In that case we should call it _before_ simulate()...
-    check_collisions();
+    {
+        PROFILE_ZONE("check_collisions");
+        check_collisions();
+    }
 
     time += delta_t;
 
@@ -899,8 +950,12 @@ void game::simulate_objects(
     bool record,
     double& nearest_contact)
 {
+    // objects may spawn torpedoes while they are simulated, so storage is
+    // checked after each object, when no lists of detected objects are in use.
+    simulating_objects = true;
+
     // ships
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         if (&ship != player)
         {
@@ -911,6 +966,7 @@ void game::simulate_objects(
             }
         }
         ship.simulate(delta_t, *this);
+        check_object_storage();
         if (record)
         {
             ship.remember_position(get_time());
@@ -918,7 +974,7 @@ void game::simulate_objects(
     }
 
     // submarines
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         if (&submarine != player)
         {
@@ -929,6 +985,7 @@ void game::simulate_objects(
             }
         }
         submarine.simulate(delta_t, *this);
+        check_object_storage();
         if (record)
         {
             submarine.remember_position(get_time());
@@ -936,7 +993,7 @@ void game::simulate_objects(
     }
 
     // airplanes
-    for (auto& [id, airplane] : airplanes)
+    for (auto& airplane : airplanes)
     {
         if (&airplane != player)
         {
@@ -947,12 +1004,14 @@ void game::simulate_objects(
             }
         }
         airplane.simulate(delta_t, *this);
+        check_object_storage();
     }
 
     // torpedoes
     for (auto& torpedo : torpedoes)
     {
         torpedo.simulate(delta_t, *this);
+        check_object_storage();
         if (record)
         {
             torpedo.remember_position(get_time());
@@ -966,6 +1025,7 @@ void game::simulate_objects(
     }
 
     // gun_shells
+    check_gun_shell_collisions();
     for (auto& gun_shell : gun_shells)
     {
         gun_shell.simulate(delta_t, *this);
@@ -979,7 +1039,7 @@ void game::simulate_objects(
 
     // for convoys/particles it doesn't hurt to mix simulate() with compact().
     // convoys
-    for (auto& [id, convoy] : convoys)
+    for (auto& convoy : convoys)
     {
         convoy.simulate(
             delta_t, *this); // fixme: handle erasing of empty convoys!
@@ -1005,6 +1065,256 @@ void game::simulate_objects(
     helper::erase_remove_if(particles, [](const std::unique_ptr<particle>& p) {
         return p == nullptr;
     });
+    simulating_objects = false;
+}
+
+void game::update_simulation_lod()
+{
+    // Only objects that can attack or observe ships from near need the
+    // physics of nearby ships. Use some hysteresis, so ships near the limit
+    // don't switch every step. Ships the player sees or has on radar always
+    // use full physics, as their AI must act on current sensor data.
+    const bool full_physics = is_editor() || kinematic_range <= 0.0;
+    vector<vector2> observers;
+    vector<const sea_object*> observed;
+    if (!full_physics)
+    {
+        if (player != nullptr)
+        {
+            observers.push_back(player->get_pos().xy());
+            observed = player->get_visible_objects();
+            observed.insert(
+                observed.end(),
+                player->get_radar_objects().begin(),
+                player->get_radar_objects().end());
+            std::sort(observed.begin(), observed.end());
+        }
+        for (auto& submarine : submarines)
+        {
+            observers.push_back(submarine.get_pos().xy());
+        }
+        for (auto& torpedo : torpedoes)
+        {
+            observers.push_back(torpedo.get_pos().xy());
+        }
+    }
+    const double promote_dist2 = kinematic_range * kinematic_range;
+    const double demote_dist2  = promote_dist2 * 1.21; // 10% farther
+    for (auto& ship : ships)
+    {
+        double dist2 = 1e30;
+        for (const auto& o : observers)
+        {
+            dist2 = std::min(dist2, ship.get_pos().xy().square_distance(o));
+        }
+        if (full_physics || dist2 < promote_dist2
+            || std::binary_search(
+                observed.begin(),
+                observed.end(),
+                static_cast<const sea_object*>(&ship)))
+        {
+            ship.set_kinematic(false);
+        }
+        else if (dist2 > demote_dist2)
+        {
+            ship.set_kinematic(true);
+        }
+    }
+}
+
+void game::check_object_storage()
+{
+    const unsigned version =
+        ships.get_storage_version() + submarines.get_storage_version()
+        + airplanes.get_storage_version() + torpedoes.get_storage_version();
+    if (version == object_storage_version)
+    {
+        return;
+    }
+    object_storage_version = version;
+    detections.clear(); // pointers are invalid now
+    for (auto& ship : ships)
+    {
+        ship.redetect_other_sea_objects(*this);
+    }
+    for (auto& submarine : submarines)
+    {
+        submarine.redetect_other_sea_objects(*this);
+    }
+    for (auto& airplane : airplanes)
+    {
+        airplane.redetect_other_sea_objects(*this);
+    }
+    for (auto& torpedo : torpedoes)
+    {
+        torpedo.redetect_other_sea_objects(*this);
+    }
+}
+
+void game::check_object_storage_after_spawn()
+{
+    // during simulation the storage is checked after each object
+    if (simulating_objects)
+    {
+        return;
+    }
+    if (player != nullptr)
+    {
+        player = &get_object(player_id);
+    }
+    check_object_storage();
+}
+
+void game::detect_sea_objects(double delta_t)
+{
+    // The results are the same as those of visible_sea_objects,
+    // radar_sea_objects and sonar_sea_objects for every detecting object,
+    // but only objects near it are tested. Kinematic ships don't detect.
+    detections.clear();
+    vector<sea_object*> detectors;
+    for (auto& ship : ships)
+    {
+        if (!ship.is_kinematic() && ship.redetects_in(delta_t))
+        {
+            detectors.push_back(&ship);
+        }
+    }
+    for (auto& submarine : submarines)
+    {
+        if (submarine.redetects_in(delta_t))
+        {
+            detectors.push_back(&submarine);
+        }
+    }
+    for (auto& airplane : airplanes)
+    {
+        if (airplane.redetects_in(delta_t))
+        {
+            detectors.push_back(&airplane);
+        }
+    }
+    for (auto& torpedo : torpedoes)
+    {
+        if (torpedo.redetects_in(delta_t))
+        {
+            detectors.push_back(&torpedo);
+        }
+    }
+    if (detectors.empty())
+    {
+        return;
+    }
+
+    // Insert objects in the order of the linear search, so results are
+    // ordered the same way. Lookout only handles living objects, radar all.
+    const double cell_size = 10000.0;
+    point_grid<const sea_object*> lookout_grid(cell_size);
+    point_grid<const sea_object*> radar_grid(cell_size);
+    point_grid<const ship*> sonar_grid(cell_size);
+    for (auto& ship : ships)
+    {
+        radar_grid.insert(ship.get_pos().xy(), &ship);
+        if (ship.is_reference_ok())
+        {
+            lookout_grid.insert(ship.get_pos().xy(), &ship);
+            sonar_grid.insert(ship.get_pos().xy(), &ship);
+        }
+    }
+    for (auto& submarine : submarines)
+    {
+        radar_grid.insert(submarine.get_pos().xy(), &submarine);
+        if (submarine.is_reference_ok())
+        {
+            lookout_grid.insert(submarine.get_pos().xy(), &submarine);
+        }
+    }
+    for (auto& airplane : airplanes)
+    {
+        if (airplane.is_reference_ok())
+        {
+            lookout_grid.insert(airplane.get_pos().xy(), &airplane);
+        }
+    }
+    for (auto& torpedo : torpedoes)
+    {
+        if (torpedo.is_reference_ok())
+        {
+            lookout_grid.insert(torpedo.get_pos().xy(), &torpedo);
+        }
+    }
+
+    detections.reserve(detectors.size());
+    for (const auto* o : detectors)
+    {
+        auto& result      = detections[o];
+        const vector2 pos = o->get_pos().xy();
+        // the grid includes the range limit, the sensors test with a
+        // slightly different formula, so query a bit more.
+        if (const auto* ls = dynamic_cast<const lookout_sensor*>(
+                o->get_sensor(o->lookout_system)))
+        {
+            for (const auto* t :
+                 lookout_grid.find_within(pos, max_view_dist + 1.0))
+            {
+                if (ls->is_detected(this, o, t))
+                {
+                    result.visible.push_back(t);
+                }
+            }
+        }
+        if (const auto* rs = dynamic_cast<const radar_sensor*>(
+                o->get_sensor(o->radar_system)))
+        {
+            for (const auto* t :
+                 radar_grid.find_within(pos, rs->get_range() + 1.0))
+            {
+                if (rs->is_detected(this, o, t))
+                {
+                    result.radar.push_back(t);
+                }
+            }
+        }
+        if (const auto* pss = dynamic_cast<const passive_sonar_sensor*>(
+                o->get_sensor(o->passive_sonar_system)))
+        {
+            // the nearest ships are tested, wether they are in range or not
+            const auto nearest = sonar_grid.find_nearest(
+                pos,
+                acoustics::max_acoustic_contacts,
+                [o](const ship* s) { return s != o; });
+            for (const auto* sh : nearest)
+            {
+                if (pss->is_detected(this, o, sh))
+                {
+                    result.sonar.emplace_back(
+                        sh->get_pos().xy(), sh->get_class());
+                }
+            }
+            // there are only few submarines, test them all
+            for (const auto& sc : sonar_submarines(o))
+            {
+                result.sonar.push_back(sc);
+            }
+        }
+    }
+}
+
+auto game::take_detection_result(
+    const sea_object* o,
+    vector<const sea_object*>& visible,
+    vector<const sea_object*>& radar,
+    vector<sonar_contact>& sonar) -> bool
+{
+    auto it = detections.find(o);
+    if (it == detections.end())
+    {
+        return false;
+    }
+    visible = std::move(it->second.visible);
+    radar   = std::move(it->second.radar);
+    sonar   = std::move(it->second.sonar);
+    detections.erase(it);
+    return true;
 }
 
 void game::add_logbook_entry(const string& s)
@@ -1045,45 +1355,9 @@ matrix from left and right and evaluate the result.
 
 */
 
-template<class T>
-inline auto visible_obj(
-    const game* gm,
-    const std::unordered_map<sea_object_id, T>& v,
-    const sea_object* o) -> vector<const T*>
-{
-    vector<const T*> result;
-    const sensor* s = o->get_sensor(o->lookout_system);
-
-    if (!s)
-    {
-        return result;
-    }
-
-    const auto* ls = dynamic_cast<const lookout_sensor*>(s);
-
-    if (!ls)
-    {
-        return result;
-    }
-
-    result.reserve(v.size());
-    for (auto& [id, obj] : v)
-    {
-        // do not handle dead or defunct objects!
-        if (obj.is_reference_ok())
-        {
-            if (ls->is_detected(gm, o, &obj))
-            {
-                result.push_back(&obj);
-            }
-        }
-    }
-    return result;
-}
-
 template<class T>
 inline auto
-visible_obj(const game* gm, const std::vector<T>& v, const sea_object* o)
+visible_obj(const game* gm, const slot_map<T>& v, const sea_object* o)
     -> vector<const T*>
 {
     vector<const T*> result;
@@ -1219,7 +1493,7 @@ auto game::sonar_ships(const sea_object* o) const -> vector<sonar_contact>
     vector<pair<double, const ship*>> contacts(
         acoustics::max_acoustic_contacts, make_pair(1e30, (ship*) nullptr));
 
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         // do not handle dead/defunct objects
         if (!ship.is_reference_ok())
@@ -1291,7 +1565,7 @@ auto game::sonar_submarines(const sea_object* o) const -> vector<sonar_contact>
 
     result.reserve(submarines.size());
 
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         // do not handle dead/defunct objects
         if (!submarine.is_reference_ok())
@@ -1349,7 +1623,7 @@ auto game::radar_submarines(const sea_object* o) const
 
     result.reserve(submarines.size());
 
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         if (ls->is_detected(this, o, &submarine))
         {
@@ -1377,7 +1651,7 @@ auto game::radar_ships(const sea_object* o) const -> vector<const ship*>
 
     result.reserve(ships.size());
 
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         if (ls->is_detected(this, o, &ship))
         {
@@ -1406,7 +1680,7 @@ auto game::convoy_positions() const -> vector<vector2>
     vector<vector2> result;
     result.reserve(convoys.size());
 
-    for (auto& [id, convoy] : convoys)
+    for (auto& convoy : convoys)
     {
         result.push_back(convoy.get_pos());
     }
@@ -1421,7 +1695,7 @@ auto game::sonar_listen_ships(const ship* listener, angle rel_listening_dir)
     tmpships.reserve(
         ships.size() + submarines.size() /* + torpedoes.size() */ - 1);
 
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         if (&ship != listener)
         {
@@ -1429,7 +1703,7 @@ auto game::sonar_listen_ships(const ship* listener, angle rel_listening_dir)
         }
     }
 
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         if (dynamic_cast<const ship*>(&submarine) != listener)
         {
@@ -1564,30 +1838,48 @@ auto game::sonar_listen_ships(const ship* listener, angle rel_listening_dir)
     return make_pair(abs_strength, n.to_dB());
 }
 
-auto game::spawn_ship(ship&& obj) -> std::pair<const sea_object_id, ship>&
+template<class T>
+auto spawn_object(slot_map<T>& objects, T&& obj, sea_object_id id)
+    -> std::pair<sea_object_id, T&>
 {
-    return *ships.insert(std::make_pair(generate_id(), std::move(obj))).first;
+    if (id == sea_object_id::invalid)
+    {
+        auto& o = objects.insert(std::move(obj));
+        return {sea_object_id(objects.key_of(o)), o};
+    }
+    return {id, objects.insert_with_key(id.id, std::move(obj))};
 }
 
-auto game::spawn_submarine(submarine&& obj)
-    -> std::pair<const sea_object_id, submarine>&
+auto game::spawn_ship(ship&& obj, sea_object_id id)
+    -> std::pair<sea_object_id, ship&>
 {
-    return *submarines.insert(std::make_pair(generate_id(), std::move(obj)))
-                .first;
+    auto result = spawn_object(ships, std::move(obj), id);
+    check_object_storage_after_spawn();
+    return result;
 }
 
-auto game::spawn_airplane(airplane&& obj)
-    -> std::pair<const sea_object_id, airplane>&
+auto game::spawn_submarine(submarine&& obj, sea_object_id id)
+    -> std::pair<sea_object_id, submarine&>
 {
-    return *airplanes.insert(std::make_pair(generate_id(), std::move(obj)))
-                .first;
+    auto result = spawn_object(submarines, std::move(obj), id);
+    check_object_storage_after_spawn();
+    return result;
+}
+
+auto game::spawn_airplane(airplane&& obj, sea_object_id id)
+    -> std::pair<sea_object_id, airplane&>
+{
+    auto result = spawn_object(airplanes, std::move(obj), id);
+    check_object_storage_after_spawn();
+    return result;
 }
 
 auto game::spawn(torpedo&& obj) -> torpedo&
 {
-    torpedoes.push_back(std::move(obj));
     // add events here
-    return torpedoes.back();
+    auto& t = torpedoes.insert(std::move(obj));
+    check_object_storage_after_spawn();
+    return t;
 }
 
 auto game::spawn(gun_shell&& obj) -> gun_shell&
@@ -1607,8 +1899,7 @@ auto game::spawn(gun_shell&& obj) -> gun_shell&
     {
         events.push_back(std::make_unique<event_gunfire_heavy>(obj.get_pos()));
     }
-    gun_shells.push_back(std::move(obj));
-    return gun_shells.back();
+    return gun_shells.insert(std::move(obj));
 }
 
 auto game::spawn(depth_charge&& obj) -> depth_charge&
@@ -1616,20 +1907,21 @@ auto game::spawn(depth_charge&& obj) -> depth_charge&
     events.push_back(
         std::make_unique<event_depth_charge_in_water>(obj.get_pos()));
 
-    depth_charges.push_back(std::move(obj));
-    return depth_charges.back();
+    return depth_charges.insert(std::move(obj));
 }
 
 auto game::spawn(water_splash&& obj) -> water_splash&
 {
-    water_splashes.push_back(std::move(obj));
     // add events here
-    return water_splashes.back();
+    return water_splashes.insert(std::move(obj));
 }
 
-auto game::spawn(convoy&& cv) -> std::pair<const sea_object_id, convoy>&
+auto game::spawn(convoy&& cv, sea_object_id id)
+    -> std::pair<sea_object_id, convoy&>
 {
-    return *convoys.insert(std::make_pair(generate_id(), std::move(cv))).first;
+    auto result = spawn_object(convoys, std::move(cv), id);
+    check_object_storage_after_spawn();
+    return result;
 }
 
 void game::spawn(std::unique_ptr<particle>&& pt)
@@ -1649,7 +1941,7 @@ void game::dc_explosion(const depth_charge& dc)
     // fixme: ships can be damaged by DCs also...
     // fixme: ai should not be able to release dcs with a depth less than 30m or
     // so, to avoid suicide
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         submarine.depth_charge_explosion(dc);
     }
@@ -1720,7 +2012,7 @@ void game::ping_ASDIC(
 
         // fixme: noise from ships can disturb ASDIC or may generate more
         // contacs. ocean floor echoes ASDIC etc...
-        for (auto& [id, submarine] : submarines)
+        for (auto& submarine : submarines)
         {
             if (ass->is_detected(this, d, &submarine))
             {
@@ -1749,26 +2041,41 @@ void game::ping_ASDIC(
 }
 
 template<class C>
-auto check_units(torpedo* t, std::unordered_map<sea_object_id, C>& units)
+auto check_units(torpedo* t, const vector3& oldpos, slot_map<C>& units)
     -> ship*
 {
-    const vector3& t_pos = t->get_pos();
+    // The torpedo is tested at positions along its way in the last step,
+    // with at most one meter in between, as with 20 steps per second. So it
+    // can't pass through a ship with the long steps of time compression.
+    const vector3 way    = t->get_pos() - oldpos;
+    const vector3 center = oldpos + way * 0.5;
+    const double reach   = way.length() * 0.5 + t->get_bounding_radius();
+    const auto samples   = std::max(1U, unsigned(ceil(way.length())));
     bv_tree::param p0    = t->compute_bv_tree_params();
 
-    for (auto& [id, obj] : units)
+    for (auto& obj : units)
     {
+        const vector3& partner_pos = obj.get_pos();
+        if (partner_pos.distance(center) > reach + obj.get_bounding_radius())
+        {
+            continue;
+        }
         // fixme use bv_trees here with special code for magnetic ignition
         // torpedoes like intersection of sphere around torpedo head with bv
         // tree
-        const vector3& partner_pos = obj.get_pos();
-        matrix4 rel_trans          = matrix4::trans(partner_pos - t_pos);
-        bv_tree::param p1          = obj.compute_bv_tree_params();
-        p1.transform               = rel_trans * p1.transform;
-        vector3f contact_point;
-
-        if (bv_tree::closest_collision(p0, p1, contact_point))
+        const bv_tree::param p1 = obj.compute_bv_tree_params();
+        for (unsigned i = 1; i <= samples; ++i)
         {
-            return &obj;
+            const vector3 t_pos     = oldpos + way * (double(i) / samples);
+            const matrix4 rel_trans = matrix4::trans(partner_pos - t_pos);
+            bv_tree::param p1t      = p1;
+            p1t.transform           = rel_trans * p1.transform;
+            vector3f contact_point;
+
+            if (bv_tree::closest_collision(p0, p1t, contact_point))
+            {
+                return &obj;
+            }
         }
         // old code:
         // if ( is_collision ( t, obj ) )
@@ -1778,13 +2085,16 @@ auto check_units(torpedo* t, std::unordered_map<sea_object_id, C>& units)
     return nullptr;
 }
 
-auto game::check_torpedo_hit(torpedo* t, bool runlengthfailure) -> bool
+auto game::check_torpedo_hit(
+    torpedo* t,
+    const vector3& oldpos,
+    bool runlengthfailure) -> bool
 {
-    auto* s = check_units(t, ships);
+    auto* s = check_units(t, oldpos, ships);
 
     if (!s)
     {
-        s = check_units(t, submarines);
+        s = check_units(t, oldpos, submarines);
     }
 
     if (s)
@@ -1862,7 +2172,7 @@ auto game::ship_in_direction_from_pos(
     if (ls)
     {
         double angle_diff = 30; // fixme: use range also, use ship width's etc.
-        for (auto& [id, ship] : ships)
+        for (auto& ship : ships)
         {
             // Only a visible and intact submarine can be selected.
             if (ls->is_detected(this, o, &ship) && (ship.is_alive()))
@@ -1872,7 +2182,7 @@ auto game::ship_in_direction_from_pos(
                 if (new_ang_diff < angle_diff)
                 {
                     angle_diff = new_ang_diff;
-                    result     = id;
+                    result     = ships.key_of(ship);
                 }
             }
         }
@@ -1896,7 +2206,7 @@ auto game::sub_in_direction_from_pos(
     if (ls)
     {
         double angle_diff = 30; // fixme: use range also, use ship width's etc.
-        for (auto& [id, submarine] : submarines)
+        for (auto& submarine : submarines)
         {
             // Only a visible and intact submarine can be selected.
             if (ls->is_detected(this, o, &submarine) && (submarine.is_alive()))
@@ -1906,7 +2216,7 @@ auto game::sub_in_direction_from_pos(
                 if (new_ang_diff < angle_diff)
                 {
                     angle_diff = new_ang_diff;
-                    result     = id;
+                    result     = submarines.key_of(submarine);
                 }
             }
         }
@@ -2016,59 +2326,91 @@ auto game::get_depth_factor(const vector3& sub) const -> double
 
 auto game::get_object(sea_object_id id) -> sea_object&
 {
-    // fixme need more here?
-    auto it = ships.find(id);
-    if (it == ships.end())
+    if (auto* s = ships.find(id.id))
     {
-        auto it2 = submarines.find(id);
-        if (it2 == submarines.end())
-        {
-            THROW(error, "invalid sea_object_id for ship");
-        }
-        return it2->second;
+        return *s;
+    }
+    if (auto* s = submarines.find(id.id))
+    {
+        return *s;
+    }
+    if (auto* a = airplanes.find(id.id))
+    {
+        return *a;
     }
-    return it->second;
+    THROW(error, "invalid sea_object_id for ship");
 }
 
 auto game::get_ship(sea_object_id id) -> ship&
 {
-    auto it = ships.find(id);
-    if (it == ships.end())
+    auto* s = ships.find(id.id);
+    if (!s)
     {
         THROW(error, "invalid sea_object_id for ship");
     }
-    return it->second;
+    return *s;
 }
 
 auto game::get_convoy(sea_object_id id) -> convoy&
 {
-    auto it = convoys.find(id);
-    if (it == convoys.end())
+    auto* cv = convoys.find(id.id);
+    if (!cv)
     {
         THROW(error, "invalid sea_object_id for convoy");
     }
-    return it->second;
+    return *cv;
 }
 
 auto game::get_id(const sea_object& s) const -> sea_object_id
 {
-    // fixme ugly! should only be available in game_editor later!
-    for (auto& [id, ship] : ships)
+    // the object is found by its position in storage
+    uint32_t key = 0;
+    if (const auto* sub = dynamic_cast<const submarine*>(&s))
     {
-        if (&ship == &s)
-        {
-            return id;
-        }
+        key = submarines.key_of(*sub);
     }
-    for (auto& [id, submarine] : submarines)
+    else if (const auto* shp = dynamic_cast<const ship*>(&s))
     {
-        if (&submarine == &s)
-        {
-            return id;
-        }
+        key = ships.key_of(*shp);
+    }
+    else if (const auto* ap = dynamic_cast<const airplane*>(&s))
+    {
+        key = airplanes.key_of(*ap);
+    }
+    if (key == 0)
+    {
+        THROW(error, "Invalid sea_object to request id");
+    }
+    return key;
+}
+
+auto game::get_object_key(const sea_object& s) const -> uint32_t
+{
+    if (const auto* sub = dynamic_cast<const submarine*>(&s))
+    {
+        return submarines.key_of(*sub);
+    }
+    if (const auto* shp = dynamic_cast<const ship*>(&s))
+    {
+        return ships.key_of(*shp);
+    }
+    if (const auto* ap = dynamic_cast<const airplane*>(&s))
+    {
+        return airplanes.key_of(*ap);
+    }
+    if (const auto* tp = dynamic_cast<const torpedo*>(&s))
+    {
+        return torpedoes.key_of(*tp);
+    }
+    if (const auto* dc = dynamic_cast<const depth_charge*>(&s))
+    {
+        return depth_charges.key_of(*dc);
+    }
+    if (const auto* gs = dynamic_cast<const gun_shell*>(&s))
+    {
+        return gun_shells.key_of(*gs);
     }
-    // fixme more here?
-    THROW(error, "Invalid sea_object to request id");
+    return 0;
 }
 
 auto game::visible_surface_objects(const sea_object* o) const
@@ -2135,7 +2477,7 @@ auto game::sonar_acoustical_torpedo_target(const torpedo* o) const
 
     if (pss)
     {
-        for (auto& [id, ship] : ships)
+        for (auto& ship : ships)
         {
             double sf = 0.0f;
             if (pss->is_detected(sf, this, o, &ship))
@@ -2148,7 +2490,7 @@ auto game::sonar_acoustical_torpedo_target(const torpedo* o) const
             }
         }
 
-        for (auto& [id, submarine] : submarines)
+        for (auto& submarine : submarines)
         {
             double sf = 0.0f;
             if (pss->is_detected(sf, this, o, &submarine))
@@ -2243,6 +2585,38 @@ it != clientcons.end(); ++it) {
 // fixme: it would be better to keep such a vector around and not recompute it
 // for every object that needs it it must be recomputed only when spawn is
 // called or compress removes objects
+void game::check_gun_shell_collisions()
+{
+    if (gun_shells.size() == 0)
+    {
+        return;
+    }
+    // Every shell only tests the ships that are near the line it moved
+    // along in the last step, so all ships are sorted in once per step.
+    const double cell_size = 1000.0;
+    point_grid<const ship*> grid(cell_size);
+    double max_radius = 0.0;
+    for (const auto* s : get_all_ships())
+    {
+        grid.insert(s->get_pos().xy(), s);
+        max_radius = std::max(max_radius, s->get_bounding_radius());
+    }
+    for (auto& gun_shell : gun_shells)
+    {
+        if (!gun_shell.is_reference_ok())
+        {
+            continue;
+        }
+        const vector2 oldpos = gun_shell.get_old_pos().xy();
+        const vector2 newpos = gun_shell.get_pos().xy();
+        gun_shell.check_collision(
+            *this,
+            grid.find_within(
+                (oldpos + newpos) * 0.5,
+                oldpos.distance(newpos) * 0.5 + max_radius));
+    }
+}
+
 auto game::get_all_ships() const -> vector<const ship*>
 {
     vector<const ship*> allships(
@@ -2255,12 +2629,12 @@ auto game::get_all_ships() const -> vector<const ship*>
         allships[k++] = &torpedo;
     }
 
-    for (auto& [id, submarine] : submarines)
+    for (auto& submarine : submarines)
     {
         allships[k++] = &submarine;
     }
 
-    for (auto& [id, ship] : ships)
+    for (auto& ship : ships)
     {
         allships[k++] = &ship;
     }
@@ -2286,6 +2660,11 @@ void game::check_collisions()
 
         for (unsigned j = std::max(i + 1, m); j < allships.size(); ++j)
         {
+            // collisions of distant ships are not simulated
+            if (allships[i]->is_kinematic() && allships[j]->is_kinematic())
+            {
+                continue;
+            }
             const vector3& partner_pos = allships[j]->get_pos();
             matrix4 rel_trans = matrix4::trans(partner_pos - actor_pos);
             bv_tree::param p1 = allships[j]->compute_bv_tree_params();
@@ -2573,17 +2952,13 @@ auto game::is_valid(sea_object_id id) const -> bool
         return false;
     }
     // Only ships or submarines can be targeted (later airplanes)
-    auto it = ships.find(id);
-
-    if (it == ships.end())
+    if (const auto* s = ships.find(id.id))
     {
-        auto it2 = submarines.find(id);
-        if (it2 == submarines.end())
-        {
-            return false;
-        }
-        return it2->second.is_reference_ok();
+        return s->is_reference_ok();
     }
-
-    return it->second.is_reference_ok();
+    if (const auto* s = submarines.find(id.id))
+    {
+        return s->is_reference_ok();
+    }
+    return false;
 }
@@ -37,10 +37,13 @@ constexpr auto max_acoustic_contacts = 5;       // max. nr of simultaneous
 #define TERRAIN_NR_LEVELS    10
 #define TERRAIN_RESOLUTION_N 7
 
+#include "body_integrator.h"
 #include "random_generator.h"
+#include "slot_map.h"
 #include "thread.h"
 
 #include <condition_variable>
+#include <cstdint>
 #include <list>
 #include <mutex>
 #include <unordered_map>
@@ -53,6 +56,7 @@ class global_data;
 class particle;
 class water;
 class height_generator;
+struct savegame_header;
 
 #include "angle.h"
 #include "color.h"
@@ -175,26 +179,35 @@ class game
     // time between records of trail positions
     static const double TRAIL_TIME;
 
-  protected:
-    // begin [SAVE]
-    std::unordered_map<sea_object_id, ship> ships;
-    std::unordered_map<sea_object_id, submarine> submarines;
-    std::unordered_map<sea_object_id, airplane> airplanes;
+    /// ships farther away than that from the player, submarines and
+    /// torpedoes are simulated kinematically (in meters, zero disables it),
+    /// unless the player sees them. Default is the maximum view distance.
+    static double kinematic_range;
 
-    std::vector<torpedo> torpedoes;
-    std::vector<depth_charge> depth_charges;
-    std::vector<gun_shell> gun_shells;
-    std::vector<water_splash> water_splashes;
+    /// integration method for physics. With automatic choice short steps
+    /// use euler and long steps (time compression) use rk4, which allows
+    /// much longer sub steps with the same accuracy.
+    static bool auto_integration;
+    static body_integrator::method integration;
 
-    std::unordered_map<sea_object_id, convoy> convoys;
+  protected:
+    // begin [SAVE]
+    // all sea objects share one id space, so an id is unique among them.
+    // Objects are only erased in simulate() (see cleanup). Lists of detected
+    // objects hold pointers, so they are recreated when the storage of
+    // detectable objects moves (see check_object_storage).
+    slot_key_allocator object_ids;
+    slot_map<ship> ships{object_ids};
+    slot_map<submarine> submarines{object_ids};
+    slot_map<airplane> airplanes{object_ids};
+
+    slot_map<torpedo> torpedoes{object_ids};
+    slot_map<depth_charge> depth_charges{object_ids};
+    slot_map<gun_shell> gun_shells{object_ids};
+    slot_map<water_splash> water_splashes{object_ids};
+
+    slot_map<convoy> convoys{object_ids};
     std::vector<std::unique_ptr<particle>> particles;
-
-    sea_object_id next_id;
-    sea_object_id generate_id()
-    {
-        ++next_id.id;
-        return next_id;
-    }
     // end [SAVE]
 
     run_state my_run_state;
@@ -239,7 +252,36 @@ class game
     std::unique_ptr<height_generator> myheightgen;
 
     // helper for simulation
+    void simulate_step(double delta_t);
     void simulate_objects(double delta_t, bool record, double& nearest_contact);
+    bool simulating_objects{false};
+    /// integration method of current simulation step
+    body_integrator::method step_integration{body_integrator::euler};
+
+    /// sum of storage versions of detectable objects, when last checked
+    unsigned object_storage_version{0};
+    /// recreate lists of detected objects if detectable objects have moved
+    void check_object_storage();
+    /// after spawning outside of simulation, e.g. in the editor: fetch
+    /// player again and check storage, as pointers may have become invalid
+    void check_object_storage_after_spawn();
+    /// switch ships between full physics and kinematic simulation
+    void update_simulation_lod();
+
+    /// objects detected by one sea_object
+    struct detection_result
+    {
+        std::vector<const sea_object*> visible;
+        std::vector<const sea_object*> radar;
+        std::vector<sonar_contact> sonar;
+    };
+    /// results of all objects that redetect in the current step
+    std::unordered_map<const sea_object*, detection_result> detections;
+    /// compute detections of all objects that are due in this step at once
+    void detect_sea_objects(double delta_t);
+
+    /// check hits of all gun shells in flight with ships or water at once
+    void check_gun_shell_collisions();
 
     player_info playerinfo;
 
@@ -274,13 +316,17 @@ class game
 
     virtual ~game();
 
-    virtual void
-    save(const std::string& savefilename, const std::string& description) const;
+    /// save game, thumbnail is RGB data for savegame_header or empty
+    virtual void save(
+        const std::string& savefilename,
+        const std::string& description,
+        const std::vector<uint8_t>& thumbnail = {}) const;
 
-    static std::string
-    read_description_of_savegame(const std::string& filename);
+    /// get text to show for a savegame in the load menu
+    static std::string describe_savegame(const savegame_header& header);
 
     void compute_max_view_dist(); // fixme - public?
+    void compute_wind();
     virtual void simulate(double delta_t);
 
     const std::list<sink_record>& get_sunken_ships() const
@@ -314,6 +360,10 @@ class game
     virtual double get_depth_factor(const vector3& sub) const;
 
     sea_object* get_player() const { return player; }
+    [[nodiscard]] body_integrator::method get_integration_method() const
+    {
+        return step_integration;
+    }
     sea_object_id get_player_id() const { return player_id; }
 
     double get_last_trail_record_time() const { return last_trail_time; }
@@ -323,6 +373,9 @@ class game
 
     convoy& get_convoy(sea_object_id id);
     sea_object_id get_id(const sea_object&) const; // fixme move to editor later
+    /// get key of any stored object, unlike its address it stays the same
+    /// when the storage moves objects. 0 if the object is not in the game.
+    uint32_t get_object_key(const sea_object& s) const;
 
     // compute visibility data
     // fixme: remove the single functions, they're always called together
@@ -388,6 +441,14 @@ class game
     virtual std::vector<const sea_object*>
     radar_sea_objects(const sea_object* o) const;
 
+    /// get detections of object computed for this step, the result is
+    /// handed out only once. False if there is none.
+    bool take_detection_result(
+        const sea_object* o,
+        std::vector<const sea_object*>& visible,
+        std::vector<const sea_object*>& radar,
+        std::vector<sonar_contact>& sonar);
+
     ///\brief compute sound strengths caused by all ships
     /** @param	listener		object that listens via passive sonar
         @passive	listening_direction	direction for listening
@@ -410,9 +471,13 @@ class game
 
     // when submarine no longer inherits from ship use names spawn() directly
     // and determine via type only.
-    std::pair<const sea_object_id, ship>& spawn_ship(ship&& obj);
-    std::pair<const sea_object_id, submarine>& spawn_submarine(submarine&& obj);
-    std::pair<const sea_object_id, airplane>& spawn_airplane(airplane&& obj);
+    // An id can be given when loading objects, otherwise a new one is used.
+    std::pair<sea_object_id, ship&>
+    spawn_ship(ship&& obj, sea_object_id id = sea_object_id());
+    std::pair<sea_object_id, submarine&>
+    spawn_submarine(submarine&& obj, sea_object_id id = sea_object_id());
+    std::pair<sea_object_id, airplane&>
+    spawn_airplane(airplane&& obj, sea_object_id id = sea_object_id());
 
     torpedo& spawn(torpedo&& obj);
     gun_shell& spawn(gun_shell&& obj);
@@ -421,7 +486,8 @@ class game
     water_splash& spawn(water_splash&& obj);
 
     void spawn(std::unique_ptr<particle>&& p);
-    std::pair<const sea_object_id, convoy>& spawn(convoy&& cv);
+    std::pair<sea_object_id, convoy&>
+    spawn(convoy&& cv, sea_object_id id = sea_object_id());
 
     // simulation events
     void dc_explosion(const depth_charge& dc); // depth charge exploding
@@ -442,8 +508,12 @@ class game
         return pings;
     }; // fixme: maybe vector not list
 
-    /// check if torpedo t hits any ship/sub and in that case spawn events
-    bool check_torpedo_hit(torpedo* t, bool runlengthfailure);
+    /// check if torpedo t hits any ship/sub on its way from oldpos and in
+    /// that case spawn events
+    bool check_torpedo_hit(
+        torpedo* t,
+        const vector3& oldpos,
+        bool runlengthfailure);
 
     sea_object_id
     contact_in_direction(const sea_object* o, const angle& direction) const;
@@ -72,16 +72,13 @@ game_editor::game_editor(const date& start_date)
 
     for (unsigned i = 0; i < 1 /*nr_of_players*/; ++i)
     {
-        xml_doc doc(data_file().get_filename(subtype));
-        doc.load();
-
-        submarine sub(*this, doc.first_child());
+        submarine sub(*this, data_file().get_spec(subtype));
 
         sub.set_skin_layout(model::default_layout);
         sub.init_fill_torpedo_tubes(start_date);
         sub.manipulate_invulnerability(true);
 
-        auto& [id, thesub] = spawn_submarine(std::move(sub));
+        auto [id, thesub] = spawn_submarine(std::move(sub));
         if (i == 0)
         {
             player    = &thesub;
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "geoclipmap.h"
 
 #include "global_data.h"
+#include "profiler.h"
 
 #include <fstream>
 #include <memory>
@@ -146,6 +147,7 @@ geoclipmap::~geoclipmap() = default;
 
 void geoclipmap::set_viewerpos(const vector3& new_viewpos)
 {
+    PROFILE_ZONE("geoclipmap::set_viewerpos");
     // check for a total reset of base_viewpos
     if (new_viewpos.xy().distance(base_viewpos) > 10000.0)
     {
@@ -201,6 +203,7 @@ void geoclipmap::display(
     bool is_mirror,
     int above_water) const
 {
+    PROFILE_ZONE("geoclipmap::display");
     if (wireframe)
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "particle.h"
 #include "ship.h"
 #include "system_interface.h"
+#include "voxel_traversal.h"
 #include "water_splash.h"
 
 #include <utility>
@@ -87,10 +88,10 @@ void gun_shell::save(xml_elem& parent) const
     parent.add_child("damage_amount").set_attr(damage_amount);
 }
 
-void gun_shell::check_collision(game& gm)
+void gun_shell::check_collision(
+    game& gm,
+    const std::vector<const ship*>& candidates)
 {
-    // fixme use bv trees for this: tree/sphere with ray intersection
-
     /* For gun shells we need to check for intersection of a line to all ships.
        The line is determined by the movement of the shell between two
        simulation steps. Let it be b + t * d, where b, d are vectors and d has
@@ -115,14 +116,13 @@ void gun_shell::check_collision(game& gm)
        order of the voxels, without checking every voxel... We know where the
        ray enters the object and thus the entry voxel, from that we can follow
        by raycasting through the voxels without the need to check for
-       intersection between every voxel and the ray. This is maybe more code but
-       it is much more efficient. We need to check for intersection of shell
-       with water surface too. It is sufficient to compute wether the new
-       position is below water surface. That is, get the water height at its xy
-       pos and compare to its z pos. The shells only fall down and start above
-       the water. It may happen then that a shell explodes below the water and
-       not exactly at the surface, but this doesn't matter and is in fact
-       realistic.
+       intersection between every voxel and the ray (see traverse_voxels). We
+       need to check for intersection of shell with water surface too. It is
+       sufficient to compute wether the new position is below water surface.
+       That is, get the water height at its xy pos and compare to its z pos.
+       The shells only fall down and start above the water. It may happen then
+       that a shell explodes below the water and not exactly at the surface,
+       but this doesn't matter and is in fact realistic.
     */
     vector3 dv2 = position - oldpos;
 
@@ -137,9 +137,7 @@ void gun_shell::check_collision(game& gm)
     dvl        = sqrt(dvl);
     vector3 dv = dv2 * (1.0 / dvl);
 
-    auto allships = gm.get_all_ships();
-
-    for (auto s : allships)
+    for (auto s : candidates)
     {
         vector3 k  = s->get_pos() - oldpos;
         double kd  = k * dv;
@@ -176,6 +174,14 @@ void gun_shell::check_collision(game& gm)
         double wh = gm.compute_water_height(position.xy());
         if (position.z < wh)
         {
+            // with long steps the shell can be far below the water, so use
+            // the point where its way crossed the surface.
+            if (oldpos.z > wh)
+            {
+                position = oldpos
+                           + (position - oldpos)
+                                 * ((oldpos.z - wh) / (oldpos.z - position.z));
+            }
             vector3 p  = position;
             position.z = wh;
             gm.spawn(water_splash::gun_shell(gm, p));
@@ -191,151 +197,67 @@ void gun_shell::check_collision_precise(
     const vector3& oldrelpos,
     const vector3& newrelpos)
 {
-    // transform positions to s' local bbox space
-    quaternion qco      = s.get_orientation().conj();
-    vector3f oldrelbbox = vector3f(qco.rotate(oldrelpos));
-    vector3f newrelbbox = vector3f(qco.rotate(newrelpos));
-
-    // now the model::get_min/get_max values can be used to compute the axis
-    // aligned bbox
-    float tmin = 0.0f, tmax = 1.0f;
-
-    // clip the line oldrelbbox->newrelbbox with the bbox
-    vector3f d        = newrelbbox - oldrelbbox;
-    const vector3f& b = oldrelbbox;
-    vector3f bmin     = s.get_model().get_min();
-    vector3f bmax     = s.get_model().get_max();
-
-    if (fabs(d.x) > 1e-5)
-    {
-        float t0 = (bmin.x - b.x) / d.x;
-        float t1 = (bmax.x - b.x) / d.x;
-        float ta = std::min(t0, t1);
-        float tb = std::max(t0, t1);
-
-        tmax = std::min(tmax, tb);
-        tmin = std::max(tmin, ta);
-    }
-    if (fabs(d.y) > 1e-5)
-    {
-        float t0 = (bmin.y - b.y) / d.y;
-        float t1 = (bmax.y - b.y) / d.y;
-        float ta = std::min(t0, t1);
-        float tb = std::max(t0, t1);
-
-        tmax = std::min(tmax, tb);
-        tmin = std::max(tmin, ta);
-    }
-    if (fabs(d.z) > 1e-5)
+    // transform positions to voxel space of s, where voxel (x,y,z) covers
+    // [x,x+1)*[y,y+1)*[z,z+1).
+    const model& mdl         = s.get_model();
+    const quaternion qco     = s.get_orientation().conj();
+    const matrix4f obj2voxel = mdl.get_base_mesh_transformation().inverse();
+    const vector3f voxel_size_rcp  = mdl.get_voxel_size().rcp();
+    const vector3i& vres           = mdl.get_voxel_resolution();
+    const vector3f voxel_pos_trans = vector3f(vres) * 0.5f;
+    auto to_voxel_space            = [&](const vector3& relpos) {
+        return vector3(
+            (obj2voxel * vector3f(qco.rotate(relpos))).coeff_mul(voxel_size_rcp)
+            + voxel_pos_trans);
+    };
+    const vector3 oldvoxpos = to_voxel_space(oldrelpos);
+    const vector3 newvoxpos = to_voxel_space(newrelpos);
+
+    // follow the line through the voxels to the first existing voxel
+    double hit_t = -1.0;
+    traverse_voxels(
+        oldvoxpos, newvoxpos, vres, [&](const vector3i& v, double t) {
+            if (mdl.get_voxel_by_pos(v) == nullptr)
+            {
+                return false;
+            }
+            hit_t = t;
+            return true;
+        });
+    if (hit_t < 0.0)
     {
-        float t0 = (bmin.z - b.z) / d.z;
-        float t1 = (bmax.z - b.z) / d.z;
-        float ta = std::min(t0, t1);
-        float tb = std::max(t0, t1);
-
-        tmax = std::min(tmax, tb);
-        tmin = std::max(tmin, ta);
+        return;
     }
 
-    if (tmin <= tmax)
-    {
-        // log_debug("shell hit object?!");
-        vector3f dd = newrelbbox - oldrelbbox;
-
-        check_collision_voxel(
-            gm, s, oldrelbbox + dd * tmin, oldrelbbox + dd * tmax);
-        if (alive_stat == dead)
-        {
-            return; // no more checks after hit
-        }
+    // we hit a part of the object! Compute exact real world position of
+    // impact, where the line enters the voxel.
+    const vector3f voxpos =
+        (vector3f(oldvoxpos + (newvoxpos - oldvoxpos) * hit_t)
+         - voxel_pos_trans)
+            .coeff_mul(mdl.get_voxel_size());
+    const vector3 impactpos =
+        s.get_pos()
+        + s.get_orientation().rotate(
+            mdl.get_base_mesh_transformation() * voxpos);
+
+    // move gun shell pos to hit position to
+    // let the explosion be at right position
+    position = impactpos;
+    log_debug("Hit object at real world pos " << impactpos);
+
+    // now damage the ship - fixme should be done in class game!
+    // report collision to game!
+    auto& shp = const_cast<ship&>(s);
+    if (shp.damage(impactpos, int(damage_amount), gm))
+    { // fixme, crude
+        gm.ship_sunk(&s);
     }
-}
-
-void gun_shell::check_collision_voxel(
-    game& gm,
-    const ship& s,
-    const vector3f& oldrelpos,
-    const vector3f& newrelpos)
-{
-    // positions are relative to bbox of s.
-    matrix4f obj2voxel = s.get_model().get_base_mesh_transformation().inverse();
-
-    vector3f oldvoxpos = obj2voxel * oldrelpos,
-             newvoxpos = obj2voxel * newrelpos;
-
-    vector3f diffvoxpos = newvoxpos - oldvoxpos;
-
-    // now iterate in 8 steps between oldvoxpos to newvoxpos,
-    // transform both to voxel coordinates (0...N)
-    // and determine voxel number by pos.
-    // if coordinate is invalid, no hit, otherwise check voxel state (volume >
-    // 0.25 or similar) if the voxel is filled.
-    vector3f voxel_size_rcp = s.get_model().get_voxel_size().rcp();
-    const vector3i& vres    = s.get_model().get_voxel_resolution();
-
-    vector3i vidxmax         = vres - vector3i(1, 1, 1);
-    vector3f voxel_pos_trans = vector3f(vres) * 0.5f;
-    int lastvn               = -1;
-
-    log_debug("check collision voxel");
-
-    for (unsigned k = 0; k <= 10; ++k)
+    else
     {
-        float kf        = k / 10.0f;
-        vector3f voxpos = oldvoxpos + diffvoxpos * kf;
-        vector3i v =
-            vector3i(voxpos.coeff_mul(voxel_size_rcp) + voxel_pos_trans);
-        v = v.max(vector3i(0, 0, 0)).min(vidxmax);
-
-        int vn = (v.z * vres.y + v.y) * vres.x + v.x;
-
-        if (vn != lastvn)
-        {
-            lastvn = vn;
-            log_debug(
-                "voxel hit k=" << k << " voxpos=" << voxpos << " v=" << v
-                               << " vn=" << vn);
-            const model::voxel* vox = s.get_model().get_voxel_by_pos(v);
-            if (vox)
-            {
-                // we hit a part of the object!
-                log_debug("..... Object hit! .....");
-
-                // first compute exact real word position of impact
-                vector3 impactpos =
-                    s.get_pos()
-                    + s.get_orientation().rotate(
-                        s.get_model().get_base_mesh_transformation() * voxpos);
-
-                // move gun shell pos to hit position to
-                // let the explosion be at right position
-                position = impactpos;
-                log_debug("Hit object at real world pos " << impactpos);
-                log_debug("that is relative: " << s.get_pos() - impactpos);
-
-                // now damage the ship - fixme should be done in class game!
-                // report collision to game!
-                auto& shp = const_cast<ship&>(s);
-                if (shp.damage(impactpos, int(damage_amount), gm))
-                { // fixme, crude
-                    gm.ship_sunk(&s);
-                }
-                else
-                {
-                    shp.ignite(gm);
-                }
-#if 0
-				//spawn some location marker object for testing
-				//at exact impact position
-				gm.spawn_particle(new marker_particle(impactpos));
-#endif
-                gm.add_event(
-                    std::make_unique<event_shell_explosion>(get_pos()));
-                kill(); // grenade is used and dead
-                return; // no more checks
-            }
-        }
+        shp.ignite(gm);
     }
+    gm.add_event(std::make_unique<event_shell_explosion>(get_pos()));
+    kill(); // grenade is used and dead
 }
 
 void gun_shell::simulate(double delta_time, game& gm)
@@ -345,7 +267,8 @@ void gun_shell::simulate(double delta_time, game& gm)
         return;
     }
 
-    check_collision(gm);
+    // collisions are checked for all shells at once by the game, see
+    // game::check_gun_shell_collisions
     oldpos = position;
     sea_object::simulate(delta_time, gm);
 }
@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "sea_object.h"
+
+#include <vector>
 class ship;
 
 #define AIR_RESISTANCE 0.05 // factor of velocity that gets subtracted
@@ -46,6 +48,7 @@ class gun_shell : public sea_object
     void load(const xml_elem& parent) override;
     void save(xml_elem& parent) const override;
     [[nodiscard]] auto get_caliber() const { return caliber; }
+    [[nodiscard]] const vector3& get_old_pos() const { return oldpos; }
 
     void simulate(double delta_time, game& gm) override;
     virtual void display() const;
@@ -54,20 +57,19 @@ class gun_shell : public sea_object
     // acceleration is only gravity and already handled by sea_object
     [[nodiscard]] virtual double damage() const { return damage_amount; }
 
+    /// check if shell hits one of the candidates or the water on its way
+    /// since last step and handle the hit.
+    void
+    check_collision(game& gm, const std::vector<const ship*>& candidates);
+
   protected:
     vector3 oldpos; // position at last iteration (for collision detection)
     double damage_amount{0};
     double caliber{0};
 
-    void check_collision(game& gm);
     void check_collision_precise(
         game& gm,
         const ship& s,
         const vector3& oldrelpos,
         const vector3& newrelpos);
-    void check_collision_voxel(
-        game& gm,
-        const ship& s,
-        const vector3f& oldrelpos,
-        const vector3f& newrelpos);
 };
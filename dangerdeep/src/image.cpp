@@ -113,3 +113,13 @@ void image::draw(int x, int y, const colorf& col) const
         yp += h;
     }
 }
+
+auto image::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = 0;
+    for (const auto& t : textures)
+    {
+        bytes += t->get_memory_used();
+    }
+    return bytes;
+}
@@ -51,4 +51,6 @@ class image
 
     [[nodiscard]] unsigned get_width() const { return width; };
     [[nodiscard]] unsigned get_height() const { return height; };
+    /// get video memory used by image in bytes
+    [[nodiscard]] std::size_t get_memory_used() const;
 };
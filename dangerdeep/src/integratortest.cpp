@@ -0,0 +1,272 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// rigid body integrator accuracy test
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "body_integrator.h"
+#include "mymain.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::vector;
+
+namespace
+{
+const double water_density = 1025.0;
+const double g             = 9.81;
+
+/// simplified dynamics of a surface ship or a torpedo, similar in their
+/// stiffness to what ship::compute_force_and_torque gives.
+struct test_body
+{
+    std::string name;
+    double mass;
+    vector3 size; // width, length, height
+    double max_speed;
+    double max_accel;
+    double heave_stiffness; ///< N per m of depth error
+    double roll_stiffness;  ///< Nm per radian
+    double pitch_stiffness; ///< Nm per radian
+    double rudder_factor;   ///< yaw torque per (m/s)^2
+    double target_depth;
+    double turn_time; ///< rudder is put over at that time
+    double duration;
+    /// allowed position error per method with its longest step the game
+    /// uses (body_integrator::max_step_time), in meters. Measured values with
+    /// some margin, so changes that make an integrator less accurate are
+    /// found.
+    double max_error[3];
+
+    [[nodiscard]] matrix3 inertia_tensor() const
+    {
+        const double w2 = size.x * size.x, l2 = size.y * size.y,
+                     h2 = size.z * size.z;
+        return matrix3(
+            mass * (l2 + h2) / 12.0,
+            0,
+            0,
+            0,
+            mass * (w2 + h2) / 12.0,
+            0,
+            0,
+            0,
+            mass * (w2 + l2) / 12.0);
+    }
+
+    [[nodiscard]] body_integrator::state start_state() const
+    {
+        body_integrator::state s;
+        s.position = vector3(0, 0, target_depth + 0.5);
+        // slightly rolled, so the roll motion is tested as well
+        s.orientation     = quaternion::rot(3.0, 0, 1, 0);
+        s.linear_momentum = vector3(0, max_speed * 0.25 * mass, 0);
+        return s;
+    }
+
+    void compute_force(
+        const body_integrator& bi,
+        double t,
+        const body_integrator::state& s,
+        vector3& force,
+        vector3& torque) const
+    {
+        const quaternion& q  = s.orientation;
+        const quaternion qc  = q.conj();
+        const vector3 v      = qc.rotate(s.linear_momentum * (1.0 / mass));
+        const vector3 w      = qc.rotate(bi.angular_velocity(s));
+        const vector3 up     = qc.rotate(vector3(0, 0, 1));
+        const double drag_fw = max_accel * mass / (max_speed * max_speed);
+        // local force: thrust and drag, strong side drag
+        vector3 f(
+            -drag_fw * 50.0 * v.x * fabs(v.x) - mass * 0.5 * v.x,
+            max_accel * mass - drag_fw * v.y * fabs(v.y),
+            0);
+        // local torque: roll/pitch back to upright, rudder, damping
+        const double rudder = (t >= turn_time) ? 1.0 : 0.0;
+        vector3 tq(
+            -up.y * pitch_stiffness,
+            up.x * roll_stiffness,
+            -rudder * rudder_factor * v.y * fabs(v.y));
+        const matrix3 it = inertia_tensor();
+        tq -= vector3(
+            w.x * 0.4 * sqrt(pitch_stiffness * it.elemarray()[0]),
+            w.y * 0.2 * sqrt(roll_stiffness * it.elemarray()[4]),
+            w.z * 2.0 * it.elemarray()[8] * (0.1 + fabs(v.y) / size.y));
+        force  = q.rotate(f);
+        torque = q.rotate(tq);
+        // buoyancy and depth keeping, world space
+        const double vz = s.linear_momentum.z / mass;
+        force.z += -heave_stiffness * (s.position.z - target_depth)
+                   - 0.4 * sqrt(heave_stiffness * mass) * vz;
+    }
+};
+
+test_body make_ship()
+{
+    test_body b;
+    b.name            = "ship";
+    b.mass            = 5e6;
+    b.size            = vector3(16, 120, 10);
+    b.max_speed       = 8.0;
+    b.max_accel       = 0.1;
+    b.heave_stiffness = water_density * g * b.size.x * b.size.y * 0.7;
+    b.roll_stiffness  = b.mass * g * 1.0;   // metacentric height 1m
+    b.pitch_stiffness = b.mass * g * 100.0; // longitudinal 100m
+    b.rudder_factor   = b.mass * 0.5;
+    b.target_depth    = 0.0;
+    b.turn_time       = 60.0;
+    b.duration        = 300.0;
+    // measured: euler 5.05m, symplectic_euler 10.3m, rk4 4e-3m
+    b.max_error[body_integrator::euler]            = 6.0;
+    b.max_error[body_integrator::symplectic_euler] = 12.0;
+    b.max_error[body_integrator::rk4]              = 0.01;
+    return b;
+}
+
+test_body make_torpedo()
+{
+    test_body b;
+    b.name            = "torpedo";
+    b.mass            = 1500.0;
+    b.size            = vector3(0.53, 7.0, 0.53);
+    b.max_speed       = 20.0;
+    b.max_accel       = 2.0;
+    b.heave_stiffness = b.mass * 0.5;
+    b.roll_stiffness  = b.mass * g * 0.05;
+    b.pitch_stiffness = b.mass * g * 0.2;
+    b.rudder_factor   = b.mass * 0.02;
+    b.target_depth    = -5.0;
+    b.turn_time       = 10.0;
+    b.duration        = 60.0;
+    // measured: euler 161m, symplectic_euler 13.4m, rk4 1.26m. Euler is much
+    // too inaccurate for the stiff torpedo, but it is the original method.
+    b.max_error[body_integrator::euler]            = 200.0;
+    b.max_error[body_integrator::symplectic_euler] = 16.0;
+    b.max_error[body_integrator::rk4]              = 1.5;
+    return b;
+}
+
+/// simulate body, return positions at every full second
+vector<vector3> simulate(
+    const test_body& b,
+    body_integrator::method m,
+    double delta_time,
+    unsigned* force_evaluations = nullptr)
+{
+    const matrix3 it = b.inertia_tensor();
+    body_integrator bi(1.0 / b.mass, it.inverse());
+    auto s = b.start_state();
+    vector<vector3> result(1, s.position);
+    const auto steps_per_second = unsigned(std::lround(1.0 / delta_time));
+    for (unsigned sec = 0; sec < unsigned(b.duration); ++sec)
+    {
+        for (unsigned i = 0; i < steps_per_second; ++i)
+        {
+            const double t = sec + i * delta_time;
+            s = bi.step(
+                m,
+                s,
+                delta_time,
+                [&](const body_integrator::state& st, vector3& f, vector3& tq) {
+                    b.compute_force(bi, t, st, f, tq);
+                    if (force_evaluations != nullptr)
+                    {
+                        ++*force_evaluations;
+                    }
+                });
+        }
+        result.push_back(s.position);
+    }
+    return result;
+}
+
+double max_error(const vector<vector3>& a, const vector<vector3>& b)
+{
+    double e = 0;
+    for (unsigned i = 0; i < a.size(); ++i)
+    {
+        e = std::max(e, a[i].distance(b[i]));
+    }
+    return e;
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    const vector<body_integrator::method> methods = {
+        body_integrator::euler,
+        body_integrator::symplectic_euler,
+        body_integrator::rk4};
+    const vector<unsigned> steps_per_second = {100, 20, 10, 5, 4, 2, 1};
+    bool ok                                 = true;
+    for (const auto& b : {make_ship(), make_torpedo()})
+    {
+        std::cout << b.name << ", " << b.duration
+                  << "s maneuver, max. position error against rk4 with 1ms "
+                     "steps:\n";
+        const auto reference = simulate(b, body_integrator::rk4, 0.001);
+        for (auto m : methods)
+        {
+            std::cout << "  " << body_integrator::name_of_method(m) << ":";
+            for (auto sps : steps_per_second)
+            {
+                const auto path = simulate(b, m, 1.0 / sps);
+                const double e  = max_error(path, reference);
+                std::cout << " " << sps << "Hz ";
+                if (std::isfinite(e) && e < 1e6)
+                {
+                    std::cout << e << "m";
+                }
+                else
+                {
+                    std::cout << "unstable";
+                }
+            }
+            std::cout << "\n";
+        }
+        // check accuracy with the longest step used by the game and show
+        // how many steps and force evaluations a game second needs.
+        std::cout << "  with longest game step:\n";
+        for (auto m : methods)
+        {
+            const double max_dt  = body_integrator::max_step_time(m);
+            unsigned evaluations = 0;
+            const double e =
+                max_error(simulate(b, m, max_dt, &evaluations), reference);
+            std::cout << "    " << body_integrator::name_of_method(m) << ": "
+                      << max_dt << "s, " << std::lround(1.0 / max_dt)
+                      << " steps and " << evaluations / b.duration
+                      << " force evaluations per second, error " << e
+                      << "m\n";
+            if (!(e <= b.max_error[m]))
+            {
+                std::cout << "ERROR: " << body_integrator::name_of_method(m)
+                          << " with " << max_dt << "s steps has error " << e
+                          << "m, allowed are " << b.max_error[m] << "m\n";
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : -1;
+}
@@ -20,131 +20,493 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 //  A logging implementation
 //
-
 #include "log.h"
 
-#include "error.h"
-
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <stdexcept>
 #include <string>
 #include <unordered_map>
-#include <vector>
 
-struct log_msg
+namespace
 {
+using clock_type = std::chrono::steady_clock;
+
+/// header of a binary record, followed by the argument data
+struct record_header
+{
+    uint64_t time;          ///< nanoseconds since creation of the log
+    const log::site* where; ///< source position
+    uint32_t thread;        ///< index of thread
+    uint32_t size;          ///< size of argument data
     log::level lvl;
-    std::thread::id tid;
-    uint32_t time;
-    std::string msg;
+};
 
-    log_msg(log::level l, std::string m) :
-        lvl(l), tid(std::this_thread::get_id()),
-        time(std::chrono::duration_cast<std::chrono::milliseconds>(
-                 std::chrono::system_clock::now().time_since_epoch())
-                 .count()),
-        msg(std::move(m))
+/// size of ring buffer per thread, must be a power of two
+const std::size_t ring_size = 256 * 1024;
+
+/// records of one thread, written by it and read by the writer thread
+struct thread_ring
+{
+    std::vector<uint8_t> data;
+    std::atomic<uint64_t> head{0};   ///< bytes written, changed by owner only
+    std::atomic<uint64_t> tail{0};   ///< bytes read, changed by reader only
+    std::atomic<bool> closed{false}; ///< owning thread has exited
+    const uint32_t thread;
+
+    thread_ring(uint32_t t) : data(ring_size), thread(t) { }
+
+    [[nodiscard]] std::size_t free_space() const
     {
+        return ring_size
+               - std::size_t(
+                   head.load(std::memory_order_relaxed)
+                   - tail.load(std::memory_order_acquire));
     }
 
-    [[nodiscard]] auto pretty_print() const -> std::string
+    void write(uint64_t pos, const uint8_t* src, std::size_t size)
     {
-        std::ostringstream oss;
-        switch (lvl)
-        {
-            case log::level::WARNING:
-                oss << "\033[1;31m";
-                break;
-            case log::level::INFO:
-                oss << "\033[1;34m";
-                break;
-            case log::level::SYSINFO:
-                oss << "\033[1;33m";
-                break;
-            case log::level::DEBUGGING:
-                oss << "\033[1;32m";
-                break;
-            default:
-                oss << "\033[0m";
-        }
-        oss << "[" << log::instance().get_thread_name(tid) << "] <" << std::dec
-            << time << "> " << msg << "\033[0m";
-        return oss.str();
+        const std::size_t p     = std::size_t(pos & (ring_size - 1));
+        const std::size_t first = std::min(size, ring_size - p);
+        std::memcpy(&data[p], src, first);
+        std::memcpy(&data[0], src + first, size - first);
     }
 
-    [[nodiscard]] auto pretty_print_console() const -> std::string
+    void read(uint64_t pos, uint8_t* dst, std::size_t size) const
     {
-        std::ostringstream oss;
-        switch (lvl)
+        const std::size_t p     = std::size_t(pos & (ring_size - 1));
+        const std::size_t first = std::min(size, ring_size - p);
+        std::memcpy(dst, &data[p], first);
+        std::memcpy(dst + first, &data[0], size - first);
+    }
+};
+
+/// counts created logs, so threads notice that their ring is outdated
+std::atomic<unsigned> log_generation{0};
+
+/// log state of a thread
+struct thread_state
+{
+    std::shared_ptr<thread_ring> ring;
+    unsigned generation{0};
+    std::vector<uint8_t> buffer; ///< record that is built
+    ~thread_state()
+    {
+        if (ring)
         {
-            case log::level::WARNING:
-                oss << "$ff8080";
-                break;
-            case log::level::INFO:
-                oss << "$c0c0ff";
-                break;
-            case log::level::SYSINFO:
-                oss << "$ffff00";
-                break;
-            case log::level::DEBUGGING:
-                oss << "$b0ffb0";
-                break;
-            default:
-                oss << "$c0c0c0";
+            ring->closed.store(true, std::memory_order_release);
         }
-        oss << "[" << log::instance().get_thread_name(tid) << "] <" << std::dec
-            << time << "> " << msg;
-        return oss.str();
     }
 };
 
+thread_local thread_state this_thread_state;
+
+auto get_header(const uint8_t* record) -> record_header
+{
+    record_header h;
+    std::memcpy(&h, record, sizeof(h));
+    return h;
+}
+
+void write_string(std::ostream& out, const std::string& s)
+{
+    const auto len = uint32_t(s.size());
+    out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.write(s.data(), len);
+}
+} // namespace
+
 class log_internal
 {
   public:
-    std::mutex mtx;
-    std::vector<log_msg> loglines;
-    std::unordered_map<std::thread::id, const char*> threadnames;
-    log_internal() = default;
+    const unsigned generation;
+    const clock_type::time_point start_time;
+    const uint64_t start_time_ms; ///< since epoch
+
+    std::mutex rings_mutex; ///< for rings and thread names
+    std::vector<std::shared_ptr<thread_ring>> rings;
+    std::vector<std::string> thread_names;
+
+    mutable std::mutex mtx; ///< for all data below, only holder drains
+    std::vector<uint8_t> records;     ///< all records collected so far
+    std::vector<std::size_t> offsets; ///< start of each record
+    std::ofstream binary_out;
+    std::unordered_map<const log::site*, uint32_t> sites_written;
+    std::vector<std::string> thread_names_written;
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_cond;
+    bool stop{false};
+    std::thread writer;
+
+    log_internal() :
+        generation(++log_generation), start_time(clock_type::now()),
+        start_time_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count())
+    {
+    }
+
+    /// get ring of calling thread, create it on first use
+    thread_ring& get_ring()
+    {
+        auto& ts = this_thread_state;
+        if (!ts.ring || ts.generation != generation)
+        {
+            std::unique_lock<std::mutex> ml(rings_mutex);
+            ts.ring =
+                std::make_shared<thread_ring>(uint32_t(thread_names.size()));
+            ts.generation = generation;
+            thread_names.emplace_back("unnamed");
+            rings.push_back(ts.ring);
+        }
+        return *ts.ring;
+    }
+
+    [[nodiscard]] std::string get_thread_name(uint32_t thread)
+    {
+        std::unique_lock<std::mutex> ml(rings_mutex);
+        return thread_names[thread];
+    }
+
+    void drain();
+    void write_binary(std::size_t first_record);
+    void write_text(
+        std::ostream& out,
+        const uint8_t* record,
+        bool console_colors);
+
+    void run_writer()
+    {
+        std::unique_lock<std::mutex> wl(writer_mutex);
+        while (!stop)
+        {
+            writer_cond.wait_for(wl, std::chrono::milliseconds(20));
+            wl.unlock();
+            {
+                std::unique_lock<std::mutex> ml(mtx);
+                drain();
+            }
+            wl.lock();
+        }
+    }
 };
 
-log::log()
+namespace
+{
+/// log that is written on fatal errors
+std::atomic<log_internal*> current_log{nullptr};
+std::terminate_handler previous_terminate_handler{nullptr};
+
+/// write records that are still in the rings when the program terminates
+/// because of an uncaught exception. The failing thread may hold the log
+/// lock, then nothing is written. This is not done for signals like SIGSEGV,
+/// as writing the log is not async-signal-safe, and they are left to the
+/// handler of faulthandler.h.
+void flush_current_log()
+{
+    log_internal* li = current_log.load();
+    if (li == nullptr || !li->mtx.try_lock())
+    {
+        return;
+    }
+    li->drain();
+    li->mtx.unlock();
+    std::cout.flush();
+}
+
+void terminate_handler()
+{
+    flush_current_log();
+    if (previous_terminate_handler != nullptr)
+    {
+        previous_terminate_handler();
+    }
+    std::abort();
+}
+} // namespace
+
+/// collect records of all threads, must be called with mtx locked
+void log_internal::drain()
+{
+    std::vector<std::shared_ptr<thread_ring>> current;
+    {
+        std::unique_lock<std::mutex> ml(rings_mutex);
+        current = rings;
+    }
+    const std::size_t first = offsets.size();
+    bool rings_closed       = false;
+    for (auto& r : current)
+    {
+        // if it is closed now, no records follow
+        const bool closed   = r->closed.load(std::memory_order_acquire);
+        uint64_t tail       = r->tail.load(std::memory_order_relaxed);
+        const uint64_t head = r->head.load(std::memory_order_acquire);
+        while (tail < head)
+        {
+            uint8_t hb[sizeof(record_header)];
+            r->read(tail, hb, sizeof(hb));
+            const auto size = sizeof(hb) + get_header(hb).size;
+            offsets.push_back(records.size());
+            records.resize(records.size() + size);
+            r->read(tail, &records[offsets.back()], size);
+            tail += size;
+        }
+        r->tail.store(tail, std::memory_order_release);
+        rings_closed = rings_closed || closed;
+    }
+    if (rings_closed)
+    {
+        std::unique_lock<std::mutex> ml(rings_mutex);
+        rings.erase(
+            std::remove_if(
+                rings.begin(),
+                rings.end(),
+                [](const auto& r) {
+                    return r->closed.load(std::memory_order_acquire)
+                           && r->tail == r->head;
+                }),
+            rings.end());
+    }
+    // records of different threads are sorted by time
+    std::stable_sort(
+        offsets.begin() + first,
+        offsets.end(),
+        [this](std::size_t a, std::size_t b) {
+            return get_header(&records[a]).time < get_header(&records[b]).time;
+        });
+    if (log::copy_output_to_console)
+    {
+        for (std::size_t i = first; i < offsets.size(); ++i)
+        {
+            write_text(std::cout, &records[offsets[i]], true);
+            std::cout << std::endl;
+        }
+    }
+    if (binary_out.is_open() && first < offsets.size())
+    {
+        write_binary(first);
+    }
+}
+
+/// write records to binary file, with positions and thread names they use
+void log_internal::write_binary(std::size_t first_record)
 {
-    mylogint                                          = new log_internal();
-    mylogint->threadnames[std::this_thread::get_id()] = "__main__";
+    for (std::size_t i = first_record; i < offsets.size(); ++i)
+    {
+        const uint8_t* rec = &records[offsets[i]];
+        const auto h       = get_header(rec);
+        auto it            = sites_written.find(h.where);
+        if (it == sites_written.end())
+        {
+            const auto id = uint32_t(sites_written.size());
+            it            = sites_written.emplace(h.where, id).first;
+            binary_out.put('S');
+            binary_out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+            const uint32_t line = h.where->line;
+            binary_out.write(reinterpret_cast<const char*>(&line), 4);
+            write_string(binary_out, h.where->file ? h.where->file : "");
+        }
+        const auto name = get_thread_name(h.thread);
+        if (thread_names_written.size() <= h.thread)
+        {
+            thread_names_written.resize(h.thread + 1);
+        }
+        if (thread_names_written[h.thread] != name)
+        {
+            thread_names_written[h.thread] = name;
+            binary_out.put('T');
+            binary_out.write(
+                reinterpret_cast<const char*>(&h.thread), sizeof(h.thread));
+            write_string(binary_out, name);
+        }
+        binary_out.put('R');
+        binary_out.write(reinterpret_cast<const char*>(&h.time), 8);
+        binary_out.write(reinterpret_cast<const char*>(&h.thread), 4);
+        binary_out.write(reinterpret_cast<const char*>(&it->second), 4);
+        binary_out.put(char(h.lvl));
+        binary_out.write(reinterpret_cast<const char*>(&h.size), 4);
+        binary_out.write(
+            reinterpret_cast<const char*>(rec + sizeof(h)), h.size);
+    }
+    binary_out.flush();
+}
+
+/// write a record as text line
+void log_internal::write_text(
+    std::ostream& out,
+    const uint8_t* record,
+    bool console_colors)
+{
+    const auto h = get_header(record);
+    static const char* color_codes[] = {
+        "\033[1;31m", "\033[1;34m", "\033[1;33m", "\033[1;32m", "\033[0m"};
+    static const char* console_color_codes[] = {
+        "$ff8080", "$c0c0ff", "$ffff00", "$b0ffb0", "$c0c0c0"};
+    const auto l = std::min(unsigned(h.lvl), unsigned(log::level::NR_LEVELS));
+    out << (console_colors ? console_color_codes[l] : color_codes[l]) << "["
+        << get_thread_name(h.thread) << "] <" << std::dec
+        << uint32_t(start_time_ms + h.time / 1000000) << "> ";
+    if (h.where->file != nullptr)
+    {
+        out << h.where->file << ":" << h.where->line << " ";
+    }
+    log::format_arguments(out, record + sizeof(h), h.size);
+    if (!console_colors)
+    {
+        out << "\033[0m";
+    }
 }
 
 bool log::copy_output_to_console = false;
 
-void log::append(log::level l, const std::string& msg)
+log::log()
 {
-    std::unique_lock<std::mutex> ml(mylogint->mtx);
-    mylogint->loglines.emplace_back(l, msg);
+    mylogint = new log_internal();
+    mylogint->thread_names[mylogint->get_ring().thread] = "__main__";
+    mylogint->writer = std::thread([this]() { mylogint->run_writer(); });
+    // records in the rings are written on uncaught exceptions as well
+    current_log                = mylogint;
+    previous_terminate_handler = std::set_terminate(terminate_handler);
+}
+
+log::~log()
+{
+    std::set_terminate(previous_terminate_handler);
+    current_log = nullptr;
+    {
+        std::unique_lock<std::mutex> wl(mylogint->writer_mutex);
+        mylogint->stop = true;
+    }
+    mylogint->writer_cond.notify_all();
+    mylogint->writer.join();
+    {
+        // last records go to the binary file
+        std::unique_lock<std::mutex> ml(mylogint->mtx);
+        mylogint->drain();
+    }
+    delete mylogint;
+}
+
+log::record::record(level l, const site& s) :
+    mylog(log::instance()), data(this_thread_state.buffer)
+{
+    record_header h;
+    h.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 clock_type::now() - mylog.mylogint->start_time)
+                 .count();
+    h.where  = &s;
+    h.thread = 0;
+    h.size   = 0;
+    h.lvl    = l;
+    data.resize(sizeof(h));
+    std::memcpy(&data[0], &h, sizeof(h));
+}
+
+log::record::~record()
+{
+    mylog.commit(data);
+}
+
+void log::record::put_string(std::string_view s)
+{
+    const auto sz  = data.size();
+    const auto len = uint32_t(s.size());
+    data.resize(sz + 1 + sizeof(len) + len);
+    data[sz] = arg_string;
+    std::memcpy(&data[sz + 1], &len, sizeof(len));
+    std::memcpy(&data[sz + 1 + sizeof(len)], s.data(), len);
+}
+
+void log::commit(std::vector<uint8_t>& data)
+{
+    auto& ring = mylogint->get_ring();
+    auto h     = get_header(&data[0]);
+    h.thread   = ring.thread;
+    h.size     = uint32_t(data.size() - sizeof(h));
+    if (data.size() > ring_size / 4)
+    {
+        // too large for ring, keep only a note
+        record r(h.lvl, *h.where);
+        r << "(message too long: " << h.size << " bytes)";
+        return;
+    }
+    std::memcpy(&data[0], &h, sizeof(h));
+    // wait for the writer if the ring is full
+    while (ring.free_space() < data.size())
+    {
+        mylogint->writer_cond.notify_one();
+        std::this_thread::yield();
+    }
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.write(head, &data[0], data.size());
+    ring.head.store(head + data.size(), std::memory_order_release);
     if (copy_output_to_console)
     {
-        std::cout << mylogint->loglines.back().pretty_print() << std::endl;
+        // console output is wanted at once, not by the writer thread
+        std::unique_lock<std::mutex> ml(mylogint->mtx);
+        mylogint->drain();
     }
 }
 
+void log::append(log::level l, const std::string& msg)
+{
+    static const site no_site{nullptr, 0};
+    record r(l, no_site);
+    r << msg;
+}
+
 void log::write(std::ostream& out, log::level limit_level) const
 {
-    // process log_msg and make ANSI colored text lines of it
+    // process records and make ANSI colored text lines of them
     std::unique_lock<std::mutex> ml(mylogint->mtx);
-    for (const auto& logmsg : mylogint->loglines)
+    mylogint->drain();
+    for (auto offset : mylogint->offsets)
     {
-        if (logmsg.lvl <= limit_level)
+        const uint8_t* rec = &mylogint->records[offset];
+        if (get_header(rec).lvl <= limit_level)
         {
-            out << logmsg.pretty_print() << std::endl;
+            mylogint->write_text(out, rec, false);
+            out << std::endl;
         }
     }
 }
 
+void log::open_binary_file(const std::string& filename)
+{
+    {
+        std::unique_lock<std::mutex> ml(mylogint->mtx);
+        mylogint->drain();
+        auto& out = mylogint->binary_out;
+        out.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+        if (out.good())
+        {
+            out.write("DFTDLOG1", 8);
+            out.write(
+                reinterpret_cast<const char*>(&mylogint->start_time_ms),
+                sizeof(mylogint->start_time_ms));
+            mylogint->sites_written.clear();
+            mylogint->thread_names_written.clear();
+            mylogint->write_binary(0);
+            return;
+        }
+    }
+    // not while holding the lock, logging may wait for the writer
+    log_warning("can't open binary log file " << filename);
+}
+
 auto log::get_last_n_lines(unsigned n) const -> std::string
 {
     std::string result;
     std::unique_lock<std::mutex> ml(mylogint->mtx);
-    auto l = unsigned(mylogint->loglines.size());
+    mylogint->drain();
+    auto l = unsigned(mylogint->offsets.size());
     if (n > l)
     {
         for (unsigned k = 0; k < n - l; ++k)
@@ -153,23 +515,22 @@ auto log::get_last_n_lines(unsigned n) const -> std::string
         }
         n = l;
     }
-    auto it = mylogint->loglines.end();
-    for (; n > 0; --n)
+    std::ostringstream oss;
+    for (unsigned i = l - n; i < l; ++i)
     {
-        --it;
+        mylogint->write_text(
+            oss, &mylogint->records[mylogint->offsets[i]], true);
+        oss << "\n";
     }
-    for (; it != mylogint->loglines.end(); ++it)
-    {
-        result += it->pretty_print_console() + "\n";
-    }
-    return result;
+    return result + oss.str();
 }
 
 void log::new_thread(const char* name)
 {
     {
-        std::unique_lock<std::mutex> ml(mylogint->mtx);
-        mylogint->threadnames[std::this_thread::get_id()] = name;
+        auto& ring = mylogint->get_ring();
+        std::unique_lock<std::mutex> ml(mylogint->rings_mutex);
+        mylogint->thread_names[ring.thread] = name;
     }
     log_sysinfo("---------- < NEW > THREAD ----------");
 }
@@ -177,23 +538,79 @@ void log::new_thread(const char* name)
 void log::end_thread()
 {
     log_sysinfo("---------- > END < THREAD ----------");
-    std::unique_lock<std::mutex> ml(mylogint->mtx);
-    /* Do not remove entry so it can be written to log file after the thread has
-     * died (and message is still in buffer). It should never get very big... */
-    //	mylogint->threadnames.erase(std::this_thread::get_id());
+    // the ring of the thread is removed when it is empty after thread exit,
+    // the thread name is kept for the records.
 }
 
-auto log::get_thread_name() const -> const char*
+void log::format_arguments(
+    std::ostream& out,
+    const uint8_t* data,
+    std::size_t size)
 {
-    return get_thread_name(std::this_thread::get_id());
-}
-
-auto log::get_thread_name(std::thread::id tid) const -> const char*
-{
-    auto it = mylogint->threadnames.find(tid);
-    if (it == mylogint->threadnames.end())
+    const uint8_t* end = data + size;
+    auto get           = [&](auto& value) {
+        std::memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+    };
+    while (data < end)
     {
-        THROW(error, "no thread name registered for thread! BUG!");
+        const uint8_t tag = *data++;
+        switch (tag)
+        {
+            case arg_bool:
+            {
+                uint8_t v;
+                get(v);
+                out << bool(v);
+                break;
+            }
+            case arg_char:
+            {
+                char v;
+                get(v);
+                out << v;
+                break;
+            }
+            case arg_int:
+            {
+                int64_t v;
+                get(v);
+                out << v;
+                break;
+            }
+            case arg_uint:
+            {
+                uint64_t v;
+                get(v);
+                out << v;
+                break;
+            }
+            case arg_double:
+            {
+                double v;
+                get(v);
+                out << v;
+                break;
+            }
+            case arg_string:
+            {
+                uint32_t len;
+                get(len);
+                out.write(reinterpret_cast<const char*>(data), len);
+                data += len;
+                break;
+            }
+            case arg_pointer:
+            {
+                uint64_t v;
+                get(v);
+                out << reinterpret_cast<const void*>(uintptr_t(v));
+                break;
+            }
+            default:
+                // corrupt data
+                out << "(?)";
+                return;
+        }
     }
-    return it->second;
 }
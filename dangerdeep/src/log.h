@@ -25,16 +25,22 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "singleton.h"
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #ifdef DEBUG
 #define log_template(x, y)                                                     \
     do                                                                         \
     {                                                                          \
-        std::ostringstream oss;                                                \
-        oss << __FILE__ << ":" << __LINE__ << " " << x;                        \
-        log::instance().append(log::y, oss.str());                             \
+        static constexpr log::site log_site{__FILE__, __LINE__};               \
+        log::record log_rec(log::y, log_site);                                 \
+        log_rec << x;                                                          \
     } while (0)
 #define log_debug(x) log_template(x, level::DEBUGGING)
 #define log_info(x)  log_template(x, level::INFO)
@@ -61,13 +67,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 
 /// manager class for a global threadsafe log
+/** Log messages are stored as binary records (time, thread, level, source
+    position and arguments) in a ring buffer per thread without locking. A
+    writer thread collects the records in the background. Text is only made
+    when the log is written, or by the logdump tool for binary log files.
+*/
 class log : public singleton<class log>
 {
     friend class singleton<log>;
 
   public:
     /// level of log message, in descending importance.
-    enum class level
+    enum class level : uint8_t
     {
         WARNING,
         INFO,
@@ -76,15 +87,111 @@ class log : public singleton<class log>
         NR_LEVELS
     };
 
+    /// source position of a log message, one static object per log call
+    struct site
+    {
+        const char* file;
+        unsigned line;
+    };
+
+    ///\brief Collects the arguments of a log message as binary values.
+    /** Arguments are given with operator<< like for streams. Numbers and
+        strings are stored binary and formatted later, other types are
+        formatted at once. The record is passed to the log on destruction.
+    */
+    class record
+    {
+      public:
+        record(level l, const site& s);
+        ~record();
+        record(const record&) = delete;
+        record& operator=(const record&) = delete;
+
+        template<typename T>
+        record& operator<<(const T& value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                put(arg_bool, uint8_t(value));
+            }
+            else if constexpr (
+                std::is_same_v<T, char> || std::is_same_v<T, signed char>
+                || std::is_same_v<T, unsigned char>)
+            {
+                put(arg_char, char(value));
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                put(arg_int, int64_t(value));
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                put(arg_uint, uint64_t(value));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                put(arg_double, double(value));
+            }
+            else if constexpr (
+                std::is_convertible_v<const T&, std::string_view>)
+            {
+                put_string(std::string_view(value));
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                put(arg_pointer, uint64_t(uintptr_t(value)));
+            }
+            else
+            {
+                std::ostringstream oss;
+                oss << value;
+                put_string(oss.str());
+            }
+            return *this;
+        }
+
+      protected:
+        log& mylog;
+        std::vector<uint8_t>& data; ///< buffer of thread for the record
+
+        template<typename T>
+        void put(uint8_t tag, T value)
+        {
+            const auto sz = data.size();
+            data.resize(sz + 1 + sizeof(T));
+            data[sz] = tag;
+            std::memcpy(&data[sz + 1], &value, sizeof(T));
+        }
+        void put_string(std::string_view s);
+    };
+
+    /// type tags of arguments in records
+    enum : uint8_t
+    {
+        arg_bool,
+        arg_char,
+        arg_int,
+        arg_uint,
+        arg_double,
+        arg_string,
+        arg_pointer
+    };
+
     /// wether log output should go to console as well
     static bool copy_output_to_console;
 
+    ~log();
+
     /// write the log to a stream, with optional filtering of importance,
     /// threadsafe
     void write(
         std::ostream& out,
         log::level limit_level = log::level::NR_LEVELS) const;
 
+    /// write all records to a binary file, also the ones that follow.
+    /// Use logdump to read it.
+    void open_binary_file(const std::string& filename);
+
     /// append a message to the log, threadsafe
     void append(log::level l, const std::string& msg);
 
@@ -99,10 +206,12 @@ class log : public singleton<class log>
     /// report end of a thread - call from its context
     void end_thread();
 
+    /// format the arguments of a binary record as text
+    static void
+    format_arguments(std::ostream& out, const uint8_t* data, std::size_t size);
+
   protected:
     log();
     class log_internal* mylogint{nullptr};
-    [[nodiscard]] const char* get_thread_name() const;
-    [[nodiscard]] const char* get_thread_name(std::thread::id) const;
-    friend struct log_msg;
+    void commit(std::vector<uint8_t>& data);
 };
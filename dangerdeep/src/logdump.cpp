@@ -0,0 +1,219 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// print binary log files as text, measure logging costs
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "log.h"
+#include "mymain.cpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+const char* level_names[] = {"WARNING", "INFO", "SYSINFO", "DEBUG"};
+
+struct site
+{
+    unsigned line{0};
+    std::string file;
+};
+
+template<typename T>
+bool read_value(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return in.good();
+}
+
+bool read_string(std::istream& in, std::string& s)
+{
+    uint32_t len = 0;
+    if (!read_value(in, len))
+    {
+        return false;
+    }
+    s.resize(len);
+    in.read(&s[0], len);
+    return in.good();
+}
+
+/// print records of binary log file
+int dump(
+    const std::string& filename,
+    unsigned max_level,
+    const std::string& thread_filter)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    char magic[8];
+    uint64_t start_time_ms = 0;
+    in.read(magic, 8);
+    if (!in.good() || std::string(magic, 8) != "DFTDLOG1"
+        || !read_value(in, start_time_ms))
+    {
+        std::cout << "No binary log file: " << filename << "\n";
+        return -1;
+    }
+    std::unordered_map<uint32_t, site> sites;
+    std::unordered_map<uint32_t, std::string> threads;
+    std::vector<uint8_t> data;
+    unsigned nr_of_records = 0;
+    char tag               = 0;
+    while (in.get(tag))
+    {
+        uint32_t id = 0;
+        if (tag == 'S')
+        {
+            site s;
+            if (!read_value(in, id) || !read_value(in, s.line)
+                || !read_string(in, s.file))
+            {
+                break;
+            }
+            sites[id] = s;
+        }
+        else if (tag == 'T')
+        {
+            if (!read_value(in, id) || !read_string(in, threads[id]))
+            {
+                break;
+            }
+        }
+        else if (tag == 'R')
+        {
+            uint64_t time   = 0;
+            uint32_t thread = 0, size = 0;
+            uint8_t level   = 0;
+            if (!read_value(in, time) || !read_value(in, thread)
+                || !read_value(in, id) || !read_value(in, level)
+                || !read_value(in, size))
+            {
+                break;
+            }
+            data.resize(size);
+            in.read(reinterpret_cast<char*>(data.data()), size);
+            if (!in.good())
+            {
+                break;
+            }
+            ++nr_of_records;
+            if (level > max_level
+                || (!thread_filter.empty() && threads[thread] != thread_filter))
+            {
+                continue;
+            }
+            const auto& s = sites[id];
+            std::cout << (level < 4 ? level_names[level] : "?") << " ["
+                      << threads[thread] << "] <" << std::dec
+                      << start_time_ms + time / 1000000 << "> ";
+            if (!s.file.empty())
+            {
+                std::cout << s.file << ":" << s.line << " ";
+            }
+            log::format_arguments(std::cout, data.data(), data.size());
+            std::cout << "\n";
+        }
+        else
+        {
+            std::cout << "Corrupt log file, unknown entry " << int(tag) << "\n";
+            return -1;
+        }
+    }
+    if (!in.eof())
+    {
+        std::cout << "Log file is truncated after " << nr_of_records
+                  << " records\n";
+    }
+    return 0;
+}
+
+/// time per log call with typical arguments
+int benchmark(unsigned n, const std::string& filename)
+{
+    static constexpr log::site bench_site{__FILE__, __LINE__};
+    if (!filename.empty())
+    {
+        log::instance().open_binary_file(filename);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < n; ++i)
+    {
+        log::record r(log::level::DEBUGGING, bench_site);
+        r << "torpedo " << i << " hit ship at distance " << i * 0.5
+          << "m, dud " << (i % 7 == 0);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    std::cout << n << " log records, " << ns / n << "ns per record\n";
+    return 0;
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    unsigned max_level = 3, bench_records = 0;
+    std::string thread_filter, filename;
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        if (*it == "--help")
+        {
+            std::cout << "usage: logdump [--level n] [--thread name] file\n"
+                         "       logdump --benchmark n [file]\n"
+                         "--level n\tshow levels up to n, 0=warnings, "
+                         "1=info, 2=sysinfo, 3=debug (default)\n"
+                         "--thread name\tshow only messages of thread\n"
+                         "--benchmark n\tmeasure n log calls, write them to "
+                         "file if given\n";
+            return 0;
+        }
+        else if (*it == "--level" && it + 1 != args.end())
+        {
+            max_level = unsigned(atoi((++it)->c_str()));
+        }
+        else if (*it == "--thread" && it + 1 != args.end())
+        {
+            thread_filter = *++it;
+        }
+        else if (*it == "--benchmark" && it + 1 != args.end())
+        {
+            bench_records = unsigned(atoi((++it)->c_str()));
+        }
+        else
+        {
+            filename = *it;
+        }
+    }
+    if (bench_records > 0)
+    {
+        return benchmark(bench_records, filename);
+    }
+    if (filename.empty())
+    {
+        std::cout << "No log file given, use --help\n";
+        return -1;
+    }
+    return dump(filename, max_level, thread_filter);
+}
@@ -95,35 +95,57 @@ void map_display::draw_vessel_symbol(
         .render();
 }
 
-void map_display::draw_trail(const sea_object* so, const vector2& offset) const
+void map_display::draw_trail(
+    const sea_object* so,
+    const vector2& offset,
+    primitives& trails) const
 {
-    // fixme: clean up this mess. maybe merge with function in water.cpp
+    // fixme: maybe merge with function in water.cpp
     // we draw trails in both functions.
     auto* shp = dynamic_cast<const ship*>(so);
     if (shp)
     {
-        const list<ship::prev_pos>& l = shp->get_previous_positions();
+        const ship::trail_buffer& l = shp->get_previous_positions();
         if (l.empty())
         {
             return;
         }
+        // trails of all objects share one vertex stream, so every trail
+        // segment is stored as pair of vertices for GL_LINES.
         vector2 p = (shp->get_pos().xy() + offset) * mapzoom;
-        primitives tr(GL_LINE_STRIP, l.size() + 1);
-        tr.vertices[0].x = 512 + p.x;
-        tr.vertices[0].y = 384 - p.y;
-        tr.colors[0]     = colorf(1, 1, 1, 1);
+        vector3f lastpos(512 + p.x, 384 - p.y, 0);
+        color lastcol(colorf(1, 1, 1, 1));
         float la = 1.0 / float(l.size()), lc = 0;
-        unsigned trc = 1;
         for (const auto& it : l)
         {
-            tr.colors[trc]     = colorf(1, 1, 1, 1 - lc);
-            vector2 p          = (it.pos + offset) * mapzoom;
-            tr.vertices[trc].x = 512 + p.x;
-            tr.vertices[trc].y = 384 - p.y;
+            vector2 p = (it.pos + offset) * mapzoom;
+            vector3f curpos(512 + p.x, 384 - p.y, 0);
+            color curcol(colorf(1, 1, 1, 1 - lc));
+            trails.vertices.push_back(lastpos);
+            trails.colors.push_back(lastcol);
+            trails.vertices.push_back(curpos);
+            trails.colors.push_back(curcol);
+            lastpos = curpos;
+            lastcol = curcol;
             lc += la;
-            ++trc;
         }
-        tr.render();
+    }
+}
+
+void map_display::draw_trails(
+    const std::vector<const sea_object*>& objs,
+    const vector2& offset) const
+{
+    primitives trails(GL_LINES, 0);
+    trails.vertices.reserve(objs.size() * ship::TRAIL_LENGTH * 2);
+    trails.colors.reserve(objs.size() * ship::TRAIL_LENGTH * 2);
+    for (auto obj : objs)
+    {
+        draw_trail(obj, offset, trails);
+    }
+    if (!trails.vertices.empty())
+    {
+        trails.render();
     }
 }
 
@@ -242,16 +264,10 @@ void map_display::draw_visual_contacts(
     const sea_object* player,
     const vector2& offset) const
 {
-    // draw vessel trails and symbols (since player is submerged, he is drawn
-    // too)
+    // draw vessel symbols (since player is submerged, he is drawn too),
+    // trails are drawn in one batch by display()
     const auto& objs = player->get_visible_objects();
 
-    // draw trails
-    for (auto obj : objs)
-    {
-        draw_trail(obj, offset);
-    }
-
     // draw vessel symbols
     for (auto obj : objs)
     {
@@ -283,12 +299,6 @@ void map_display::draw_radar_contacts(
 {
     const auto& objs = player->get_radar_objects();
 
-    // draw trails
-    for (auto obj : objs)
-    {
-        draw_trail(obj, offset);
-    }
-
     // draw vessel symbols
     for (auto obj : objs)
     {
@@ -741,9 +751,7 @@ void map_display::edit_copy_obj(game_editor& gm)
         auto* su  = dynamic_cast<submarine*>(&obj);
         if (s && su == nullptr)
         {
-            xml_doc spec(data_file().get_filename(s->get_specfilename()));
-            spec.load();
-            ship s2(gm, spec.first_child());
+            ship s2(gm, data_file().get_spec(s->get_specfilename()));
             s2.set_skin_layout(model::default_layout);
             // set pos and other values etc.
             vector3 pos = s->get_pos() + offset;
@@ -775,7 +783,7 @@ void map_display::edit_convoy_menu(game_editor& gm)
     }
     // fill list of convoy names
     edit_cvlist->clear();
-    for (auto& [id, convoy] : gm.get_convoy_list())
+    for (auto& convoy : gm.get_convoy_list())
     {
         string nm = convoy.get_name();
         if (nm.length() == 0)
@@ -965,9 +973,39 @@ void map_display::display() const
 
     auto target = gm.get_player()->get_target();
 
-    // draw vessel symbols (or noise contacts)
     auto* sub_player = dynamic_cast<submarine*>(player);
-    if (sub_player && sub_player->is_submerged())
+    const bool player_submerged = sub_player && sub_player->is_submerged();
+    // Special handling for submarine player: When the submarine is
+    // on periscope depth and the periscope is up the visual contact
+    // must be drawn on map.
+    const bool scope_contacts =
+        player_submerged
+        && (sub_player->get_depth() <= sub_player->get_periscope_depth())
+        && sub_player->is_scope_up();
+
+    // draw trails of all shown vessels at once, below the symbols
+    vector<const sea_object*> trail_objs;
+    if (player_submerged)
+    {
+        trail_objs.push_back(player);
+        if (scope_contacts)
+        {
+            const auto& vis = player->get_visible_objects();
+            trail_objs.insert(trail_objs.end(), vis.begin(), vis.end());
+        }
+    }
+    else
+    {
+        const auto& vis = player->get_visible_objects();
+        const auto& rad = player->get_radar_objects();
+        trail_objs.reserve(vis.size() + rad.size());
+        trail_objs.insert(trail_objs.end(), vis.begin(), vis.end());
+        trail_objs.insert(trail_objs.end(), rad.begin(), rad.end());
+    }
+    draw_trails(trail_objs, -offset);
+
+    // draw vessel symbols (or noise contacts)
+    if (player_submerged)
     {
         // draw pings
         draw_pings(gm, -offset);
@@ -977,15 +1015,10 @@ void map_display::display() const
         // contacts
         draw_sound_contact(gm, sub_player, -offset);
 
-        // draw player trails and player
-        draw_trail(player, -offset);
+        // draw player
         draw_vessel_symbol(-offset, sub_player, color(255, 255, 128));
 
-        // Special handling for submarine player: When the submarine is
-        // on periscope depth and the periscope is up the visual contact
-        // must be drawn on map.
-        if ((sub_player->get_depth() <= sub_player->get_periscope_depth())
-            && sub_player->is_scope_up())
+        if (scope_contacts)
         {
             draw_visual_contacts(gm, sub_player, -offset);
 
@@ -1215,10 +1248,10 @@ auto map_display::handle_mouse_button_event(const mouse_click_data& m) -> bool
                     if (retval == EPFG_SHIPADDED)
                     {
                         // add ship
-                        xml_doc spec(data_file().get_filename(
-                            edit_shiplist->get_selected_entry()));
-                        spec.load();
-                        ship shp(gm, spec.first_child());
+                        ship shp(
+                            gm,
+                            data_file().get_spec(
+                                edit_shiplist->get_selected_entry()));
                         shp.set_skin_layout(model::default_layout);
                         // set pos and other values etc.
                         vector2 pos =
@@ -31,6 +31,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "widget.h"
 
 #include <unordered_set>
+#include <vector>
 
 class game;
 class game_editor;
@@ -50,7 +51,13 @@ class map_display : public user_display
         const vector2& offset,
         const sea_object* so,
         color c) const;
-    void draw_trail(const sea_object* so, const vector2& offset) const;
+    void draw_trail(
+        const sea_object* so,
+        const vector2& offset,
+        primitives& trails) const;
+    void draw_trails(
+        const std::vector<const sea_object*>& objs,
+        const vector2& offset) const;
     void draw_pings(game& gm, const vector2& offset) const;
     void draw_sound_contact(
         game& gm,
@@ -0,0 +1,120 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// accounting of memory per subsystem
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "memory_usage.h"
+
+#include "log.h"
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+std::atomic<std::size_t> used[memory_usage::nr_of_categories];
+std::atomic<std::size_t> peak[memory_usage::nr_of_categories];
+
+const char* names[memory_usage::nr_of_categories] = {
+    "models",
+    "textures",
+    "images",
+    "water",
+    "terrain",
+    "particles",
+    "xml",
+    "sound"};
+
+/// format bytes as megabytes
+std::string megabytes(std::size_t bytes)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB";
+    return oss.str();
+}
+} // namespace
+
+void memory_usage::add(category c, std::size_t bytes)
+{
+    if (bytes == 0)
+    {
+        return;
+    }
+    const std::size_t u =
+        used[c].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t p = peak[c].load(std::memory_order_relaxed);
+    while (u > p
+           && !peak[c].compare_exchange_weak(p, u, std::memory_order_relaxed))
+    {
+    }
+}
+
+void memory_usage::sub(category c, std::size_t bytes)
+{
+    if (bytes != 0)
+    {
+        used[c].fetch_sub(bytes, std::memory_order_relaxed);
+    }
+}
+
+auto memory_usage::get_used(category c) -> std::size_t
+{
+    return used[c].load(std::memory_order_relaxed);
+}
+
+auto memory_usage::get_peak(category c) -> std::size_t
+{
+    return peak[c].load(std::memory_order_relaxed);
+}
+
+auto memory_usage::get_name(category c) -> const char*
+{
+    return names[c];
+}
+
+auto memory_usage::get_report_lines() -> std::vector<std::string>
+{
+    std::vector<std::string> result;
+    std::size_t total = 0;
+    for (unsigned i = 0; i < nr_of_categories; ++i)
+    {
+        const auto c = category(i);
+        total += get_used(c);
+        std::ostringstream oss;
+        oss << std::left << std::setw(10) << get_name(c) << " "
+            << megabytes(get_used(c)) << ", peak " << megabytes(get_peak(c));
+        result.push_back(oss.str());
+    }
+    result.push_back("total      " + megabytes(total));
+    return result;
+}
+
+void memory_usage::log_report()
+{
+    // log_info is empty in release builds, but the report is requested by
+    // the user or written once per game, so write the records directly.
+    static constexpr log::site report_site{__FILE__, __LINE__};
+    log::record(log::level::INFO, report_site) << "Memory usage by subsystem:";
+    for (const auto& line : get_report_lines())
+    {
+        log::record(log::level::INFO, report_site) << line;
+    }
+}
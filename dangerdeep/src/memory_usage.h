@@ -0,0 +1,125 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// accounting of memory per subsystem
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+///\brief Counts memory used by the subsystems of the game.
+/** Subsystems report the size of their big data blocks, like the vertices of
+    a model or the pixels of a texture, so live bytes and peaks can be shown
+    per subsystem. This is no allocator hook, small allocations are not
+    counted. Counting is thread safe and costs an atomic addition.
+*/
+class memory_usage
+{
+  public:
+    /// the subsystems
+    enum category
+    {
+        models,    ///< vertex and index data of models
+        textures,  ///< OpenGL textures
+        images,    ///< decoded images in main memory
+        water,     ///< wave phases
+        terrain,   ///< terrain height tiles
+        particles, ///< particle objects
+        xml,       ///< XML documents
+        sound,     ///< sound effects
+        nr_of_categories
+    };
+
+    /// count memory as allocated
+    static void add(category c, std::size_t bytes);
+
+    /// count memory as freed
+    static void sub(category c, std::size_t bytes);
+
+    /// get bytes currently used by subsystem
+    [[nodiscard]] static std::size_t get_used(category c);
+
+    /// get maximum bytes used by subsystem so far
+    [[nodiscard]] static std::size_t get_peak(category c);
+
+    /// get name of subsystem
+    [[nodiscard]] static const char* get_name(category c);
+
+    /// get report, one line per subsystem and the total
+    [[nodiscard]] static std::vector<std::string> get_report_lines();
+
+    /// write report to log, in release builds as well
+    static void log_report();
+
+    ///\brief Counts memory of an object as long as it lives.
+    /** Use as member of the object and set the size when it is known. Copies
+        count the same memory again.
+    */
+    class account
+    {
+      public:
+        account(category c, std::size_t bytes_ = 0) : cat(c), bytes(bytes_)
+        {
+            add(cat, bytes);
+        }
+        account(const account& other) : account(other.cat, other.bytes) { }
+        account(account&& other) noexcept : cat(other.cat), bytes(other.bytes)
+        {
+            other.bytes = 0;
+        }
+        account& operator=(const account& other)
+        {
+            set(other.bytes);
+            return *this;
+        }
+        account& operator=(account&& other) noexcept
+        {
+            sub(cat, bytes);
+            bytes       = other.bytes;
+            other.bytes = 0;
+            return *this;
+        }
+        ~account() { sub(cat, bytes); }
+
+        /// change counted size
+        void set(std::size_t new_bytes)
+        {
+            add(cat, new_bytes);
+            sub(cat, bytes);
+            bytes = new_bytes;
+        }
+
+        /// get counted size
+        [[nodiscard]] std::size_t get() const { return bytes; }
+
+      protected:
+        category cat;
+        std::size_t bytes;
+    };
+};
+
+/// get size of the elements of a vector in bytes
+template<typename V>
+std::size_t memory_of(const V& v)
+{
+    return v.capacity() * sizeof(typename V::value_type);
+}
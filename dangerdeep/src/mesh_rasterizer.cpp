@@ -0,0 +1,224 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// CPU rasterization of triangle meshes for measuring models
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "mesh_rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+/// edge function of edge p->q at (u, v), positive left of the edge
+double edge(const vector2& p, const vector2& q, double u, double v)
+{
+    return (q.x - p.x) * (v - p.y) - (q.y - p.y) * (u - p.x);
+}
+
+/// check if sample with edge function value e belongs to the triangle.
+/// Samples on an edge count only for the triangle where the edge points
+/// upwards (or left when horizontal). The neighbouring triangle has the
+/// edge in the opposite direction, so the sample is counted exactly once.
+bool covers(double e, const vector2& p, const vector2& q)
+{
+    if (e != 0.0)
+    {
+        return e > 0.0;
+    }
+    return q.y > p.y || (q.y == p.y && q.x < p.x);
+}
+} // namespace
+
+auto mesh_rasterizer::compute_voxel_volumes(
+    const std::vector<vector3f>& triangles,
+    const vector3f& bmin,
+    const vector3f& bmax,
+    const vector3i& resolution,
+    unsigned samples_per_voxel) -> std::vector<float>
+{
+    const int spv = int(samples_per_voxel);
+    const int nx  = resolution.x * spv;
+    const int ny  = resolution.y * spv;
+    const int nz  = resolution.z * spv;
+    const vector3 bsize(bmax - bmin);
+    const vector3 sample_size(bsize.x / nx, bsize.y / ny, bsize.z / nz);
+    // transform to sample space, where sample centers have integer
+    // coordinates
+    auto to_sample = [&](const vector3f& p) {
+        return vector3(
+            (p.x - bmin.x) / sample_size.x - 0.5,
+            (p.y - bmin.y) / sample_size.y - 0.5,
+            (p.z - bmin.z) / sample_size.z - 0.5);
+    };
+
+    // x-coordinates of crossings of the mesh for every row of samples
+    std::vector<std::vector<float>> crossings(ny * nz);
+    for (unsigned t = 0; t + 2 < triangles.size(); t += 3)
+    {
+        vector3 a = to_sample(triangles[t]);
+        vector3 b = to_sample(triangles[t + 1]);
+        vector3 c = to_sample(triangles[t + 2]);
+        // rasterize in yz-plane with counter clockwise orientation
+        vector2 a2(a.y, a.z), b2(b.y, b.z), c2(c.y, c.z);
+        double area = edge(a2, b2, c2.x, c2.y);
+        if (area == 0.0)
+        {
+            // triangle is parallel to the rows and is never crossed
+            continue;
+        }
+        if (area < 0.0)
+        {
+            std::swap(b, c);
+            std::swap(b2, c2);
+            area = -area;
+        }
+        const int jmin = std::max(
+            0, int(std::ceil(std::min(a2.x, std::min(b2.x, c2.x)))));
+        const int jmax = std::min(
+            ny - 1, int(std::floor(std::max(a2.x, std::max(b2.x, c2.x)))));
+        const int kmin = std::max(
+            0, int(std::ceil(std::min(a2.y, std::min(b2.y, c2.y)))));
+        const int kmax = std::min(
+            nz - 1, int(std::floor(std::max(a2.y, std::max(b2.y, c2.y)))));
+        for (int k = kmin; k <= kmax; ++k)
+        {
+            for (int j = jmin; j <= jmax; ++j)
+            {
+                const double ea = edge(b2, c2, j, k);
+                const double eb = edge(c2, a2, j, k);
+                const double ec = edge(a2, b2, j, k);
+                if (covers(ea, b2, c2) && covers(eb, c2, a2)
+                    && covers(ec, a2, b2))
+                {
+                    crossings[k * ny + j].push_back(
+                        float((ea * a.x + eb * b.x + ec * c.x) / area));
+                }
+            }
+        }
+    }
+
+    // count samples inside per voxel by parity of crossings along the rows
+    std::vector<unsigned> inside(resolution.x * resolution.y * resolution.z);
+    for (int k = 0; k < nz; ++k)
+    {
+        for (int j = 0; j < ny; ++j)
+        {
+            auto& row = crossings[k * ny + j];
+            if (row.empty())
+            {
+                continue;
+            }
+            std::sort(row.begin(), row.end());
+            const unsigned voxel_row =
+                ((k / spv) * resolution.y + j / spv) * resolution.x;
+            unsigned crossed = 0;
+            for (int i = 0; i < nx; ++i)
+            {
+                while (crossed < row.size() && row[crossed] < float(i))
+                {
+                    ++crossed;
+                }
+                if (crossed & 1)
+                {
+                    ++inside[voxel_row + i / spv];
+                }
+            }
+        }
+    }
+    std::vector<float> result(inside.size());
+    const float sample_volume = 1.0f / float(spv * spv * spv);
+    for (unsigned i = 0; i < inside.size(); ++i)
+    {
+        result[i] = inside[i] * sample_volume;
+    }
+    return result;
+}
+
+auto mesh_rasterizer::rasterize(
+    const std::vector<vector2f>& triangles,
+    unsigned width,
+    unsigned height,
+    std::vector<uint8_t>& coverage) -> unsigned
+{
+    unsigned newly_covered = 0;
+    for (unsigned t = 0; t + 2 < triangles.size(); t += 3)
+    {
+        // pixel centers are at integer coordinates here
+        const vector2 half(0.5, 0.5);
+        vector2 a = vector2(triangles[t].x, triangles[t].y) - half;
+        vector2 b = vector2(triangles[t + 1].x, triangles[t + 1].y) - half;
+        vector2 c = vector2(triangles[t + 2].x, triangles[t + 2].y) - half;
+        const double area = edge(a, b, c.x, c.y);
+        if (area == 0.0)
+        {
+            continue;
+        }
+        if (area < 0.0)
+        {
+            std::swap(b, c);
+        }
+        const int ymin =
+            std::max(0, int(std::ceil(std::min(a.y, std::min(b.y, c.y)))));
+        const int ymax = std::min(
+            int(height) - 1,
+            int(std::floor(std::max(a.y, std::max(b.y, c.y)))));
+        for (int y = ymin; y <= ymax; ++y)
+        {
+            // the edge functions are linear in x, so each edge limits the
+            // span of the row at one side
+            double xlo = 0.0, xhi = width - 1.0;
+            for (const auto& e :
+                 {std::make_pair(a, b),
+                  std::make_pair(b, c),
+                  std::make_pair(c, a)})
+            {
+                const vector2& p = e.first;
+                const vector2& q = e.second;
+                const double dy  = q.y - p.y;
+                const double ex  = (q.x - p.x) * (y - p.y);
+                if (dy == 0.0)
+                {
+                    if (ex < 0.0)
+                    {
+                        xhi = -1.0;
+                    }
+                }
+                else if (dy > 0.0)
+                {
+                    xhi = std::min(xhi, p.x + ex / dy);
+                }
+                else
+                {
+                    xlo = std::max(xlo, p.x + ex / dy);
+                }
+            }
+            const int x0 = int(std::ceil(xlo));
+            const int x1 = int(std::floor(xhi));
+            uint8_t* line = &coverage[y * width];
+            for (int x = x0; x <= x1; ++x)
+            {
+                newly_covered += line[x] ? 0 : 1;
+                line[x] = 1;
+            }
+        }
+    }
+    return newly_covered;
+}
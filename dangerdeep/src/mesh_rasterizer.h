@@ -0,0 +1,63 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// CPU rasterization of triangle meshes for measuring models
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "vector2.h"
+#include "vector3.h"
+
+#include <cstdint>
+#include <vector>
+
+///\brief Rasterizes triangle meshes on the CPU, without OpenGL.
+/** Triangles are given as lists of positions, three per triangle.
+    Samples exactly on an edge shared by two triangles are only counted for
+    one of them, so closed meshes give exact parity along every ray.
+*/
+struct mesh_rasterizer
+{
+    /// compute part of volume (0...1) inside a closed mesh for every voxel.
+    /** The box bmin...bmax is divided in resolution voxels, and every voxel
+        is sampled with samples_per_voxel^3 points. The inside test is done
+        row by row: all crossings of a row of samples along the x-axis with
+        the mesh are computed by rasterizing the mesh in the yz-plane, and
+        the parity of crossings left of a sample tells if it is inside.
+        @returns values in order x, then y, then z.
+    */
+    static std::vector<float> compute_voxel_volumes(
+        const std::vector<vector3f>& triangles,
+        const vector3f& bmin,
+        const vector3f& bmax,
+        const vector3i& resolution,
+        unsigned samples_per_voxel);
+
+    /// mark pixels covered by 2d triangles given in pixel coordinates
+    /** A pixel is covered if its center is inside a triangle.
+        @param coverage - width*height values, covered pixels are set to 1
+        @returns number of pixels that were newly covered
+    */
+    static unsigned rasterize(
+        const std::vector<vector2f>& triangles,
+        unsigned width,
+        unsigned height,
+        std::vector<uint8_t>& coverage);
+};
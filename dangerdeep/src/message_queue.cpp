@@ -22,89 +22,115 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "message_queue.h"
 
-#include "error.h"
-#include "log.h"
-#include "system_interface.h"
+namespace
+{
+/// number of slots, power of two for the position mask
+unsigned round_up_capacity(unsigned capacity)
+{
+    unsigned n = 2;
+    while (n < capacity)
+    {
+        n <<= 1;
+    }
+    return n;
+}
+} // namespace
 
-void message::evaluate() const
+auto message::evaluate() const -> bool
 {
-    result = false;
     try
     {
         eval();
-        result = true;
+        return true;
     }
     catch (std::exception& /*e*/)
     {
         // avoid to spam the log. define when needed.
         // log_debug("msg eval failed: " << e.what());
     }
+    return false;
 }
 
-message_queue::message_queue() = default;
+message_queue::message_queue(unsigned capacity) :
+    slots(round_up_capacity(capacity)), mask(slots.size() - 1)
+{
+    for (std::size_t i = 0; i < slots.size(); ++i)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
 
 message_queue::~message_queue()
 {
-    // clean up queues, report all pending messages as failed, then wait
-    // until ackqueue is empty... it should not happen though...
-    bool ackqueueempty = true;
+    // report all pending messages as failed
+    while (slot* s = get_filled_slot())
     {
-        std::unique_lock<std::mutex> ml(mymutex);
-        for (auto& elem : myqueue)
+        if (s->answer)
         {
-            if (elem->needsanswer)
-            {
-                ackqueue.push_back(std::move(elem));
-            }
+            s->answer->set_value(false);
         }
-        ackcondvar.notify_all();
-        ackqueueempty = ackqueue.empty();
+        s->msg().~message();
+        s->sequence.store(read_pos + slots.size(), std::memory_order_release);
+        ++read_pos;
     }
+}
 
-    while (!ackqueueempty)
+auto message_queue::reserve_slot(bool wait) -> slot*
+{
+    std::size_t pos = write_pos.load(std::memory_order_relaxed);
+    while (true)
     {
-        // fixme// thread::sleep(10);//fixme use sys! uses SDL_Delay...is there
-        // a c++ solution?!
-        std::unique_lock<std::mutex> ml(mymutex);
-        ackqueueempty = ackqueue.empty();
+        slot& s               = slots[pos & mask];
+        const std::size_t seq = s.sequence.load(std::memory_order_acquire);
+        const auto diff       = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+        if (diff == 0)
+        {
+            // slot is free, try to take it
+            if (write_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                return &s;
+            }
+        }
+        else if (diff < 0)
+        {
+            // slot still holds the message of the previous round
+            if (!wait)
+            {
+                return nullptr;
+            }
+            std::this_thread::yield();
+            pos = write_pos.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            // another sender was faster
+            pos = write_pos.load(std::memory_order_relaxed);
+        }
     }
 }
 
-auto message_queue::send(message::ptr msg, bool waitforanswer) -> bool
+void message_queue::publish(slot& s)
 {
-    msg->needsanswer  = waitforanswer;
-    msg->result       = false;
-    message* msg_addr = msg.get(); // address only for comparison
-    std::unique_lock<std::mutex> oml(mymutex);
-
-    bool e = myqueue.empty();
-    myqueue.push_back(std::move(msg));
-    msginqueue = true;
-
-    if (e)
+    s.sequence.fetch_add(1, std::memory_order_release);
+    // pairs with the fence in process_messages, either the receiver sees the
+    // message or we see that it waits.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (receiver_waiting.load(std::memory_order_relaxed))
     {
-        emptycondvar.notify_all();
+        std::unique_lock<std::mutex> ml(mymutex);
+        emptycondvar.notify_one();
     }
+}
 
-    if (waitforanswer)
+auto message_queue::get_filled_slot() -> slot*
+{
+    slot& s = slots[read_pos & mask];
+    if (s.sequence.load(std::memory_order_acquire) != read_pos + 1)
     {
-        while (true)
-        {
-            ackcondvar.wait(oml);
-            // check if this message has been acknowledged
-            for (auto it = ackqueue.begin(); it != ackqueue.end();)
-            {
-                if (it->get() == msg_addr)
-                {
-                    // found it, return result, delete and unqueue message
-                    bool result = (*it)->result;
-                    ackqueue.erase(it);
-                    return result;
-                }
-            }
-        }
+        return nullptr;
     }
-    return true;
+    return &s;
 }
 
 void message_queue::wakeup_receiver()
@@ -117,59 +143,37 @@ void message_queue::wakeup_receiver()
     emptycondvar.notify_all();
 }
 
-auto message_queue::receive(bool wait) -> std::vector<message::ptr>
+void message_queue::process_messages(bool wait)
 {
-    std::vector<message::ptr> result;
-    std::unique_lock<std::mutex> oml(mymutex);
+    if (wait && get_filled_slot() == nullptr)
+    {
+        std::unique_lock<std::mutex> oml(mymutex);
+        receiver_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        emptycondvar.wait(oml, [this]() {
+            return abortwait || get_filled_slot() != nullptr;
+        });
+        receiver_waiting.store(false, std::memory_order_relaxed);
+        abortwait = false;
+    }
 
-    if (myqueue.empty())
+    // handle at most one round, so the caller can check for abort requests
+    for (std::size_t i = 0; i < slots.size(); ++i)
     {
-        if (wait && !abortwait)
+        slot* s = get_filled_slot();
+        if (s == nullptr)
         {
-            emptycondvar.wait(oml);
+            break;
         }
-        else
+        const bool result = s->msg().evaluate();
+        if (s->answer)
         {
-            // no need to wait, so clear abort signal
-            abortwait  = false;
-            msginqueue = false;
-            return result;
+            s->answer->set_value(result);
+            s->answer.reset();
         }
-    }
-
-    abortwait = false;
-
-    // if we woke up and queue is still empty, we received a wakeup signal
-    // so result either is empty or contains the full queue after this line
-    myqueue.swap(result);
-
-    // any way, there are now no messages in the queue. return messages or empty
-    // list.
-    msginqueue = false;
-    return result;
-}
-
-void message_queue::acknowledge(message::ptr msg)
-{
-    if (msg.get() == nullptr)
-    {
-        THROW(error, "acknowledge without message called");
-    }
-    bool needsanswer = msg->needsanswer;
-    if (needsanswer)
-    {
-        std::unique_lock<std::mutex> oml(mymutex);
-        ackqueue.push_back(std::move(msg));
-        ackcondvar.notify_all();
-    }
-}
-
-void message_queue::process_messages(bool wait)
-{
-    auto msgs = receive(wait);
-    for (auto& msg : msgs)
-    {
-        msg->evaluate();
-        acknowledge(std::move(msg));
+        s->msg().~message();
+        // free the slot for the next round
+        s->sequence.store(read_pos + slots.size(), std::memory_order_release);
+        ++read_pos;
     }
 }
@@ -22,22 +22,23 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <future>
 #include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 /// a generic message, base class
 class message
 {
-  public:
-    using ptr = std::unique_ptr<message>;
-
   private:
-    friend class message_queue;
-    bool needsanswer;
-    mutable bool result;
-
-    // no copy, no move
+    // no copy, no move, messages are constructed in their queue slot
     message(const message&) = delete;
     message& operator=(const message&) = delete;
     message(message&&)                 = delete;
@@ -58,13 +59,18 @@ class message
     /// evaluate the message. Do not overload!
     ///@note Method is <b>not</b> virtual by intent. Do <b>not</b> overload. use
     /// eval() instead.
-    void evaluate() const;
-
-    /// get result of evaluation
-    bool get_result() const { return result; }
+    ///@returns true if eval() did not throw
+    bool evaluate() const;
 };
 
-/// an C++ message queue with generic messages
+///\brief A message queue with many senders and one receiver.
+/** The queue is a ring of preallocated slots, messages are constructed
+    directly in a slot, so sending needs no memory allocation and no lock.
+    Senders reserve a slot by advancing the write position atomically, every
+    slot has a sequence number that tells if it is free or holds a message
+    (bounded queue of D. Vyukov). Only the receiver sleeps when the queue is
+    empty, senders take the mutex just to wake it up.
+*/
 class message_queue
 {
   private:
@@ -72,46 +78,121 @@ class message_queue
     message_queue(const message_queue&) = delete;
     message_queue& operator=(const message_queue&) = delete;
 
-  protected:
-    std::vector<message::ptr> myqueue;
-    std::mutex mymutex;
-    std::condition_variable emptycondvar;
-    std::condition_variable ackcondvar;
-
-    bool msginqueue{false};
-    bool abortwait{false}; // set to true by wakeup_receiver()
-
-    std::vector<message::ptr> ackqueue; // queue with acknowledged messages
-
   public:
+    /// maximum size of a message class
+    static constexpr std::size_t max_message_size = 128;
+
     /// create message queue
-    message_queue();
+    ///@param capacity - number of slots, rounded up to a power of two
+    message_queue(unsigned capacity = 256);
 
-    /// destroy message queue
+    /// destroy message queue, pending messages are not evaluated, their
+    /// answers are false
     ~message_queue();
 
-    /// send a message
-    ///@param msg - message to send
-    ///@param waitforanswer - true to send message synchronously (wait for reply
-    /// with result)
-    ///@return result of answer or true when message is asynchronous
-    bool send(message::ptr msg, bool waitforanswer = true);
+    /// send a message without waiting, the message is constructed in the
+    /// queue from the arguments.
+    ///@returns false if the queue is full and the message was dropped
+    template<typename T, typename... Args>
+    bool post(Args&&... args)
+    {
+        slot* s = reserve_slot(false);
+        if (s == nullptr)
+        {
+            return false;
+        }
+        construct<T>(*s, std::forward<Args>(args)...);
+        publish(*s);
+        return true;
+    }
+
+    /// send a message that is answered with the result of its evaluation.
+    /// If the queue is full, this waits until a slot is free.
+    ///@returns future of the answer, true if eval() did not throw
+    template<typename T, typename... Args>
+    std::future<bool> request(Args&&... args)
+    {
+        slot* s = reserve_slot(true);
+        construct<T>(*s, std::forward<Args>(args)...);
+        std::future<bool> answer = s->answer.emplace().get_future();
+        publish(*s);
+        return answer;
+    }
+
+    /// send a message and wait for its answer
+    ///@note Must not be called by the receiver thread!
+    ///@returns true if eval() did not throw
+    template<typename T, typename... Args>
+    bool send(Args&&... args)
+    {
+        return request<T>(std::forward<Args>(args)...).get();
+    }
 
     /// wakeup thread waiting for a message
     void wakeup_receiver();
 
-    /// wait for a messages
-    ///@param wait - if true block while queue is empty, if false only test and
-    /// do not block
-    ///@return list of messages
-    std::vector<message::ptr> receive(bool wait = true);
-
-    /// acknowledge received message.
-    ///@note Must be called for every message passed from the receive function!
-    void acknowledge(message::ptr msg);
-
     /// process all messages, that is wait for messages, run eval() for every
-    /// message and ack them
+    /// message and answer them. Only one thread may receive.
     ///@param wait - true: block if queue is empty
     void process_messages(bool wait = true);
+
+  protected:
+    /// storage for one message
+    struct slot
+    {
+        /// equals position for a free slot and position + 1 for a message
+        std::atomic<std::size_t> sequence{0};
+        std::optional<std::promise<bool>> answer;
+        alignas(std::max_align_t) unsigned char data[max_message_size];
+
+        message& msg()
+        {
+            return *std::launder(reinterpret_cast<message*>(data));
+        }
+    };
+
+    std::vector<slot> slots;
+    const std::size_t mask;
+    std::atomic<std::size_t> write_pos{0};
+    std::size_t read_pos{0}; ///< only used by receiver
+
+    std::mutex mymutex;                   ///< only for waiting
+    std::condition_variable emptycondvar; ///< signals new messages
+    std::atomic<bool> receiver_waiting{false};
+    bool abortwait{false}; // set to true by wakeup_receiver()
+
+    /// get free slot at write position or nullptr if queue is full
+    ///@param wait - wait for a free slot if queue is full
+    slot* reserve_slot(bool wait);
+
+    /// mark slot as filled and wake up receiver
+    void publish(slot& s);
+
+    /// get slot at read position if it holds a message
+    slot* get_filled_slot();
+
+    template<typename T, typename... Args>
+    void construct(slot& s, Args&&... args)
+    {
+        static_assert(std::is_base_of_v<message, T>, "T must be a message");
+        static_assert(sizeof(T) <= max_message_size, "message too large");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "bad alignment");
+        try
+        {
+            new (s.data) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            // the slot is already reserved, it must be filled
+            new (s.data) failed_message();
+            publish(s);
+            throw;
+        }
+    }
+
+    /// placeholder if construction of a message failed
+    class failed_message : public message
+    {
+        void eval() const override { }
+    };
 };
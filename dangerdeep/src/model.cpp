@@ -39,9 +39,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "triangle_intersection.h"
 #include "xml.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <queue>
 #include <sstream>
 #include <utility>
 
@@ -57,6 +60,14 @@ texture::mapping_mode model::mapping =
 
 unsigned model::init_count = 0;
 
+unsigned model::nr_of_lod_levels = 0;
+
+// objects with at least that size on screen are drawn with full detail
+const float LOD_FULL_DETAIL_SCREEN_SIZE = 256.0f;
+
+// meshes with less triangles are not simplified
+const unsigned LOD_MIN_TRIANGLES = 64;
+
 /*
 fixme: possible cleanup/simplification of rendering EVERYWHERE:
 0) maybe introduce a camera class that generates projection and camera modelview
@@ -212,23 +223,24 @@ auto model::object::find(const std::string& name_) const -> const model::object*
     return nullptr;
 }
 
-void model::object::display(const texture* caustic_map) const
+void model::object::display(const texture* caustic_map, unsigned lod_level)
+    const
 {
     glPushMatrix();
     glTranslated(translation.x, translation.y, translation.z);
     glRotated(rotat_angle, rotat_axis.x, rotat_axis.y, rotat_axis.z);
     if (mymesh)
     {
-        mymesh->display(caustic_map);
+        mymesh->display(caustic_map, lod_level);
     }
     for (const auto& it : children)
     {
-        it.display(caustic_map);
+        it.display(caustic_map, lod_level);
     }
     glPopMatrix();
 }
 
-void model::object::display_mirror_clip() const
+void model::object::display_mirror_clip(unsigned lod_level) const
 {
     // matrix mode is GL_MODELVIEW and active texture is GL_TEXTURE1 here
     glPushMatrix();
@@ -237,11 +249,11 @@ void model::object::display_mirror_clip() const
 
     if (mymesh)
     {
-        mymesh->display_mirror_clip();
+        mymesh->display_mirror_clip(lod_level);
     }
     for (const auto& it : children)
     {
-        it.display_mirror_clip();
+        it.display_mirror_clip(lod_level);
     }
 
     glPopMatrix();
@@ -271,6 +283,21 @@ auto model::object::get_transformation() const -> matrix4f
            * quaternionf::rot(rotat_angle, rotat_axis).rotmat4();
 }
 
+void model::object::collect_triangles(
+    std::vector<vector3f>& positions,
+    const matrix4f& transmat) const
+{
+    const matrix4f mytransmat = transmat * get_transformation();
+    if (mymesh)
+    {
+        mymesh->collect_triangles(positions, mytransmat);
+    }
+    for (const auto& it : children)
+    {
+        it.collect_triangles(positions, mytransmat);
+    }
+}
+
 void model::render_init()
 {
     // initialize shaders
@@ -362,14 +389,18 @@ model::model()
     ++init_count;
 }
 
-model::model(string filename_, bool use_material) :
-    filename(std::move(filename_)), scene(0xffffffff, "<scene>", nullptr)
+model::model(string filename_, bool use_material, bool for_display_) :
+    filename(std::move(filename_)), for_display(for_display_),
+    scene(0xffffffff, "<scene>", nullptr)
 {
-    if (init_count == 0)
+    if (for_display)
     {
-        render_init();
+        if (init_count == 0)
+        {
+            render_init();
+        }
+        ++init_count;
     }
-    ++init_count;
 
     string::size_type st = filename.rfind('.');
     string extension     = (st == string::npos) ? "" : filename.substr(st);
@@ -430,11 +461,41 @@ model::model(string filename_, bool use_material) :
 
     compute_bounds();
     compute_normals();
-    compile();
+    if (for_display)
+    {
+        compute_lods();
+        compile();
+    }
 
     // try to read physical data file, needs min/max data etc., so call it after
     // compute_bounds().
     read_phys_file(filename2);
+    mem.set(get_data_memory_used());
+}
+
+auto model::get_data_memory_used() const -> std::size_t
+{
+    std::size_t bytes = memory_of(cross_sections) + memory_of(voxel_data)
+                        + memory_of(voxel_index_by_pos);
+    for (const auto* m : meshes)
+    {
+        bytes += m->get_memory_used();
+    }
+    return bytes;
+}
+
+auto model::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = get_data_memory_used();
+    for (const auto* m : meshes)
+    {
+        bytes += m->get_video_memory_used();
+    }
+    for (const auto* m : materials)
+    {
+        bytes += m->get_memory_used();
+    }
+    return bytes;
 }
 
 model::~model()
@@ -447,10 +508,13 @@ model::~model()
     {
         delete it;
     }
-    --init_count;
-    if (init_count == 0)
+    if (for_display)
     {
-        render_deinit();
+        --init_count;
+        if (init_count == 0)
+        {
+            render_deinit();
+        }
     }
 }
 
@@ -496,6 +560,31 @@ void model::compute_normals()
     }
 }
 
+void model::compute_lods()
+{
+    if (nr_of_lod_levels == 0)
+    {
+        return;
+    }
+    for (auto& meshe : meshes)
+    {
+        meshe->compute_lods(nr_of_lod_levels);
+    }
+}
+
+auto model::get_lod_level_for_screen_size(float pixels) -> unsigned
+{
+    if (nr_of_lod_levels == 0 || pixels >= LOD_FULL_DETAIL_SCREEN_SIZE)
+    {
+        return 0;
+    }
+    // every level has half the triangles of the previous one, so switch
+    // level whenever the projected size halves.
+    const float ratio = LOD_FULL_DETAIL_SCREEN_SIZE / std::max(pixels, 1.0f);
+    const float level = std::floor(std::log2(ratio)) + 1.0f;
+    return std::min(nr_of_lod_levels, unsigned(level));
+}
+
 auto model::mesh::gl_primitive_type() const -> int
 {
     switch (indices_type)
@@ -902,6 +991,395 @@ auto model::mesh::get_nr_of_triangles() const -> unsigned
     }
 }
 
+auto model::mesh::get_nr_of_triangles(unsigned lod_level) const -> unsigned
+{
+    if (lod_level == 0 || lod_indices.empty())
+    {
+        return get_nr_of_triangles();
+    }
+    return lod_indices[std::min(lod_level, unsigned(lod_indices.size())) - 1]
+               .size()
+           / 3;
+}
+
+namespace
+{
+/// Symmetric 4x4 matrix measuring squared distance to a set of planes
+struct error_quadric
+{
+    double a2{0}, ab{0}, ac{0}, ad{0}, b2{0}, bc{0}, bd{0}, c2{0}, cd{0},
+        d2{0};
+
+    error_quadric() = default;
+
+    /// quadric of plane a*x+b*y+c*z+d=0, weighted
+    error_quadric(const vector3& n, double d, double w) :
+        a2(w * n.x * n.x), ab(w * n.x * n.y), ac(w * n.x * n.z),
+        ad(w * n.x * d), b2(w * n.y * n.y), bc(w * n.y * n.z),
+        bd(w * n.y * d), c2(w * n.z * n.z), cd(w * n.z * d), d2(w * d * d)
+    {
+    }
+
+    error_quadric& operator+=(const error_quadric& o)
+    {
+        a2 += o.a2;
+        ab += o.ab;
+        ac += o.ac;
+        ad += o.ad;
+        b2 += o.b2;
+        bc += o.bc;
+        bd += o.bd;
+        c2 += o.c2;
+        cd += o.cd;
+        d2 += o.d2;
+        return *this;
+    }
+
+    [[nodiscard]] double evaluate(const vector3& v) const
+    {
+        return a2 * v.x * v.x + 2 * ab * v.x * v.y + 2 * ac * v.x * v.z
+               + 2 * ad * v.x + b2 * v.y * v.y + 2 * bc * v.y * v.z
+               + 2 * bd * v.y + c2 * v.z * v.z + 2 * cd * v.z + d2;
+    }
+};
+
+/// A possible collapse of vertex "from" onto vertex "to"
+struct collapse_candidate
+{
+    double cost;
+    unsigned from, to;
+    unsigned version_from, version_to;
+    // inverted, so that std::priority_queue delivers cheapest candidate
+    bool operator<(const collapse_candidate& o) const { return cost > o.cost; }
+};
+} // namespace
+
+auto model::mesh::compute_simplified_indices(
+    const std::vector<unsigned>& nr_of_triangles) const
+    -> std::vector<std::vector<uint32_t>>
+{
+    std::vector<std::vector<uint32_t>> result;
+    if (nr_of_triangles.empty())
+    {
+        return result;
+    }
+
+    // gather plain triangle list, skipping degenerated strip triangles
+    std::vector<uint32_t> tri;
+    const unsigned nr_tri = get_nr_of_triangles();
+    tri.reserve(nr_tri * 3);
+    for (unsigned i = 0; i < nr_tri; ++i)
+    {
+        uint32_t idx[3];
+        get_triangle(i, idx);
+        if (idx[0] != idx[1] && idx[1] != idx[2] && idx[0] != idx[2])
+        {
+            tri.insert(tri.end(), idx, idx + 3);
+        }
+    }
+    const unsigned nt = tri.size() / 3;
+    const unsigned nv = vertices.size();
+
+    // triangles per vertex
+    std::vector<std::vector<unsigned>> vertex_triangles(nv);
+    for (unsigned t = 0; t < nt; ++t)
+    {
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            vertex_triangles[tri[t * 3 + k]].push_back(t);
+        }
+    }
+
+    // Vertices on edges that are not shared by exactly two triangles are
+    // on the mesh border, on texture seams or non-manifold. Keep them, so
+    // the silhouette and the texture mapping do not fall apart.
+    std::vector<bool> locked(nv, false);
+    {
+        std::map<std::pair<unsigned, unsigned>, unsigned> edge_use;
+        for (unsigned t = 0; t < nt; ++t)
+        {
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                unsigned a = tri[t * 3 + k], b = tri[t * 3 + (k + 1) % 3];
+                ++edge_use[std::make_pair(std::min(a, b), std::max(a, b))];
+            }
+        }
+        for (const auto& eu : edge_use)
+        {
+            if (eu.second != 2)
+            {
+                locked[eu.first.first]  = true;
+                locked[eu.first.second] = true;
+            }
+        }
+    }
+
+    // initial quadrics, weighted by triangle area
+    std::vector<error_quadric> quadrics(nv);
+    for (unsigned t = 0; t < nt; ++t)
+    {
+        const vector3 v0 = vertices[tri[t * 3]];
+        const vector3 v1 = vertices[tri[t * 3 + 1]];
+        const vector3 v2 = vertices[tri[t * 3 + 2]];
+        vector3 n        = (v1 - v0).cross(v2 - v0);
+        double l         = n.length();
+        if (l < 1e-12)
+        {
+            continue;
+        }
+        n = n * (1.0 / l);
+        error_quadric q(n, -(n * v0), l * 0.5);
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            quadrics[tri[t * 3 + k]] += q;
+        }
+    }
+
+    std::vector<bool> triangle_removed(nt, false);
+    std::vector<unsigned> version(nv, 0);
+    std::priority_queue<collapse_candidate> candidates;
+    auto push_candidate = [&](unsigned from, unsigned to) {
+        if (locked[from])
+        {
+            return;
+        }
+        error_quadric q = quadrics[from];
+        q += quadrics[to];
+        candidates.push(
+            {q.evaluate(vertices[to]), from, to, version[from], version[to]});
+    };
+    auto push_vertex_edges = [&](unsigned v) {
+        for (unsigned t : vertex_triangles[v])
+        {
+            if (triangle_removed[t])
+            {
+                continue;
+            }
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                unsigned o = tri[t * 3 + k];
+                if (o != v)
+                {
+                    push_candidate(v, o);
+                    push_candidate(o, v);
+                }
+            }
+        }
+    };
+    for (unsigned v = 0; v < nv; ++v)
+    {
+        push_vertex_edges(v);
+    }
+
+    // vertices connected to v by remaining triangles, sorted
+    auto get_ring = [&](unsigned v, std::vector<unsigned>& ring) {
+        ring.clear();
+        for (unsigned t : vertex_triangles[v])
+        {
+            if (triangle_removed[t])
+            {
+                continue;
+            }
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                if (tri[t * 3 + k] != v)
+                {
+                    ring.push_back(tri[t * 3 + k]);
+                }
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    };
+
+    // A collapse must keep the mesh manifold (link condition: the only
+    // vertices connected to both "from" and "to" are the opposite vertices
+    // of the triangles sharing the edge) and must not flip any remaining
+    // triangle around "from".
+    std::vector<unsigned> ring_from, ring_to, common, opposite;
+    auto collapse_is_valid = [&](unsigned from, unsigned to) {
+        get_ring(from, ring_from);
+        get_ring(to, ring_to);
+        common.clear();
+        std::set_intersection(
+            ring_from.begin(),
+            ring_from.end(),
+            ring_to.begin(),
+            ring_to.end(),
+            std::back_inserter(common));
+        opposite.clear();
+        for (unsigned t : vertex_triangles[from])
+        {
+            const uint32_t* ti = &tri[t * 3];
+            if (!triangle_removed[t]
+                && (ti[0] == to || ti[1] == to || ti[2] == to))
+            {
+                opposite.push_back(ti[0] ^ ti[1] ^ ti[2] ^ from ^ to);
+            }
+        }
+        std::sort(opposite.begin(), opposite.end());
+        opposite.erase(
+            std::unique(opposite.begin(), opposite.end()), opposite.end());
+        if (common != opposite)
+        {
+            return false;
+        }
+        bool edge_exists = false;
+        for (unsigned t : vertex_triangles[from])
+        {
+            if (triangle_removed[t])
+            {
+                continue;
+            }
+            const uint32_t* ti = &tri[t * 3];
+            if (ti[0] == to || ti[1] == to || ti[2] == to)
+            {
+                edge_exists = true;
+                continue;
+            }
+            vector3 p[3], q[3];
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                p[k] = vertices[ti[k]];
+                q[k] = (ti[k] == from) ? vector3(vertices[to]) : p[k];
+            }
+            vector3 n0 = (p[1] - p[0]).cross(p[2] - p[0]);
+            vector3 n1 = (q[1] - q[0]).cross(q[2] - q[0]);
+            if (n0 * n1 <= 0.0)
+            {
+                return false;
+            }
+        }
+        return edge_exists;
+    };
+
+    auto store_level = [&]() {
+        result.emplace_back();
+        auto& r = result.back();
+        for (unsigned t = 0; t < nt; ++t)
+        {
+            if (!triangle_removed[t])
+            {
+                r.insert(r.end(), &tri[t * 3], &tri[t * 3 + 3]);
+            }
+        }
+    };
+
+    unsigned remaining = nt;
+    unsigned next_lvl  = 0;
+    while (next_lvl < nr_of_triangles.size())
+    {
+        if (remaining <= nr_of_triangles[next_lvl])
+        {
+            store_level();
+            ++next_lvl;
+            continue;
+        }
+        if (candidates.empty())
+        {
+            break;
+        }
+        collapse_candidate c = candidates.top();
+        candidates.pop();
+        if (c.version_from != version[c.from] || c.version_to != version[c.to]
+            || !collapse_is_valid(c.from, c.to))
+        {
+            continue;
+        }
+        // collapse: triangles with both vertices vanish, others get remapped
+        for (unsigned t : vertex_triangles[c.from])
+        {
+            if (triangle_removed[t])
+            {
+                continue;
+            }
+            uint32_t* ti = &tri[t * 3];
+            if (ti[0] == c.to || ti[1] == c.to || ti[2] == c.to)
+            {
+                triangle_removed[t] = true;
+                --remaining;
+            }
+            else
+            {
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    if (ti[k] == c.from)
+                    {
+                        ti[k] = c.to;
+                    }
+                }
+                vertex_triangles[c.to].push_back(t);
+            }
+        }
+        vertex_triangles[c.from].clear();
+        quadrics[c.to] += quadrics[c.from];
+        ++version[c.from];
+        ++version[c.to];
+        push_vertex_edges(c.to);
+    }
+    // no more collapses possible, coarser levels are the same
+    while (result.size() < nr_of_triangles.size())
+    {
+        store_level();
+    }
+    return result;
+}
+
+void model::mesh::compute_lods(unsigned nr_of_levels)
+{
+    lod_indices.clear();
+    const unsigned nr_tri = get_nr_of_triangles();
+    if (nr_tri < LOD_MIN_TRIANGLES)
+    {
+        return;
+    }
+    std::vector<unsigned> wanted;
+    for (unsigned i = 1; i <= nr_of_levels; ++i)
+    {
+        wanted.push_back(std::max(1U, nr_tri >> i));
+    }
+    lod_indices = compute_simplified_indices(wanted);
+    // drop empty levels and levels that could not be simplified any further
+    while (!lod_indices.empty() && lod_indices.back().empty())
+    {
+        lod_indices.pop_back();
+    }
+    while (lod_indices.size() > 1
+           && lod_indices.back().size()
+                  == lod_indices[lod_indices.size() - 2].size())
+    {
+        lod_indices.pop_back();
+    }
+}
+
+auto model::mesh::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = memory_of(vertices) + memory_of(normals)
+                        + memory_of(tangentsx) + memory_of(texcoords)
+                        + memory_of(righthanded) + memory_of(indices)
+                        + memory_of(triangle_adjacency)
+                        + memory_of(vertex_triangle_adjacency);
+    for (const auto& l : lod_indices)
+    {
+        bytes += memory_of(l);
+    }
+    return bytes;
+}
+
+auto model::mesh::get_video_memory_used() const -> std::size_t
+{
+    std::size_t bytes = vbo_positions.get_map_size()
+                        + vbo_normals.get_map_size()
+                        + vbo_texcoords.get_map_size()
+                        + vbo_tangents_righthanded.get_map_size()
+                        + vbo_colors.get_map_size() + index_data.get_map_size();
+    for (const auto& l : lod_index_data)
+    {
+        bytes += l->get_map_size();
+    }
+    return bytes;
+}
+
 void model::mesh::get_plain_triangle(unsigned triangle, uint32_t idx[3]) const
 {
     unsigned t = triangle * 3;
@@ -1079,6 +1557,22 @@ void model::mesh::compile()
         indices.size() * 4 /* index type is uint32_t! */,
         &indices[0],
         GL_STATIC_DRAW);
+
+    // simplified levels share all vertex data, they only need own indices
+    lod_index_data.clear();
+    for (const auto& li : lod_indices)
+    {
+        if (li.empty())
+        {
+            // only coarser levels can be empty, draw_indices uses the last
+            break;
+        }
+        lod_index_data.push_back(std::make_unique<vertexbufferobject>(true));
+        lod_index_data.back()->init_data(
+            li.size() * 4 /* index type is uint32_t! */,
+            li.data(),
+            GL_STATIC_DRAW);
+    }
 }
 
 void model::mesh::transform(const matrix4f& m)
@@ -1359,6 +1853,19 @@ auto model::mesh::is_inside(const vector3f& p) const -> bool
     return in_out_count > 0;
 }
 
+void model::mesh::collect_triangles(
+    std::vector<vector3f>& positions,
+    const matrix4f& transmat) const
+{
+    std::unique_ptr<triangle_iterator> tit(get_tri_iterator());
+    do
+    {
+        positions.push_back(transmat.mul4vec3xlat(vertices[tit->i0()]));
+        positions.push_back(transmat.mul4vec3xlat(vertices[tit->i1()]));
+        positions.push_back(transmat.mul4vec3xlat(vertices[tit->i2()]));
+    } while (tit->next());
+}
+
 /* computing Volume
  */
 auto model::mesh::compute_volume() const -> double
@@ -1732,6 +2239,19 @@ void model::material::map::get_all_layout_names(
     }
 }
 
+auto model::material::map::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = mytexture ? mytexture->get_memory_used() : 0;
+    for (const auto& it : skins)
+    {
+        if (it.second.mytexture)
+        {
+            bytes += it.second.mytexture->get_memory_used();
+        }
+    }
+    return bytes;
+}
+
 model::material::material(std::string nm) : name(std::move(nm)) { }
 
 void model::material::map::set_gl_texture() const
@@ -1949,6 +2469,19 @@ void model::material::get_all_layout_names(std::set<std::string>& result) const
     }
 }
 
+auto model::material::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = 0;
+    for (const auto* m : {colormap.get(), normalmap.get(), specularmap.get()})
+    {
+        if (m)
+        {
+            bytes += m->get_memory_used();
+        }
+    }
+    return bytes;
+}
+
 model::material_glsl::material_glsl(
     const std::string& nm,
     const std::string& vsfn,
@@ -2052,7 +2585,21 @@ void model::material_glsl::get_all_layout_names(
     }
 }
 
-void model::mesh::display(const texture* caustic_map) const
+auto model::material_glsl::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = 0;
+    for (unsigned i = 0; i < nrtex; ++i)
+    {
+        if (texmaps[i].get())
+        {
+            bytes += texmaps[i]->get_memory_used();
+        }
+    }
+    return bytes;
+}
+
+void model::mesh::display(const texture* caustic_map, unsigned lod_level)
+    const
 {
     // set up material
     if (mymaterial != nullptr)
@@ -2123,16 +2670,8 @@ void model::mesh::display(const texture* caustic_map) const
     // vert/index)
     vbo_positions.unbind();
 
-    // render geometry, glDrawRangeElements is faster than glDrawElements.
-    index_data.bind();
-    glDrawRangeElements(
-        gl_primitive_type(),
-        0,
-        vertices.size() - 1,
-        indices.size(),
-        GL_UNSIGNED_INT,
-        nullptr);
-    index_data.unbind();
+    // render geometry
+    draw_indices(lod_level);
 
     // maybe: add code to show normals as Lines
 
@@ -2150,7 +2689,7 @@ void model::mesh::display(const texture* caustic_map) const
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void model::mesh::display_mirror_clip() const
+void model::mesh::display_mirror_clip(unsigned lod_level) const
 {
     // matrix mode is GL_MODELVIEW and active texture is GL_TEXTURE1 here
     bool has_texture_u0 = false;
@@ -2184,15 +2723,7 @@ void model::mesh::display_mirror_clip() const
     vbo_positions.unbind();
 
     // render geometry
-    index_data.bind();
-    glDrawRangeElements(
-        gl_primitive_type(),
-        0,
-        vertices.size() - 1,
-        indices.size(),
-        GL_UNSIGNED_INT,
-        nullptr);
-    index_data.unbind();
+    draw_indices(lod_level);
 
     glDisableClientState(GL_NORMAL_ARRAY);
     glDisableClientState(GL_COLOR_ARRAY);
@@ -2200,6 +2731,35 @@ void model::mesh::display_mirror_clip() const
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+void model::mesh::draw_indices(unsigned lod_level) const
+{
+    // glDrawRangeElements is faster than glDrawElements.
+    if (lod_level == 0 || lod_index_data.empty())
+    {
+        index_data.bind();
+        glDrawRangeElements(
+            gl_primitive_type(),
+            0,
+            vertices.size() - 1,
+            indices.size(),
+            GL_UNSIGNED_INT,
+            nullptr);
+        index_data.unbind();
+        return;
+    }
+    // use coarsest level if the wanted one is not available
+    const unsigned l = std::min(lod_level, unsigned(lod_index_data.size()));
+    lod_index_data[l - 1]->bind();
+    glDrawRangeElements(
+        GL_TRIANGLES,
+        0,
+        vertices.size() - 1,
+        lod_indices[l - 1].size(),
+        GL_UNSIGNED_INT,
+        nullptr);
+    lod_index_data[l - 1]->unbind();
+}
+
 void model::set_layout(const std::string& layout)
 {
     //	cout << "set layout '" << layout << "' for model '" << filename <<
@@ -2215,7 +2775,7 @@ void model::set_layout(const std::string& layout)
     current_layout = layout;
 }
 
-void model::display(const texture* caustic_map) const
+void model::display(const texture* caustic_map, unsigned lod_level) const
 {
     if (current_layout.length() == 0)
     {
@@ -2229,16 +2789,16 @@ void model::display(const texture* caustic_map) const
     {
         for (auto meshe : meshes)
         {
-            meshe->display(caustic_map);
+            meshe->display(caustic_map, lod_level);
         }
     }
     else
     {
-        scene.display(caustic_map);
+        scene.display(caustic_map, lod_level);
     }
 }
 
-void model::display_mirror_clip() const
+void model::display_mirror_clip(unsigned lod_level) const
 {
     // set up a object->worldspace transformation matrix in tex unit#1 matrix.
     if (scene.children.size() == 0)
@@ -2246,12 +2806,12 @@ void model::display_mirror_clip() const
         // default scene: no objects, just draw all meshes.
         for (auto meshe : meshes)
         {
-            meshe->display_mirror_clip();
+            meshe->display_mirror_clip(lod_level);
         }
     }
     else
     {
-        scene.display_mirror_clip();
+        scene.display_mirror_clip(lod_level);
     }
 }
 
@@ -3284,6 +3844,24 @@ bool model::is_inside(const vector3f& p) const
 }
 */
 
+auto model::get_all_triangles() const -> std::vector<vector3f>
+{
+    std::vector<vector3f> positions;
+    // default scene: no objects, all meshes like in display().
+    if (scene.children.empty())
+    {
+        for (auto meshe : meshes)
+        {
+            meshe->collect_triangles(positions, matrix4f::one());
+        }
+    }
+    else
+    {
+        scene.collect_triangles(positions, matrix4f::one());
+    }
+    return positions;
+}
+
 auto model::get_base_mesh_transformation() const -> matrix4f
 {
     if (scene.children.empty())
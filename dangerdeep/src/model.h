@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "color.h"
 #include "matrix3.h"
 #include "matrix4.h"
+#include "memory_usage.h"
 #include "shader.h"
 #include "texture.h"
 #include "vector3.h"
@@ -111,6 +112,8 @@ class model
             void unregister_layout(const std::string& name);
             void set_layout(const std::string& layout);
             void get_all_layout_names(std::set<std::string>& result) const;
+            /// get video memory of all loaded textures in bytes
+            [[nodiscard]] std::size_t get_memory_used() const;
         };
 
         std::string name;
@@ -134,6 +137,8 @@ class model
         virtual void unregister_layout(const std::string& name);
         virtual void set_layout(const std::string& layout);
         virtual void get_all_layout_names(std::set<std::string>& result) const;
+        /// get video memory of the textures of all maps in bytes
+        [[nodiscard]] virtual std::size_t get_memory_used() const;
         [[nodiscard]] virtual bool needs_texcoords() const
         {
             return colormap.get() != nullptr;
@@ -160,6 +165,7 @@ class model
         void unregister_layout(const std::string& name) override;
         void set_layout(const std::string& layout) override;
         void get_all_layout_names(std::set<std::string>& result) const override;
+        [[nodiscard]] std::size_t get_memory_used() const override;
         void compute_texloc();
         [[nodiscard]] const std::string& get_vertexshaderfn() const
         {
@@ -262,8 +268,10 @@ class model
             ((*this).*(get_triangle_ptr))(triangle, indices);
         }
 
-        void display(const texture* caustic_map = nullptr) const;
-        void display_mirror_clip() const;
+        void display(
+            const texture* caustic_map = nullptr,
+            unsigned lod_level         = 0) const;
+        void display_mirror_clip(unsigned lod_level = 0) const;
         void compute_vertex_bounds();
         void compute_bounds(
             vector3f& totmin,
@@ -302,6 +310,11 @@ class model
         /// check if a given point is inside the mesh
         ///@param p - point in vertex space, transformation not applied
         bool is_inside(const vector3f& p) const;
+        /// append all triangles as three positions each, transformed by
+        /// transmat
+        void collect_triangles(
+            std::vector<vector3f>& positions,
+            const matrix4f& transmat) const;
         double compute_volume() const;
         vector3 compute_center_of_gravity() const;
         /// give transformation matrix for vertices here (vertex->world space)
@@ -324,6 +337,28 @@ class model
             return vertex_triangle_adjacency[vertex];
         }
 
+        /// Level of detail data. Each level is a plain triangle index list
+        /// over the unmodified vertex data, level 0 is the full mesh. So all
+        /// vertex related data (and adjacency information) stays valid.
+        std::vector<std::vector<uint32_t>> lod_indices;
+        std::vector<std::unique_ptr<vertexbufferobject>> lod_index_data;
+
+        /// simplify mesh by edge collapses using quadric error metrics,
+        /// vertices are only removed, never moved or added.
+        ///@param nr_of_triangles - wanted triangle counts, descending
+        ///@returns plain triangle index list for every wanted count
+        std::vector<std::vector<uint32_t>> compute_simplified_indices(
+            const std::vector<unsigned>& nr_of_triangles) const;
+
+        /// get memory used by vertex and index data in bytes
+        [[nodiscard]] std::size_t get_memory_used() const;
+        /// get video memory used by the VBOs in bytes
+        [[nodiscard]] std::size_t get_video_memory_used() const;
+        /// generate simplified levels, each with half the triangles
+        void compute_lods(unsigned nr_of_levels);
+        unsigned get_nr_of_lod_levels() const { return 1 + lod_indices.size(); }
+        unsigned get_nr_of_triangles(unsigned lod_level) const;
+
         void compute_bv_tree();
         bool has_bv_tree() const { return !bounding_volume_tree.empty(); }
         const bv_tree& get_bv_tree() const { return bounding_volume_tree; }
@@ -352,6 +387,7 @@ class model
         void (model::mesh::*get_triangle_ptr)(
             unsigned triangle,
             uint32_t indices[3]) const;
+        void draw_indices(unsigned lod_level) const;
 
       private:
         mesh()            = delete;
@@ -414,21 +450,35 @@ class model
         object* find(const std::string& name);
         [[nodiscard]] const object* find(unsigned id) const;
         [[nodiscard]] const object* find(const std::string& name) const;
-        void display(const texture* caustic_map = nullptr) const;
-        void display_mirror_clip() const;
+        void display(
+            const texture* caustic_map = nullptr,
+            unsigned lod_level         = 0) const;
+        void display_mirror_clip(unsigned lod_level = 0) const;
         void compute_bounds(
             vector3f& min,
             vector3f& max,
             const matrix4f& transmat) const;
         [[nodiscard]] matrix4f get_transformation() const;
+        void collect_triangles(
+            std::vector<vector3f>& positions,
+            const matrix4f& transmat) const;
     };
 
     // store that for debugging purposes.
     std::string filename;
 
+    /// model is used for rendering, so it needs an OpenGL context
+    bool for_display{true};
+
     std::vector<material*> materials;
     std::vector<mesh*> meshes;
 
+    /// memory of meshes and voxels, counted after loading
+    memory_usage::account mem{memory_usage::models};
+
+    /// get memory used by meshes and voxels in bytes, without video memory
+    [[nodiscard]] std::size_t get_data_memory_used() const;
+
     object scene;
 
     std::string
@@ -475,6 +525,7 @@ class model
 
     void compute_bounds();
     void compute_normals();
+    void compute_lods();
 
     std::vector<float> cross_sections; // array over angles
 
@@ -520,20 +571,33 @@ class model
     static texture::mapping_mode
         mapping; // GL_* mapping constants (default GL_LINEAR_MIPMAP_LINEAR)
 
-    model(std::string filename, bool use_material = true);
+    /// number of simplified detail levels generated for meshes at load time
+    static unsigned nr_of_lod_levels;
+
+    /// get detail level for an object with given projected size in pixels
+    static unsigned get_lod_level_for_screen_size(float pixels);
+
+    /// load model. Models that are not for display (e.g. for measuring)
+    /// need no OpenGL context.
+    model(
+        std::string filename,
+        bool use_material = true,
+        bool for_display  = true);
     ~model();
     static const std::string default_layout;
     void set_layout(const std::string& layout = default_layout);
     // extend method by matrix4(f) for additional transformation, to avoid
     // that the user has to du glPushMatrix/manipulate/glPopMatrix
-    void display(const texture* caustic_map = nullptr) const;
+    void display(
+        const texture* caustic_map = nullptr,
+        unsigned lod_level         = 0) const;
     /** display model but clip away coords with z < 0 in world space.
         @note! set up texture matrix for unit 1 so that it contains
         object to world-space transformation, and set up modelview
         matrix so that it contains worldspace to viewer transformation
         with z-mirroring.
     */
-    void display_mirror_clip() const;
+    void display_mirror_clip(unsigned lod_level = 0) const;
     mesh& get_mesh(unsigned nr);
     [[nodiscard]] const mesh& get_mesh(unsigned nr) const;
     /// get mesh at root of object tree or first mesh if no tree defined
@@ -542,6 +606,9 @@ class model
     material& get_material(unsigned nr);
     [[nodiscard]] const material& get_material(unsigned nr) const;
     [[nodiscard]] unsigned get_nr_of_meshes() const { return meshes.size(); }
+    /// get memory used in bytes, by meshes and voxels as well as by VBOs and
+    /// the textures of all registered layouts. Used by the model cache.
+    [[nodiscard]] std::size_t get_memory_used() const;
     [[nodiscard]] unsigned get_nr_of_materials() const
     {
         return materials.size();
@@ -607,6 +674,10 @@ class model
     bool is_inside(const vector3f& p) const;
     */
 
+    /// get all triangles of all meshes in model space like they are
+    /// displayed, three positions per triangle
+    [[nodiscard]] std::vector<vector3f> get_all_triangles() const;
+
     /// request voxel data resolution
     [[nodiscard]] const vector3i& get_voxel_resolution() const
     {
@@ -0,0 +1,216 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// model level of detail test, measures simplification error and savings
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "cfg.h"
+#include "model.h"
+#include "mymain.cpp"
+#include "system_interface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::vector;
+
+/// distance of point p to triangle abc
+double point_triangle_distance(
+    const vector3& p,
+    const vector3& a,
+    const vector3& b,
+    const vector3& c)
+{
+    const vector3 ab = b - a, ac = c - a, ap = p - a;
+    const double d1 = ab * ap, d2 = ac * ap;
+    if (d1 <= 0 && d2 <= 0)
+    {
+        return ap.length();
+    }
+    const vector3 bp = p - b;
+    const double d3 = ab * bp, d4 = ac * bp;
+    if (d3 >= 0 && d4 <= d3)
+    {
+        return bp.length();
+    }
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        return (p - (a + ab * (d1 / (d1 - d3)))).length();
+    }
+    const vector3 cp = p - c;
+    const double d5 = ab * cp, d6 = ac * cp;
+    if (d6 >= 0 && d5 <= d6)
+    {
+        return cp.length();
+    }
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        return (p - (a + ac * (d2 / (d2 - d6)))).length();
+    }
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    {
+        return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))))
+            .length();
+    }
+    const double denom = 1.0 / (va + vb + vc);
+    return (p - (a + ab * (vb * denom) + ac * (vc * denom))).length();
+}
+
+/// maximum distance of (a sample of) the mesh vertices to the simplified
+/// surface, brute force.
+double compute_max_error(
+    const model::mesh& msh,
+    const vector<uint32_t>& lod_indices)
+{
+    const unsigned nr_samples = 1000;
+    const unsigned step =
+        std::max(1U, unsigned(msh.vertices.size()) / nr_samples);
+    double max_error = 0.0;
+    for (unsigned v = 0; v < msh.vertices.size(); v += step)
+    {
+        const vector3 p = msh.vertices[v];
+        double d        = 1e30;
+        for (unsigned t = 0; t + 2 < lod_indices.size(); t += 3)
+        {
+            d = std::min(
+                d,
+                point_triangle_distance(
+                    p,
+                    msh.vertices[lod_indices[t]],
+                    msh.vertices[lod_indices[t + 1]],
+                    msh.vertices[lod_indices[t + 2]]));
+        }
+        max_error = std::max(max_error, d);
+    }
+    return max_error;
+}
+
+int mymain(std::vector<string>& args)
+{
+    if (args.empty())
+    {
+        std::cout << "Usage: modellodtest model.ddxml [model2.ddxml ...]\n";
+        return -1;
+    }
+
+    cfg& mycfg = cfg::instance();
+
+    mycfg.register_option("screen_res_x", 1024);
+    mycfg.register_option("screen_res_y", 768);
+    mycfg.register_option("fullscreen", true);
+    mycfg.register_option("debug", false);
+    mycfg.register_option("sound", true);
+    mycfg.register_option("use_hqsfx", true);
+    mycfg.register_option("use_ani_filtering", false);
+    mycfg.register_option("anisotropic_level", 1.0f);
+    mycfg.register_option("use_compressed_textures", false);
+    mycfg.register_option("multisampling_level", 0);
+    mycfg.register_option("use_multisampling", false);
+    mycfg.register_option("bloom_enabled", false);
+    mycfg.register_option("hdr_enabled", false);
+    mycfg.register_option("hint_multisampling", 0);
+    mycfg.register_option("hint_fog", 0);
+    mycfg.register_option("hint_mipmap", 0);
+    mycfg.register_option("hint_texture_compression", 0);
+    mycfg.register_option("vsync", false);
+    mycfg.register_option("water_detail", 128);
+    mycfg.register_option("wave_fft_res", 128);
+    mycfg.register_option("wave_phases", 256);
+    mycfg.register_option("wavetile_length", 256.0f);
+    mycfg.register_option("wave_tidecycle_time", 10.24f);
+    mycfg.register_option("usex86sse", true);
+    mycfg.register_option("language", 0);
+    mycfg.register_option("cpucores", 1);
+    mycfg.register_option("terrain_texture_resolution", 0.1f);
+    mycfg.register_option("model_lod_levels", 3);
+
+    system_interface::parameters params;
+
+    params.resolution   = {1024, 768};
+    params.near_z       = 1.0;
+    params.far_z        = 1000.0;
+    params.fullscreen   = false;
+    params.resolution2d = {1024, 768};
+
+    system_interface::create_instance(new class system_interface(params));
+
+    model::nr_of_lod_levels = mycfg.geti("model_lod_levels");
+
+    // same projection as freeview display with 70 degrees field of view
+    const double pixel_factor =
+        params.resolution.x / (2.0 * std::tan(70.0 * M_PI / 360.0));
+    const vector<double> distances = {50, 100, 200, 500, 1000, 2000, 5000};
+
+    for (const auto& fn : args)
+    {
+        std::cout << "Model " << fn << "\n";
+        // the levels are generated while loading, so time the loading
+        auto t0 = std::chrono::steady_clock::now();
+        model mdl(fn);
+        auto t1 = std::chrono::steady_clock::now();
+        std::cout << " loading with simplification took "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count()
+                  << "ms\n";
+        unsigned total_triangles = 0;
+        vector<unsigned> triangles_per_level(model::nr_of_lod_levels + 1, 0);
+        for (unsigned m = 0; m < mdl.get_nr_of_meshes(); ++m)
+        {
+            const model::mesh& msh = mdl.get_mesh(m);
+            const unsigned nr_tri  = msh.get_nr_of_triangles();
+            total_triangles += nr_tri;
+            std::cout << " Mesh " << msh.name << ": " << nr_tri
+                      << " triangles\n";
+            for (unsigned l = 0; l < msh.lod_indices.size(); ++l)
+            {
+                std::cout << "  level " << l + 1 << ": "
+                          << msh.lod_indices[l].size() / 3
+                          << " triangles, max. error "
+                          << compute_max_error(msh, msh.lod_indices[l])
+                          << "m\n";
+            }
+            for (unsigned l = 0; l <= model::nr_of_lod_levels; ++l)
+            {
+                triangles_per_level[l] += msh.get_nr_of_triangles(l);
+            }
+        }
+
+        const double size = 2.0 * mdl.get_bounding_sphere_radius();
+        std::cout << " Rendered triangles by distance (full detail "
+                  << total_triangles << "):\n";
+        for (double d : distances)
+        {
+            const unsigned level = model::get_lod_level_for_screen_size(
+                float(size / d * pixel_factor));
+            const unsigned tris = triangles_per_level[level];
+            std::cout << "  " << d << "m: level " << level << ", " << tris
+                      << " triangles ("
+                      << 100.0 * tris / std::max(1U, total_triangles)
+                      << "%)\n";
+        }
+    }
+
+    return 0;
+}
@@ -20,25 +20,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // a cross section measurement tool
 // subsim (C)+(W) Thorsten Jordan. SEE LICENSE
 
-#ifdef WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#endif
-
-#include "cfg.h"
-#include "datadirs.h"
-#include "font.h"
+#include "mesh_rasterizer.h"
 #include "model.h"
 #include "mymain.cpp"
-#include "primitives.h"
-#include "system_interface.h"
 #include "texture.h"
-#include "thread.h"
 #include "vector3.h"
 #include "xml.h"
 
-#include <glu.h>
-#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -75,37 +66,52 @@ using namespace std;
     The inertia tensor differs if CoG is shifted before computing it.
 */
 
-int res_x, res_y;
-model* mdl;
-double screenarea_meters;
-double mw, mh;
-unsigned ANGLES = 256;
-
-void draw_model(double angle)
+namespace
 {
-    glPushMatrix();
-    glRotatef(angle, 0, 1, 0);
-    glRotated(-90.0, 1, 0, 0);
-    mdl->display();
-    glPopMatrix();
-}
+/// resolution of cross section measurement
+unsigned res_x = 1024, res_y = 768;
+unsigned ANGLES = 256;
 
-void measure_model(double angle, ostringstream& osscs)
+/// measure cross section of model from the side for all angles around the
+/// vertical axis. Ships are measured only above the waterline. The values
+/// use the same scale as the former measurement with OpenGL, so they are
+/// compatible with existing .phys files.
+vector<double> measure_cross_sections(const model& mdl, bool torpedomode)
 {
-    glClear(GL_COLOR_BUFFER_BIT);
-    draw_model(angle);
-    unsigned filledpixels  = 0;
-    unsigned screen_pixels = res_x * res_y;
-    vector<uint8_t> pic(screen_pixels * 3);
-    glReadPixels(0, 0, res_x, res_y, GL_RGB, GL_UNSIGNED_BYTE, &pic[0]);
-    for (unsigned i = 0; i < screen_pixels * 3; i += 3)
+    vector3f mmin = mdl.get_min();
+    vector3f mmax = mdl.get_max();
+    // modify min/max so that model is always fully visible, when it rotates.
+    mmin                    = mmin.min(-mmax);
+    mmax                    = -mmin;
+    const double mw         = mmax.y - mmin.y;
+    const double mh         = mmax.z - mmin.z;
+    const double screenarea = mw * mh;
+    cout << "min=" << mmin << " max=" << mmax << " mw=" << mw << " mh=" << mh
+         << "\n";
+    const auto triangles = mdl.get_all_triangles();
+    vector<vector2f> projected(triangles.size());
+    vector<uint8_t> coverage(res_x * res_y);
+    vector<double> result;
+    for (unsigned i = 0; i < ANGLES; ++i)
     {
-        // faster counting, uses no conditional jumps.
-        filledpixels += pic[i] ? 1 : 0;
+        const double a  = 2.0 * M_PI * i / ANGLES;
+        const double ca = cos(a), sa = sin(a);
+        for (unsigned j = 0; j < triangles.size(); ++j)
+        {
+            const vector3f& p = triangles[j];
+            projected[j].x =
+                float((p.x * ca - p.y * sa - mmin.y) * res_x / mw);
+            // do not show model centered but only above waterline for ships
+            projected[j].y = torpedomode
+                                 ? float((p.z - mmin.z) * res_y / mh)
+                                 : float(p.z * res_y * 2 / mh);
+        }
+        std::fill(coverage.begin(), coverage.end(), 0);
+        const unsigned filledpixels =
+            mesh_rasterizer::rasterize(projected, res_x, res_y, coverage);
+        result.push_back(screenarea * filledpixels / (res_x * res_y));
     }
-    double crosssection = screenarea_meters * filledpixels / screen_pixels;
-    osscs << crosssection << " ";
-    SYS().finish_frame();
+    return result;
 }
 
 void measure_mass_distribution(
@@ -114,37 +120,29 @@ void measure_mass_distribution(
     vector<float>& mass_part,
     const vector<float>& is_inside)
 {
-    glClear(GL_COLOR_BUFFER_BIT);
-    texture massmap(massmapfn, texture::LINEAR, texture::CLAMP);
-    glEnable(GL_TEXTURE_2D);
-    SYS().prepare_2d_drawing();
-    massmap.draw(0, 0, res_x, res_y);
-    SYS().unprepare_2d_drawing();
-    glDisable(GL_TEXTURE_2D);
-    unsigned screen_pixels = res_x * res_y;
-    vector<uint8_t> pic(screen_pixels * 3);
-    glReadPixels(0, 0, res_x, res_y, GL_RGB, GL_UNSIGNED_BYTE, &pic[0]);
-    SYS().finish_frame();
-    float allmass = 0;
+    sdl_image massmap(massmapfn);
+    unsigned w = 0, h = 0, bpp = 0;
+    const auto pic = massmap.get_plain_data(w, h, bpp);
+    float allmass  = 0;
     for (int z = 0; z < resolution.z; ++z)
     {
         for (int y = 0; y < resolution.y; ++y)
         {
+            // the map shows the model from the side, with its bottom at the
+            // bottom of the image
             unsigned mass_sum = 0;
-            unsigned y0       = res_y * z / resolution.z;
-            unsigned y1       = res_y * (z + 1) / resolution.z;
-            unsigned x0       = res_x * y / resolution.y;
-            unsigned x1       = res_x * (y + 1) / resolution.y;
+            unsigned y0       = h * z / resolution.z;
+            unsigned y1       = h * (z + 1) / resolution.z;
+            unsigned x0       = w * y / resolution.y;
+            unsigned x1       = w * (y + 1) / resolution.y;
             for (unsigned yy = y0; yy < y1; ++yy)
             {
                 for (unsigned xx = x0; xx < x1; ++xx)
                 {
-                    mass_sum += pic[(yy * res_x + xx) * 3];
+                    mass_sum += pic[((h - 1 - yy) * w + xx) * bpp];
                 }
             }
             float masspart = float(mass_sum) / ((x1 - x0) * (y1 - y0) * 255);
-            // cout << "y="<<y<<" z="<<z<<" mass_sum="<<mass_sum<<"
-            // masspart="<<masspart<<"\n";
             for (int x = 0; x < resolution.x; ++x)
             {
                 float in_part =
@@ -156,198 +154,48 @@ void measure_mass_distribution(
         }
     }
     // normalize mass part over voxels
-    for (int z = 0; z < resolution.z; ++z)
+    for (auto& m : mass_part)
     {
-        for (int y = 0; y < resolution.y; ++y)
-        {
-            for (int x = 0; x < resolution.x; ++x)
-            {
-                mass_part[(z * resolution.y + y) * resolution.x + x] /= allmass;
-            }
-        }
+        m /= allmass;
     }
 }
 
-class worker : public ::thread
+/// write side view of base mesh as template for painting a mass map
+void write_mass_map_draft(const model& mdl, const std::string& filename)
 {
-    model& mdl;
-    vector<float>& is_inside;
-    vector3i resolution;
-    unsigned slice;
-    unsigned nr_slices;
-    int& counter;
-    mutex& counter_mtx;
-    unsigned samples_per_voxel;
-
-  public:
-    worker(
-        model& m,
-        vector<float>& ii,
-        const vector3i& res,
-        unsigned s,
-        unsigned nrs,
-        int& ctr,
-        mutex& cm,
-        unsigned samplespervoxel) :
-        thread("modelmsr"),
-        mdl(m), is_inside(ii), resolution(res), slice(s), nr_slices(nrs),
-        counter(ctr), counter_mtx(cm), samples_per_voxel(samplespervoxel)
+    const vector3f& mmin = mdl.get_base_mesh().min;
+    const vector3f& mmax = mdl.get_base_mesh().max;
+    const double mw      = mmax.y - mmin.y;
+    const double mh      = mmax.z - mmin.z;
+    // sub's y-axis must point right, so that it fits massmap
+    vector<vector3f> triangles;
+    mdl.get_base_mesh().collect_triangles(triangles, matrix4f::one());
+    vector<vector2f> projected;
+    for (const auto& p : triangles)
     {
+        projected.emplace_back(
+            float((p.y - mmin.y) * res_x / mw),
+            float((p.z - mmin.z) * res_y / mh));
     }
-    void loop() override
+    vector<uint8_t> coverage(res_x * res_y);
+    mesh_rasterizer::rasterize(projected, res_x, res_y, coverage);
+    ofstream out(filename, ios::binary);
+    out << "P5\n" << res_x << " " << res_y << "\n255\n";
+    for (unsigned y = res_y; y > 0; --y)
     {
-        int zmin = resolution.z * slice / nr_slices;
-        int zmax = (slice + 1 == nr_slices)
-                       ? resolution.z
-                       : (resolution.z * (slice + 1) / nr_slices);
-
-        const vector3f& bmax = mdl.get_base_mesh().max;
-        const vector3f& bmin = mdl.get_base_mesh().min;
-        const vector3f bsize = bmax - bmin;
-        const double csx     = bsize.x / resolution.x;
-        const double csy     = bsize.y / resolution.y;
-        const double csz     = bsize.z / resolution.z;
-        const double csx2    = csx / samples_per_voxel;
-        const double csy2    = csy / samples_per_voxel;
-        const double csz2    = csz / samples_per_voxel;
-        double zc            = bmin.z + zmin * csz;
-        for (int izz = zmin; izz < zmax; ++izz)
+        for (unsigned x = 0; x < res_x; ++x)
         {
-            double yc = bmin.y;
-            for (int iyy = 0; iyy < resolution.y; ++iyy)
-            {
-                double xc = bmin.x;
-                for (int ixx = 0; ixx < resolution.x; ++ixx)
-                {
-                    unsigned inside = 0;
-                    double zc2      = zc + csz2 * 0.5;
-                    for (unsigned z = 0; z < samples_per_voxel; ++z)
-                    {
-                        double yc2 = yc + csy2 * 0.5;
-                        for (unsigned y = 0; y < samples_per_voxel; ++y)
-                        {
-                            double xc2 = xc + csx2 * 0.5;
-                            for (unsigned x = 0; x < samples_per_voxel; ++x)
-                            {
-                                bool is_in = mdl.get_base_mesh().is_inside(
-                                    vector3f(xc2, yc2, zc2));
-                                inside += is_in ? 1 : 0;
-                                xc2 += csx2;
-                            }
-                            yc2 += csy2;
-                        }
-                        zc2 += csz2;
-                    }
-                    // cout << "is_inside " << inside << " / " <<
-                    // samples_per_voxel*samples_per_voxel*samples_per_voxel <<
-                    // "\n";
-                    is_inside[(izz * resolution.y + iyy) * resolution.x + ixx] =
-                        float(inside)
-                        / (samples_per_voxel * samples_per_voxel
-                           * samples_per_voxel);
-                    xc += csx;
-                }
-                yc += csy;
-                std::unique_lock<std::mutex> ml(counter_mtx);
-                --counter;
-            }
-            zc += csz;
+            out.put(coverage[(y - 1) * res_x + x] ? char(255) : char(0));
         }
-        request_abort();
     }
-};
+    cout << "Wrote " << filename << "\n";
+}
 
-int mymain(std::vector<string>& args)
+void measure(
+    const string& modelfilename,
+    vector3i resolution,
+    unsigned samples_per_voxel)
 {
-    res_x           = 1024;
-    bool fullscreen = true;
-    string modelfilename;
-    for (auto it = args.begin(); it != args.end(); ++it)
-    {
-        if (*it == "--help")
-        {
-            cout << "crosssection, usage:\n--help\t\tshow this\n"
-                 << "--res n\t\tuse resolution n horizontal,\n\t\tn is "
-                    "512,640,800,1024 (recommended) or 1280\n"
-                 << "--nofullscreen\tdon't use fullscreen\n--angles n\tmeasure "
-                    "n different angles\n"
-                 << "MODELFILENAME\n";
-            return 0;
-        }
-        else if (*it == "--nofullscreen")
-        {
-            fullscreen = false;
-        }
-        else if (*it == "--res")
-        {
-            auto it2 = it;
-            ++it2;
-            if (it2 != args.end())
-            {
-                int r = atoi(it2->c_str());
-                if (r == 512 || r == 640 || r == 800 || r == 1024 || r == 1280)
-                    res_x = r;
-                ++it;
-            }
-        }
-        else if (*it == "--angles")
-        {
-            auto it2 = it;
-            ++it2;
-            if (it2 != args.end())
-            {
-                int r  = atoi(it2->c_str());
-                ANGLES = r;
-                ++it;
-            }
-        }
-        else
-        {
-            modelfilename = *it;
-        }
-    }
-
-    res_y = res_x * 3 / 4;
-
-    // parse configuration
-    cfg& mycfg = cfg::instance();
-    mycfg.register_option("screen_res_x", 1024);
-    mycfg.register_option("screen_res_y", 768);
-    mycfg.register_option("fullscreen", true);
-    mycfg.register_option("debug", false);
-    mycfg.register_option("sound", true);
-    mycfg.register_option("use_hqsfx", true);
-    mycfg.register_option("use_ani_filtering", false);
-    mycfg.register_option("anisotropic_level", 1.0f);
-    mycfg.register_option("use_compressed_textures", false);
-    mycfg.register_option("multisampling_level", 0);
-    mycfg.register_option("use_multisampling", false);
-    mycfg.register_option("bloom_enabled", false);
-    mycfg.register_option("hdr_enabled", false);
-    mycfg.register_option("hint_multisampling", 0);
-    mycfg.register_option("hint_fog", 0);
-    mycfg.register_option("hint_mipmap", 0);
-    mycfg.register_option("hint_texture_compression", 0);
-    mycfg.register_option("vsync", false);
-    mycfg.register_option("water_detail", 128);
-    mycfg.register_option("wave_fft_res", 128);
-    mycfg.register_option("wave_phases", 256);
-    mycfg.register_option("wavetile_length", 256.0f);
-    mycfg.register_option("wave_tidecycle_time", 10.24f);
-    mycfg.register_option("usex86sse", true);
-    mycfg.register_option("language", 0);
-    mycfg.register_option("cpucores", 1);
-    mycfg.register_option("terrain_texture_resolution", 0.1f);
-
-    system_interface::parameters params;
-    params.resolution     = {res_x, res_y};
-    params.near_z         = 1.0;
-    params.far_z          = 1000.0;
-    params.fullscreen     = fullscreen;
-    params.resolution2d   = {1024, 768};
-    params.window_caption = "modelmeasure";
-    system_interface::create_instance(new class system_interface(params));
-
     // prepare output data file
     string::size_type st = modelfilename.rfind(".");
     if (st == string::npos)
@@ -364,106 +212,47 @@ int mymain(std::vector<string>& args)
         cout << "*******************************\n";
     }
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(0, res_x, 0, res_y);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D); // trick to render it correctly
-    glDisable(GL_DEPTH_TEST);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    glClearColor(0, 0, 0, 0);
-    glDisable(GL_BLEND);
-
-    mdl = new model(modelfilename, false);
-    mdl->register_layout();
-    mdl->set_layout();
-    vector3f mmin = mdl->get_min();
-    vector3f mmax = mdl->get_max();
-    // modify min/max so that model is always fully visible, when it rotates.
-    mmin              = mmin.min(-mmax);
-    mmax              = -mmin;
-    mw                = mmax.y - mmin.y;
-    mh                = mmax.z - mmin.z;
-    screenarea_meters = mw * mh;
-    xml_elem physcs   = physroot.add_child("cross-section");
+    // the model is not displayed, so no OpenGL context is needed
+    model mdl(modelfilename, false, false);
+    xml_elem physcs = physroot.add_child("cross-section");
     physcs.set_attr(ANGLES, "angles");
     ostringstream osscs;
-
-    // set up primary modelview matrix
-    glLoadIdentity();
-    // do not show model centered at screen but only above waterline for ships
-    if (torpedomode)
+    for (double cs : measure_cross_sections(mdl, torpedomode))
     {
-        glScalef(double(res_x) / mw, double(res_y) / mh, 0.0);
-        glTranslated(-mmin.y, -mmin.z, 0);
+        osscs << cs << " ";
     }
-    else
-    {
-        glScalef(double(res_x) / mw, double(res_y) * 2 / mh, 0.0);
-        glTranslated(-mmin.y, 0, 0);
-    }
-    cout << "min=" << mmin << " max=" << mmax << " mw=" << mw << " mh=" << mh
-         << "\n";
+    physcs.add_child_text(osscs.str());
 
     // voxel resolution
-    const vector3i resolution =
-        torpedomode ? vector3i(2, 4, 2) : vector3i(5, 7, 7);
-    vector<float> mass_part(resolution.x * resolution.y * resolution.z);
-
-    for (unsigned i = 0; i < ANGLES; ++i)
+    if (resolution.x <= 0)
     {
-        double angle = 360.0 * i / ANGLES;
-        measure_model(angle, osscs);
+        resolution = torpedomode ? vector3i(2, 4, 2) : vector3i(5, 7, 7);
     }
-    physcs.add_child_text(osscs.str());
+    if (samples_per_voxel == 0)
+    {
+        samples_per_voxel = torpedomode ? 20 : 4;
+    }
+    vector<float> mass_part(resolution.x * resolution.y * resolution.z);
 
     // some measurements
-    const vector3f& bmax = mdl->get_base_mesh().max;
-    const vector3f& bmin = mdl->get_base_mesh().min;
+    const vector3f& bmax = mdl.get_base_mesh().max;
+    const vector3f& bmin = mdl.get_base_mesh().min;
     const vector3f bsize = bmax - bmin;
     const double vol     = bsize.x * bsize.y * bsize.z;
 
-    vector<float> is_inside(resolution.x * resolution.y * resolution.z);
-    // start workers and let them compute data, then wait for them to finish
-    unsigned tm0 = SYS().millisec();
-    {
-        mutex ctrmtx;
-        int ctr                    = resolution.z * resolution.y;
-        unsigned samples_per_voxel = torpedomode ? 20 : 4;
-        ::thread::ptr<worker> w0(new worker(
-            *mdl, is_inside, resolution, 0, 2, ctr, ctrmtx, samples_per_voxel));
-        ::thread::ptr<worker> w1(new worker(
-            *mdl, is_inside, resolution, 1, 2, ctr, ctrmtx, samples_per_voxel));
-        w0->start();
-        w1->start();
-        SYS().prepare_2d_drawing();
-        while (ctr > 0)
-        {
-            int w = res_x - res_x * ctr / (resolution.z * resolution.y);
-            primitive_col<4> qd(GL_QUADS);
-            qd.vertices[3] = vector3f(0, 0, 0);
-            qd.vertices[2] = vector3f(0, res_y / 10, 0);
-            qd.vertices[1] = vector3f(w, res_y / 10, 0);
-            qd.vertices[0] = vector3f(w, 0, 0);
-            qd.colors[3]   = colorf(1, 0, 0);
-            qd.colors[2]   = colorf(1, 0, 0);
-            qd.colors[1]   = colorf(0, 0, 1);
-            qd.colors[0]   = colorf(0, 0, 1);
-            qd.render();
-            SYS().finish_frame();
-            ::thread::sleep(100);
-        }
-        SYS().unprepare_2d_drawing();
-    }
-    cout << "\n";
-    unsigned tm1 = SYS().millisec();
-    cout << "time needed " << tm1 - tm0 << "\n";
+    const auto tm0 = std::chrono::steady_clock::now();
+    vector<vector3f> triangles;
+    mdl.get_base_mesh().collect_triangles(triangles, matrix4f::one());
+    const vector<float> is_inside = mesh_rasterizer::compute_voxel_volumes(
+        triangles, bmin, bmax, resolution, samples_per_voxel);
+    const auto tm1 = std::chrono::steady_clock::now();
+    cout << "time needed "
+         << std::chrono::duration<double, std::milli>(tm1 - tm0).count()
+         << "ms\n";
 
     unsigned nr_inside = 0;
     double inside_vol  = 0;
     ostringstream insidedat;
-    ostringstream massdis;
     for (int z = 0; z < resolution.z; ++z)
     {
         cout << "Layer " << z + 1 << "/" << resolution.z << "\n";
@@ -497,40 +286,17 @@ int mymain(std::vector<string>& args)
         string massmapfilename = modelfilename.substr(0, st) + ".mass.png";
         measure_mass_distribution(
             massmapfilename, resolution, mass_part, is_inside);
-        for (int z = 0; z < resolution.z; ++z)
+        for (float m : mass_part)
         {
-            for (int y = 0; y < resolution.y; ++y)
-            {
-                for (int x = 0; x < resolution.x; ++x)
-                {
-                    massdis
-                        << mass_part[(z * resolution.y + y) * resolution.x + x]
-                        << " ";
-                }
-            }
+            massdis << m << " ";
         }
         ve.add_child("mass-distribution").add_child_text(massdis.str());
     }
     catch (std::exception& e)
     {
         cout << e.what() << "\n";
-        mmin = mdl->get_base_mesh().min;
-        mmax = mdl->get_base_mesh().max;
-        mw   = mmax.y - mmin.y;
-        mh   = mmax.z - mmin.z;
-        glLoadIdentity();
-        glScalef(double(res_x) / mw, double(res_y) / mh, 0.0);
-        cout << "min=" << mmin << " max=" << mmax << " mw=" << mw
-             << " mh=" << mh << "\n";
-        // sub's y-axis must point right, so that it fits massmap
-        glTranslated(-mmin.y, -mmin.z, 0);
-        glRotated(-90.0, 0, 1, 0);
-        glRotated(-90.0, 1, 0, 0);
-        glClear(GL_COLOR_BUFFER_BIT);
-        mdl->get_base_mesh().display();
-        SYS().finish_frame();
-        SYS().screenshot(modelfilename.substr(0, st) + ".mass_map_draft");
-        ::thread::sleep(3000);
+        write_mass_map_draft(
+            mdl, modelfilename.substr(0, st) + ".mass_map_draft.pgm");
     }
 
     double vol_inside = (inside_vol * vol) / is_inside.size();
@@ -538,19 +304,79 @@ int mymain(std::vector<string>& args)
     // BRT) of " << vol << "\n";
     physroot.add_child("volume").set_attr(vol_inside);
     physroot.child("volume").set_attr(
-        mdl->get_base_mesh().compute_volume(), "mesh");
+        mdl.get_base_mesh().compute_volume(), "mesh");
     physroot.add_child("center-of-gravity")
-        .set_attr(mdl->get_base_mesh().compute_center_of_gravity());
-    matrix3 ten = mdl->get_base_mesh().compute_inertia_tensor(
-        mdl->get_base_mesh_transformation());
+        .set_attr(mdl.get_base_mesh().compute_center_of_gravity());
+    matrix3 ten = mdl.get_base_mesh().compute_inertia_tensor(
+        mdl.get_base_mesh_transformation());
     ostringstream ossit;
     ten.to_stream(ossit);
     physroot.add_child("inertia-tensor").add_child_text(ossit.str());
 
     physdat.save();
+}
+} // namespace
 
-    delete mdl;
-    system_interface::destroy_instance();
+int mymain(std::vector<string>& args)
+{
+    vector<string> modelfilenames;
+    vector3i resolution(0, 0, 0);
+    unsigned samples_per_voxel = 0;
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        auto next_arg = [&]() {
+            ++it;
+            if (it == args.end())
+            {
+                THROW(error, "missing value for option");
+            }
+            return atoi(it->c_str());
+        };
+        if (*it == "--help")
+        {
+            cout << "modelmeasure, usage:\n--help\t\tshow this\n"
+                 << "--res n\t\tuse resolution n horizontal for cross "
+                    "sections\n"
+                 << "--angles n\tmeasure n different angles\n"
+                 << "--voxels x y z\tuse x*y*z voxels\n"
+                 << "--samples n\tuse n^3 samples per voxel\n"
+                 << "MODELFILENAME...\n";
+            return 0;
+        }
+        else if (*it == "--res")
+        {
+            int r = next_arg();
+            if (r >= 64)
+            {
+                res_x = r;
+                res_y = res_x * 3 / 4;
+            }
+        }
+        else if (*it == "--angles")
+        {
+            ANGLES = next_arg();
+        }
+        else if (*it == "--voxels")
+        {
+            resolution.x = next_arg();
+            resolution.y = next_arg();
+            resolution.z = next_arg();
+        }
+        else if (*it == "--samples")
+        {
+            samples_per_voxel = next_arg();
+        }
+        else
+        {
+            modelfilenames.push_back(*it);
+        }
+    }
+
+    for (const auto& modelfilename : modelfilenames)
+    {
+        cout << "Measuring " << modelfilename << "\n";
+        measure(modelfilename, resolution, samples_per_voxel);
+    }
 
     return 0;
 }
@@ -207,80 +207,69 @@ void music::request_abort()
 
 auto music::append_track(const std::string& filename) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_append_track(*this, filename)));
+    return command_queue.send<command_append_track>(*this, filename);
 }
 
 auto music::set_playback_mode(playback_mode pbm) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_set_playback_mode(*this, pbm)));
+    return command_queue.send<command_set_playback_mode>(*this, pbm);
 }
 
 auto music::play(unsigned fadein) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_play(*this, fadein)));
+    return command_queue.send<command_play>(*this, fadein);
 }
 
 auto music::stop(unsigned fadeout) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_stop(*this, fadeout)));
+    return command_queue.send<command_stop>(*this, fadeout);
 }
 
 auto music::pause() -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_pause(*this)));
+    return command_queue.send<command_pause>(*this);
 }
 
 auto music::resume() -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_resume(*this)));
+    return command_queue.send<command_resume>(*this);
 }
 
 auto music::set_music_position(float pos) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_set_music_position(*this, pos)));
+    return command_queue.send<command_set_music_position>(*this, pos);
 }
 
 auto music::play_track(unsigned nr, unsigned fadeouttime, unsigned fadeintime)
     -> bool
 {
-    return command_queue.send(std::unique_ptr<message>(
-        new command_play_track(*this, nr, fadeouttime, fadeintime)));
+    return command_queue.send<command_play_track>(
+        *this, nr, fadeouttime, fadeintime);
 }
 
 auto music::track_finished() -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_track_finished(*this)), false);
+    return command_queue.post<command_track_finished>(*this);
 }
 
 auto music::get_playlist() -> std::vector<std::string>
 {
     std::vector<std::string> myplaylist;
-    command_queue.send(
-        std::unique_ptr<message>(new command_get_playlist(*this, myplaylist)));
+    command_queue.send<command_get_playlist>(*this, myplaylist);
     return myplaylist;
 }
 
 auto music::get_current_track() -> unsigned
 {
     unsigned track = 0;
-    command_queue.send(
-        std::unique_ptr<message>(new command_get_current_track(*this, track)));
+    command_queue.send<command_get_current_track>(*this, track);
     return track;
 }
 
 auto music::is_playing() -> bool
 {
     bool isply = false;
-    command_queue.send(
-        std::unique_ptr<message>(new command_is_playing(*this, isply)));
+    command_queue.send<command_is_playing>(*this, isply);
     return isply;
 }
 
@@ -290,20 +279,19 @@ auto music::play_sfx(
     angle listener_dir,
     const vector3& noise_pos) -> bool
 {
-    return command_queue.send(std::unique_ptr<message>(new command_play_sfx(
-        *this, category, listener, listener_dir, noise_pos)));
+    return command_queue.post<command_play_sfx>(
+        *this, category, listener, listener_dir, noise_pos);
 }
 
 auto music::play_sfx_machine(const std::string& name, unsigned throttle) -> bool
 {
-    return command_queue.send(std::unique_ptr<message>(
-        new command_play_sfx_machine(*this, name, throttle)));
+    // state changing, so it must not be dropped when the queue is full
+    return command_queue.send<command_play_sfx_machine>(*this, name, throttle);
 }
 
 auto music::pause_sfx(bool on) -> bool
 {
-    return command_queue.send(
-        std::unique_ptr<message>(new command_pause_sfx(*this, on)));
+    return command_queue.send<command_pause_sfx>(*this, on);
 }
 
 // -------------------- command exec --------------------
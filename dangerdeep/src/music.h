@@ -72,6 +72,8 @@ class music : public singleton<class music>, public ::thread
     music(bool use_music = true, unsigned sample_rate = 44100);
 
     // ----------- command interface --------------------
+    // Commands are run by the music thread. Sound effects are sent without
+    // waiting, all other commands wait for their result.
 
     /// append entry to play list
     ///@param filename - filename of track
@@ -129,7 +131,7 @@ class music : public singleton<class music>, public ::thread
     ///@param listener - position of listener
     ///@param listener_dir - angle that listener is facing (around z-axis)
     ///@param noise_pos - position of noise source
-    ///@returns true if command was successful
+    ///@returns false if the command could not be queued
     bool play_sfx(
         const std::string& category,
         const vector3& listener,
@@ -139,12 +141,12 @@ class music : public singleton<class music>, public ::thread
     /// play machine (environmental) sfx
     ///@param name - name of machine
     ///@param throttle - throttle level, can be 0...100, 0 stops play
-    ///@returns true if command was successful
+    ///@returns false if the command failed
     bool play_sfx_machine(const std::string& name, unsigned throttle);
 
     /// Pause/Resume all sound effects
     ///@param on - true to pause, false to resume
-    ///@returns true if command was successful
+    ///@returns false if the command failed
     bool pause_sfx(bool on);
 
     // ---------------------------------------------
@@ -22,18 +22,22 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <cstddef>
 #include <iostream>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 ///\brief Handles and caches instances of globally used objects.
-// fixme: to make it useable as *cache* we need to delay destruction. when an
-// object reaches refcount zero, do not delete it immediatly. Check periodically
-// or when the next object is deleted, so at least 1-2 objects can be hold with
-// refcount zero, like a delete-queue. This avoids permanent reload when e.g.
-// user switches between two menes and both use images of the image-cache.
-// fixme2: maybe add special handler-class, like an auto_ptr, c'tor ref's an
+/** Objects are deleted when their reference count reaches zero, unless the
+    cache has a memory budget. Then unreferenced objects are kept until their
+    memory exceeds the budget, and the least recently used ones are deleted
+    first. This avoids permanent reloading when e.g. the user switches between
+    two menus that use the same images. The memory of an object is taken from
+    its get_memory_used() function, objects without it count as empty.
+*/
+// fixme: maybe add special handler-class, like an auto_ptr, c'tor ref's an
 // object, d'tor unrefs it. Thus objcache usage is easier.
 
 // fixme 2: add "reference" class, that is auto_ptr like reference handler. Do
@@ -43,12 +47,107 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 template<class T>
 class objcachet
 {
-    std::map<std::string, std::pair<unsigned, T*>> cache;
+    struct entry
+    {
+        unsigned refs;
+        T* obj;
+        unsigned last_use{0}; ///< when it was unreferenced
+        std::size_t bytes{0}; ///< memory of unreferenced object
+    };
+    std::map<std::string, entry> cache;
     std::string basedir;
+    std::size_t budget{0};       ///< for unreferenced objects
+    std::size_t unused_bytes{0}; ///< memory of unreferenced objects
+    unsigned use_counter{0};
     objcachet()           = delete;
     objcachet<T>& operator=(const objcachet<T>&) = delete;
     objcachet(const objcachet<T>&)               = delete;
 
+    template<class U, typename = void>
+    struct has_memory_used : std::false_type
+    {
+    };
+    template<class U>
+    struct has_memory_used<
+        U,
+        std::void_t<decltype(std::declval<const U&>().get_memory_used())>>
+        : std::true_type
+    {
+    };
+
+    static std::size_t memory_used(const T& obj)
+    {
+        if constexpr (has_memory_used<T>::value)
+        {
+            return obj.get_memory_used();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /// count object as used again
+    void reuse(entry& e)
+    {
+        if (e.refs == 0)
+        {
+            unused_bytes -= e.bytes;
+            e.bytes = 0;
+        }
+        ++e.refs;
+    }
+
+    /// give back a reference to an object
+    void release(typename std::map<std::string, entry>::iterator it)
+    {
+        if (it->second.refs == 0)
+        {
+            // error, unref'd too much...
+            return;
+        }
+        --(it->second.refs);
+        if (it->second.refs == 0)
+        {
+            if (budget == 0)
+            {
+                delete it->second.obj;
+                cache.erase(it);
+                return;
+            }
+            it->second.last_use = ++use_counter;
+            it->second.bytes    = memory_used(*it->second.obj);
+            unused_bytes += it->second.bytes;
+            trim();
+        }
+    }
+
+    /// delete least recently used objects until budget is met
+    void trim()
+    {
+        while (unused_bytes > budget)
+        {
+            auto oldest = cache.end();
+            for (auto it = cache.begin(); it != cache.end(); ++it)
+            {
+                if (it->second.refs == 0
+                    && (oldest == cache.end()
+                        || it->second.last_use < oldest->second.last_use))
+                {
+                    oldest = it;
+                }
+            }
+            if (oldest == cache.end())
+            {
+                unused_bytes = 0;
+                return;
+            }
+            unused_bytes -= oldest->second.bytes;
+            delete oldest->second.obj;
+            cache.erase(oldest);
+        }
+    }
+
   public:
     objcachet(std::string basedir_) : basedir(std::move(basedir_)) { }
     ~objcachet() { clear(); }
@@ -57,8 +156,38 @@ class objcachet
     void clear()
     {
         for (auto it = cache.begin(); it != cache.end(); ++it)
-            delete it->second.second;
+            delete it->second.obj;
         cache.clear();
+        unused_bytes = 0;
+    }
+
+    /// set memory budget for unreferenced objects, 0 deletes them at once
+    void set_budget(std::size_t bytes)
+    {
+        budget = bytes;
+        if (budget == 0)
+        {
+            for (auto it = cache.begin(); it != cache.end();)
+            {
+                if (it->second.refs == 0)
+                {
+                    delete it->second.obj;
+                    it = cache.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            unused_bytes = 0;
+        }
+        trim();
+    }
+
+    /// get memory of unreferenced objects kept in cache
+    [[nodiscard]] std::size_t get_unused_memory() const
+    {
+        return unused_bytes;
     }
 
     T* find(const std::string& objname)
@@ -68,7 +197,7 @@ class objcachet
         auto it = cache.find(objname);
         if (it == cache.end())
             return nullptr;
-        return it->second.second;
+        return it->second.obj;
     }
 
     T* ref(const std::string& objname)
@@ -78,18 +207,16 @@ class objcachet
         auto it = cache.find(objname);
         if (it == cache.end())
         {
-            it =
-                cache
-                    .insert(std::make_pair(
-                        objname,
-                        std::make_pair((unsigned) 1, new T(basedir + objname))))
-                    .first;
+            it = cache
+                     .insert(std::make_pair(
+                         objname, entry{1, new T(basedir + objname)}))
+                     .first;
         }
         else
         {
-            ++(it->second.first);
+            reuse(it->second);
         }
-        return it->second.second;
+        return it->second.obj;
     }
 
     bool ref(const std::string& objname, T* obj)
@@ -99,10 +226,7 @@ class objcachet
         auto it = cache.find(objname);
         if (it == cache.end())
         {
-            it = cache
-                     .insert(std::make_pair(
-                         objname, std::make_pair((unsigned) 1, obj)))
-                     .first;
+            it = cache.insert(std::make_pair(objname, entry{1, obj})).first;
         }
         else
         {
@@ -118,17 +242,7 @@ class objcachet
         auto it = cache.find(objname);
         if (it != cache.end())
         {
-            if (it->second.first == 0)
-            {
-                // error, unref'd too much...
-                return;
-            }
-            --(it->second.first);
-            if (it->second.first == 0)
-            {
-                delete it->second.second;
-                cache.erase(it);
-            }
+            release(it);
         }
     }
 
@@ -136,19 +250,9 @@ class objcachet
     {
         for (auto it = cache.begin(); it != cache.end(); ++it)
         {
-            if (it->second.second == obj)
+            if (it->second.obj == obj)
             {
-                if (it->second.first == 0)
-                {
-                    // error, unref'd too much...
-                    return;
-                }
-                --(it->second.first);
-                if (it->second.first == 0)
-                {
-                    delete it->second.second;
-                    cache.erase(it);
-                }
+                release(it);
                 break;
             }
         }
@@ -157,12 +261,9 @@ class objcachet
     void print() const
     {
         std::cout << "objcache: " << cache.size() << " entries.\n";
-        for (typename std::map<std::string, std::pair<unsigned, T*>>::
-                 const_iterator it = cache.begin();
-             it != cache.end();
-             ++it)
-            std::cout << "key=\"" << it->first << "\" ref=" << it->second.first
-                      << " addr=" << it->second.second << "\n";
+        for (auto it = cache.begin(); it != cache.end(); ++it)
+            std::cout << "key=\"" << it->first << "\" ref=" << it->second.refs
+                      << " addr=" << it->second.obj << "\n";
     }
 
     class reference
@@ -24,32 +24,45 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "constant.h"
+#include "error.h"
 #include "random_generator.h"
 #include "vector3.h"
 
 #include <complex>
 #include <fftw3.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 // use float fftw (faster) or double (default) ?
 #ifdef WITH_FLOAT_FFTW
-#define FFT_COMPLEX_TYPE fftwf_complex
-#define FFT_REAL_TYPE    float
-#define FFT_PLAN_TYPE    fftwf_plan
-#define FFT_CREATE_PLAN  fftwf_plan_dft_c2r_2d
-#define FFT_DELETE_PLAN  fftwf_destroy_plan
-#define FFT_EXECUTE_PLAN fftwf_execute
-#define FFT_ALLOC        fftwf_malloc
-#define FFT_FREE         fftwf_free
+#define FFT_COMPLEX_TYPE  fftwf_complex
+#define FFT_REAL_TYPE     float
+#define FFT_PLAN_TYPE     fftwf_plan
+#define FFT_CREATE_PLAN   fftwf_plan_dft_c2r_2d
+#define FFT_DELETE_PLAN   fftwf_destroy_plan
+#define FFT_EXECUTE_PLAN  fftwf_execute_dft_c2r
+#define FFT_ALLOC         fftwf_malloc
+#define FFT_FREE          fftwf_free
+#define FFT_IMPORT_WISDOM fftwf_import_wisdom_from_filename
+#define FFT_EXPORT_WISDOM fftwf_export_wisdom_to_filename
+#define FFT_INIT_THREADS  fftwf_init_threads
+#define FFT_PLAN_THREADS  fftwf_plan_with_nthreads
 #else
-#define FFT_COMPLEX_TYPE fftw_complex
-#define FFT_REAL_TYPE    double
-#define FFT_PLAN_TYPE    fftw_plan
-#define FFT_CREATE_PLAN  fftw_plan_dft_c2r_2d
-#define FFT_DELETE_PLAN  fftw_destroy_plan
-#define FFT_EXECUTE_PLAN fftw_execute
-#define FFT_ALLOC        fftw_malloc
-#define FFT_FREE         fftw_free
+#define FFT_COMPLEX_TYPE  fftw_complex
+#define FFT_REAL_TYPE     double
+#define FFT_PLAN_TYPE     fftw_plan
+#define FFT_CREATE_PLAN   fftw_plan_dft_c2r_2d
+#define FFT_DELETE_PLAN   fftw_destroy_plan
+#define FFT_EXECUTE_PLAN  fftw_execute_dft_c2r
+#define FFT_ALLOC         fftw_malloc
+#define FFT_FREE          fftw_free
+#define FFT_IMPORT_WISDOM fftw_import_wisdom_from_filename
+#define FFT_EXPORT_WISDOM fftw_export_wisdom_to_filename
+#define FFT_INIT_THREADS  fftw_init_threads
+#define FFT_PLAN_THREADS  fftw_plan_with_nthreads
 #endif
 
 #ifdef WIN32
@@ -59,6 +72,100 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 #endif
 
+///\brief Shares fftw plans among all ocean_wave_generator objects.
+/** Creating a plan measures the speed of several algorithms, which takes
+    long. So plans are created once per grid size and executed on the
+    buffers of each generator, what fftw allows from several threads at
+    once. The planner results (wisdom) can be kept in a file, which makes
+    creating plans fast on later runs.
+*/
+class fft_plan_cache
+{
+  public:
+    /// get plan for a complex to real transform of N*N values
+    static FFT_PLAN_TYPE get(int N)
+    {
+        auto& c = instance();
+        std::lock_guard<std::mutex> ml(c.mtx);
+        auto it = c.plans.find(N);
+        if (it != c.plans.end())
+        {
+            return it->second;
+        }
+        // plan with buffers of the same size and alignment as later used
+        auto* in = (FFT_COMPLEX_TYPE*) FFT_ALLOC(
+            sizeof(FFT_COMPLEX_TYPE) * (N * (N / 2 + 1)));
+        auto* out = (FFT_REAL_TYPE*) FFT_ALLOC(sizeof(FFT_REAL_TYPE) * (N * N));
+        FFT_PLAN_TYPE plan = nullptr;
+        if (in && out)
+        {
+            plan = FFT_CREATE_PLAN(N, N, in, out, FFTW_MEASURE);
+        }
+        if (in)
+            FFT_FREE(in);
+        if (out)
+            FFT_FREE(out);
+        if (!plan)
+        {
+            THROW(error, "could not create fftw plan");
+        }
+        c.plans[N] = plan;
+        if (!c.wisdom_file.empty())
+        {
+            FFT_EXPORT_WISDOM(c.wisdom_file.c_str());
+        }
+        return plan;
+    }
+
+    /// read wisdom from file, new wisdom is written there too. Gives false
+    /// if the file could not be read, e.g. on the first run.
+    static bool use_wisdom_file(const std::string& filename)
+    {
+        auto& c = instance();
+        std::lock_guard<std::mutex> ml(c.mtx);
+        c.wisdom_file = filename;
+        return FFT_IMPORT_WISDOM(filename.c_str()) != 0;
+    }
+
+    /// let each transform use several threads, only for plans created
+    /// later. Does nothing when not compiled with WITH_FFTW_THREADS.
+    static void set_nr_of_threads(unsigned n)
+    {
+#ifdef WITH_FFTW_THREADS
+        auto& c = instance();
+        std::lock_guard<std::mutex> ml(c.mtx);
+        if (!c.threads_initialized)
+        {
+            c.threads_initialized = FFT_INIT_THREADS() != 0;
+        }
+        if (c.threads_initialized)
+        {
+            FFT_PLAN_THREADS(int(std::max(n, 1U)));
+        }
+#endif
+    }
+
+  protected:
+    std::mutex mtx;
+    std::unordered_map<int, FFT_PLAN_TYPE> plans;
+    std::string wisdom_file;
+    bool threads_initialized{false};
+
+    fft_plan_cache() = default;
+    ~fft_plan_cache()
+    {
+        for (auto& p : plans)
+        {
+            FFT_DELETE_PLAN(p.second);
+        }
+    }
+    static fft_plan_cache& instance()
+    {
+        static fft_plan_cache c;
+        return c;
+    }
+};
+
 ///\brief A generator class for ocean wave height data using a statistical model
 /// and the FFT.
 template<class T>
@@ -70,7 +177,8 @@ class ocean_wave_generator
     T wave_height_scale; // wave height scalar
     T Lm;                // tile size in m
     T w0;                // cycle time, 0.0 if no cycling needed
-    std::vector<std::complex<T>> h0tilde;
+    // read only after creation, so shared by copies
+    std::shared_ptr<const std::vector<std::complex<T>>> h0tilde;
     std::vector<std::complex<T>> htilde; // holds values for one fix time.
     mutable random_generator rndgen;
 
@@ -85,7 +193,7 @@ class ocean_wave_generator
     FFT_COMPLEX_TYPE *fft_in,
         *fft_in2; // can't be a vector, since the type is an array
     FFT_REAL_TYPE *fft_out, *fft_out2; // for sake of uniformity
-    FFT_PLAN_TYPE plan, plan2, plan3;
+    FFT_PLAN_TYPE plan; // shared, see fft_plan_cache
 
     void freemem()
     {
@@ -151,6 +259,9 @@ class ocean_wave_generator
         int gridsize,
         int clearlowfreq = 0);
     void set_time(T time); // call this before any compute_*() function
+    /// change wind, the random numbers are the same as before, so a small
+    /// change of wind gives a small change of waves.
+    void set_wind(const vector2t<T>& winddir, T windspeed);
     void compute_heights(std::vector<T>& waveheights) const;
     // use this after height computation to avoid the overhead of fft normals
     void compute_finite_normals(
@@ -229,6 +340,9 @@ template<class T>
 void ocean_wave_generator<T>::compute_h0tilde()
 {
     const T pi2 = T(2.0 * constant::PI);
+    // a new vector, because copies may still use the old one
+    auto h0 =
+        std::make_shared<std::vector<std::complex<T>>>((N + 1) * (N + 1));
     // outer parts of arrays (x2,y2 away from zero) hold higher frequencies.
     // the significant frequencies are very close to zero, anything above
     // +-N/4 or so is only very high frequency
@@ -237,10 +351,11 @@ void ocean_wave_generator<T>::compute_h0tilde()
         T Ky = pi2 * y2 / Lm;
         for (int x = 0, x2 = -N / 2; x <= N; ++x, ++x2)
         {
-            T Kx                     = pi2 * x2 / Lm;
-            h0tilde[y * (N + 1) + x] = h0_tilde(vector2t<T>(Kx, Ky));
+            T Kx                   = pi2 * x2 / Lm;
+            (*h0)[y * (N + 1) + x] = h0_tilde(vector2t<T>(Kx, Ky));
         }
     }
+    h0tilde = std::move(h0);
 }
 
 template<class T>
@@ -248,9 +363,9 @@ std::complex<T>
 ocean_wave_generator<T>::h_tilde(const vector2t<T>& K, int kx, int ky, T time)
     const
 {
-    std::complex<T> h0_tildeK = h0tilde[ky * (N + 1) + kx];
-    std::complex<T> h0_tildemKconj =
-        conj(h0tilde[(N - ky) * (N + 1) + (N - kx)]);
+    const auto& h0                 = *h0tilde;
+    std::complex<T> h0_tildeK      = h0[ky * (N + 1) + kx];
+    std::complex<T> h0_tildemKconj = conj(h0[(N - ky) * (N + 1) + (N - kx)]);
     // all frequencies should be multiples of one base frequency (see paper), if
     // we want a looping animation
     T wK  = T(sqrt(constant::GRAVITY * K.length()));
@@ -297,12 +412,10 @@ ocean_wave_generator<T>::ocean_wave_generator(
     w0(cycletime < T(0.0) ? T(0.0) : T(2.0 * constant::PI) / cycletime),
     rndgen(12345)
 {
-    h0tilde.resize((N + 1) * (N + 1));
     compute_h0tilde();
     htilde.resize(N * (N / 2 + 1));
     allocmem();
-    plan  = FFT_CREATE_PLAN(N, N, fft_in, fft_out, 0);
-    plan2 = FFT_CREATE_PLAN(N, N, fft_in2, fft_out2, 0);
+    plan = fft_plan_cache::get(N);
 }
 
 template<class T>
@@ -312,11 +425,10 @@ ocean_wave_generator<T>::ocean_wave_generator(
     W(owg.W), v(owg.v), wave_height_scale(owg.wave_height_scale), Lm(owg.Lm),
     w0(owg.w0), h0tilde(owg.h0tilde), rndgen(12345)
 {
-    // clear htilde, create new fftw plans.
+    // clear htilde, share h0tilde and plan, only buffers are per object.
     htilde.resize(N * (N / 2 + 1));
     allocmem();
-    plan  = FFT_CREATE_PLAN(N, N, fft_in, fft_out, 0);
-    plan2 = FFT_CREATE_PLAN(N, N, fft_in2, fft_out2, 0);
+    plan = fft_plan_cache::get(N);
 }
 
 template<class T>
@@ -328,15 +440,17 @@ ocean_wave_generator<T>::ocean_wave_generator(
     W(owg.W), v(owg.v), wave_height_scale(owg.wave_height_scale), Lm(owg.Lm),
     w0(owg.w0), rndgen(12345)
 {
-    h0tilde.resize((N + 1) * (N + 1));
+    auto h0p =
+        std::make_shared<std::vector<std::complex<T>>>((N + 1) * (N + 1));
+    auto& h0 = *h0p; // filled here, then shared read only
     // copy h0 tilde instead of computing it
     int offset = (owg.N - N) / 2;
     for (int y = 0; y <= N; ++y)
     {
         for (int x = 0; x <= N; ++x)
         {
-            h0tilde[y * (N + 1) + x] =
-                owg.h0tilde[(y + offset) * (owg.N + 1) + (x + offset)];
+            h0[y * (N + 1) + x] =
+                (*owg.h0tilde)[(y + offset) * (owg.N + 1) + (x + offset)];
         }
     }
     bool clearhigh = false;
@@ -355,10 +469,10 @@ ocean_wave_generator<T>::ocean_wave_generator(
         {
             for (int x = 0; x < clearlowfreq; ++x)
             {
-                h0tilde[y * (N + 1) + x]             = 0;
-                h0tilde[y * (N + 1) + (N - x)]       = 0;
-                h0tilde[(N - y) * (N + 1) + x]       = 0;
-                h0tilde[(N - y) * (N + 1) + (N - x)] = 0;
+                h0[y * (N + 1) + x]             = 0;
+                h0[y * (N + 1) + (N - x)]       = 0;
+                h0[(N - y) * (N + 1) + x]       = 0;
+                h0[(N - y) * (N + 1) + (N - x)] = 0;
             }
         }
     }
@@ -372,21 +486,19 @@ ocean_wave_generator<T>::ocean_wave_generator(
                  x <= N / 2 - 1 + clearlowfreq;
                  ++x)
             {
-                h0tilde[y * (N + 1) + x] = 0;
+                h0[y * (N + 1) + x] = 0;
             }
         }
     }
+    h0tilde = std::move(h0p);
     htilde.resize(N * (N / 2 + 1));
     allocmem();
-    plan  = FFT_CREATE_PLAN(N, N, fft_in, fft_out, 0);
-    plan2 = FFT_CREATE_PLAN(N, N, fft_in2, fft_out2, 0);
+    plan = fft_plan_cache::get(N);
 }
 
 template<class T>
 ocean_wave_generator<T>::~ocean_wave_generator /*<T>*/ ()
 {
-    FFT_DELETE_PLAN(plan);
-    FFT_DELETE_PLAN(plan2);
     freemem();
 }
 
@@ -396,6 +508,15 @@ void ocean_wave_generator<T>::set_time(T time)
     compute_htilde(time);
 }
 
+template<class T>
+void ocean_wave_generator<T>::set_wind(const vector2t<T>& winddir, T windspeed)
+{
+    W      = winddir.normal();
+    v      = windspeed;
+    rndgen = random_generator(12345);
+    compute_h0tilde();
+}
+
 template<class T>
 void ocean_wave_generator<T>::compute_heights(std::vector<T>& waveheights) const
 {
@@ -413,7 +534,7 @@ void ocean_wave_generator<T>::compute_heights(std::vector<T>& waveheights) const
         }
     }
 
-    FFT_EXECUTE_PLAN(plan);
+    FFT_EXECUTE_PLAN(plan, fft_in, fft_out);
 
     // our kx,ky are in {-N/2...N/2}, but fft goes from {0...N-1}
     // so we have to add N/2 in the formulas, a term that can be seperated as
@@ -481,8 +602,8 @@ void ocean_wave_generator<T>::compute_normals(
         }
     }
 
-    FFT_EXECUTE_PLAN(plan);
-    FFT_EXECUTE_PLAN(plan2);
+    FFT_EXECUTE_PLAN(plan, fft_in, fft_out);
+    FFT_EXECUTE_PLAN(plan, fft_in2, fft_out2);
 
     if (wavenormals.size() != N * N)
         wavenormals.resize(N * N);
@@ -529,8 +650,8 @@ void ocean_wave_generator<T>::compute_displacements(
         }
     }
 
-    FFT_EXECUTE_PLAN(plan);
-    FFT_EXECUTE_PLAN(plan2);
+    FFT_EXECUTE_PLAN(plan, fft_in, fft_out);
+    FFT_EXECUTE_PLAN(plan, fft_in2, fft_out2);
 
     if (wavedisplacements.size() != unsigned(N * N))
         wavedisplacements.resize(N * N);
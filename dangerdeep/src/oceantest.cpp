@@ -22,7 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ocean_wave_generator.h"
 
+#include <chrono>
 #include <fstream>
+#include <iostream>
 using namespace std;
 
 #ifndef fmin
@@ -32,8 +34,62 @@ using namespace std;
 #define fmax(x, y) (x > y) ? x : y
 #endif
 
+/// measure plan creation, copying and transform throughput
+int benchmark()
+{
+    using clock = chrono::steady_clock;
+    auto ms     = [](clock::time_point t0, clock::time_point t1) {
+        return chrono::duration<double, milli>(t1 - t0).count();
+    };
+    const unsigned nr_of_copies     = 16;
+    const unsigned nr_of_transforms = 16;
+    for (unsigned res : {128U, 256U, 512U, 1024U})
+    {
+        // first generator of a size creates the plan, which is costly with
+        // FFTW_MEASURE unless wisdom is known.
+        const auto t0 = clock::now();
+        ocean_wave_generator<float> owg(res, vector2f(1, 1), 12, 1e-8, 256, 10);
+        const auto t1 = clock::now();
+        // copies share the plan and the base amplitudes
+        vector<ocean_wave_generator<float>> copies;
+        copies.reserve(nr_of_copies);
+        for (unsigned i = 0; i < nr_of_copies; ++i)
+        {
+            copies.emplace_back(owg);
+        }
+        const auto t2 = clock::now();
+        vector<float> heights;
+        vector<vector3f> normals;
+        vector<vector2f> displacements;
+        for (unsigned i = 0; i < nr_of_transforms; ++i)
+        {
+            owg.set_time(i * 0.1);
+            owg.compute_heights(heights);
+        }
+        const auto t3 = clock::now();
+        for (unsigned i = 0; i < nr_of_transforms; ++i)
+        {
+            owg.set_time(i * 0.1);
+            owg.compute_normals(normals);
+            owg.compute_displacements(1.0f, displacements);
+        }
+        const auto t4 = clock::now();
+        cout << res << "x" << res << ": creation " << ms(t0, t1)
+             << "ms, copy " << ms(t1, t2) / nr_of_copies << "ms, heights "
+             << nr_of_transforms * 1000.0 / ms(t2, t3)
+             << " transforms/s, normals+displacements "
+             << nr_of_transforms * 4 * 1000.0 / ms(t3, t4)
+             << " transforms/s\n";
+    }
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
+    if (argc > 1 && string(argv[1]) == "--benchmark")
+    {
+        return benchmark();
+    }
     const unsigned resbig = 1024;
     const unsigned ressml = 128;
     srand(1234);
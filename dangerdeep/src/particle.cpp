@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "global_data.h" // for myfrac etc.
 #include "oglext/OglExt.h"
 #include "primitives.h"
+#include "profiler.h"
 #include "texture.h"
 
 #include <algorithm>
@@ -513,6 +514,7 @@ void particle::display_all(
     class game& gm,
     const colorf& light_color)
 {
+    PROFILE_ZONE("particle::display_all");
     glDepthMask(GL_FALSE);
     matrix4 mv      = matrix4::get_gl(GL_MODELVIEW_MATRIX);
     vector3 mvtrans = -mv.inverse().column3(3);
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "color.h"
+#include "memory_usage.h"
 #include "vector3.h"
 
 #include <vector>
@@ -42,6 +43,7 @@ class particle
     vector3 position;
     vector3 velocity;
     double life{1.0}; // 0...1, 0 = faded out
+    memory_usage::account mem{memory_usage::particles, sizeof(particle)};
     particle() = default;
     particle(const particle& other);
     particle& operator=(const particle& other);
@@ -0,0 +1,203 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// Uniform grid of 2d points for range queries
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "vector2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+///\brief Stores values at 2d positions in a sparse uniform grid.
+/** Queries only visit the cells overlapping the query circle. All results
+    are given in the order of insertion, or by distance and then order of
+    insertion, so they are the same as a linear search over all values.
+*/
+template<class T>
+class point_grid
+{
+  public:
+    /// create grid with given cell size in meters
+    point_grid(double cell_size_) : cell_size(cell_size_) { }
+
+    /// remove all values
+    void clear()
+    {
+        entries.clear();
+        cells.clear();
+    }
+
+    /// add value at position
+    void insert(const vector2& pos, const T& value)
+    {
+        if (entries.empty())
+        {
+            bbox_min = bbox_max = pos;
+        }
+        else
+        {
+            bbox_min = bbox_min.min(pos);
+            bbox_max = bbox_max.max(pos);
+        }
+        cells[cell_key(cell_of(pos.x), cell_of(pos.y))].push_back(
+            unsigned(entries.size()));
+        entries.push_back({pos, value});
+    }
+
+    /// get all values within radius (inclusive) in order of insertion
+    [[nodiscard]] std::vector<T>
+    find_within(const vector2& center, double radius) const
+    {
+        std::vector<unsigned> idx;
+        collect(center, radius, idx);
+        std::sort(idx.begin(), idx.end());
+        std::vector<T> result;
+        result.reserve(idx.size());
+        for (auto i : idx)
+        {
+            result.push_back(entries[i].value);
+        }
+        return result;
+    }
+
+    /// get the n nearest values accepted by pred, ordered by distance and
+    /// then by order of insertion.
+    template<typename Pred>
+    [[nodiscard]] std::vector<T>
+    find_nearest(const vector2& center, unsigned n, Pred pred) const
+    {
+        std::vector<T> result;
+        if (entries.empty() || n == 0)
+        {
+            return result;
+        }
+        // distance to farthest corner of bounding box covers all values
+        const double max_radius =
+            std::sqrt(std::max(
+                center.square_distance(bbox_min),
+                std::max(
+                    center.square_distance(bbox_max),
+                    std::max(
+                        center.square_distance(
+                            vector2(bbox_min.x, bbox_max.y)),
+                        center.square_distance(
+                            vector2(bbox_max.x, bbox_min.y))))))
+            + 1.0;
+        std::vector<unsigned> idx;
+        for (double radius = cell_size;; radius *= 2)
+        {
+            idx.clear();
+            collect(center, std::min(radius, max_radius), idx);
+            idx.erase(
+                std::remove_if(
+                    idx.begin(),
+                    idx.end(),
+                    [&](unsigned i) { return !pred(entries[i].value); }),
+                idx.end());
+            if (idx.size() >= n || radius >= max_radius)
+            {
+                break;
+            }
+        }
+        // values outside the radius are farther away than all found ones,
+        // but there could be more than n, so sort and cut.
+        std::vector<std::pair<double, unsigned>> found;
+        found.reserve(idx.size());
+        for (auto i : idx)
+        {
+            found.emplace_back(entries[i].pos.square_distance(center), i);
+        }
+        std::sort(found.begin(), found.end());
+        for (unsigned k = 0; k < found.size() && k < n; ++k)
+        {
+            result.push_back(entries[found[k].second].value);
+        }
+        return result;
+    }
+
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+
+  protected:
+    struct entry
+    {
+        vector2 pos;
+        T value;
+    };
+    double cell_size;
+    std::vector<entry> entries;
+    std::unordered_map<uint64_t, std::vector<unsigned>> cells;
+    vector2 bbox_min, bbox_max;
+
+    [[nodiscard]] int cell_of(double c) const
+    {
+        return int(std::floor(c / cell_size));
+    }
+
+    static uint64_t cell_key(int x, int y)
+    {
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+
+    /// collect indices of entries within radius, unordered
+    void
+    collect(const vector2& center, double radius, std::vector<unsigned>& idx)
+        const
+    {
+        const double r2 = radius * radius;
+        const int x0 = cell_of(center.x - radius);
+        const int x1 = cell_of(center.x + radius);
+        const int y0 = cell_of(center.y - radius);
+        const int y1 = cell_of(center.y + radius);
+        auto check_cell = [&](const std::vector<unsigned>& cell) {
+            for (auto i : cell)
+            {
+                if (entries[i].pos.square_distance(center) <= r2)
+                {
+                    idx.push_back(i);
+                }
+            }
+        };
+        if (double(x1 - x0 + 1) * double(y1 - y0 + 1) > double(cells.size()))
+        {
+            // circle covers more cells than there are used ones
+            for (const auto& c : cells)
+            {
+                check_cell(c.second);
+            }
+            return;
+        }
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                auto it = cells.find(cell_key(x, y));
+                if (it != cells.end())
+                {
+                    check_cell(it->second);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,343 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// hierarchical profiling of frames
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "profiler.h"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+/// weight of new values for averages
+const double average_weight = 0.05;
+/// number of frames a maximum is shown
+const unsigned max_frame_age = 60;
+
+/// time since first use in nanoseconds
+uint64_t get_time()
+{
+    static const auto start_time = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start_time)
+        .count();
+}
+
+/// update average and recent maximum with value of this frame
+void account(double value, double& average, double& maximum, unsigned& age)
+{
+    average += (value - average) * average_weight;
+    if (value >= maximum || ++age > max_frame_age)
+    {
+        maximum = value;
+        age     = 0;
+    }
+}
+
+/// write string as JSON string
+void write_json_string(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+thread_local const char* this_thread_name = nullptr;
+} // namespace
+
+struct profiler::thread_data
+{
+    /// a zone in the tree of zones of the thread
+    struct node
+    {
+        const site* where;
+        unsigned parent;
+        unsigned depth;
+        uint64_t frame_ns{0};
+        unsigned frame_calls{0};
+        double average_ms{0}, max_ms{0};
+        unsigned max_age{0};
+    };
+
+    /// a measured zone
+    struct event
+    {
+        unsigned node;
+        uint64_t start, end;
+    };
+
+    mutable std::mutex mtx; ///< for everything but current
+    std::string name;
+    std::vector<node> nodes; ///< first node is the thread itself
+    std::vector<event> events;
+    unsigned current{0}; ///< node of innermost zone, only used by owner
+    unsigned id{0};      ///< thread number for trace
+    std::atomic<bool> exited{false};
+};
+
+std::atomic<bool> profiler::enabled{false};
+
+profiler::profiler() = default;
+
+profiler::~profiler() = default;
+
+auto profiler::local_thread_data() -> thread_data*&
+{
+    // marks data when thread exits, it is removed after the next frame
+    struct holder
+    {
+        thread_data* td{nullptr};
+        ~holder()
+        {
+            if (td != nullptr)
+            {
+                td->exited = true;
+            }
+        }
+    };
+    thread_local holder h;
+    return h.td;
+}
+
+auto profiler::get_thread_data() -> thread_data&
+{
+    auto& td = local_thread_data();
+    if (td == nullptr)
+    {
+        auto newtd = std::make_unique<thread_data>();
+        std::unique_lock<std::mutex> ml(mtx);
+        newtd->name = this_thread_name != nullptr
+                          ? std::string(this_thread_name)
+                          : "thread " + std::to_string(threads.size());
+        newtd->nodes.push_back({nullptr, 0, 0});
+        newtd->id = next_thread_id++;
+        td        = newtd.get();
+        threads.push_back(std::move(newtd));
+    }
+    return *td;
+}
+
+void profiler::set_thread_name(const char* name)
+{
+    this_thread_name = name;
+    auto* td         = local_thread_data();
+    if (td != nullptr)
+    {
+        std::unique_lock<std::mutex> ml(td->mtx);
+        td->name = name;
+    }
+}
+
+void profiler::zone::begin(const site& s)
+{
+    td = &profiler::instance().get_thread_data();
+    std::unique_lock<std::mutex> ml(td->mtx);
+    // find zone in children of current zone
+    auto& nodes = td->nodes;
+    unsigned n  = 1;
+    for (; n < nodes.size(); ++n)
+    {
+        if (nodes[n].parent == td->current && nodes[n].where == &s)
+        {
+            break;
+        }
+    }
+    if (n == nodes.size())
+    {
+        nodes.push_back({&s, td->current, nodes[td->current].depth + 1});
+    }
+    node        = n;
+    td->current = n;
+    start       = get_time();
+}
+
+void profiler::zone::end()
+{
+    const uint64_t t = get_time();
+    std::unique_lock<std::mutex> ml(td->mtx);
+    td->events.push_back({node, start, t});
+    td->current = td->nodes[node].parent;
+}
+
+void profiler::end_frame()
+{
+    const uint64_t t = get_time();
+    std::unique_lock<std::mutex> ml(mtx);
+    if (last_frame_time > 0)
+    {
+        account(
+            (t - last_frame_time) / 1e6,
+            average_frame_ms,
+            max_frame_ms,
+            max_frame_age);
+    }
+    last_frame_time = t;
+    for (unsigned i = 0; i < threads.size(); ++i)
+    {
+        auto& td = *threads[i];
+        std::unique_lock<std::mutex> tl(td.mtx);
+        for (auto& n : td.nodes)
+        {
+            n.frame_ns    = 0;
+            n.frame_calls = 0;
+        }
+        for (const auto& e : td.events)
+        {
+            td.nodes[e.node].frame_ns += e.end - e.start;
+            ++td.nodes[e.node].frame_calls;
+            if (recording)
+            {
+                trace.push_back({e.start, e.end, &td, e.node});
+            }
+        }
+        td.events.clear();
+        for (auto& n : td.nodes)
+        {
+            account(n.frame_ns / 1e6, n.average_ms, n.max_ms, n.max_age);
+        }
+    }
+    // remove data of exited threads, keep it for the trace if needed
+    for (auto it = threads.begin(); it != threads.end();)
+    {
+        if ((*it)->exited)
+        {
+            if (!trace.empty())
+            {
+                finished_threads.push_back(std::move(*it));
+            }
+            it = threads.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void profiler::record(bool on)
+{
+    std::unique_lock<std::mutex> ml(mtx);
+    recording = on;
+}
+
+void profiler::write_trace(std::ostream& out) const
+{
+    std::unique_lock<std::mutex> ml(mtx);
+    out << "{\"traceEvents\":[\n";
+    for (const auto* list : {&threads, &finished_threads})
+    {
+        for (const auto& td : *list)
+        {
+            std::unique_lock<std::mutex> tl(td->mtx);
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                << "\"tid\":" << td->id << ",\"args\":{\"name\":";
+            write_json_string(out, td->name);
+            out << "}},\n";
+        }
+    }
+    // times are given in microseconds
+    out << std::fixed << std::setprecision(3);
+    for (const auto& e : trace)
+    {
+        std::unique_lock<std::mutex> tl(e.thread->mtx);
+        out << "{\"name\":";
+        write_json_string(out, e.thread->nodes[e.node].where->name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread->id
+            << ",\"ts\":" << e.start / 1e3 << ",\"dur\":"
+            << (e.end - e.start) / 1e3 << "},\n";
+    }
+    // the last entry has no comma
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+           "\"args\":{\"name\":\"dangerdeep\"}}\n],"
+           "\"displayTimeUnit\":\"ms\"}\n";
+}
+
+auto profiler::get_zone_infos() const -> std::vector<zone_info>
+{
+    std::vector<zone_info> result;
+    std::unique_lock<std::mutex> ml(mtx);
+    result.push_back(
+        {"frame", 0, average_frame_ms, max_frame_ms, last_frame_time > 0});
+    for (const auto& tdp : threads)
+    {
+        const auto& td = *tdp;
+        std::unique_lock<std::mutex> tl(td.mtx);
+        if (td.nodes.size() < 2)
+        {
+            continue;
+        }
+        result.push_back({td.name, 0, 0.0, 0.0, 0});
+        // depth first order, children in order of first use
+        std::vector<unsigned> stack(1, 0);
+        while (!stack.empty())
+        {
+            const unsigned n = stack.back();
+            stack.pop_back();
+            if (n > 0)
+            {
+                const auto& nd = td.nodes[n];
+                result.push_back(
+                    {nd.where->name,
+                     nd.depth,
+                     nd.average_ms,
+                     nd.max_ms,
+                     nd.frame_calls});
+            }
+            for (unsigned c = unsigned(td.nodes.size()); c-- > 1;)
+            {
+                if (td.nodes[c].parent == n)
+                {
+                    stack.push_back(c);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+auto profiler::get_overlay_lines() const -> std::vector<std::string>
+{
+    std::vector<std::string> result;
+    for (const auto& zi : get_zone_infos())
+    {
+        std::ostringstream oss;
+        oss << std::string(zi.depth * 2, ' ') << zi.name;
+        if (zi.depth > 0 || result.empty())
+        {
+            oss << std::fixed << std::setprecision(2) << "  " << zi.average_ms
+                << " ms, max " << zi.max_ms << " ms";
+            if (zi.nr_of_calls > 1)
+            {
+                oss << ", " << zi.nr_of_calls << " calls";
+            }
+        }
+        result.push_back(oss.str());
+    }
+    return result;
+}
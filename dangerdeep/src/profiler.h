@@ -0,0 +1,154 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// hierarchical profiling of frames
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "singleton.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT2(a, b)
+/// measure time of the rest of the scope as zone with the given name
+#define PROFILE_ZONE(name)                                                     \
+    static constexpr profiler::site PROFILE_CONCAT(                            \
+        profile_site_, __LINE__){name};                                        \
+    profiler::zone PROFILE_CONCAT(profile_zone_, __LINE__)(                    \
+        PROFILE_CONCAT(profile_site_, __LINE__))
+
+///\brief Measures time spent in nested zones of code per frame.
+/** Zones are defined with PROFILE_ZONE, they nest like the scopes, so every
+    thread gets a tree of zones. Once per frame end_frame() sums up the time
+    of all zones, averages are kept for display. A session can be recorded
+    and written in the Chrome tracing format (chrome://tracing or Perfetto).
+    When the profiler is disabled, a zone costs only a check of a flag.
+*/
+class profiler : public singleton<class profiler>
+{
+    friend class singleton<profiler>;
+
+  protected:
+    /// zones and events of one thread
+    struct thread_data;
+
+  public:
+    /// static description of a zone
+    struct site
+    {
+        const char* name;
+    };
+
+    /// measures a zone from construction to destruction
+    class zone
+    {
+      public:
+        zone(const site& s)
+        {
+            if (enabled.load(std::memory_order_relaxed))
+            {
+                begin(s);
+            }
+        }
+        ~zone()
+        {
+            if (td != nullptr)
+            {
+                end();
+            }
+        }
+        zone(const zone&) = delete;
+        zone& operator=(const zone&) = delete;
+
+      protected:
+        thread_data* td{nullptr};
+        unsigned node{0};
+        uint64_t start{0};
+        void begin(const site& s);
+        void end();
+    };
+
+    /// statistics of a zone for display
+    struct zone_info
+    {
+        std::string name;
+        unsigned depth;       ///< 0 for threads, zones start with 1
+        double average_ms;    ///< average time per frame
+        double max_ms;        ///< maximum time per frame recently
+        unsigned nr_of_calls; ///< in last frame
+    };
+
+    ~profiler();
+
+    /// enable or disable measuring
+    static void enable(bool on) { enabled = on; }
+
+    /// request if profiler measures
+    static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /// set name of calling thread for display, give a static string
+    static void set_thread_name(const char* name);
+
+    /// sum up zones of the frame, call once at the end of every frame
+    void end_frame();
+
+    /// start or stop recording of all zones for trace output
+    void record(bool on);
+
+    /// write recorded zones as Chrome tracing JSON
+    void write_trace(std::ostream& out) const;
+
+    /// get statistics of all zones, sorted by thread and as tree
+    [[nodiscard]] std::vector<zone_info> get_zone_infos() const;
+
+    /// get overlay text, one line per zone
+    [[nodiscard]] std::vector<std::string> get_overlay_lines() const;
+
+  protected:
+    profiler();
+    static std::atomic<bool> enabled;
+    mutable std::mutex mtx; ///< for threads and trace
+    std::vector<std::unique_ptr<thread_data>> threads;
+    std::vector<std::unique_ptr<thread_data>> finished_threads; ///< in trace
+    unsigned next_thread_id{0};
+    uint64_t last_frame_time{0};
+    double average_frame_ms{0}, max_frame_ms{0};
+    unsigned max_frame_age{0};
+    bool recording{false};
+    /// recorded zone of a thread
+    struct trace_event
+    {
+        uint64_t start, end;
+        const thread_data* thread;
+        unsigned node;
+    };
+    std::vector<trace_event> trace;
+
+    /// get data of calling thread, created on first use
+    thread_data& get_thread_data();
+    static thread_data*& local_thread_data();
+};
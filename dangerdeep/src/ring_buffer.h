@@ -0,0 +1,128 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// fixed capacity ring buffer
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+///\brief Fixed capacity ring buffer with contiguous storage.
+/** Elements are pushed at the front, when the buffer is full the oldest
+    (back) element gets overwritten. Indexing and iteration run from the
+    newest element (index 0) to the oldest one, so it can be used as drop-in
+    replacement for a std::list that is filled with push_front/pop_back.
+    No memory is allocated after construction. */
+template<typename T, std::size_t N>
+class ring_buffer
+{
+    static_assert(N > 0, "ring_buffer needs a capacity");
+
+  public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    /// iterator from newest to oldest element
+    class const_iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const T*;
+        using reference         = const T&;
+
+        const_iterator(const ring_buffer* rb_, size_type idx_) :
+            rb(rb_), idx(idx_)
+        {
+        }
+        reference operator*() const { return (*rb)[idx]; }
+        pointer operator->() const { return &(*rb)[idx]; }
+        const_iterator& operator++()
+        {
+            ++idx;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            ++idx;
+            return tmp;
+        }
+        bool operator==(const const_iterator& other) const
+        {
+            return idx == other.idx;
+        }
+        bool operator!=(const const_iterator& other) const
+        {
+            return idx != other.idx;
+        }
+
+      private:
+        const ring_buffer* rb;
+        size_type idx;
+    };
+
+    ring_buffer() = default;
+
+    /// add new element at front, overwrites the oldest one when full
+    void push_front(const T& t)
+    {
+        head       = (head + N - 1) % N;
+        data[head] = t;
+        if (count < N)
+        {
+            ++count;
+        }
+    }
+
+    /// remove the oldest element
+    void pop_back()
+    {
+        if (count > 0)
+        {
+            --count;
+        }
+    }
+
+    void clear()
+    {
+        head  = 0;
+        count = 0;
+    }
+
+    /// access element, 0 is the newest one
+    const T& operator[](size_type i) const { return data[(head + i) % N]; }
+    [[nodiscard]] const T& front() const { return data[head]; }
+    [[nodiscard]] const T& back() const { return (*this)[count - 1]; }
+    [[nodiscard]] size_type size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] bool full() const { return count == N; }
+    [[nodiscard]] static constexpr size_type capacity() { return N; }
+    [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const { return {this, count}; }
+
+  protected:
+    std::array<T, N> data{};
+    size_type head{0};  ///< index of newest element
+    size_type count{0}; ///< number of valid elements
+};
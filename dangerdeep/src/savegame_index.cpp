@@ -0,0 +1,338 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// savegame headers and an index of them for the load menu
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "savegame_index.h"
+
+#include "filehelper.h"
+#include "log.h"
+#include "xml.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+/// maximum number of bytes read to find the header
+const std::size_t max_header_bytes = 65536;
+
+const char* base64_chars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string encode_base64(const std::vector<uint8_t>& data)
+{
+    std::string result;
+    result.reserve((data.size() + 2) / 3 * 4);
+    for (std::size_t i = 0; i < data.size(); i += 3)
+    {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (i + 1 < data.size())
+        {
+            v |= uint32_t(data[i + 1]) << 8;
+        }
+        if (i + 2 < data.size())
+        {
+            v |= data[i + 2];
+        }
+        result += base64_chars[(v >> 18) & 63];
+        result += base64_chars[(v >> 12) & 63];
+        result += (i + 1 < data.size()) ? base64_chars[(v >> 6) & 63] : '=';
+        result += (i + 2 < data.size()) ? base64_chars[v & 63] : '=';
+    }
+    return result;
+}
+
+std::vector<uint8_t> decode_base64(const std::string& text)
+{
+    std::vector<uint8_t> result;
+    result.reserve(text.size() / 4 * 3);
+    uint32_t v    = 0;
+    unsigned bits = 0;
+    for (char c : text)
+    {
+        const char* p = (c != 0) ? strchr(base64_chars, c) : nullptr;
+        if (p == nullptr)
+        {
+            // padding or garbage ends the data
+            break;
+        }
+        v = (v << 6) | uint32_t(p - base64_chars);
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            result.push_back(uint8_t(v >> bits));
+        }
+    }
+    return result;
+}
+
+/// get start of savegame up to the header element, closed to be valid XML
+std::string read_start_of_savegame(const std::string& filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in.good())
+    {
+        THROW(file_read_error, filename);
+    }
+    std::string text(max_header_bytes, ' ');
+    in.read(&text[0], text.size());
+    text.resize(std::size_t(in.gcount()));
+    const auto root = text.find("<dftd-savegame");
+    auto end        = (root == std::string::npos) ? root : text.find('>', root);
+    if (end == std::string::npos)
+    {
+        THROW(xml_error, "no savegame", filename);
+    }
+    if (text[end - 1] == '/')
+    {
+        // root element has no children
+        return text.substr(0, end + 1);
+    }
+    const auto header = text.find_first_not_of(" \t\r\n", end + 1);
+    if (header != std::string::npos && text.compare(header, 7, "<header") == 0)
+    {
+        const auto header_end = text.find("/>", header);
+        if (header_end != std::string::npos)
+        {
+            end = header_end + 1;
+        }
+    }
+    return text.substr(0, end + 1) + "</dftd-savegame>";
+}
+} // namespace
+
+savegame_header::savegame_header(const std::string& filename)
+{
+    xml_doc doc(filename);
+    doc.parse(read_start_of_savegame(filename));
+    xml_elem root = doc.child("dftd-savegame");
+    version       = root.attru("version");
+    description   = root.attr("description");
+    // older savegames have no header
+    if (root.has_child("header"))
+    {
+        xml_elem h = root.child("header");
+        date       = h.attr("date");
+        player     = h.attr("player");
+        thumbnail  = decode_base64(h.attr("thumbnail"));
+        if (thumbnail.size() != thumbnail_size * thumbnail_size * 3)
+        {
+            thumbnail.clear();
+        }
+    }
+}
+
+void savegame_header::save(xml_elem& root) const
+{
+    root.set_attr(description, "description");
+    root.set_attr(version, "version");
+    xml_elem h = root.add_child("header");
+    h.set_attr(date, "date");
+    h.set_attr(player, "player");
+    h.set_attr(encode_base64(thumbnail), "thumbnail");
+}
+
+const char* savegame_index::index_filename = "savegame_index.xml";
+
+savegame_index::savegame_index(std::string directory_) :
+    directory(std::move(directory_))
+{
+    load_index();
+}
+
+savegame_index::~savegame_index()
+{
+    try
+    {
+        updating.wait();
+    }
+    catch (std::exception& e)
+    {
+        log_warning("Reading savegames failed: " << e.what());
+    }
+}
+
+void savegame_index::update()
+{
+    if (updating.is_done())
+    {
+        updating.run([this]() { scan(); });
+    }
+}
+
+auto savegame_index::get_entries() -> std::vector<entry>
+{
+    updating.wait();
+    std::unique_lock<std::mutex> ml(mtx);
+    std::vector<entry> result;
+    result.reserve(entries.size());
+    for (const auto& e : entries)
+    {
+        result.push_back(e.second);
+    }
+    return result;
+}
+
+void savegame_index::scan()
+{
+    std::map<std::string, entry> known;
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        known = entries;
+    }
+    std::map<std::string, entry> found;
+    bool changed = false;
+    ::directory dir(directory);
+    for (std::string fn = dir.read(); !fn.empty(); fn = dir.read())
+    {
+        if (!is_savegame_name(fn))
+        {
+            continue;
+        }
+        const int64_t file_time = get_file_time(directory + fn);
+        const int64_t file_size = get_file_size(directory + fn);
+        auto it                 = known.find(fn);
+        if (it != known.end() && it->second.file_time == file_time
+            && it->second.file_size == file_size)
+        {
+            found[fn] = std::move(it->second);
+            continue;
+        }
+        entry e;
+        e.filename  = fn;
+        e.file_time = file_time;
+        e.file_size = file_size;
+        try
+        {
+            e.header = savegame_header(directory + fn);
+            e.header.thumbnail.clear();
+        }
+        catch (std::exception& ex)
+        {
+            log_warning("Can't read savegame header: " << ex.what());
+            e.header.description = "<ERROR> Unreadable savegame";
+        }
+        found[fn] = std::move(e);
+        changed   = true;
+    }
+    changed = changed || found.size() != known.size();
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        entries = std::move(found);
+    }
+    if (changed)
+    {
+        save_index();
+    }
+}
+
+void savegame_index::load_index()
+{
+    const std::string fn = directory + index_filename;
+    if (!is_file(fn))
+    {
+        return;
+    }
+    try
+    {
+        xml_doc doc(fn);
+        doc.load();
+        xml_elem root = doc.child("dftd-savegame-index");
+        for (auto elem : root.iterate("savegame"))
+        {
+            entry e;
+            e.filename           = elem.attr("file");
+            e.file_time          = std::stoll(elem.attr("time"));
+            if (elem.has_attr("size"))
+            {
+                e.file_size = std::stoll(elem.attr("size"));
+            }
+            e.header.version     = elem.attru("version");
+            e.header.description = elem.attr("description");
+            e.header.date        = elem.attr("date");
+            e.header.player      = elem.attr("player");
+            entries[e.filename]  = std::move(e);
+        }
+    }
+    catch (std::exception& e)
+    {
+        // the index is rebuilt then
+        log_warning("Can't read savegame index: " << e.what());
+        entries.clear();
+    }
+}
+
+void savegame_index::save_index() const
+{
+    try
+    {
+        xml_doc doc(directory + index_filename);
+        xml_elem root = doc.add_child("dftd-savegame-index");
+        for (const auto& it : entries)
+        {
+            const entry& e = it.second;
+            xml_elem elem  = root.add_child("savegame");
+            elem.set_attr(e.filename, "file");
+            elem.set_attr(std::to_string(e.file_time), "time");
+            elem.set_attr(std::to_string(e.file_size), "size");
+            elem.set_attr(e.header.version, "version");
+            elem.set_attr(e.header.description, "description");
+            elem.set_attr(e.header.date, "date");
+            elem.set_attr(e.header.player, "player");
+        }
+        doc.save();
+    }
+    catch (std::exception& e)
+    {
+        // not fatal, headers are read again next time
+        log_warning("Can't write savegame index: " << e.what());
+    }
+}
+
+auto is_savegame_name(const std::string& s) -> bool
+{
+    if (s.length() != 14)
+    {
+        return false;
+    }
+
+    if (s.substr(0, 5) != "save_")
+    {
+        return false;
+    }
+
+    if (s.substr(9, 7) != ".dftd")
+    {
+        return false;
+    }
+
+    for (int i = 5; i < 9; ++i)
+    {
+        if (s[i] < '0' || s[i] > '9')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// savegame headers and an index of them for the load menu
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "task_scheduler.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class xml_elem;
+
+///\brief Data about a savegame that is shown before loading it.
+/** Version and description are attributes of the savegame's root element,
+    the other values are stored in a header element that is written as first
+    child, so all of them are found at the start of the file.
+*/
+struct savegame_header
+{
+    /// edge length of the square thumbnail in pixels
+    static const unsigned thumbnail_size = 64;
+
+    unsigned version{0};
+    std::string description;
+    std::string date;   ///< game date as text
+    std::string player; ///< name of player
+    /// RGB pixels of a screen shot, thumbnail_size^2 * 3 bytes or empty
+    std::vector<uint8_t> thumbnail;
+
+    savegame_header() = default;
+
+    /// read header from the start of a savegame file, without loading the
+    /// rest of it. Throws if the file is no savegame.
+    savegame_header(const std::string& filename);
+
+    /// store header to root element of savegame
+    void save(xml_elem& root) const;
+};
+
+///\brief Headers of all savegames in a directory.
+/** Headers are cached in an index file in the directory, so only new or
+    changed savegames (by modification time and size) need to be read.
+    Updating runs as task in background, so the load menu can be shown at
+    once.
+*/
+class savegame_index
+{
+  public:
+    struct entry
+    {
+        std::string filename; ///< without directory
+        int64_t file_time{0};
+        int64_t file_size{-1};
+        savegame_header header; ///< without thumbnail
+    };
+
+    /// create index for directory, read cached index file
+    savegame_index(std::string directory);
+
+    /// wait for background update
+    ~savegame_index();
+
+    savegame_index(const savegame_index&) = delete;
+    savegame_index& operator=(const savegame_index&) = delete;
+
+    /// start reading savegames in background
+    void update();
+
+    /// request if the background update is finished
+    [[nodiscard]] bool is_ready() const { return updating.is_done(); }
+
+    /// get entries sorted by filename, waits for background update
+    std::vector<entry> get_entries();
+
+    /// filename of index in savegame directory
+    static const char* index_filename;
+
+  protected:
+    const std::string directory;
+    std::mutex mtx; ///< for entries
+    std::map<std::string, entry> entries;
+    task_group updating;
+
+    /// read changed savegames and write index, runs as task
+    void scan();
+    void load_index();
+    void save_index() const;
+};
+
+/// check if a filename is a savegame name (save_XXXX.dftd)
+bool is_savegame_name(const std::string& s);
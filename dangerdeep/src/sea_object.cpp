@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "sea_object.h"
 
 #include "ai.h"
+#include "body_integrator.h"
 #include "constant.h"
 #include "datadirs.h"
 #include "game.h"
@@ -677,99 +678,42 @@ void sea_object::simulate(double delta_time, game& gm)
         redetect_time -= delta_time;
         if (redetect_time <= 0)
         {
-            // fixme: doing this for every object leads to N^2 sensor tests per
-            // second. until now this was done for the player only leading to
-            // N*fps tests per second, which is more for a small number of
-            // objects, but less than for greater N (> 30). this can be a
-            // problem, but even with 120 ships we have 14400 sensor checks per
-            // second only and this is not much. On the other hand we need to
-            // check for each ship if it can see other ships to make the AI work
-            // correctly (like collision avoidance). We can decrease the needed
-            // cpu usage easily by increasing the redection cycles to 5 seconds
-            // or so, which is still realistic.
-            visible_objects = gm.visible_sea_objects(this);
-            radar_objects   = gm.radar_sea_objects(this);
-            sonar_objects   = gm.sonar_sea_objects(this);
+            // Doing this for every object separately would lead to N^2
+            // sensor tests per second. The game computes the detections of
+            // all objects that are due in this step at once with a spatial
+            // index (see game::detect_sea_objects), so only nearby pairs are
+            // tested. Objects created in this step detect on their own.
+            if (!gm.take_detection_result(
+                    this, visible_objects, radar_objects, sonar_objects))
+            {
+                redetect_other_sea_objects(gm);
+            }
             redetect_time = 1.0; // fixme: maybe make it variable, depending on
                                  // the object type.
         }
     }
 
-    // get force and torque for current time.
-    vector3 force, torque;
-    compute_force_and_torque(force, torque, gm);
-
-    // DBGOUT6(position, orientation, linear_momentum, angular_momentum, force,
-    // torque);
-
-    // compute new position by integrating linear_momentum
-    // M^-1 * P = v, linear_momentum is in world space!
-    position += linear_momentum * mass_inv * delta_time;
-
-    // compute new linear_momentum by integrating force
-    // fixme: linear_momentum was object_local, so direction of linear_momentum
-    // was changed automatically when orientation changed. This is no longer
-    // the case. Normal objects still are simulated correctly, but this is
-    // missing some physics laws? - a fast moving plane going into a curve
-    // will change its linear momentum for example, because direction is
-    // changed without new force (e.g. if motor is off, like sailing plane).
-    // test show that this still works with subs: accelerate to flank speed,
-    // then turn off engine, then turn rudder -> sub will turn!
-    // the drag may slow the sub down, but why it is moving forward in new
-    // direction?! drag should slow sub down and does so, but nothing
-    // accelerates it!!
-    linear_momentum += delta_time * force;
-
-    // compute new orientation by integrating angular momentum
-    // L = I * w = R * I_k * R^T * w =>
-    // w = I^-1 * L = R * I_k^-1 * R^-1 * L
-    // so we can compute w from I_k^-1 and L.
-    // with some math we have:
-    // w = R * (I_k^-1 * (R^-1 * L))
-    //                   ^^^^^^^^^^
-    //                      vector
-    //         ^^^^^^^^^^^^^^^^^^^^
-    //               vector
-    // Thus we don't need the matrix R but can use
-    // the orientation quaternion directly for rotation.
-    // This is much more efficient.
-    // with w we can update orientation.
-    // w codes the axis/angle, which needs to get multiplied by delta_t,
-    // so we can just compute w' = w * delta_t and then compute a
-    // rotation quaternion from w' and set new orientation as
-    // produkt of old orientation and w'.
-    // 	std::cout << "torque=" << torque << " angular momentum=" <<
-    // angular_momentum << "\n"; 	std::cout << "compute w, angular_momentum="
-    // << angular_momentum << " inertiainv:\n";
-    vector3 w = orientation.rotate(
-        inertia_tensor_inv * orientation.conj().rotate(angular_momentum));
-    vector3 w2 = w * delta_time;
-
-    // 	std::cout << "update orientation, dt=" << delta_time << " w=" << w << "
-    // w2=" << w2 << "\n"; unit of |w| is revolutions per time, that is
-    // 2*Pi/second.
-    double w2l = w2.length();
-
-    if (w2l > 1e-8)
-    {
-        // avoid too small numbers
-        quaternion q = quaternion::rot_rad(w2l, w2 * (1.0 / w2l));
-
-        // multiply orientation with q: combined rotation.
-        // 		std::cout << "q=" << q << " orientation old=" << orientation <<
-        // " new=" << q * orientation << "\n";
-        orientation = q * orientation;
-
-        // we should renormalize orientation regularly, to avoid that
-        // orientation isn't a valid rotation after many changes.
-        if (fabs(orientation.square_length() - 1.0) > 1e-8)
-        {
-            orientation.normalize();
-        }
-    }
-
-    // compute new angular momentum by integrating torque (both in world space)
-    angular_momentum += delta_time * torque;
+    // integrate state over time. The force is sampled for intermediate
+    // states by setting them, but game time and thus the waves stay the
+    // same during the step.
+    const body_integrator bi(mass_inv, inertia_tensor_inv);
+    const body_integrator::state s = bi.step(
+        gm.get_integration_method(),
+        {position, orientation, linear_momentum, angular_momentum},
+        delta_time,
+        [this, &gm](
+            const body_integrator::state& st, vector3& force, vector3& torque) {
+            position         = st.position;
+            orientation      = st.orientation;
+            linear_momentum  = st.linear_momentum;
+            angular_momentum = st.angular_momentum;
+            compute_helper_values();
+            compute_force_and_torque(force, torque, gm);
+        });
+    position         = s.position;
+    orientation      = s.orientation;
+    linear_momentum  = s.linear_momentum;
+    angular_momentum = s.angular_momentum;
 
     // update helper variables
     compute_helper_values();
@@ -822,6 +766,22 @@ void sea_object::simulate(double delta_time, game& gm)
     // fixme: use orientation here and compute heading from it, not vice versa!
 }
 
+void sea_object::redetect_other_sea_objects(game& gm)
+{
+    if (detect_other_sea_objects())
+    {
+        visible_objects = gm.visible_sea_objects(this);
+        radar_objects   = gm.radar_sea_objects(this);
+        sonar_objects   = gm.sonar_sea_objects(this);
+    }
+    else
+    {
+        visible_objects.clear();
+        radar_objects.clear();
+        sonar_objects.clear();
+    }
+}
+
 auto sea_object::damage(const vector3& fromwhere, unsigned strength, game& gm)
     -> bool
 {
@@ -889,25 +849,25 @@ auto sea_object::get_engine_noise_source() const -> vector2
     return get_pos().xy() - get_heading().direction() * 0.3f * get_length();
 }
 
-void sea_object::display(const texture* caustic_map) const
+void sea_object::display(const texture* caustic_map, unsigned lod_level) const
 {
     if (mymodel.is_valid())
     {
         //		cout << "render with skin layout = " << skin_name << "\n";
         const_cast<model&>(mymodel.get())
             .set_layout(skin_name); // hack, replace by new gpu stuff
-        mymodel->display(caustic_map);
+        mymodel->display(caustic_map, lod_level);
     }
 }
 
-void sea_object::display_mirror_clip() const
+void sea_object::display_mirror_clip(unsigned lod_level) const
 {
     if (mymodel.is_valid())
     {
         //		cout << "renderMC with skin layout = " << skin_name << "\n";
         const_cast<model&>(mymodel.get())
             .set_layout(skin_name); // hack, replace by new gpu stuff
-        mymodel->display_mirror_clip();
+        mymodel->display_mirror_clip(lod_level);
     }
 }
 
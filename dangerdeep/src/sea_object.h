@@ -468,8 +468,11 @@ class sea_object
     [[nodiscard]] virtual double get_noise_factor() const { return 0; }
     [[nodiscard]] virtual vector2 get_engine_noise_source() const;
 
-    virtual void display(const texture* caustic_map = nullptr) const;
-    virtual void display_mirror_clip() const;
+    /// render object, higher detail level means less triangles
+    virtual void display(
+        const texture* caustic_map = nullptr,
+        unsigned lod_level         = 0) const;
+    virtual void display_mirror_clip(unsigned lod_level = 0) const;
     [[nodiscard]] double get_bounding_radius() const
     {
         return size3d.x + size3d.y;
@@ -492,6 +495,17 @@ class sea_object
         return sonar_objects;
     }
 
+    /// recreate lists of detected objects now, e.g. when the objects that
+    /// they point to have been moved in memory.
+    void redetect_other_sea_objects(game& gm);
+    /// check if lists of detected objects are recreated in the next
+    /// simulation step of given length.
+    [[nodiscard]] bool redetects_in(double delta_time) const
+    {
+        return is_reference_ok() && detect_other_sea_objects()
+               && redetect_time - delta_time <= 0;
+    }
+
     // check for a vector of pointers if the objects are still alive
     // and remove entries of dead objects (do not delete the objects itself!)
     // and compress the vector afterwars.
@@ -0,0 +1,387 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// benchmark for batched sensor detection with a spatial index
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "cfg.h"
+#include "game.h"
+#include "global_data.h"
+#include "mymain.cpp"
+#include "point_grid.h"
+#include "system_interface.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::vector;
+
+namespace
+{
+/// a ship as seen by the sensors, the tests follow sensors.cpp
+struct test_ship
+{
+    vector2 pos;
+    double cross_section; ///< visible area in square meters
+    double noise;         ///< noise factor
+    double radar_range;   ///< zero if ship has no radar
+};
+
+const double max_view_dist   = 30000.0;
+const double sonar_range     = 9500.0;
+const unsigned max_contacts  = 5;
+const unsigned nr_of_repeats = 10;
+
+/// number of sensor tests done, in the game they are the costly part
+unsigned long nr_of_tests = 0;
+
+bool lookout_detects(const test_ship& d, const test_ship& t)
+{
+    ++nr_of_tests;
+    const double dist = t.pos.distance(d.pos);
+    if (dist >= max_view_dist)
+    {
+        return false;
+    }
+    return dist < 1.0 || t.cross_section / dist >= 0.05;
+}
+
+bool radar_detects(const test_ship& d, const test_ship& t)
+{
+    ++nr_of_tests;
+    const double dist = t.pos.distance(d.pos);
+    if (dist > d.radar_range)
+    {
+        return false;
+    }
+    double df = d.radar_range / dist;
+    df *= df;
+    df *= df;
+    return df * t.cross_section * 0.001 > 0.15;
+}
+
+bool sonar_detects(const test_ship& d, const test_ship& t)
+{
+    ++nr_of_tests;
+    const double dist = t.pos.distance(d.pos);
+    double df         = 0;
+    if (dist <= sonar_range)
+    {
+        df = sonar_range / dist;
+        df *= df;
+    }
+    return (1.0 - d.noise) * t.noise * df > 0.15;
+}
+
+/// all detections of one ship, as indices of ships
+struct result
+{
+    vector<unsigned> visible, radar, sonar;
+    bool operator==(const result& o) const
+    {
+        return visible == o.visible && radar == o.radar && sonar == o.sonar;
+    }
+};
+
+/// the old way, every ship tests all other ships
+vector<result> detect_linear(const vector<test_ship>& ships)
+{
+    vector<result> results(ships.size());
+    for (unsigned i = 0; i < ships.size(); ++i)
+    {
+        const auto& d = ships[i];
+        auto& r       = results[i];
+        vector<std::pair<double, unsigned>> contacts(
+            max_contacts, std::make_pair(1e30, unsigned(-1)));
+        for (unsigned j = 0; j < ships.size(); ++j)
+        {
+            const auto& t = ships[j];
+            if (lookout_detects(d, t))
+            {
+                r.visible.push_back(j);
+            }
+            if (d.radar_range > 0 && radar_detects(d, t))
+            {
+                r.radar.push_back(j);
+            }
+            if (i == j)
+            {
+                continue;
+            }
+            // insert into list of nearest contacts like game::sonar_ships
+            const double dd = t.pos.square_distance(d.pos);
+            unsigned k      = 0;
+            for (; k < contacts.size(); ++k)
+            {
+                if (contacts[k].first > dd)
+                {
+                    break;
+                }
+            }
+            if (k < contacts.size())
+            {
+                for (unsigned m = contacts.size() - 1; m > k; --m)
+                {
+                    contacts[m] = contacts[m - 1];
+                }
+                contacts[k] = std::make_pair(dd, j);
+            }
+        }
+        for (const auto& c : contacts)
+        {
+            if (c.second != unsigned(-1) && sonar_detects(d, ships[c.second]))
+            {
+                r.sonar.push_back(c.second);
+            }
+        }
+    }
+    return results;
+}
+
+/// the new way of game::detect_sea_objects
+vector<result> detect_grid(const vector<test_ship>& ships)
+{
+    point_grid<unsigned> grid(10000.0);
+    for (unsigned i = 0; i < ships.size(); ++i)
+    {
+        grid.insert(ships[i].pos, i);
+    }
+    vector<result> results(ships.size());
+    for (unsigned i = 0; i < ships.size(); ++i)
+    {
+        const auto& d = ships[i];
+        auto& r       = results[i];
+        for (auto j : grid.find_within(d.pos, max_view_dist + 1.0))
+        {
+            if (lookout_detects(d, ships[j]))
+            {
+                r.visible.push_back(j);
+            }
+        }
+        if (d.radar_range > 0)
+        {
+            for (auto j : grid.find_within(d.pos, d.radar_range + 1.0))
+            {
+                if (radar_detects(d, ships[j]))
+                {
+                    r.radar.push_back(j);
+                }
+            }
+        }
+        for (auto j :
+             grid.find_nearest(d.pos, max_contacts, [i](unsigned j) {
+                 return j != i;
+             }))
+        {
+            if (sonar_detects(d, ships[j]))
+            {
+                r.sonar.push_back(j);
+            }
+        }
+    }
+    return results;
+}
+
+/// convoys of up to 50 ships with escorts, spread over a large area
+vector<test_ship> make_ships(unsigned nr, std::mt19937& gen)
+{
+    std::uniform_real_distribution<double> area(-150000.0, 150000.0);
+    std::uniform_real_distribution<double> spot(-4000.0, 4000.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<test_ship> ships;
+    vector2 center;
+    for (unsigned i = 0; i < nr; ++i)
+    {
+        if (i % 50 == 0)
+        {
+            center = vector2(area(gen), area(gen));
+        }
+        test_ship s;
+        s.pos           = center + vector2(spot(gen), spot(gen));
+        s.cross_section = 200.0 + 1300.0 * unit(gen);
+        s.noise         = 0.2 + 0.6 * unit(gen);
+        // every fifth ship is an escort with radar
+        s.radar_range = (i % 5 == 0) ? 18520.0 : 0.0;
+        ships.push_back(s);
+    }
+    return ships;
+}
+
+/// measure time of function in ms and count sensor tests of one call
+template<typename F>
+double measure_ms(F func, unsigned long& tests)
+{
+    nr_of_tests   = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < nr_of_repeats; ++i)
+    {
+        func();
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    tests         = nr_of_tests / nr_of_repeats;
+    return std::chrono::duration<double, std::milli>(t1 - t0).count()
+           / nr_of_repeats;
+}
+
+/// game of a mission, checks that the detections of all objects computed at
+/// once by the game are the same as the ones every object computes itself.
+class detection_check : public game
+{
+  public:
+    detection_check(const std::string& filename) : game(filename) { }
+
+    /// compare both ways for all objects, returns true if they are the same
+    bool compare()
+    {
+        compute_max_view_dist();
+        // a huge time step makes every object redetect, the results of the
+        // last run are compared
+        const double all_due = 1e6;
+        unsigned long tests  = 0;
+        const double t_batch =
+            measure_ms([&]() { detect_sea_objects(all_due); }, tests);
+        unsigned nr_detectors = 0;
+        unsigned nr_different = 0;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        auto check    = [&](const sea_object& o) {
+            vector<const sea_object*> visible, radar;
+            vector<sonar_contact> sonar;
+            if (!take_detection_result(&o, visible, radar, sonar))
+            {
+                return;
+            }
+            ++nr_detectors;
+            const auto single_sonar = sonar_sea_objects(&o);
+            bool same = visible == visible_sea_objects(&o)
+                        && radar == radar_sea_objects(&o)
+                        && sonar.size() == single_sonar.size();
+            for (unsigned i = 0; same && i < sonar.size(); ++i)
+            {
+                same = sonar[i].pos == single_sonar[i].pos
+                       && sonar[i].type == single_sonar[i].type;
+            }
+            if (!same)
+            {
+                ++nr_different;
+            }
+        };
+        for (const auto& s : ships)
+        {
+            check(s);
+        }
+        for (const auto& s : submarines)
+        {
+            check(s);
+        }
+        for (const auto& a : airplanes)
+        {
+            check(a);
+        }
+        for (const auto& t : torpedoes)
+        {
+            check(t);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        std::cout << "  " << nr_detectors << " detecting objects: batched "
+                  << t_batch << "ms, per object (with comparison) "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count()
+                  << "ms, " << nr_different << " with different results\n";
+        return nr_detectors > 0 && nr_different == 0;
+    }
+};
+
+/// compare the game's detections for the objects of missions
+bool check_missions(const std::vector<std::string>& missions)
+{
+    cfg& mycfg = cfg::instance();
+    mycfg.register_option("screen_res_x", 1024);
+    mycfg.register_option("screen_res_y", 768);
+    mycfg.register_option("fullscreen", false);
+    mycfg.register_option("use_hqsfx", false);
+    mycfg.register_option("water_detail", 128);
+    mycfg.register_option("wave_fft_res", 128);
+    mycfg.register_option("wave_phases", 256);
+    mycfg.register_option("wavetile_length", 256.0f);
+    mycfg.register_option("wave_tidecycle_time", 10.24f);
+    mycfg.register_option("terrain_texture_resolution", 0.1f);
+
+    // objects load their models, which needs OpenGL
+    system_interface::parameters params;
+    params.resolution   = {1024, 768};
+    params.near_z       = 1.0;
+    params.far_z        = 1000.0;
+    params.fullscreen   = false;
+    params.resolution2d = {1024, 768};
+    system_interface::create_instance(new class system_interface(params));
+    global_data::instance();
+
+    bool ok = true;
+    for (const auto& fn : missions)
+    {
+        std::cout << "Detections of mission " << fn << ":\n";
+        detection_check gm(fn);
+        ok = gm.compare() && ok;
+    }
+    global_data::destroy_instance();
+    system_interface::destroy_instance();
+    return ok;
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    if (!args.empty() && args[0] == "--help")
+    {
+        std::cout << "Usage: sensorbench [mission.xml ...]\n"
+                  << "Benchmarks batched sensor detection with generated "
+                     "ships. With missions given,\nalso checks that the "
+                     "game's batched detections are the same as the\n"
+                     "detections of every object computed on its own.\n";
+        return 0;
+    }
+    std::mt19937 gen(12345);
+    bool ok = true;
+    std::cout << "Detection of all ships by all ships, once per second of "
+                 "game time:\n";
+    for (unsigned nr : {50U, 200U, 1000U})
+    {
+        const auto ships = make_ships(nr, gen);
+        vector<result> linear, grid;
+        unsigned long tests_linear = 0, tests_grid = 0;
+        const double t_linear      = measure_ms(
+            [&]() { linear = detect_linear(ships); }, tests_linear);
+        const double t_grid =
+            measure_ms([&]() { grid = detect_grid(ships); }, tests_grid);
+        const bool same = linear == grid;
+        std::cout << "  " << nr << " ships: linear " << t_linear << "ms, "
+                  << tests_linear << " sensor tests; grid " << t_grid
+                  << "ms, " << tests_grid << " sensor tests"
+                  << (same ? "" : ", RESULTS DIFFER!") << "\n";
+        ok = ok && same;
+    }
+    if (!args.empty())
+    {
+        ok = check_missions(args) && ok;
+    }
+    return ok ? 0 : -1;
+}
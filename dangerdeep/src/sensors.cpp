@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "submarine.h"
 #include "vector2.h"
 
+#include <cstdint>
 #include <utility>
 
 // Class sensor
@@ -52,6 +53,24 @@ auto sensor::get_distance_factor(double d) const -> double
     return df;
 }
 
+auto sensor::detection_threshold(
+    const game* gm,
+    const sea_object* d,
+    const sea_object* t) -> double
+{
+    // Mix the keys of both objects and the time to a pseudo random number.
+    // Keys are saved and stay the same when objects move in storage, so a
+    // savegame gives the same detections in every run.
+    uint64_t h = uint64_t(gm->get_object_key(*d)) * 0x9e3779b97f4a7c15ULL;
+    h ^= uint64_t(gm->get_object_key(*t)) + 0x632be59bd9b4e019ULL + (h << 6)
+         + (h >> 2);
+    h ^= uint64_t(gm->get_time()) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 29;
+    return 0.1 + 0.01 * double(h % 10);
+}
+
 auto sensor::is_within_detection_cone(const vector2& r, const angle& h) const
     -> bool
 {
@@ -261,7 +280,7 @@ auto passive_sonar_sensor::is_detected(
             dnoisefac   = 1.0f - dnoisefac;
             sound_level = dnoisefac * tnoisefac * df;
 
-            if (sound_level > (0.1f + 0.01f * rnd(10)))
+            if (sound_level > detection_threshold(gm, d, t))
             {
                 detected = true;
             }
@@ -366,7 +385,7 @@ auto radar_sensor::is_detected(
             // constants
             vis = t->surface_visibility(d->get_pos().xy());
 
-            if (df * vis > (0.1f + 0.01f * rnd(10)))
+            if (df * vis > detection_threshold(gm, d, t))
             {
                 detected = true;
             }
@@ -434,7 +453,7 @@ auto active_sonar_sensor::is_detected(
                 double prod =
                     dist_factor * sonar_vis * dnoisefac * depth_factor;
 
-                if (prod > (0.1f + 0.01f * rnd(10)))
+                if (prod > detection_threshold(gm, d, t))
                 {
                     detected = true;
                 }
@@ -78,6 +78,21 @@ class sensor
     */
     [[nodiscard]] virtual bool
     is_within_detection_cone(const vector2& r, const angle& h) const;
+    /**
+        Gives the signal level that is needed for a detection. It varies
+        randomly between 0.1 and 0.19, but depends only on the keys of the
+        pair of objects and the game time in seconds, so the result does not
+        depend on the order in which detections are computed or on where
+        objects are in memory.
+        @param gm game
+        @param d detecting unit
+        @param t target
+        @return needed signal level
+    */
+    [[nodiscard]] static double detection_threshold(
+        const game* gm,
+        const sea_object* d,
+        const sea_object* t);
 
   public:
     /**
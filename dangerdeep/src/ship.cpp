@@ -348,6 +348,87 @@ ship::ship(game& gm_, const xml_elem& parent) :
     rudder_2_id    = mymodel->get_object_id_by_name("rudder_2");
 }
 
+void ship::start_flooding(unsigned voxel)
+{
+    // flooded mass < 0.05 means empty, < max. mass of voxel means flooding,
+    // else full. This is also the saved state, so keep that encoding.
+    if (flooded_mass[voxel] < 0.06f)
+    {
+        flooded_mass[voxel] = 0.1f;
+        flooding_voxels.push_back(voxel);
+        flooding_volume += mymodel->get_voxel_data()[voxel].relative_volume;
+    }
+}
+
+void ship::simulate_flooding(double delta_time)
+{
+    // distribute the per-time-flooding mass to the flooding voxels evenly.
+    // if a voxel has been filled up, all of its neighbours are set to
+    // flooding state if they aren't already flooding or full. Only the flood
+    // front is touched, so full or dry parts of the ship cost nothing.
+    if (flooding_voxels.empty())
+    {
+        return;
+    }
+    const vector<model::voxel>& voxdat = mymodel->get_voxel_data();
+    const double mass_per_volume =
+        delta_time * flooding_speed / flooding_volume;
+    vector<unsigned> filled;
+    for (unsigned k = 0; k < flooding_voxels.size();)
+    {
+        const unsigned i = flooding_voxels[k];
+        flooded_mass[i] += mass_per_volume * voxdat[i].relative_volume;
+        // max. flooded mass for voxel
+        const double mfm = voxdat[i].relative_volume * max_flooded_mass;
+        if (flooded_mass[i] < mfm)
+        {
+            ++k;
+            continue;
+        }
+        // voxel is full, use a bit more so that "< mfm" is always false.
+        // beware of float inaccuracies!
+        flooded_mass[i] = mfm * 1.00001f;
+        flooding_volume -= voxdat[i].relative_volume;
+        flooding_voxels[k] = flooding_voxels.back();
+        flooding_voxels.pop_back();
+        filled.push_back(i);
+    }
+    for (unsigned i : filled)
+    {
+        for (int ng : voxdat[i].neighbour_idx)
+        {
+            if (ng >= 0)
+            {
+                start_flooding(unsigned(ng));
+            }
+        }
+    }
+    if (flooding_voxels.empty())
+    {
+        flooding_volume = 0; // avoid accumulating rounding errors
+    }
+}
+
+void ship::rebuild_flooding_voxels()
+{
+    flooding_voxels.clear();
+    flooding_volume = 0;
+    if (!mymodel.is_valid())
+    {
+        return;
+    }
+    const vector<model::voxel>& voxdat = mymodel->get_voxel_data();
+    for (unsigned i = 0; i < flooded_mass.size(); ++i)
+    {
+        if (flooded_mass[i] > 0.05f
+            && flooded_mass[i] < voxdat[i].relative_volume * max_flooded_mass)
+        {
+            flooding_voxels.push_back(i);
+            flooding_volume += voxdat[i].relative_volume;
+        }
+    }
+}
+
 void ship::sink()
 {
     flooding_speed += 40000; // 40 tons per second
@@ -396,12 +477,9 @@ void ship::remember_position(double t)
     if (previous_positions.empty()
         || previous_positions.front().pos.square_distance(p) >= 25.0)
     {
+        // the ring buffer drops the oldest entry by itself when full
         previous_positions.push_front(
             prev_pos(p, get_heading().direction(), t, get_speed()));
-        if (previous_positions.size() > TRAIL_LENGTH)
-        {
-            previous_positions.pop_back();
-        }
     }
 }
 
@@ -505,9 +583,10 @@ void ship::load(const xml_elem& parent)
     {
         fiss >> flooded_mas;
     }
+    rebuild_flooding_voxels();
 
     // fixme load that
-    // list<prev_pos> previous_positions;
+    // trail_buffer previous_positions;
     // class particle* myfire;
 
     // fixme: load per gun data
@@ -584,7 +663,7 @@ void ship::save(xml_elem& parent) const
     esink.add_child_text(foss.str());
 
     // fixme save that
-    // list<prev_pos> previous_positions;
+    // trail_buffer previous_positions;
     // class particle* myfire;
 
     // fixme: save per gun data
@@ -635,6 +714,12 @@ void ship::simulate(double delta_time, game& gm)
         return;
     }
 
+    if (kinematic)
+    {
+        simulate_kinematic(delta_time, gm);
+        return;
+    }
+
     sea_object::simulate(delta_time, gm);
 
     // screw animation
@@ -667,60 +752,7 @@ void ship::simulate(double delta_time, game& gm)
     // calculate sinking, fixme replace by buoyancy...
     if (is_inactive())
     {
-        // compute the set of voxels that are currently being flooded.
-        // distribute the per-time-flooding mass to them evenly.
-        // if a voxel has been filled up, all of its neighbours
-        // are set to "filling" state if they aren't already filling or filled.
-        // *important note*
-        // we don't store extra flags for every voxel if it's filling or already
-        // filled, we rather use its flooded mass as special indicator.
-        // < 0.05 means empty, not filling
-        // < max-flooded-mass-for-voxel means filling, but not yet full
-        // else: already filled.
-        // beware of float inaccuracies! so add extra margin before comparing
-        const vector<model::voxel>& voxdat = mymodel->get_voxel_data();
-        vector<unsigned> flooding_voxels;
-        flooding_voxels.reserve(voxdat.size());
-        double flooding_volume = 0;
-        for (unsigned i = 0; i < voxdat.size(); ++i)
-        {
-            if (flooded_mass[i] > 0.05f)
-            {
-                // voxel is flooding or full
-                // get max. flooded mass for voxel
-                double mfm = voxdat[i].relative_volume * max_flooded_mass;
-                if (flooded_mass[i] < mfm)
-                {
-                    // voxel is flooding
-                    flooding_voxels.push_back(i);
-                    flooding_volume += voxdat[i].relative_volume;
-                }
-                else
-                {
-                    // voxel has been flooded, check for its neighbours
-                    // use a bit more so that "< mfm" is always false.
-                    flooded_mass[i] = mfm * 1.00001f;
-                    for (int ng : voxdat[i].neighbour_idx)
-                    {
-                        if (ng >= 0 && flooded_mass[ng] < 0.06f)
-                        {
-                            // has a neighbour that is not flooding nor full
-                            flooded_mass[ng] = 0.1f;
-                        }
-                    }
-                }
-            }
-        }
-        double flooding_volume_rcp = 1.0 / flooding_volume;
-        // add mass to all voxels that are currently flooding.
-        double totally_flooded = 0;
-        for (unsigned int i : flooding_voxels)
-        {
-            flooded_mass[i] += delta_time * flooding_speed
-                               * voxdat[i].relative_volume
-                               * flooding_volume_rcp;
-            totally_flooded += flooded_mass[i];
-        }
+        simulate_flooding(delta_time);
         if (position.z < -200)
         { // used for ships.
             kill();
@@ -757,7 +789,50 @@ void ship::simulate(double delta_time, game& gm)
         }
     }
 
-    // smoke particle generation logic
+    generate_smoke(delta_time, gm);
+
+    // steering logic, adjust rudder pos so that heading matches head_to
+    steering_logic();
+
+    // Adjust rudder
+    rudder.simulate(delta_time);
+
+    // gun turrets
+    auto gun_turret = gun_turrets.begin();
+    while (gun_turret != gun_turrets.end())
+    {
+        // Note! condition must be greater than zero, so that nothing happens
+        // when manning time is zero, like at begin of mission.
+        if (gun_turret->manning_time > 0.0)
+        {
+            gun_turret->manning_time -= delta_time;
+            if (gun_turret->manning_time <= 0.0)
+            {
+                gun_turret->is_gun_manned = !gun_turret->is_gun_manned;
+                gun_manning_is_changing   = false;
+                gun_manning_changed(gun_turret->is_gun_manned, gm);
+            }
+        }
+
+        if (gun_turret->manning_time <= 0.0)
+        {
+            auto gun_barrel = gun_turret->gun_barrels.begin();
+            while (gun_barrel != gun_turret->gun_barrels.end())
+            {
+                if (gun_barrel->load_time_remaining > 0.0)
+                {
+                    gun_barrel->load_time_remaining -= delta_time;
+                }
+                gun_barrel++;
+            }
+        }
+
+        gun_turret++;
+    }
+}
+
+void ship::generate_smoke(double delta_time, game& gm)
+{
     if (is_alive())
     {
         for (auto& it : smoke)
@@ -792,44 +867,106 @@ void ship::simulate(double delta_time, game& gm)
             }
         }
     }
+}
 
-    // steering logic, adjust rudder pos so that heading matches head_to
-    steering_logic();
+void ship::simulate_kinematic(double delta_time, game& gm)
+{
+    // bookkeeping of sea_object::simulate, sensors are not used
+    if (!gm.is_valid(target))
+    {
+        target = sea_object_id{};
+    }
+    compress(visible_objects);
+    compress(radar_objects);
 
-    // Adjust rudder
-    rudder.simulate(delta_time);
+    if (myai.get())
+    {
+        myai->act(*this, gm, delta_time);
+    }
 
-    // gun turrets
-    auto gun_turret = gun_turrets.begin();
-    while (gun_turret != gun_turrets.end())
+    if (is_inactive())
     {
-        // Note! condition must be greater than zero, so that nothing happens
-        // when manning time is zero, like at begin of mission.
-        if (gun_turret->manning_time > 0.0)
+        // flooding is frozen, the ship just goes down at constant speed
+        const double sink_speed = 0.5; // m/s
+        position.z -= sink_speed * delta_time;
+        linear_momentum  = vector3(0, 0, -sink_speed * mass);
+        angular_momentum = vector3();
+        compute_helper_values();
+        if (position.z < -200)
         {
-            gun_turret->manning_time -= delta_time;
-            if (gun_turret->manning_time <= 0.0)
-            {
-                gun_turret->is_gun_manned = !gun_turret->is_gun_manned;
-                gun_manning_is_changing   = false;
-                gun_manning_changed(gun_turret->is_gun_manned, gm);
-            }
+            kill();
         }
+        throttle = stop;
+        return;
+    }
 
-        if (gun_turret->manning_time <= 0.0)
+    calculate_fuel_factor(delta_time);
+
+    // speed follows throttle with maximum acceleration
+    double speed        = get_speed();
+    const double max_dv = max_accel_forward * delta_time;
+    speed += myclamp(get_throttle_speed() - speed, -max_dv, max_dv);
+
+    // turn to course, turn rate is an angle per meter of forward motion
+    double turn = 0;
+    if (head_to_fixed != HEAD_TO_UNDEFINED)
+    {
+        const double max_turn  = turn_rate * fabs(speed) * delta_time;
+        const double anglediff = (head_to - heading).value_pm180();
+        if ((head_to_fixed & HEAD_TO_FORCE_DIRECTION)
+            && heading.diff_in_direction(head_to_fixed & HEAD_TO_LEFT, head_to)
+                   >= 180.0)
         {
-            auto gun_barrel = gun_turret->gun_barrels.begin();
-            while (gun_barrel != gun_turret->gun_barrels.end())
-            {
-                if (gun_barrel->load_time_remaining > 0.0)
-                {
-                    gun_barrel->load_time_remaining -= delta_time;
-                }
-                gun_barrel++;
-            }
+            turn = (head_to_fixed & HEAD_TO_LEFT) ? -max_turn : max_turn;
+        }
+        else if (fabs(anglediff) <= max_turn)
+        {
+            turn          = anglediff;
+            head_to_fixed = HEAD_TO_UNDEFINED;
+        }
+        else
+        {
+            turn = anglediff < 0 ? -max_turn : max_turn;
         }
+    }
 
-        gun_turret++;
+    // set state as the physics would have it for straight upright motion,
+    // so switching back to physics continues smoothly.
+    orientation = quaternion::rot(-(heading.value() + turn), 0, 0, 1);
+    const vector3 v = orientation.rotate(vector3(0, speed, 0));
+    position += v * delta_time;
+    linear_momentum = v * mass;
+    // heading is clockwise, but angular velocity is mathematical. The
+    // physics rotates by twice the angle of w (see sea_object::simulate).
+    const vector3 w(0, 0, -turn * (M_PI / 360.0) / delta_time);
+    angular_momentum =
+        orientation.rotate(inertia_tensor * orientation.conj().rotate(w));
+    compute_helper_values();
+
+    if (myfire)
+    {
+        myfire->set_pos(get_pos() + vector3(0, 0, 12));
+    }
+    generate_smoke(delta_time, gm);
+}
+
+void ship::set_kinematic(bool k)
+{
+    if (k == kinematic)
+    {
+        return;
+    }
+    kinematic = k;
+    if (k)
+    {
+        // the kinematic model turns without rudder
+        rudder.angle    = 0;
+        rudder.to_angle = 0;
+    }
+    else
+    {
+        // sensors were not used, so detect other objects at once
+        redetect_time = 0;
     }
 }
 
@@ -955,7 +1092,7 @@ auto ship::damage(const vector3& fromwhere, unsigned strength, game& gm) -> bool
     for (unsigned int i : voxlist)
     {
         // set all damaged voxels to flooding state (mass > 0.05f)
-        flooded_mass[i] = 0.1f;
+        start_flooding(i);
     }
 
     damage_status& where = midship_damage; // fixme
@@ -1131,6 +1268,55 @@ void ship::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
     // we can parallelize water construction by letting 2 levels compute in
     // parallel.
 
+    vector3 Fl, Tl;
+    compute_hull_force_and_torque(
+        get_hull_parameters(),
+        rudder,
+        local_velocity,
+        inertia_tensor_inv * orientation.conj().rotate(angular_momentum),
+        get_throttle_accel(),
+        Fl,
+        Tl);
+
+    // force is in world space
+    F = orientation.rotate(Fl);
+
+    // Note! drag should be computed for all three dimensions, each with area,
+    // to limit sideward/downward movement as well. We need to know the area
+    // that is underwater then (air drag is negligible for ships). That
+    // value can be computed when we know the volume below water and divide
+    // this by length or width. Volume below water should be precomputed
+    // like cross section, e.g. with is_inside test over voxels inside the ship.
+    F.z += lift_force_sum; // buoyancy/gravity
+
+    // positive torque turns counter clockwise! torque is in world space!
+    T = orientation.rotate(Tl) + dr_torque;
+
+    // fixme: the AI uses turn radius to decide turning direction, that may give
+    // wrong values with new physics!
+}
+
+auto ship::get_hull_parameters() const -> hull_parameters
+{
+    hull_parameters hp;
+    hp.mass            = mass;
+    hp.max_speed       = max_speed_forward;
+    hp.max_accel       = max_accel_forward;
+    hp.size            = vector3(size3d.x, size3d.y, size3d.z);
+    hp.turn_drag_area  = get_turn_drag_area();
+    hp.turn_drag_coeff = get_turn_drag_coeff();
+    return hp;
+}
+
+void ship::compute_hull_force_and_torque(
+    const hull_parameters& hp,
+    const generic_rudder& rudder,
+    const vector3& local_velocity,
+    const vector3& local_turn_velocity,
+    double throttle_accel,
+    vector3& F,
+    vector3& T)
+{
     // acceleration of ship depends on rudder.
     // forward acceleration is max_accel_forward * cos(rudder_ang)
     // fixme 2004/07/18: the drag is too small. engine stop -> the ship slows
@@ -1145,32 +1331,20 @@ void ship::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
     // fixme: add linear drag caused by hull skin friction here!
     if (fabs(local_velocity.y) < 1.0)
     {
-        local_velocity2.y = local_velocity.y * max_speed_forward;
+        local_velocity2.y = local_velocity.y * hp.max_speed;
     }
 
-    vector3 Fr, Tr;
-    double flowforce           = get_throttle_accel() * mass;
+    F                          = vector3();
+    T                          = vector3();
+    double flowforce           = throttle_accel * hp.mass;
     const double water_density = 1000.0;
     double finalflowforce      = rudder.compute_force_and_torque(
-        Fr, Tr, local_velocity, water_density, flowforce);
-    Fr.y += finalflowforce;
+        F, T, local_velocity, water_density, flowforce);
+    F.y += finalflowforce;
 
     const vector3 drag_factors(
-        1.0, max_accel_forward / (max_speed_forward * max_speed_forward), 0.2);
-    Fr -= local_velocity2.coeff_mul(drag_factors) * mass;
-
-    // force is in world space
-    F = orientation.rotate(Fr);
-
-    // Note! drag should be computed for all three dimensions, each with area,
-    // to limit sideward/downward movement as well. We need to know the area
-    // that is underwater then (air drag is negligible for ships). That
-    // value can be computed when we know the volume below water and divide
-    // this by length or width. Volume below water should be precomputed
-    // like cross section, e.g. with is_inside test over voxels inside the ship.
-    F.z += lift_force_sum; // buoyancy/gravity
-    // log_debug("force = "<<orientation.rotate(Fr)<<" + (z)
-    // "<<lift_force_sum<<" = "<<F);
+        1.0, hp.max_accel / (hp.max_speed * hp.max_speed), 0.2);
+    F -= local_velocity2.coeff_mul(drag_factors) * hp.mass;
 
     // torque:
     // there are two forces leading to torque:
@@ -1205,11 +1379,10 @@ void ship::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
     // densitiy * z^3 * tvr^2 * area/(4*L) dz = Dcoeff * density * tvr^2 * area
     // / (2*L) * Int z=0...L  z^3 dz = Dcoeff * density * tvr^2 * area / (2*L) *
     // L^4 / 4 = Dcoeff * density * tvr^2 * area * L^3 / 8
-    const double drag_coefficient = get_turn_drag_coeff();
+    const double drag_coefficient = hp.turn_drag_coeff;
     // compute turn velocities around the 3 axes (local)
     // w.xyz is turn velocity around xyz axis.
-    vector3 w =
-        inertia_tensor_inv * orientation.conj().rotate(angular_momentum);
+    const vector3& w = local_turn_velocity;
     vector3 tvr(fabs(w.x), fabs(w.y), fabs(w.z));
     vector3 tvr2 = tvr.coeff_mul(tvr);
     /*
@@ -1219,12 +1392,12 @@ void ship::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
     if (tvr.z < lmt) tvr2.z = tvr.z*lmt;
     */
     tvr2 += tvr * 0.2;
-    const vector3 L(size3d.y * 0.5, size3d.x * 0.5, size3d.y * 0.5);
+    const vector3 L(hp.size.y * 0.5, hp.size.x * 0.5, hp.size.y * 0.5);
     // fixme: size3d.xyz is not always symmetric...
     const vector3 area(
-        size3d.x * size3d.y * 0.25,
-        size3d.x * size3d.y * 1.0,
-        get_turn_drag_area());
+        hp.size.x * hp.size.y * 0.25,
+        hp.size.x * hp.size.y * 1.0,
+        hp.turn_drag_area);
     // local_torque is drag_torque
     // fixme without that 80 drag is too low, not only turn drag,
     // but also roll/yaw drag, ship capsizes without that!!
@@ -1244,13 +1417,8 @@ void ship::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
         local_torque.z = -local_torque.z;
     }
 
-    // positive torque turns counter clockwise! torque is in world space!
-    T = orientation.rotate(local_torque + Tr) + dr_torque;
-    // log_debug("Torque, local="<<local_torque<<"  Tr="<<Tr<<"
-    // dr_tq="<<dr_torque);
-
-    // fixme: the AI uses turn radius to decide turning direction, that may give
-    // wrong values with new physics!
+    // positive torque turns counter clockwise!
+    T += local_torque;
 }
 
 auto ship::get_turn_drag_area() const -> double
@@ -1391,7 +1559,8 @@ auto ship::fire_shell_at(const vector2& pos, game& gm) -> ship::gun_status
 
 auto ship::man_guns() -> bool
 {
-    log_debug("man guns, is gun manned? " << has_guns() && is_gun_manned());
+    log_debug(
+        "man guns, is gun manned? " << (has_guns() && is_gun_manned()));
     if (has_guns() && !is_gun_manned())
     {
         if (!gun_manning_is_changing)
@@ -1408,7 +1577,8 @@ auto ship::man_guns() -> bool
 
 auto ship::unman_guns() -> bool
 {
-    log_debug("UNman guns, is gun manned? " << has_guns() && is_gun_manned());
+    log_debug(
+        "UNman guns, is gun manned? " << (has_guns() && is_gun_manned()));
     if (has_guns() && is_gun_manned())
     {
         if (!gun_manning_is_changing)
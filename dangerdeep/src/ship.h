@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "bv_tree.h"
+#include "ring_buffer.h"
 #include "sea_object.h"
 
 #include <map>
@@ -93,6 +94,7 @@ class ship : public sea_object
         vector2 dir;  // direction (heading) of ship
         double time;  // absolute time when position was recorded
         double speed; // speed of ship when position was recorded
+        prev_pos() = default; // needed for ring buffer storage
         prev_pos(const vector2& p, const vector2& d, double t, double s) :
             pos(p), dir(d), time(t), speed(s)
         {
@@ -100,11 +102,8 @@ class ship : public sea_object
         // add xml load/save functions here, fixme
     };
 
-  protected:
-    unsigned tonnage; // in BRT, created after values from spec file, must get
-                      // stored!
-
-    int throttle; // if < 0: throttle_state, if > 0: knots
+    /// trail record with fixed capacity, no allocation per sample
+    using trail_buffer = ring_buffer<prev_pos, TRAIL_LENGTH>;
 
     /// rudder related stuff grouped as class
     struct generic_rudder
@@ -158,6 +157,36 @@ class ship : public sea_object
             const double& flow_force = 0) const;
     };
 
+    /// run-time constants of a hull for the forces of the water flow
+    struct hull_parameters
+    {
+        double mass{1.0};
+        double max_speed{1.0}; ///< forward, in m/s
+        double max_accel{1.0}; ///< forward, in m/s^2
+        vector3 size;          ///< width, length and height in meters
+        double turn_drag_area{0.0};
+        double turn_drag_coeff{1.0};
+    };
+
+    /// compute force and torque of engine, drag and rudder in local space.
+    /// Buoyancy and gravity are computed from the voxels in
+    /// compute_force_and_torque. Static, so tests can use it without game.
+    ///@param local_turn_velocity - turn velocity around local axes in rad/s
+    static void compute_hull_force_and_torque(
+        const hull_parameters& hp,
+        const generic_rudder& rudder,
+        const vector3& local_velocity,
+        const vector3& local_turn_velocity,
+        double throttle_accel,
+        vector3& F,
+        vector3& T);
+
+  protected:
+    unsigned tonnage; // in BRT, created after values from spec file, must get
+                      // stored!
+
+    int throttle; // if < 0: throttle_state, if > 0: knots
+
     generic_rudder rudder;
 
     head_to_param head_to_fixed;
@@ -185,7 +214,11 @@ class ship : public sea_object
     // sonar / underwater sound specific constants, read from spec file
     noise_signature noise_sign;
 
-    std::list<prev_pos> previous_positions;
+    /// ship is simulated by cheap kinematic model instead of physics
+    bool kinematic{false};
+
+    // trail record, newest position first
+    trail_buffer previous_positions;
 
     shipclass myclass; // read from spec file, e.g. warship/merchant/escort/...
 
@@ -200,6 +233,18 @@ class ship : public sea_object
     // maximum of additional mass because of flooding, computed from spec/mdl
     // file can be volume * density of water.
     double max_flooded_mass;
+    // voxels that are currently flooding (the flood front), derived from
+    // flooded_mass. Only these are touched while the ship sinks.
+    std::vector<unsigned> flooding_voxels;
+    // sum of relative volume of flooding voxels
+    double flooding_volume{0};
+
+    /// set voxel to flooding state if it is neither flooding nor full
+    void start_flooding(unsigned voxel);
+    /// let water flood into the ship, advancing the flood front
+    void simulate_flooding(double delta_time);
+    /// recreate flood front from flooded_mass
+    void rebuild_flooding_voxels();
 
     void compute_force_and_torque(vector3& F, vector3& T, game& gm)
         const override; // drag must be already included!
@@ -207,6 +252,10 @@ class ship : public sea_object
     /// implementation of the steering logic: helmsman simulation, or simpler
     /// model for torpedoes.
     virtual void steering_logic();
+    /// kinematic simulation, only course, speed and sinking are handled
+    void simulate_kinematic(double delta_time, game& gm);
+    /// produce smoke particles from the smoke generators
+    void generate_smoke(double delta_time, game& gm);
     /// return the acceleration factor for computing torque (depends on rudder
     /// area etc.)
     [[nodiscard]] virtual double get_turn_accel_factor() const
@@ -218,6 +267,7 @@ class ship : public sea_object
     /// return the side area for drag computation multiplied by drag
     /// coefficient.
     [[nodiscard]] virtual double get_turn_drag_area() const;
+    [[nodiscard]] hull_parameters get_hull_parameters() const;
 
     /**
         This method calculates the hourly fuel consumption. An
@@ -337,6 +387,13 @@ class ship : public sea_object
 
     void simulate(double delta_time, game& gm) override;
 
+    /// Switch between full physics and kinematic simulation. The kinematic
+    /// model only follows course and speed, voxel buoyancy and flooding are
+    /// frozen. It keeps the physical state consistent, so the ship can
+    /// switch back at any time. Meant for distant, unobserved ships.
+    void set_kinematic(bool k);
+    [[nodiscard]] bool is_kinematic() const { return kinematic; }
+
     virtual void sink();
 
     virtual void ignite(game& gm);
@@ -359,7 +416,7 @@ class ship : public sea_object
     virtual void set_throttle(int thr);
 
     virtual void remember_position(double t);
-    [[nodiscard]] virtual const std::list<prev_pos>&
+    [[nodiscard]] virtual const trail_buffer&
     get_previous_positions() const
     {
         return previous_positions;
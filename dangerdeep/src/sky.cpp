@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "moon.h"
 #include "oglext/OglExt.h"
 #include "primitives.h"
+#include "profiler.h"
 #include "sky.h"
 #include "texture.h"
 
@@ -47,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 using std::vector;
 
 const double CLOUD_ANIMATION_CYCLE_TIME = 3600.0;
+const unsigned CLOUD_MAP_RESOLUTION     = 256;
 
 /* fixme: idea:
    use perlin noise data as height (3d depth) of cloud.
@@ -93,10 +95,16 @@ sky::sky(
     // cos/sin(direction_in_sphere). That means a circle with radius 512 of the
     // original map is used.
 
+    // The maps are computed by a worker thread one animation step ahead and
+    // uploaded to the same texture, so there is no frame time spike when the
+    // animation advances.
+
     cloud_levels    = 5;
     cloud_coverage  = 192; // 128;	// 0-256 (none-full)
     cloud_sharpness = 256; // 0-256
     cloud_animphase = 0;
+    cloud_cycle     = 0;
+    noise_cycle     = 0;
 
     cloud_interpolate_func.resize(256);
     for (unsigned n = 0; n < 256; ++n)
@@ -104,9 +112,27 @@ sky::sky(
         cloud_interpolate_func[n] = unsigned(128 - cos(n * M_PI / 256) * 128);
     }
 
+    // lookup table for the accumulated noise value of all levels (max. 2*255)
+    // to cloud alpha value, clamp(clamp_at_zero(s - 96) * sharpness).
+    // fixme: the offset should depend on cloud_coverage.
+    cloud_coverage_func.resize(512);
+    for (unsigned v = 0; v < 512; ++v)
+    {
+        unsigned c = (v < 96) ? 0 : ((v - 96) * cloud_sharpness) / 256;
+        cloud_coverage_func[v] = uint8_t(std::min(c, 255U));
+    }
+
     noisemaps_0 = compute_noisemaps();
     noisemaps_1 = compute_noisemaps();
-    compute_clouds();
+    cloud_mixmaps = noisemaps_0;
+    compute_clouds(0, cloud_map_upload);
+    clouds = std::make_unique<texture>(
+        cloud_map_upload,
+        CLOUD_MAP_RESOLUTION,
+        CLOUD_MAP_RESOLUTION,
+        GL_LUMINANCE,
+        texture::LINEAR,
+        texture::REPEAT);
 
     clouds_texcoords.init_data(
         nr_sky_vertices * 2 * 4, nullptr, GL_STATIC_DRAW);
@@ -129,33 +155,115 @@ sky::sky(
         get_shader_dir() + "clouds.fshader");
     glsl_clouds->use();
     loc_cloudstex = glsl_clouds->get_uniform_location("tex_cloud");
+
+    // start computing the next cloud map
+    cloudworker.reset(new cloud_worker(*this));
+    cloudworker->start();
+    request_cloud_step(1);
+}
+
+void sky::cloud_worker::loop()
+{
+    unsigned step = 0;
+    {
+        std::unique_lock<std::mutex> ml(sk.cloud_mutex);
+        sk.cloud_cond.wait(ml, [this]() {
+            return sk.cloud_request_pending || abort_requested();
+        });
+        if (abort_requested())
+        {
+            return;
+        }
+        step                     = sk.cloud_step_request;
+        sk.cloud_request_pending = false;
+    }
+    // compute without holding the lock, main thread must not wait for us
+    sk.compute_clouds(step, workmap);
+    std::unique_lock<std::mutex> ml(sk.cloud_mutex);
+    sk.cloud_map_ready_data.swap(workmap);
+    sk.cloud_step_ready = step;
+    sk.cloud_map_ready  = true;
+}
+
+void sky::cloud_worker::request_abort()
+{
+    std::unique_lock<std::mutex> ml(sk.cloud_mutex);
+    ::thread::request_abort();
+    sk.cloud_cond.notify_all();
+}
+
+void sky::request_cloud_step(unsigned step)
+{
+    // called with cloud_mutex unlocked
+    std::unique_lock<std::mutex> ml(cloud_mutex);
+    cloud_step_request    = step;
+    cloud_request_pending = true;
+    cloud_step_requested  = step;
+    cloud_cond.notify_one();
 }
 
 void sky::advance_cloud_animation(double fac)
 {
-    int oldphase = int(cloud_animphase * 256);
     cloud_animphase += fac;
-    int newphase = int(cloud_animphase * 256);
     if (cloud_animphase >= 1.0)
     {
         cloud_animphase -= 1.0;
-        noisemaps_0 = noisemaps_1;
-        noisemaps_1 = compute_noisemaps();
+        ++cloud_cycle;
     }
-    else
+    unsigned step = cloud_cycle * 256 + unsigned(cloud_animphase * 256);
+
+    // fetch map from worker if it is ready and not in the future
+    bool new_map = false;
     {
-        if (newphase > oldphase)
+        std::unique_lock<std::mutex> ml(cloud_mutex);
+        if (cloud_map_ready && cloud_step_ready <= step)
         {
-            compute_clouds();
+            cloud_map_upload.swap(cloud_map_ready_data);
+            cloud_step_displayed = cloud_step_ready;
+            cloud_map_ready      = false;
+            new_map              = true;
         }
     }
+    if (new_map)
+    {
+        clouds->sub_image(
+            0,
+            0,
+            CLOUD_MAP_RESOLUTION,
+            CLOUD_MAP_RESOLUTION,
+            cloud_map_upload,
+            GL_LUMINANCE);
+    }
+
+    // let the worker compute the next step in advance, or catch up with time
+    // if it has been skipped forward.
+    unsigned next_step = (cloud_step_displayed == step) ? step + 1 : step;
+    if (next_step != cloud_step_requested)
+    {
+        request_cloud_step(next_step);
+    }
 }
 
-void sky::compute_clouds()
+void sky::compute_clouds(unsigned step, vector<uint8_t>& fullmap)
 {
     unsigned mapsize  = 8 - cloud_levels;
     unsigned mapsize2 = (2 << mapsize);
 
+    // bring noise maps to the animation cycle of the step
+    unsigned cycle = step / 256;
+    if (cycle == noise_cycle + 1)
+    {
+        noisemaps_0.swap(noisemaps_1);
+        noisemaps_1 = compute_noisemaps();
+    }
+    else if (cycle > noise_cycle + 1)
+    {
+        // skipped whole cycles, just start with fresh noise
+        noisemaps_0 = compute_noisemaps();
+        noisemaps_1 = compute_noisemaps();
+    }
+    noise_cycle = cycle;
+
     // FIXME could we interpolate between accumulated noise maps
     // to further speed up the process?
     // in theory, yes. formula says that we can...
@@ -165,49 +273,33 @@ void sky::compute_clouds()
     // clouds facing away from the sun shouldn't be black though (because of
     // bump mapping).
     // FIXME use perlin noise generator here!
-    vector<vector<uint8_t>> cmaps = noisemaps_0;
-    float f                       = cloud_animphase;
+    unsigned f = step % 256;
     for (unsigned i = 0; i < cloud_levels; ++i)
     {
         for (unsigned j = 0; j < mapsize2 * mapsize2; ++j)
         {
-            cmaps[i][j] =
-                uint8_t(noisemaps_0[i][j] * (1 - f) + noisemaps_1[i][j] * f);
+            cloud_mixmaps[i][j] = uint8_t(
+                (noisemaps_0[i][j] * (256 - f) + noisemaps_1[i][j] * f) >> 8);
         }
     }
 
     // create full map
-    const unsigned res = 256;
-    vector<uint8_t> fullmap(res * res);
+    fullmap.resize(CLOUD_MAP_RESOLUTION * CLOUD_MAP_RESOLUTION);
     unsigned fullmapptr = 0;
-    for (unsigned y = 0; y < res; ++y)
+    for (unsigned y = 0; y < CLOUD_MAP_RESOLUTION; ++y)
     {
-        for (unsigned x = 0; x < res; ++x)
+        for (unsigned x = 0; x < CLOUD_MAP_RESOLUTION; ++x)
         {
             unsigned v = 0;
             // accumulate values
             for (unsigned k = 0; k < cloud_levels; ++k)
             {
-                unsigned tv = get_value_from_bytemap(x, y, k, cmaps[k]);
+                unsigned tv = get_value_from_bytemap(x, y, k, cloud_mixmaps[k]);
                 v += (tv >> k);
             }
-            // FIXME generate a lookup table for this function, depending on
-            // coverage/sharpness
-            if (v < 96)
-            {
-                v = 96;
-            }
-            v -= 96;
-            if (v > 255)
-            {
-                v = 255;
-            }
-            fullmap[fullmapptr++] = v;
+            fullmap[fullmapptr++] = cloud_coverage_func[v];
         }
     }
-
-    clouds = std::make_unique<texture>(
-        fullmap, res, res, GL_LUMINANCE, texture::LINEAR, texture::REPEAT);
 }
 
 auto sky::compute_noisemaps() -> vector<vector<uint8_t>>
@@ -220,7 +312,7 @@ auto sky::compute_noisemaps() -> vector<vector<uint8_t>>
         noisemaps[i].resize(mapsize2 * mapsize2);
         for (unsigned j = 0; j < mapsize2 * mapsize2; ++j)
         {
-            noisemaps[i][j] = static_cast<unsigned char>(255 * rnd());
+            noisemaps[i][j] = static_cast<unsigned char>(255 * cloud_rnd.get());
         }
         smooth_and_equalize_bytemap(mapsize2, noisemaps[i]);
     }
@@ -231,7 +323,7 @@ auto sky::get_value_from_bytemap(
     unsigned x,
     unsigned y,
     unsigned level,
-    const vector<uint8_t>& nmap) -> uint8_t
+    const vector<uint8_t>& nmap) const -> uint8_t
 {
     // x,y are in 0...255, shift them according to level
     unsigned shift    = cloud_levels - 1 - level;
@@ -322,6 +414,7 @@ void sky::display(
     double max_view_dist,
     bool isreflection) const
 {
+    PROFILE_ZONE("sky::display");
     // 25th jan 2007, after switch to VBO: skipping sky render brings 4fps.
     // 50->54 in editor
 
@@ -30,11 +30,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "color.h"
 #include "model.h"
 #include "moon.h"
+#include "random_generator.h"
 #include "shader.h"
 #include "stars.h"
+#include "thread.h"
 #include "vector3.h"
 #include "vertexbufferobject.h"
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 class game;
@@ -49,11 +53,43 @@ class sky
     texture::ptr clouds;
     texture::ptr suntex;
     double cloud_animphase; // 0-1 phase of interpolation
-    std::vector<std::vector<uint8_t>> noisemaps_0,
-        noisemaps_1; // interpolate to animate clouds
+    unsigned cloud_cycle;   // number of completed animation cycles
     vertexbufferobject clouds_texcoords;
     unsigned cloud_levels, cloud_coverage, cloud_sharpness;
     std::vector<unsigned> cloud_interpolate_func; // give fraction as uint8_t
+    std::vector<uint8_t> cloud_coverage_func; // accumulated noise to alpha
+
+    // cloud map generation, only used by cloud worker after construction
+    std::vector<std::vector<uint8_t>> noisemaps_0,
+        noisemaps_1; // interpolate to animate clouds
+    std::vector<std::vector<uint8_t>> cloud_mixmaps; // interpolated maps
+    unsigned noise_cycle; // animation cycle that noisemaps belong to
+    random_generator cloud_rnd;
+
+    // cloud maps are computed one animation step ahead by a worker thread.
+    // step numbers count animation steps (1/256 of a cycle) since start.
+    std::mutex cloud_mutex;
+    std::condition_variable cloud_cond;
+    bool cloud_request_pending{false}; ///< worker should compute a map
+    unsigned cloud_step_request{0};    ///< step the worker should compute
+    bool cloud_map_ready{false};       ///< worker has a new map ready
+    unsigned cloud_step_ready{0};      ///< step of the ready map
+    std::vector<uint8_t> cloud_map_ready_data; ///< map for cloud_step_ready
+    // only used by main thread
+    unsigned cloud_step_displayed{0}; ///< step that the texture shows
+    unsigned cloud_step_requested{0}; ///< step that was last requested
+    std::vector<uint8_t> cloud_map_upload; ///< reused buffer for upload
+
+    class cloud_worker : public ::thread
+    {
+        sky& sk;
+        std::vector<uint8_t> workmap;
+
+      public:
+        cloud_worker(sky& s) : thread("skyclouds"), sk(s) { }
+        void loop() override;
+        void request_abort() override;
+    };
 
     sky& operator=(const sky& other);
     sky(const sky& other);
@@ -61,13 +97,14 @@ class sky
     // generate new clouds, fac (0-1) gives animation phase. animation is
     // cyclic.
     void advance_cloud_animation(double fac); // 0-1
-    void compute_clouds();
+    void request_cloud_step(unsigned step);
+    void compute_clouds(unsigned step, std::vector<uint8_t>& fullmap);
     std::vector<std::vector<uint8_t>> compute_noisemaps();
     uint8_t get_value_from_bytemap(
         unsigned x,
         unsigned y,
         unsigned level,
-        const std::vector<uint8_t>& nmap);
+        const std::vector<uint8_t>& nmap) const;
     void smooth_and_equalize_bytemap(unsigned s, std::vector<uint8_t>& map1);
 
     stars _stars;
@@ -85,6 +122,9 @@ class sky
     std::unique_ptr<glsl_shader_setup> glsl_clouds;
     unsigned loc_cloudstex;
 
+    // declared last, so the worker is stopped before its data is destroyed
+    ::thread::ptr<cloud_worker> cloudworker;
+
     void build_dome(const unsigned int sectors_h, const unsigned int sectors_v);
 
   public:
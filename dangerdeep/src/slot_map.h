@@ -0,0 +1,312 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// Dense object storage with generational keys
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "error.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+///\brief Hands out generational keys for slot_map objects.
+/** A key holds the slot number plus one in the lower bits (so zero is never
+    a valid key) and the generation of the slot in the upper bits. When a key
+    is released the generation of its slot is increased, so stale keys never
+    refer to a new object in that slot. An allocator can be shared by several
+    slot_maps to get keys that are unique among them.
+    Freshly allocated keys count up from 1, so plain sequential numbers from
+    older data are valid keys with generation zero.
+*/
+class slot_key_allocator
+{
+  public:
+    static constexpr unsigned index_bits = 20;
+    static constexpr uint32_t index_mask = (1U << index_bits) - 1;
+
+    /// get slot number of key
+    static unsigned slot_of(uint32_t key) { return (key & index_mask) - 1; }
+
+    /// allocate a new key
+    uint32_t allocate()
+    {
+        unsigned slot = 0;
+        if (free_slots.empty())
+        {
+            slot = unsigned(generations.size());
+            if (slot >= index_mask)
+            {
+                THROW(error, "slot_key_allocator: out of keys");
+            }
+            generations.push_back(0);
+            used.push_back(true);
+        }
+        else
+        {
+            // reuse oldest free slot, so stale keys stay invalid longest
+            slot = free_slots.front();
+            free_slots.pop_front();
+            used[slot] = true;
+        }
+        return make_key(slot);
+    }
+
+    /// mark a given key as used, e.g. when loading stored keys
+    void reserve(uint32_t key)
+    {
+        if ((key & index_mask) == 0)
+        {
+            THROW(error, "slot_key_allocator: invalid key to reserve");
+        }
+        const unsigned slot = slot_of(key);
+        while (generations.size() <= slot)
+        {
+            free_slots.push_back(unsigned(generations.size()));
+            generations.push_back(0);
+            used.push_back(false);
+        }
+        if (used[slot])
+        {
+            THROW(error, "slot_key_allocator: key already in use");
+        }
+        for (auto it = free_slots.begin(); it != free_slots.end(); ++it)
+        {
+            if (*it == slot)
+            {
+                free_slots.erase(it);
+                break;
+            }
+        }
+        generations[slot] = key >> index_bits;
+        used[slot]        = true;
+    }
+
+    /// give key back, the slot can be reused with a new generation
+    void release(uint32_t key)
+    {
+        if (!is_valid(key))
+        {
+            THROW(error, "slot_key_allocator: release of invalid key");
+        }
+        const unsigned slot = slot_of(key);
+        generations[slot]   = (generations[slot] + 1) & (~0U >> index_bits);
+        used[slot]          = false;
+        free_slots.push_back(slot);
+    }
+
+    /// check if key is currently in use
+    [[nodiscard]] bool is_valid(uint32_t key) const
+    {
+        if ((key & index_mask) == 0)
+        {
+            return false;
+        }
+        const unsigned slot = slot_of(key);
+        return slot < generations.size() && used[slot]
+               && generations[slot] == (key >> index_bits);
+    }
+
+    /// number of slots ever used, keys map to slot numbers below that
+    [[nodiscard]] unsigned get_nr_of_slots() const
+    {
+        return unsigned(generations.size());
+    }
+
+    /// forget all keys
+    void clear()
+    {
+        generations.clear();
+        used.clear();
+        free_slots.clear();
+    }
+
+  protected:
+    std::vector<uint32_t> generations;
+    std::vector<bool> used;
+    std::deque<unsigned> free_slots;
+
+    [[nodiscard]] uint32_t make_key(unsigned slot) const
+    {
+        return (generations[slot] << index_bits) | (slot + 1);
+    }
+};
+
+///\brief Stores objects contiguously and finds them by generational key.
+/** Values are kept in one vector, so iterating is cache friendly. Lookup
+    by key and finding the key of a stored object are O(1). Erasing moves
+    the last object into the gap and inserting may reallocate, so pointers
+    to objects are only stable while the storage version does not change.
+    Keys come from a slot_key_allocator that may be shared.
+*/
+template<class T>
+class slot_map
+{
+  public:
+    using iterator       = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    /// create map that uses the given key allocator
+    slot_map(slot_key_allocator& keys_) : keys(&keys_) { }
+
+    /// insert object with new key
+    T& insert(T&& obj) { return insert_at(keys->allocate(), std::move(obj)); }
+
+    /// insert object with known key, that must not be in use
+    T& insert_with_key(uint32_t key, T&& obj)
+    {
+        keys->reserve(key);
+        return insert_at(key, std::move(obj));
+    }
+
+    /// find object by key, nullptr if key is not valid for this map
+    T* find(uint32_t key)
+    {
+        const auto i = index_of(key);
+        return i < values.size() ? &values[i] : nullptr;
+    }
+
+    /// find object by key, nullptr if key is not valid for this map
+    const T* find(uint32_t key) const
+    {
+        const auto i = index_of(key);
+        return i < values.size() ? &values[i] : nullptr;
+    }
+
+    /// get key of stored object, 0 if object is not stored here
+    [[nodiscard]] uint32_t key_of(const T& obj) const
+    {
+        // object must be inside our storage, then its index is known
+        const std::less<const T*> less;
+        if (values.empty() || less(&obj, &values.front())
+            || less(&values.back(), &obj))
+        {
+            return 0;
+        }
+        return dense_keys[&obj - &values.front()];
+    }
+
+    /// get key of object by storage index
+    [[nodiscard]] uint32_t key_at(std::size_t index) const
+    {
+        return dense_keys[index];
+    }
+
+    /// erase all objects matching the predicate, giving their keys back.
+    ///@note moves objects, so all pointers to objects may change
+    template<typename Pred>
+    void erase_if(Pred pred)
+    {
+        for (std::size_t i = 0; i < values.size();)
+        {
+            if (pred(values[i]))
+            {
+                erase_at(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    /// remove all objects and give their keys back
+    void clear()
+    {
+        for (auto k : dense_keys)
+        {
+            keys->release(k);
+        }
+        values.clear();
+        dense_keys.clear();
+        sparse.clear();
+    }
+
+    /// get counter that changes whenever stored objects move in memory
+    [[nodiscard]] unsigned get_storage_version() const
+    {
+        return storage_version;
+    }
+
+    [[nodiscard]] std::size_t size() const { return values.size(); }
+    [[nodiscard]] bool empty() const { return values.empty(); }
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+
+  protected:
+    static constexpr uint32_t no_index = ~0U;
+    slot_key_allocator* keys;
+    std::vector<T> values;
+    std::vector<uint32_t> dense_keys; ///< key per value
+    std::vector<uint32_t> sparse;     ///< slot to value index or no_index
+    unsigned storage_version{0};
+
+    T& insert_at(uint32_t key, T&& obj)
+    {
+        const unsigned slot = slot_key_allocator::slot_of(key);
+        if (sparse.size() <= slot)
+        {
+            sparse.resize(slot + 1, no_index);
+        }
+        sparse[slot] = uint32_t(values.size());
+        dense_keys.push_back(key);
+        if (values.size() == values.capacity())
+        {
+            ++storage_version; // reallocation
+        }
+        values.push_back(std::move(obj));
+        return values.back();
+    }
+
+    [[nodiscard]] std::size_t index_of(uint32_t key) const
+    {
+        if ((key & slot_key_allocator::index_mask) == 0)
+        {
+            return no_index;
+        }
+        const unsigned slot = slot_key_allocator::slot_of(key);
+        if (slot >= sparse.size() || sparse[slot] == no_index
+            || dense_keys[sparse[slot]] != key)
+        {
+            return no_index;
+        }
+        return sparse[slot];
+    }
+
+    void erase_at(std::size_t i)
+    {
+        keys->release(dense_keys[i]);
+        sparse[slot_key_allocator::slot_of(dense_keys[i])] = no_index;
+        const std::size_t last = values.size() - 1;
+        if (i != last)
+        {
+            ++storage_version;
+            values[i]     = std::move(values[last]);
+            dense_keys[i] = dense_keys[last];
+            sparse[slot_key_allocator::slot_of(dense_keys[i])] = uint32_t(i);
+        }
+        values.pop_back();
+        dense_keys.pop_back();
+    }
+};
@@ -1516,9 +1516,10 @@ auto submarine::launch_torpedo(int tubenr, const vector3& targetpos, game& gm)
         // cout << "fired at " << fired_at_angle.value() << ", head to " <<
         // torp_head_to.value() << ", is cw nearer " <<
         // torp_head_to.is_clockwise_nearer(fired_at_angle) << "\n";
-        xml_doc doc(data_file().get_filename(torpedoes[tubenr].specfilename));
-        doc.load();
-        torpedo torp(gm, doc.first_child(), torpedoes[tubenr].setup);
+        torpedo torp(
+            gm,
+            data_file().get_spec(torpedoes[tubenr].specfilename),
+            torpedoes[tubenr].setup);
         torp.head_to_course(
             torp_head_to,
             fired_at_angle.is_clockwise_nearer(torp_head_to) ? 1 : -1);
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "credits.h"
 #include "datadirs.h"
 #include "date.h"
+#include "display_asset_cache.h"
 #include "faulthandler.h"
 #include "filehelper.h"
 #include "game.h"
@@ -38,19 +39,25 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "image.h"
 #include "keys.h"
 #include "log.h"
+#include "memory_usage.h"
 #include "model.h"
 #include "music.h"
 #include "mymain.cpp"
 #include "oglext/OglExt.h"
+#include "profiler.h"
+#include "savegame_index.h"
 #include "ship.h"
 #include "system_interface.h"
 #include "texts.h"
 #include "texture.h"
+#include "torpedo.h"
 #include "user_interface.h"
 #include "vector3.h"
+#include "water.h"
 #include "widget.h"
 
 #include <ctime>
+#include <fstream>
 #include <glu.h>
 #include <iostream>
 #include <memory>
@@ -144,32 +151,51 @@ auto get_savegame_name_for(const string& descr, map<string, string>& savegames)
     return savegamedirectory + tmp;
 }
 
-auto is_savegame_name(const string& s) -> bool
-{
-    if (s.length() != 14)
-    {
-        return false;
-    }
-
-    if (s.substr(0, 5) != "save_")
-    {
-        return false;
-    }
+/// RGB thumbnail of last frame of game, stored in savegames
+std::vector<uint8_t> last_frame_thumbnail;
 
-    if (s.substr(9, 7) != ".dftd")
+/// read back buffer and scale it down to a savegame thumbnail
+void capture_thumbnail()
+{
+    const unsigned w = SYS().get_res_x();
+    const unsigned h = SYS().get_res_y();
+    const unsigned t = savegame_header::thumbnail_size;
+    if (w < t || h < t)
     {
-        return false;
+        last_frame_thumbnail.clear();
+        return;
     }
-
-    for (int i = 5; i < 9; ++i)
-    {
-        if (s[i] < '0' || s[i] > '9')
-        {
-            return false;
+    std::vector<uint8_t> screen(w * h * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, &screen[0]);
+    // average the screen pixels of each thumbnail pixel, GL rows are
+    // bottom up
+    last_frame_thumbnail.resize(t * t * 3);
+    for (unsigned y = 0; y < t; ++y)
+    {
+        const unsigned y0 = (t - 1 - y) * h / t, y1 = (t - y) * h / t;
+        for (unsigned x = 0; x < t; ++x)
+        {
+            const unsigned x0 = x * w / t, x1 = (x + 1) * w / t;
+            unsigned sum[3]   = {0, 0, 0};
+            for (unsigned sy = y0; sy < y1; ++sy)
+            {
+                for (unsigned sx = x0; sx < x1; ++sx)
+                {
+                    for (unsigned c = 0; c < 3; ++c)
+                    {
+                        sum[c] += screen[(sy * w + sx) * 3 + c];
+                    }
+                }
+            }
+            const unsigned n = (y1 - y0) * (x1 - x0);
+            for (unsigned c = 0; c < 3; ++c)
+            {
+                last_frame_thumbnail[(y * t + x) * 3 + c] = uint8_t(sum[c] / n);
+            }
         }
     }
-
-    return true;
 }
 
 //
@@ -179,13 +205,18 @@ class loadsavequit_dialogue : public widget
 {
     widget_edit* gamename;
     widget_list* gamelist;
+    widget_text* gameinfo;
+    widget* gamethumbnail;
     widget_button *btnload, *btnsave, *btndel, *btnquit, *btncancel;
 
     const game* mygame;
     bool gamesaved;
 
+    savegame_index index;
+    bool list_pending;
     map<string, string> savegames;
     string gamefilename_to_load;
+    std::unique_ptr<texture> thumbnail;
 
     void load();
     void save();
@@ -199,6 +230,8 @@ class loadsavequit_dialogue : public widget
       // loaded
 
     void update_list();
+    void fill_list();
+    void show_header();
 
   public:
     auto get_gamefilename_to_load() const -> string
@@ -206,12 +239,13 @@ class loadsavequit_dialogue : public widget
         return gamefilename_to_load;
     }
     auto get_gamename() const -> widget_edit* { return gamename; }
+    void on_idle() override;
     explicit loadsavequit_dialogue(const game* g); // give 0 to disable saving
 };
 
 loadsavequit_dialogue::loadsavequit_dialogue(const game* g) :
     widget(0, 0, 1024, 768, texts::get(177), nullptr, "depthcharge.jpg"),
-    mygame(g), gamesaved(false)
+    mygame(g), gamesaved(false), index(savegamedirectory), list_pending(false)
 {
     add_child(std::make_unique<widget_text>(40, 40, 0, 0, texts::get(178)));
 
@@ -258,19 +292,84 @@ loadsavequit_dialogue::loadsavequit_dialogue(const game* g) :
     {
         void on_sel_change() override
         {
-            dynamic_cast<loadsavequit_dialogue*>(parent)
-                ->get_gamename()
-                ->set_text(get_selected_entry());
+            auto* ld = dynamic_cast<loadsavequit_dialogue*>(parent);
+            ld->get_gamename()->set_text(get_selected_entry());
+            ld->show_header();
         }
         lsqlist(int x, int y, int w, int h) : widget_list(x, y, w, h) { }
         ~lsqlist() override = default;
     };
 
-    gamelist = &add_child(std::make_unique<lsqlist>(40, 100, 944, 580));
+    struct lsqthumbnail : public widget
+    {
+        const std::unique_ptr<texture>& tex;
+        void draw() const override
+        {
+            widget::draw();
+            if (tex)
+            {
+                const int fw = globaltheme->frame_size();
+                tex->draw(
+                    pos.x + fw, pos.y + fw, size.x - 2 * fw, size.y - 2 * fw);
+            }
+        }
+        lsqthumbnail(int x, int y, const std::unique_ptr<texture>& t) :
+            widget(x, y, 144, 144, ""), tex(t)
+        {
+        }
+    };
+
+    gamelist = &add_child(std::make_unique<lsqlist>(40, 100, 780, 580));
+    gamethumbnail =
+        &add_child(std::make_unique<lsqthumbnail>(840, 100, thumbnail));
+    gameinfo =
+        &add_child(std::make_unique<widget_text>(840, 260, 144, 80, ""));
 
+    // headers are read in background, list is filled when ready
+    btnload->disable();
+    btndel->disable();
     update_list();
+}
 
-    gamename->set_text(gamelist->get_selected_entry());
+void loadsavequit_dialogue::on_idle()
+{
+    if (list_pending && index.is_ready())
+    {
+        fill_list();
+    }
+}
+
+void loadsavequit_dialogue::show_header()
+{
+    thumbnail.reset();
+    gameinfo->set_text("");
+    const string fn = get_savegame_name_for(gamename->get_text(), savegames);
+    if (!is_file(fn))
+    {
+        return;
+    }
+    try
+    {
+        // only the start of the file is read, so this is fast
+        savegame_header header(fn);
+        gameinfo->set_text(header.date + "\n" + header.player);
+        if (!header.thumbnail.empty())
+        {
+            const unsigned t = savegame_header::thumbnail_size;
+            thumbnail        = std::make_unique<texture>(
+                header.thumbnail,
+                t,
+                t,
+                GL_RGB,
+                texture::LINEAR,
+                texture::CLAMP);
+        }
+    }
+    catch (std::exception& e)
+    {
+        log_warning("Can't read savegame header: " << e.what());
+    }
+    gamethumbnail->redraw();
 }
 
 void loadsavequit_dialogue::load()
@@ -306,7 +405,7 @@ void loadsavequit_dialogue::save()
     }
 
     gamesaved = true;
-    mygame->save(fn, gamename->get_text());
+    mygame->save(fn, gamename->get_text(), last_frame_thumbnail);
 
     unique_ptr<widget> w(create_dialogue_ok(
         texts::get(186),
@@ -331,6 +430,7 @@ void loadsavequit_dialogue::erase()
         remove(fn.c_str());
         int s = gamelist->get_selected() - 1;
         update_list();
+        fill_list();
         if (s < 0)
         {
             s = 0;
@@ -360,25 +460,17 @@ void loadsavequit_dialogue::quit()
 
 void loadsavequit_dialogue::update_list()
 {
-    savegames.clear();
+    index.update();
+    list_pending = true;
+}
 
-    // read save games in directory
+void loadsavequit_dialogue::fill_list()
+{
+    list_pending = false;
+    savegames.clear();
+    for (const auto& e : index.get_entries())
     {
-        directory savegamedir(savegamedirectory);
-        while (true)
-        {
-            string e = savegamedir.read();
-            if (e.empty())
-            {
-                break;
-            }
-            if (is_savegame_name(e))
-            {
-                string descr =
-                    mygame->read_description_of_savegame(savegamedirectory + e);
-                savegames[e] = descr;
-            }
-        }
+        savegames[e.filename] = game::describe_savegame(e.header);
     }
 
     gamelist->clear();
@@ -395,6 +487,12 @@ void loadsavequit_dialogue::update_list()
         ++sel;
     }
 
+    if (gamename->get_text().empty())
+    {
+        gamename->set_text(gamelist->get_selected_entry());
+    }
+    show_header();
+
     if (savegames.size() == 0)
     {
         btnload->disable();
@@ -405,6 +503,7 @@ void loadsavequit_dialogue::update_list()
         btnload->enable();
         btndel->enable();
     }
+    redraw();
 }
 
 //
@@ -584,17 +683,17 @@ auto game__exec(game& gm, const std::shared_ptr<user_interface>& ui)
         // next simulation step
         if (!ui->paused())
         {
-            for (unsigned j = 0; j < time_scale; ++j)
+            PROFILE_ZONE("simulation");
+            // with time compression the game chooses the length of the
+            // steps in between, so it can use fewer, longer steps.
+            gm.simulate(time_scale == 1 ? delta_time : time_scale / 30.0);
+            // evaluate events of game, because they are cleared
+            // by next call of game::simulate and new ones are
+            // generated
+            const auto& events = gm.get_events();
+            for (auto& it : events)
             {
-                gm.simulate(time_scale == 1 ? delta_time : (1.0 / 30.0));
-                // evaluate events of game, because they are cleared
-                // by next call of game::simulate and new ones are
-                // generated
-                const auto& events = gm.get_events();
-                for (auto& it : events)
-                {
-                    it->evaluate(*ui);
-                }
+                it->evaluate(*ui);
             }
         }
 
@@ -610,14 +709,30 @@ auto game__exec(game& gm, const std::shared_ptr<user_interface>& ui)
             fpstime = totaltime;
             log_info("fps " << (frames - lastframes) / measuretime);
             lastframes = frames;
+            if (user_interface::show_memory_usage)
+            {
+                memory_usage::log_report();
+            }
         }
 
         // this also fetches input events to the handlers
-        SYS().finish_frame();
+        {
+            PROFILE_ZONE("finish_frame");
+            SYS().finish_frame();
+        }
+        if (profiler::is_enabled())
+        {
+            profiler::instance().end_frame();
+        }
     }
     SYS().remove_input_event_handler(ui);
 
+    // draw last frame again to keep a thumbnail of it for savegames
+    ui->display();
+    capture_thumbnail();
+
     ui->pause_all_sound();
+    memory_usage::log_report();
 
     return gm.get_run_state(); // if player is killed, end game (1), else show
                                // menu (0)
@@ -2351,6 +2466,7 @@ auto mymain(std::vector<string>& args) -> int
     bool runeditor     = false;
     bool override_lang = false;
     bool use_sound     = true;
+    string profile_trace_filename;
 
     date editor_start_date(1939, 9, 1);
 
@@ -2386,7 +2502,16 @@ auto mymain(std::vector<string>& args) -> int
                 << "--vsync\tsync to vertical retrace signal (for nvidia "
                    "cards)\n"
 #endif
-                << "--consolelog\tcopy log output to current console\n";
+                << "--consolelog\tcopy log output to current console\n"
+                << "--binarylog fn\twrite log to binary file fn, print it "
+                   "with logdump\n"
+                << "--memreport\tshow memory used by subsystems and log it "
+                   "regularly\n"
+                << "--fastxml\tload data files with the read-only in situ "
+                   "XML parser\n"
+                << "--profile\tshow time spent in parts of each frame\n"
+                << "--profiletrace fn\tlike --profile and write all frames "
+                   "to fn in Chrome tracing format\n";
             return 0;
         }
         else if (*it == "--nofullscreen")
@@ -2427,6 +2552,42 @@ auto mymain(std::vector<string>& args) -> int
         {
             log::copy_output_to_console = true;
         }
+        else if (*it == "--binarylog")
+        {
+            auto it2 = it;
+            ++it2;
+            if (it2 != args.end())
+            {
+                log::instance().open_binary_file(*it2);
+                ++it;
+            }
+        }
+        else if (*it == "--memreport")
+        {
+            user_interface::show_memory_usage = true;
+        }
+        else if (*it == "--fastxml")
+        {
+            xml_doc::set_default_backend(xml_doc::backend::in_situ);
+        }
+        else if (*it == "--profile")
+        {
+            profiler::enable(true);
+            profiler::set_thread_name("main");
+        }
+        else if (*it == "--profiletrace")
+        {
+            auto it2 = it;
+            ++it2;
+            if (it2 != args.end())
+            {
+                profiler::enable(true);
+                profiler::set_thread_name("main");
+                profiler::instance().record(true);
+                profile_trace_filename = *it2;
+                ++it;
+            }
+        }
         else if (*it == "--nosound")
         {
             use_sound = false;
@@ -2611,11 +2772,21 @@ auto mymain(std::vector<string>& args) -> int
     mycfg.register_option("wave_phases", 256);
     mycfg.register_option("wavetile_length", 256.0f);
     mycfg.register_option("wave_tidecycle_time", 10.24f);
+    mycfg.register_option("wave_runtime_synthesis", false);
     mycfg.register_option("usex86sse", true);
     mycfg.register_option("language", 0);
     mycfg.register_option("cpucores", 1);
     mycfg.register_option("terrain_texture_resolution", 0.1f);
     mycfg.register_option("terrain_detail", 1);
+    mycfg.register_option("model_lod_levels", 3);
+    mycfg.register_option("display_cache_mb", 192);
+    mycfg.register_option("model_cache_mb", 64);
+    mycfg.register_option("image_cache_mb", 32);
+    mycfg.register_option("terrain_cache_mb", 128);
+    mycfg.register_option("kinematic_range", 30000.0f);
+    mycfg.register_option("physics_integrator", std::string("auto"));
+    mycfg.register_option("torpedo_dynamics", std::string("physics"));
+    mycfg.register_option("torpedo_homing_sensors", false);
 
     mycfg.register_key(
         key_names[unsigned(key_command::ZOOM_MAP)].name,
@@ -2996,6 +3167,23 @@ auto mymain(std::vector<string>& args) -> int
     texture::use_compressed_textures   = mycfg.getb("use_compressed_textures");
     texture::use_anisotropic_filtering = mycfg.getb("use_ani_filtering");
     texture::anisotropic_level         = mycfg.getf("anisotropic_level");
+    texture::record_load_times         = true;
+    model::nr_of_lod_levels            = mycfg.geti("model_lod_levels");
+    display_asset_cache::budget_mb     = mycfg.geti("display_cache_mb");
+    game::kinematic_range              = mycfg.getf("kinematic_range");
+    water::use_runtime_synthesis       = mycfg.getb("wave_runtime_synthesis");
+    fft_plan_cache::set_nr_of_threads(mycfg.geti("cpucores"));
+    fft_plan_cache::use_wisdom_file(configdirectory + "fftw_wisdom");
+    game::auto_integration = mycfg.gets("physics_integrator") == "auto";
+    if (!game::auto_integration)
+    {
+        game::integration = body_integrator::method_from_name(
+            mycfg.gets("physics_integrator"));
+    }
+    torpedo::default_dynamics = (mycfg.gets("torpedo_dynamics") == "analytic")
+                                    ? torpedo::ANALYTIC
+                                    : torpedo::PHYSICS;
+    torpedo::use_homing_sensors = mycfg.getb("torpedo_homing_sensors");
 
     system_interface::create_instance(new class system_interface(params));
     SYS().set_screenshot_directory(savegamedirectory);
@@ -3003,6 +3191,10 @@ auto mymain(std::vector<string>& args) -> int
     global_data::instance(); // create fonts
     reset_loading_screen();
 
+    // keep unused models and images up to budget, so they are not reloaded
+    modelcache().set_budget(size_t(mycfg.geti("model_cache_mb")) << 20);
+    imagecache().set_budget(size_t(mycfg.geti("image_cache_mb")) << 20);
+
     widget::set_image_cache(&(imagecache()));
 
     // --------------------------------------------------------------------------------
@@ -3180,6 +3372,10 @@ auto mymain(std::vector<string>& args) -> int
     hsl_mission = highscorelist(highscoredirectory + HSL_MISSION_NAME);
     hsl_career  = highscorelist(highscoredirectory + HSL_CAREER_NAME);
 
+    // startup is done, report where texture creation spent its time
+    texture::log_load_times();
+    texture::record_load_times = false;
+
     // check if there was a mission given at the command line, or editor more
     // etc.
     if (runeditor)
@@ -3291,6 +3487,12 @@ auto mymain(std::vector<string>& args) -> int
     hsl_career.save(highscoredirectory + HSL_CAREER_NAME);
     mycfg.save(configdirectory + "config");
 
+    if (!profile_trace_filename.empty())
+    {
+        std::ofstream trace(profile_trace_filename.c_str());
+        profiler::instance().write_trace(trace);
+    }
+
     data_file_handler::destroy_instance();
     cfg::destroy_instance();
     widget::set_theme(unique_ptr<widget::theme>()); // clear allocated theme
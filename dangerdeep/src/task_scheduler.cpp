@@ -0,0 +1,272 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// multithreading primitives: task scheduler
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "task_scheduler.h"
+
+#include "log.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+/// scheduler and queue index of a worker thread
+thread_local const task_scheduler* current_scheduler = nullptr;
+thread_local int current_queue                        = -1;
+} // namespace
+
+task_scheduler::task_scheduler(unsigned nr_of_threads)
+{
+    if (nr_of_threads == 0)
+    {
+        nr_of_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < nr_of_threads; ++i)
+    {
+        queues.push_back(std::make_unique<task_queue>());
+    }
+    // workers register at the log, create it before they run
+    log::instance();
+    for (unsigned i = 0; i < nr_of_threads; ++i)
+    {
+        workers.emplace_back(&task_scheduler::work, this, i);
+    }
+}
+
+task_scheduler::~task_scheduler()
+{
+    {
+        std::unique_lock<std::mutex> ml(sleep_mutex);
+        stop = true;
+    }
+    sleep_cond.notify_all();
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+auto task_scheduler::instance() -> task_scheduler&
+{
+    static task_scheduler ts;
+    return ts;
+}
+
+void task_scheduler::submit(task t)
+{
+    int q = get_own_queue();
+    if (q < 0)
+    {
+        q = int(next_queue++ % queues.size());
+    }
+    {
+        std::unique_lock<std::mutex> ml(queues[q]->mtx);
+        queues[q]->tasks.push_back(std::move(t));
+    }
+    {
+        // count under the lock, so no worker misses the wakeup
+        std::unique_lock<std::mutex> ml(sleep_mutex);
+        ++nr_of_pending;
+    }
+    sleep_cond.notify_one();
+}
+
+auto task_scheduler::run_one() -> bool
+{
+    const int q = get_own_queue();
+    task t;
+    if (!take_task(q < 0 ? 0 : unsigned(q), t))
+    {
+        return false;
+    }
+    t();
+    return true;
+}
+
+auto task_scheduler::get_own_queue() const -> int
+{
+    return (current_scheduler == this) ? current_queue : -1;
+}
+
+auto task_scheduler::take_task(unsigned index, task& t) -> bool
+{
+    if (nr_of_pending <= 0)
+    {
+        return false;
+    }
+    // newest task of own queue first, then steal oldest task of others
+    for (unsigned i = 0; i < queues.size(); ++i)
+    {
+        auto& q = *queues[(index + i) % queues.size()];
+        std::unique_lock<std::mutex> ml(q.mtx);
+        if (q.tasks.empty())
+        {
+            continue;
+        }
+        if (i == 0)
+        {
+            t = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        else
+        {
+            t = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        --nr_of_pending;
+        return true;
+    }
+    return false;
+}
+
+void task_scheduler::work(unsigned index)
+{
+    log::instance().new_thread("tasks");
+    profiler::set_thread_name("tasks");
+    current_scheduler = this;
+    current_queue     = int(index);
+    while (true)
+    {
+        task t;
+        if (take_task(index, t))
+        {
+            PROFILE_ZONE("task");
+            t();
+            continue;
+        }
+        std::unique_lock<std::mutex> ml(sleep_mutex);
+        sleep_cond.wait(ml, [this]() { return stop || nr_of_pending > 0; });
+        if (stop && nr_of_pending <= 0)
+        {
+            return;
+        }
+    }
+}
+
+task_group::~task_group()
+{
+    try
+    {
+        wait();
+    }
+    catch (std::exception& e)
+    {
+        log_warning("task error was not handled: " << e.what());
+    }
+    catch (...)
+    {
+        log_warning("task error was not handled");
+    }
+}
+
+void task_group::run(std::function<void()> func)
+{
+    ++nr_of_tasks;
+    scheduler.submit([this, func = std::move(func)]() {
+        if (!canceled)
+        {
+            try
+            {
+                func();
+            }
+            catch (...)
+            {
+                // pass the error to the waiting thread
+                std::unique_lock<std::mutex> ml(mtx);
+                if (!first_error)
+                {
+                    first_error = std::current_exception();
+                }
+                canceled = true;
+            }
+        }
+        // the waiting thread can destroy the group when it gets the lock
+        std::unique_lock<std::mutex> ml(mtx);
+        if (--nr_of_tasks == 0)
+        {
+            done.notify_all();
+        }
+    });
+}
+
+void task_group::wait()
+{
+    while (nr_of_tasks > 0)
+    {
+        // help with the work instead of blocking a thread
+        if (scheduler.run_one())
+        {
+            continue;
+        }
+        // tasks of the group run in other threads, but they may create
+        // new tasks, so look again after a while
+        std::unique_lock<std::mutex> ml(mtx);
+        done.wait_for(ml, std::chrono::milliseconds(1), [this]() {
+            return nr_of_tasks == 0;
+        });
+    }
+    std::exception_ptr e;
+    {
+        std::unique_lock<std::mutex> ml(mtx);
+        std::swap(e, first_error);
+        canceled = false;
+    }
+    if (e)
+    {
+        std::rethrow_exception(e);
+    }
+}
+
+void parallel_for(
+    unsigned begin,
+    unsigned end,
+    const std::function<void(unsigned, unsigned)>& func,
+    unsigned max_parts,
+    task_scheduler& sched)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    const unsigned n = end - begin;
+    if (max_parts == 0)
+    {
+        max_parts = sched.get_nr_of_threads() * 4;
+    }
+    const unsigned parts = std::min(n, max_parts);
+    if (parts <= 1)
+    {
+        func(begin, end);
+        return;
+    }
+    task_group tg(sched);
+    for (unsigned i = 0; i < parts; ++i)
+    {
+        const unsigned first = begin + unsigned(uint64_t(n) * i / parts);
+        const unsigned last  = begin + unsigned(uint64_t(n) * (i + 1) / parts);
+        tg.run([&func, first, last]() { func(first, last); });
+    }
+    tg.wait();
+}
@@ -0,0 +1,150 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// multithreading primitives: task scheduler
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///\brief Runs tasks on a fixed pool of worker threads.
+/** Every worker has its own queue of tasks. Tasks created by a worker are
+    put to its own queue and the worker takes the newest task first, so
+    nested work stays local. Workers without work steal the oldest task of
+    other queues. Tasks created by other threads are distributed over the
+    queues. Threads waiting for tasks (see task_group::wait) run tasks
+    meanwhile, so waiting inside a task does not block a worker.
+    Use task_group or parallel_for instead of submitting tasks directly.
+*/
+class task_scheduler
+{
+  public:
+    using task = std::function<void()>;
+
+    /// create scheduler
+    ///@param nr_of_threads - number of workers, 0 for one per cpu core
+    task_scheduler(unsigned nr_of_threads = 0);
+
+    /// finishes all pending tasks and stops the workers
+    ~task_scheduler();
+
+    task_scheduler(const task_scheduler&) = delete;
+    task_scheduler& operator=(const task_scheduler&) = delete;
+
+    /// the scheduler used by the game, sized to the number of cpu cores
+    static task_scheduler& instance();
+
+    /// get number of worker threads
+    [[nodiscard]] unsigned get_nr_of_threads() const
+    {
+        return unsigned(workers.size());
+    }
+
+    /// add task to be run by some thread
+    void submit(task t);
+
+    /// run one pending task in the calling thread
+    ///@returns false if there was no task to run
+    bool run_one();
+
+  protected:
+    /// queue of one worker, the owner uses the back, thieves the front
+    struct task_queue
+    {
+        std::mutex mtx;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<task_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> nr_of_pending{0};       ///< tasks in all queues
+    std::atomic<unsigned> next_queue{0};     ///< for tasks of other threads
+    std::mutex sleep_mutex;                  ///< for sleeping workers
+    std::condition_variable sleep_cond;      ///< signals new tasks
+    bool stop{false};                        ///< workers should exit
+
+    void work(unsigned index);
+    bool take_task(unsigned index, task& t);
+    /// index of queue of calling thread if it is a worker, else -1
+    [[nodiscard]] int get_own_queue() const;
+};
+
+///\brief A set of tasks that can be waited for together.
+/** If a task throws an exception, the remaining tasks that have not started
+    yet are skipped and wait() rethrows the exception in the waiting thread.
+    The destructor waits for the tasks, but can't report errors, so call
+    wait() before.
+*/
+class task_group
+{
+  public:
+    task_group(task_scheduler& ts = task_scheduler::instance()) :
+        scheduler(ts)
+    {
+    }
+    ~task_group();
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    /// run function as task of this group
+    void run(std::function<void()> func);
+
+    /// wait until all tasks are done, the caller runs tasks meanwhile.
+    /// Throws the first exception thrown by a task.
+    void wait();
+
+    /// tasks of the group that did not start yet are skipped
+    void cancel() { canceled = true; }
+
+    /// request if group was canceled, long running tasks can check this
+    [[nodiscard]] bool is_canceled() const { return canceled; }
+
+    /// request if all tasks are done, wait() would not block
+    [[nodiscard]] bool is_done() const { return nr_of_tasks == 0; }
+
+  protected:
+    task_scheduler& scheduler;
+    std::atomic<unsigned> nr_of_tasks{0}; ///< tasks not yet finished
+    std::atomic<bool> canceled{false};
+    std::exception_ptr first_error;
+    std::mutex mtx;               ///< for first_error and done
+    std::condition_variable done; ///< signals that all tasks are done
+};
+
+/// call func(first, last) for parts of the range [begin, end) in parallel and
+/// wait for them. The range is split in more parts than there are threads,
+/// so work is balanced by stealing.
+///@param max_parts - maximum number of parts, 0 for automatic. With one part
+///                   func is called directly.
+void parallel_for(
+    unsigned begin,
+    unsigned end,
+    const std::function<void(unsigned, unsigned)>& func,
+    unsigned max_parts    = 0,
+    task_scheduler& sched = task_scheduler::instance());
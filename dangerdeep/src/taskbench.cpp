@@ -0,0 +1,206 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// task scheduler overhead and scaling
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "mymain.cpp"
+#include "task_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/// some work per element that can't be optimized away
+double kernel(unsigned i)
+{
+    double sum = 0.0;
+    for (unsigned j = 0; j < 200; ++j)
+    {
+        sum += std::sin(i * 0.001 + j * 0.01);
+    }
+    return sum;
+}
+
+/// time per task for empty tasks, compared to a thread per task
+bool test_overhead(task_scheduler& ts)
+{
+    const unsigned nr_of_tasks = 100000, nr_of_spawns = 1000;
+    std::atomic<unsigned> counter{0};
+    auto start = clock_type::now();
+    task_group tg(ts);
+    for (unsigned i = 0; i < nr_of_tasks; ++i)
+    {
+        tg.run([&counter]() { ++counter; });
+    }
+    tg.wait();
+    const double task_time = seconds_since(start) / nr_of_tasks;
+    start                  = clock_type::now();
+    for (unsigned i = 0; i < nr_of_spawns; ++i)
+    {
+        std::thread t([&counter]() { ++counter; });
+        t.join();
+    }
+    const double spawn_time = seconds_since(start) / nr_of_spawns;
+    std::cout << "Empty task: " << task_time * 1e9 << "ns, thread spawn: "
+              << spawn_time * 1e9 << "ns, ratio " << spawn_time / task_time
+              << "\n";
+    return counter == nr_of_tasks + nr_of_spawns;
+}
+
+/// parallel_for with different numbers of threads, results must match
+bool test_scaling()
+{
+    const unsigned n = 200000;
+    std::vector<double> expected(n);
+    auto start = clock_type::now();
+    for (unsigned i = 0; i < n; ++i)
+    {
+        expected[i] = kernel(i);
+    }
+    const double serial_time = seconds_since(start);
+    std::cout << "Serial: " << serial_time * 1000 << "ms\n";
+    const unsigned max_threads =
+        std::max(1U, std::thread::hardware_concurrency());
+    bool ok = true;
+    for (unsigned t = 1; t <= max_threads; t *= 2)
+    {
+        task_scheduler ts(t);
+        std::vector<double> result(n);
+        start = clock_type::now();
+        parallel_for(
+            0,
+            n,
+            [&result](unsigned first, unsigned last) {
+                for (unsigned i = first; i < last; ++i)
+                {
+                    result[i] = kernel(i);
+                }
+            },
+            0,
+            ts);
+        const double time = seconds_since(start);
+        const bool same   = (result == expected);
+        std::cout << t << " threads: " << time * 1000 << "ms, speedup "
+                  << serial_time / time << (same ? "" : ", WRONG RESULT!")
+                  << "\n";
+        ok = ok && same;
+    }
+    return ok;
+}
+
+/// nested groups in tasks must not dead lock, even with one worker
+bool test_nesting()
+{
+    task_scheduler ts(1);
+    std::atomic<unsigned> counter{0};
+    task_group outer(ts);
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        outer.run([&ts, &counter]() {
+            parallel_for(
+                0,
+                64,
+                [&counter](unsigned first, unsigned last) {
+                    counter += last - first;
+                },
+                8,
+                ts);
+        });
+    }
+    outer.wait();
+    std::cout << "Nested tasks: " << counter << " of " << 16 * 64 << "\n";
+    return counter == 16 * 64;
+}
+
+/// an exception of a task must reach the waiting thread
+bool test_exception(task_scheduler& ts)
+{
+    task_group tg(ts);
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        tg.run([i]() {
+            if (i == 50)
+            {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+    try
+    {
+        tg.wait();
+    }
+    catch (std::exception& e)
+    {
+        std::cout << "Exception passed: " << e.what() << "\n";
+        // the group can be used again
+        std::atomic<unsigned> counter{0};
+        tg.run([&counter]() { ++counter; });
+        tg.wait();
+        return counter == 1;
+    }
+    std::cout << "Exception was not passed!\n";
+    return false;
+}
+
+/// canceled groups skip tasks that did not start
+bool test_cancel()
+{
+    task_scheduler ts(1);
+    std::atomic<unsigned> counter{0};
+    task_group tg(ts);
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        tg.run([&tg, &counter]() {
+            if (++counter == 10)
+            {
+                tg.cancel();
+            }
+        });
+    }
+    tg.wait();
+    std::cout << "Canceled after " << counter << " of 1000 tasks\n";
+    return counter < 1000 && !tg.is_canceled();
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    task_scheduler ts;
+    std::cout << "Scheduler with " << ts.get_nr_of_threads() << " threads\n";
+    bool ok = test_overhead(ts);
+    ok      = test_scaling() && ok;
+    ok      = test_nesting() && ok;
+    ok      = test_exception(ts) && ok;
+    ok      = test_cancel() && ok;
+    return ok ? 0 : -1;
+}
@@ -31,7 +31,6 @@ class tdc
   private:
     tdc& operator=(const tdc& other) = delete;
     tdc(const tdc& other)            = delete;
-    tdc& operator=(tdc&&) = delete;
 
   protected:
     // tracker switches
@@ -76,6 +75,7 @@ class tdc
   public:
     tdc();
     tdc(tdc&&) = default;
+    tdc& operator=(tdc&&) = default;
     void load(const xml_elem& parent);
     void save(xml_elem& parent) const;
 
@@ -32,6 +32,7 @@
 #include "vector3.h"
 #include "xml.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -185,8 +186,14 @@ terrain<T>::terrain(
     tex_stretch_factor =
         cfg::instance().getf("terrain_texture_resolution") / 100.0;
 
+    // number of cached tiles is limited by memory budget
+    const size_t tile_bytes = size_t(tile_size) * tile_size * sizeof(T);
+    const auto slots        = unsigned(std::max(
+        size_t(1),
+        (size_t(cfg::instance().geti("terrain_cache_mb")) << 20)
+            / tile_bytes));
     m_tile_cache =
-        tile_cache<T>(data_dir, bounds.y, bounds.x, tile_size, 0, 300000);
+        tile_cache<T>(data_dir, bounds.y, bounds.x, tile_size, slots, 300000);
 
     noise_map.resize(vector2i(256, 256));
 
@@ -1,62 +1,151 @@
-/* compile:
-g++ -Wall test4.cpp error.cpp thread.cpp mutex.cpp condvar.cpp message_queue.cpp
--I/usr/include/SDL -lSDL
+/* message queue throughput and latency benchmark
+compile:
+g++ -std=c++17 -O2 -Wall -I.. msgqueuetest.cpp ../message_queue.cpp -lpthread
 */
 
-#include "condvar.h"
-#include "error.h"
 #include "message_queue.h"
-#include "mutex.h"
-#include "thread.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 using namespace std;
 
-struct msg_A : public message
+using clock_type = chrono::steady_clock;
+
+struct msg_count : public message
+{
+    atomic<unsigned>& counter;
+    msg_count(atomic<unsigned>& c) : counter(c) { }
+    void eval() const override { counter.fetch_add(1, memory_order_relaxed); }
+};
+
+struct msg_fail : public message
 {
-    void eval() const { cout << "msg A eval\n"; }
+    void eval() const override { throw runtime_error("no way!"); }
 };
 
-struct msg_B : public message
+/// like music's sound effect command, with a string and some positions
+struct msg_sfx : public message
 {
-    void eval() const
+    atomic<unsigned>& counter;
+    string category;
+    double pos[6];
+    msg_sfx(atomic<unsigned>& c, string cat) : counter(c), category(move(cat))
+    {
+    }
+    void eval() const override
     {
-        cout << "msg B eval\n";
-        throw error("no way!");
+        counter.fetch_add(unsigned(category.size()), memory_order_relaxed);
     }
 };
 
-struct msg_C : public message
+/// receiver thread, processes until stopped
+struct receiver
 {
-    void eval() const { cout << "msg C eval\n"; }
+    message_queue& mq;
+    atomic<bool> stop{false};
+    thread t;
+    receiver(message_queue& q) : mq(q), t([this]() {
+        while (!stop)
+        {
+            mq.process_messages();
+        }
+    })
+    {
+    }
+    ~receiver()
+    {
+        stop = true;
+        mq.wakeup_receiver();
+        t.join();
+    }
 };
 
-class A : public thread
+/// fire and forget messages from several senders
+bool test_throughput(unsigned nr_of_senders)
 {
-  public:
+    const unsigned per_sender = 1000000;
+    message_queue mq(1024);
+    atomic<unsigned> counter{0};
+    atomic<unsigned> nr_full{0};
+    const auto start = clock_type::now();
+    {
+        receiver r(mq);
+        vector<thread> senders;
+        for (unsigned s = 0; s < nr_of_senders; ++s)
+        {
+            senders.emplace_back([&]() {
+                for (unsigned i = 0; i < per_sender; ++i)
+                {
+                    while (!mq.post<msg_count>(counter))
+                    {
+                        ++nr_full;
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : senders)
+        {
+            t.join();
+        }
+        // a synchronous message is answered after all earlier messages
+        mq.send<msg_count>(counter);
+    }
+    const double secs =
+        chrono::duration<double>(clock_type::now() - start).count();
+    const unsigned total = nr_of_senders * per_sender + 1;
+    cout << nr_of_senders << " senders: " << total / secs / 1e6
+         << " M messages/s, queue was full " << nr_full << " times\n";
+    return counter == total;
+}
+
+/// round trip time of synchronous messages
+bool test_latency()
+{
+    const unsigned nr_of_requests = 20000;
     message_queue mq;
-    A() { cout << "A: c'tor " << this << "\n"; }
-    ~A() { cout << "A: D'tor " << this << "\n"; }
-    void loop()
+    atomic<unsigned> counter{0};
+    receiver r(mq);
+    vector<double> times;
+    for (unsigned i = 0; i < nr_of_requests; ++i)
     {
-        cout << "A: waiting for messages\n";
-        mq.process_messages();
+        const auto start = clock_type::now();
+        mq.send<msg_sfx>(counter, "shell-splash");
+        times.push_back(
+            chrono::duration<double>(clock_type::now() - start).count());
     }
-};
+    sort(times.begin(), times.end());
+    cout << "Round trip: median " << times[times.size() / 2] * 1e6
+         << "us, 99% " << times[times.size() * 99 / 100] * 1e6 << "us, max "
+         << times.back() * 1e6 << "us\n";
+    return counter == nr_of_requests * 12;
+}
+
+/// failed evaluation is answered with false
+bool test_failure()
+{
+    message_queue mq;
+    receiver r(mq);
+    auto answer = mq.request<msg_fail>();
+    const bool failed = !answer.get();
+    cout << "Failing message answered " << (failed ? "false" : "TRUE!") << "\n";
+    return failed;
+}
 
 int main(int, char**)
 {
-    cout << "Here we go.\n";
-    A* a = new A();
-    a->start();
-    thread::sleep(2000);
-    cout << "send msg_A = " << a->mq.send(message::ptr(new msg_A())) << "\n";
-    cout << "send msg_B = " << a->mq.send(message::ptr(new msg_B())) << "\n";
-    cout << "send msg_C = " << a->mq.send(message::ptr(new msg_C()), false)
-         << "\n";
-    thread::sleep(2000);
-    a->request_abort();
-    a->mq.wakeup_receiver();
-    a->join();
-    cout << "cleaned up!\n";
+    bool ok = true;
+    for (unsigned s = 1; s <= 4; s *= 2)
+    {
+        ok = test_throughput(s) && ok;
+    }
+    ok = test_latency() && ok;
+    ok = test_failure() && ok;
+    cout << (ok ? "ok" : "FAILED") << "\n";
+    return ok ? 0 : 1;
 }
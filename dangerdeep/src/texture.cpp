@@ -29,30 +29,242 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "oglext/OglExt.h"
 #include "primitives.h"
 #include "system_interface.h"
+#include "task_scheduler.h"
 #include "texture.h"
 #include "vector3.h"
 
 #include <SDL.h>
 #include <SDL_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <glu.h>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <vector>
-using namespace std;
-
-#undef MEMMEASURE
-
-#ifdef MEMMEASURE
-unsigned texture::mem_used    = 0;
-unsigned texture::mem_alloced = 0;
-unsigned texture::mem_freed   = 0;
+#ifdef __SSE2__
+#include <emmintrin.h>
 #endif
+using namespace std;
 
 int texture::size_non_power_2           = -1;
 bool texture::use_compressed_textures   = false;
 bool texture::use_anisotropic_filtering = false;
 float texture::anisotropic_level        = 0.0f;
+unsigned texture::nr_of_threads         = 0;
+bool texture::record_load_times         = false;
+
+namespace
+{
+/// time spent for creation of one texture
+struct texture_load_time
+{
+    std::string name;
+    unsigned width, height;
+    double preprocess_ms; ///< normal map and mipmap generation
+    double total_ms;      ///< including upload
+};
+std::vector<texture_load_time> texture_load_times;
+std::mutex texture_load_times_mutex;
+
+/// images smaller than that are not worth to be split over threads
+const unsigned PARALLEL_MIN_PIXELS = 128 * 128;
+
+/// call func(y_begin, y_end) for bands of rows, in parallel for large images.
+/// Each row is written by exactly one thread, so results do not depend on
+/// the number of threads.
+void for_each_row_band(
+    unsigned w,
+    unsigned h,
+    const std::function<void(unsigned, unsigned)>& func)
+{
+    if (texture::nr_of_threads == 1 || w * h < PARALLEL_MIN_PIXELS)
+    {
+        func(0, h);
+        return;
+    }
+    parallel_for(0, h, func, texture::nr_of_threads);
+}
+
+/// box filter one row of destination pixels, B bytes per pixel
+template<unsigned B>
+void scale_half_row(
+    const uint8_t* row0,
+    const uint8_t* row1,
+    uint8_t* dst,
+    unsigned dst_w,
+    unsigned src_xadd)
+{
+    for (unsigned x = 0; x < dst_w; ++x)
+    {
+        const uint8_t* a = row0 + 2 * x * B;
+        const uint8_t* b = row1 + 2 * x * B;
+        for (unsigned k = 0; k < B; ++k)
+        {
+            dst[x * B + k] = uint8_t(
+                (unsigned(a[k]) + unsigned(a[k + src_xadd]) + unsigned(b[k])
+                 + unsigned(b[k + src_xadd]) + 2)
+                / 4);
+        }
+    }
+}
+
+/// average of two pixels for images with one dimension of size 1
+template<unsigned B>
+void scale_half_line(
+    const uint8_t* src,
+    uint8_t* dst,
+    unsigned dst_n,
+    unsigned src_step)
+{
+    for (unsigned x = 0; x < dst_n; ++x)
+    {
+        const uint8_t* a = src + 2 * x * src_step;
+        for (unsigned k = 0; k < B; ++k)
+        {
+            dst[x * B + k] =
+                uint8_t((unsigned(a[k]) + unsigned(a[k + src_step])) / 2);
+        }
+    }
+}
+
+template<unsigned B>
+void scale_half_generic(
+    const std::vector<uint8_t>& src,
+    std::vector<uint8_t>& dst,
+    unsigned w,
+    unsigned h)
+{
+    const unsigned nw = std::max(1U, w / 2), nh = std::max(1U, h / 2);
+    if (w == 1 || h == 1)
+    {
+        scale_half_line<B>(&src[0], &dst[0], nw * nh, B);
+        return;
+    }
+    for_each_row_band(nw, nh, [&](unsigned y0, unsigned y1) {
+        for (unsigned y = y0; y < y1; ++y)
+        {
+            const uint8_t* row0 = &src[2 * y * w * B];
+            scale_half_row<B>(row0, row0 + w * B, &dst[y * nw * B], nw, B);
+        }
+    });
+}
+
+/// compute normals of one row of a height map, heights are every S bytes.
+/// Writes B bytes per pixel, if B is 4, the alpha value is copied from the
+/// byte after the height.
+template<unsigned S, unsigned B>
+void make_normals_row(
+    const uint8_t* rowc,
+    const uint8_t* rowu,
+    const uint8_t* rowd,
+    uint8_t* dst,
+    unsigned w,
+    float zh)
+{
+    // Same float operations as vector3f::normal() so the result is exactly
+    // the same, but written as flat loop the compiler can vectorize. The
+    // values are in [1...255] so the conversion via int is the same, too.
+    auto normal = [=](unsigned xx, unsigned x1, unsigned x2) {
+        const float nx  = float(rowc[S * x1]) - float(rowc[S * x2]);
+        const float ny  = float(rowd[S * xx]) - float(rowu[S * xx]);
+        const float len = 1.0f / float(std::sqrt(nx * nx + ny * ny + zh * zh));
+        uint8_t* d      = dst + B * xx;
+        d[0]            = uint8_t(int((nx * len) * 127 + 128));
+        d[1]            = uint8_t(int((ny * len) * 127 + 128));
+        d[2]            = uint8_t(int((zh * len) * 127 + 128));
+        if (B == 4)
+        {
+            d[3] = rowc[S * xx + 1];
+        }
+    };
+    // border texels wrap around, inner texels need no masking
+    normal(0, w - 1, 1 & (w - 1));
+    unsigned xx = 1;
+#ifdef __SSE2__
+    // four texels at once, sqrt/div are the expensive part and SSE gives
+    // the same IEEE results as the scalar code.
+    const __m128 zhv = _mm_set1_ps(zh), zh2 = _mm_set1_ps(zh * zh);
+    const __m128 f127 = _mm_set1_ps(127.0f), f128 = _mm_set1_ps(128.0f);
+    for (; xx + 4 < w; xx += 4)
+    {
+        alignas(16) float hl[4], hr[4], hu[4], hd[4];
+        for (unsigned k = 0; k < 4; ++k)
+        {
+            hl[k] = rowc[S * (xx + k - 1)];
+            hr[k] = rowc[S * (xx + k + 1)];
+            hu[k] = rowu[S * (xx + k)];
+            hd[k] = rowd[S * (xx + k)];
+        }
+        const __m128 nx = _mm_sub_ps(_mm_load_ps(hl), _mm_load_ps(hr));
+        const __m128 ny = _mm_sub_ps(_mm_load_ps(hd), _mm_load_ps(hu));
+        const __m128 len = _mm_div_ps(
+            _mm_set1_ps(1.0f),
+            _mm_sqrt_ps(_mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), zh2)));
+        alignas(16) int32_t c[3][4];
+        _mm_store_si128(
+            reinterpret_cast<__m128i*>(c[0]),
+            _mm_cvttps_epi32(
+                _mm_add_ps(_mm_mul_ps(_mm_mul_ps(nx, len), f127), f128)));
+        _mm_store_si128(
+            reinterpret_cast<__m128i*>(c[1]),
+            _mm_cvttps_epi32(
+                _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ny, len), f127), f128)));
+        _mm_store_si128(
+            reinterpret_cast<__m128i*>(c[2]),
+            _mm_cvttps_epi32(
+                _mm_add_ps(_mm_mul_ps(_mm_mul_ps(zhv, len), f127), f128)));
+        for (unsigned k = 0; k < 4; ++k)
+        {
+            uint8_t* d = dst + B * (xx + k);
+            d[0]       = uint8_t(c[0][k]);
+            d[1]       = uint8_t(c[1][k]);
+            d[2]       = uint8_t(c[2][k]);
+            if (B == 4)
+            {
+                d[3] = rowc[S * (xx + k) + 1];
+            }
+        }
+    }
+#endif
+    for (; xx + 1 < w; ++xx)
+    {
+        normal(xx, xx - 1, xx + 1);
+    }
+    if (w > 1)
+    {
+        normal(w - 1, w - 2, 0);
+    }
+}
+
+template<unsigned S, unsigned B>
+void make_normals_generic(
+    const std::vector<uint8_t>& src,
+    std::vector<uint8_t>& dst,
+    unsigned w,
+    unsigned h,
+    float zh)
+{
+    for_each_row_band(w, h, [&](unsigned y_begin, unsigned y_end) {
+        for (unsigned yy = y_begin; yy < y_end; ++yy)
+        {
+            unsigned y1 = (yy + h - 1) & (h - 1);
+            unsigned y2 = (yy + 1) & (h - 1);
+            make_normals_row<S, B>(
+                &src[S * yy * w],
+                &src[S * y1 * w],
+                &src[S * y2 * w],
+                &dst[B * yy * w],
+                w,
+                zh);
+        }
+    });
+}
+} // namespace
 
 auto texture::size_non_power_two() -> bool
 {
@@ -79,7 +291,8 @@ static GLuint clampmodes[texture::NR_OF_CLAMPING_MODES] = {
     GL_CLAMP_TO_EDGE};
 // --------------------------------------------------
 
-sdl_image::sdl_image(const std::string& filename) : img(nullptr)
+sdl_image::sdl_image(const std::string& filename) :
+    img(nullptr), filename(filename)
 {
     // get extension
     string::size_type st = filename.rfind('.');
@@ -204,6 +417,7 @@ sdl_image::sdl_image(const std::string& filename) : img(nullptr)
 
         img = result;
     }
+    mem.set(std::size_t(img->pitch) * img->h);
 }
 
 sdl_image::~sdl_image()
@@ -530,12 +744,21 @@ void texture::init(
             "texture values too large, not supported by card");
     }
 
+    // measure time of normal map/mipmap computation for startup profiling
+    const auto start_time = std::chrono::steady_clock::now();
+    double preprocess_ms  = 0.0;
+    auto timed            = [&preprocess_ms](const std::function<void()>& f) {
+        const auto t0 = std::chrono::steady_clock::now();
+        f();
+        preprocess_ms += std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - t0)
+                             .count();
+    };
+
     glGenTextures(1, &opengl_name);
     glBindTexture(dimension, opengl_name);
 
-#ifdef MEMMEASURE
-    unsigned add_mem_used = 0;
-#endif
+    std::size_t add_mem_used = 0;
 
     if (makenormalmap && format == GL_LUMINANCE)
     {
@@ -548,8 +771,10 @@ void texture::init(
         // give increasing levels with decreasing w/h down to 1x1
         // e.g. 64x16 -> 32x8, 16x4, 8x2, 4x1, 2x1, 1x1
         format = GL_RGB;
-        vector<uint8_t> nmpix =
-            make_normals(data, gl_width, gl_height, detailh);
+        vector<uint8_t> nmpix;
+        timed([&]() {
+            nmpix = make_normals(data, gl_width, gl_height, detailh);
+        });
         int internalformat = format;
 
         if (use_compressed_textures)
@@ -568,9 +793,7 @@ void texture::init(
             GL_UNSIGNED_BYTE,
             &nmpix[0]);
 
-#ifdef MEMMEASURE
-        add_mem_used = gl_width * gl_height * get_bpp();
-#endif
+        add_mem_used = std::size_t(gl_width) * gl_height * get_bpp();
 
         if (do_mipmapping[mapping])
         {
@@ -582,17 +805,7 @@ void texture::init(
                     "mip mapping only supported for 2D textures");
             }
 #if 1
-            // fixme: doesn't work with textures that don't have power of two
-            // size...
-            gluBuild2DMipmaps(
-                GL_TEXTURE_2D,
-                format,
-                gl_width,
-                gl_height,
-                format,
-                GL_UNSIGNED_BYTE,
-                &nmpix[0]);
-
+            timed([&]() { build_mipmaps(nmpix, format, format, 3); });
 #else
             // buggy version. gives white textures. maybe some mipmap levels
             // are missing so that gl complains by make white textures?
@@ -641,8 +854,10 @@ void texture::init(
     else if (makenormalmap && format == GL_LUMINANCE_ALPHA)
     {
         format = GL_RGBA;
-        vector<uint8_t> nmpix =
-            make_normals_with_alpha(data, gl_width, gl_height, detailh);
+        vector<uint8_t> nmpix;
+        timed([&]() {
+            nmpix = make_normals_with_alpha(data, gl_width, gl_height, detailh);
+        });
         glTexImage2D(
             GL_TEXTURE_2D,
             0,
@@ -653,21 +868,10 @@ void texture::init(
             format,
             GL_UNSIGNED_BYTE,
             &nmpix[0]);
-#ifdef MEMMEASURE
-        add_mem_used = gl_width * gl_height * get_bpp();
-#endif
+        add_mem_used = std::size_t(gl_width) * gl_height * get_bpp();
         if (do_mipmapping[mapping])
         {
-            // fixme: doesn't work with textures that don't have power of two
-            // size...
-            gluBuild2DMipmaps(
-                GL_TEXTURE_2D,
-                format,
-                gl_width,
-                gl_height,
-                format,
-                GL_UNSIGNED_BYTE,
-                &nmpix[0]);
+            timed([&]() { build_mipmaps(nmpix, format, format, 4); });
         }
     }
     else
@@ -724,37 +928,20 @@ void texture::init(
             break;
         }
 
-#ifdef MEMMEASURE
-        add_mem_used = gl_width * gl_height * get_bpp();
-#endif
+        add_mem_used = std::size_t(gl_width) * gl_height * get_bpp();
         if (do_mipmapping[mapping])
         {
             // fixme: does this command set the base level, too?
             // i.e. are the two gl commands redundant?
-            // fixme: doesn't work with textures that don't have power of two
-            // size...
-            gluBuild2DMipmaps(
-                GL_TEXTURE_2D,
-                format,
-                gl_width,
-                gl_height,
-                format,
-                GL_UNSIGNED_BYTE,
-                &data[0]);
+            timed([&]() { build_mipmaps(data, format, format, get_bpp()); });
         }
     }
 
-#ifdef MEMMEASURE
     if (do_mipmapping[mapping])
+    {
         add_mem_used = (4 * add_mem_used) / 3;
-    mem_used += add_mem_used;
-    log_debug(
-        "Allocated " << add_mem_used << " bytes of video memory for texture '"
-                     << texfilename << "', total video mem use "
-                     << mem_used / 1024 << " kb");
-    mem_alloced += add_mem_used;
-    log_debug("Video mem usage " << mem_alloced << " vs " << mem_freed);
-#endif
+    }
+    mem.set(add_mem_used);
 
     glTexParameteri(dimension, GL_TEXTURE_MIN_FILTER, mapmodes[mapping]);
     glTexParameteri(dimension, GL_TEXTURE_MAG_FILTER, magfilter[mapping]);
@@ -767,6 +954,93 @@ void texture::init(
         glTexParameterf(
             dimension, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropic_level);
     }
+
+    if (record_load_times)
+    {
+        const auto load_time  = std::chrono::steady_clock::now() - start_time;
+        const double total_ms =
+            std::chrono::duration<double, std::milli>(load_time).count();
+        std::lock_guard<std::mutex> lock(texture_load_times_mutex);
+        texture_load_times.push_back(
+            {texfilename, gl_width, gl_height, preprocess_ms, total_ms});
+    }
+}
+
+void texture::build_mipmaps(
+    const vector<uint8_t>& data,
+    int internalformat,
+    int pixelformat,
+    unsigned bpp) const
+{
+    // GLU rescales images with other sizes to powers of two first
+    if ((gl_width & (gl_width - 1)) != 0 || (gl_height & (gl_height - 1)) != 0)
+    {
+        gluBuild2DMipmaps(
+            GL_TEXTURE_2D,
+            internalformat,
+            gl_width,
+            gl_height,
+            pixelformat,
+            GL_UNSIGNED_BYTE,
+            &data[0]);
+        return;
+    }
+    vector<uint8_t> curlvl;
+    const vector<uint8_t>* gdat = &data;
+    for (unsigned level = 0, w = gl_width, h = gl_height;; ++level)
+    {
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            level,
+            internalformat,
+            w,
+            h,
+            0,
+            pixelformat,
+            GL_UNSIGNED_BYTE,
+            &(*gdat)[0]);
+        if (w == 1 && h == 1)
+        {
+            break;
+        }
+        curlvl = scale_half(*gdat, w, h, bpp);
+        gdat   = &curlvl;
+        w      = std::max(1U, w / 2);
+        h      = std::max(1U, h / 2);
+    }
+}
+
+void texture::log_load_times(unsigned max_entries)
+{
+    std::lock_guard<std::mutex> lock(texture_load_times_mutex);
+    std::sort(
+        texture_load_times.begin(),
+        texture_load_times.end(),
+        [](const texture_load_time& a, const texture_load_time& b) {
+            return a.total_ms > b.total_ms;
+        });
+    double sum_total = 0.0, sum_preprocess = 0.0;
+    for (const auto& t : texture_load_times)
+    {
+        sum_total += t.total_ms;
+        sum_preprocess += t.preprocess_ms;
+    }
+    log_info(
+        "Created " << texture_load_times.size() << " textures in "
+                   << sum_total << "ms, " << sum_preprocess
+                   << "ms of it for normal maps/mipmaps");
+    for (unsigned i = 0;
+         i < std::min(max_entries, unsigned(texture_load_times.size()));
+         ++i)
+    {
+        const auto& t = texture_load_times[i];
+        log_info(
+            std::fixed << std::setprecision(2) << std::setw(8) << t.total_ms
+                       << "ms (" << std::setw(8) << t.preprocess_ms
+                       << "ms preprocessing) " << t.width << "x" << t.height
+                       << " " << t.name);
+    }
+    texture_load_times.clear();
 }
 
 #define MAKEFOURCC(ch0, ch1, ch2, ch3)                                         \
@@ -875,22 +1149,23 @@ auto texture::scale_half(
         }
     }
 
-    vector<uint8_t> dst(w * h * bpp / 4);
-    unsigned ptr = 0;
-    for (unsigned y = 0; y < h; y += 2)
+    vector<uint8_t> dst(std::max(1U, w / 2) * std::max(1U, h / 2) * bpp);
+    switch (bpp)
     {
-        for (unsigned x = 0; x < w; x += 2)
-        {
-            for (unsigned b = 0; b < bpp; ++b)
-            {
-                dst[ptr++] = uint8_t(
-                    (unsigned(src[(y * w + x) * bpp + b])
-                     + unsigned(src[(y * w + x + 1) * bpp + b])
-                     + unsigned(src[((y + 1) * w + x) * bpp + b])
-                     + unsigned(src[((y + 1) * w + x + 1) * bpp + b]))
-                    / 4);
-            }
-        }
+        case 1:
+            scale_half_generic<1>(src, dst, w, h);
+            break;
+        case 2:
+            scale_half_generic<2>(src, dst, w, h);
+            break;
+        case 3:
+            scale_half_generic<3>(src, dst, w, h);
+            break;
+        case 4:
+            scale_half_generic<4>(src, dst, w, h);
+            break;
+        default:
+            THROW(texerror, "[scale_half]", "unsupported bytes per pixel");
     }
     return dst;
 }
@@ -908,27 +1183,8 @@ auto texture::make_normals(
     // This depends on the size of the face the normal map is mapped onto.
     // but all other code is written to match 255/detailh, especially
     // bump scaling in model.cpp, so don't change this!
-    float zh     = /* 2.0f* */ 255.0f / detailh;
-    unsigned ptr = 0;
-    for (unsigned yy = 0; yy < h; ++yy)
-    {
-        unsigned y1 = (yy + h - 1) & (h - 1);
-        unsigned y2 = (yy + 1) & (h - 1);
-        for (unsigned xx = 0; xx < w; ++xx)
-        {
-            unsigned x1  = (xx + w - 1) & (w - 1);
-            unsigned x2  = (xx + 1) & (w - 1);
-            float hr     = src[yy * w + x2];
-            float hu     = src[y1 * w + xx];
-            float hl     = src[yy * w + x1];
-            float hd     = src[y2 * w + xx];
-            vector3f nm  = vector3f(hl - hr, hd - hu, zh).normal();
-            dst[ptr + 0] = uint8_t(nm.x * 127 + 128);
-            dst[ptr + 1] = uint8_t(nm.y * 127 + 128);
-            dst[ptr + 2] = uint8_t(nm.z * 127 + 128);
-            ptr += 3;
-        }
-    }
+    float zh = /* 2.0f* */ 255.0f / detailh;
+    make_normals_generic<1, 3>(src, dst, w, h, zh);
     return dst;
 }
 
@@ -945,28 +1201,8 @@ auto texture::make_normals_with_alpha(
     // This depends on the size of the face the normal map is mapped onto.
     // but all other code is written to match 255/detailh, especially
     // bump scaling in model.cpp, so don't change this!
-    float zh     = /* 2.0f* */ 255.0f / detailh;
-    unsigned ptr = 0;
-    for (unsigned yy = 0; yy < h; ++yy)
-    {
-        unsigned y1 = (yy + h - 1) & (h - 1);
-        unsigned y2 = (yy + 1) & (h - 1);
-        for (unsigned xx = 0; xx < w; ++xx)
-        {
-            unsigned x1  = (xx + w - 1) & (w - 1);
-            unsigned x2  = (xx + 1) & (w - 1);
-            float hr     = src[2 * (yy * w + x2) + 0];
-            float hu     = src[2 * (y1 * w + xx) + 0];
-            float hl     = src[2 * (yy * w + x1) + 0];
-            float hd     = src[2 * (y2 * w + xx) + 0];
-            vector3f nm  = vector3f(hl - hr, hd - hu, zh).normal();
-            dst[ptr + 0] = uint8_t(nm.x * 127 + 128);
-            dst[ptr + 1] = uint8_t(nm.y * 127 + 128);
-            dst[ptr + 2] = uint8_t(nm.z * 127 + 128);
-            dst[ptr + 3] = src[2 * (yy * w + xx) + 1];
-            ptr += 4;
-        }
-    }
+    float zh = /* 2.0f* */ 255.0f / detailh;
+    make_normals_generic<2, 4>(src, dst, w, h, zh);
     return dst;
 }
 
@@ -1028,9 +1264,10 @@ texture::texture(
     bool rgb2grey,
     GLenum _dimension)
 {
-    dimension = _dimension;
-    mapping   = mapping_;
-    clamping  = clamp;
+    dimension   = _dimension;
+    mapping     = mapping_;
+    clamping    = clamp;
+    texfilename = teximage.get_filename();
     sdl_init(
         teximage.get_SDL_Surface(),
         sx,
@@ -1160,6 +1397,7 @@ texture::texture(
         GL_RGB,
         GL_UNSIGNED_BYTE,
         (void*) nullptr);
+    mem.set(std::size_t(w) * h * get_bpp());
 }
 
 texture::texture(
@@ -1257,22 +1495,11 @@ texture::texture(
         m_width  = (m_width / 2);
         m_height = (m_height / 2);
     }
+    mem.set(m_offset);
 }
 
 texture::~texture()
 {
-#ifdef MEMMEASURE
-    unsigned sub_mem_used = gl_width * gl_height * get_bpp();
-    if (do_mipmapping[mapping])
-        sub_mem_used = (4 * sub_mem_used) / 3;
-    mem_used -= sub_mem_used;
-    log_debug(
-        "Freed " << sub_mem_used << " bytes of video memory for texture '"
-                 << texfilename << "', total video mem use " << mem_used / 1024
-                 << " kb");
-    mem_freed += sub_mem_used;
-    log_debug("Video mem usage " << mem_alloced << " vs " << mem_freed);
-#endif
     glDeleteTextures(1, &opengl_name);
 }
 
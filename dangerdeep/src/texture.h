@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 struct SDL_Surface;
 #include "color.h"
 #include "error.h"
+#include "memory_usage.h"
 #include "oglext/OglExt.h"
 #include "vector3.h"
 
@@ -77,8 +78,13 @@ class sdl_image
     /// get height of image
     [[nodiscard]] unsigned get_height() const;
 
+    /// get name of image file
+    [[nodiscard]] const std::string& get_filename() const { return filename; }
+
   protected:
     SDL_Surface* img;
+    std::string filename;
+    memory_usage::account mem{memory_usage::images};
 
   private:
     sdl_image()        = delete; // no copy
@@ -114,6 +120,11 @@ class texture
     static bool use_compressed_textures;
     static bool use_anisotropic_filtering;
     static float anisotropic_level;
+    /// number of parallel parts for normal map and mipmap generation,
+    /// 0 = automatic, 1 = no parallelism
+    static unsigned nr_of_threads;
+    /// record time spent for every texture creation (for startup profiling)
+    static bool record_load_times;
 
   private:
     texture& operator=(const texture& other);
@@ -132,6 +143,7 @@ class texture
         mapping; // how GL draws the texture (GL_NEAREST, GL_LINEAR, etc.)
     clamping_mode
         clamping; // how GL handles the border (GL_REPEAT, GL_CLAMP_TO_EDGE)
+    memory_usage::account mem{memory_usage::textures}; // video memory
 
     void sdl_init(
         SDL_Surface* teximage,
@@ -151,12 +163,15 @@ class texture
         bool makenormalmap = false,
         float detailh      = 1.0f);
 
-    static int size_non_power_2;
+    /// compute and upload all mipmap levels of a 2D texture, including the
+    /// base level. Gives the same result as gluBuild2DMipmaps.
+    void build_mipmaps(
+        const std::vector<uint8_t>& data,
+        int internalformat,
+        int pixelformat,
+        unsigned bpp) const;
 
-    // statistics.
-    static unsigned mem_used;
-    static unsigned mem_alloced;
-    static unsigned mem_freed;
+    static int size_non_power_2;
 
     texture() = default;
 
@@ -323,6 +338,8 @@ class texture
     [[nodiscard]] int get_format() const { return format; }
     [[nodiscard]] unsigned get_bpp() const;
     [[nodiscard]] unsigned get_opengl_name() const { return opengl_name; }
+    /// get video memory used by texture in bytes
+    [[nodiscard]] std::size_t get_memory_used() const { return mem.get(); }
     void set_gl_texture() const;
     [[nodiscard]] std::string get_name() const { return texfilename; }
     [[nodiscard]] unsigned get_width() const { return width; }
@@ -400,8 +417,13 @@ class texture
     /// after GL init.
     static bool size_non_power_two();
 
+    /// write statistics of recorded texture creation times to the log,
+    /// slowest textures first, and clear them.
+    static void log_load_times(unsigned max_entries = 20);
+
     // will scale down the image data to half size in each direction (at least
-    // w/h=1) w,h must be > 1
+    // w/h=1), w,h are the source size. Uses the box filter of
+    // gluBuild2DMipmaps, so results are identical.
     static std::vector<uint8_t> scale_half(
         const std::vector<uint8_t>& src,
         unsigned w,
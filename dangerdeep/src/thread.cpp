@@ -24,6 +24,7 @@
 
 #include "error.h"
 #include "log.h"
+#include "profiler.h"
 #include "system_interface.h"
 
 #include <utility>
@@ -40,6 +41,7 @@ void thread::run()
     try
     {
         log::instance().new_thread(myname);
+        profiler::set_thread_name(myname);
         init();
     }
     catch (std::exception& e)
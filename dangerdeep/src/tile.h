@@ -20,19 +20,26 @@
 
 #include "bitstream.h"
 #include "bzip.h"
+#include "error.h"
 #include "log.h"
+#include "memory_usage.h"
 #include "morton_bivector.h"
 #include "system_interface.h"
+#include "tile_codec.h"
 #include "vector2.h"
 
 #include <ctime>
 #include <fstream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 template<class T>
 class tile
 {
   public:
+    /// filename is given without extension, tiles in tile_codec format are
+    /// preferred, bzip2 compressed raw tiles (.bz2) are used as fallback.
     tile(const char* filename, vector2i& _bottom_left, unsigned size);
     tile(const tile<T>&);
     tile() : data(1){};
@@ -49,29 +56,17 @@ class tile
     morton_bivector<T> data;
     vector2i bottom_left;
     unsigned long last_access;
+    memory_usage::account mem{memory_usage::terrain};
+
+    void read_file(const std::string& filename, unsigned size);
 };
 
 template<class T>
 tile<T>::tile(const char* filename, vector2i& _bottom_left, unsigned size) :
     data(size, -200), bottom_left(_bottom_left), last_access(SYS().millisec())
 {
-    std::ifstream file;
-    file.open(filename);
-
-    if (file.is_open())
-    {
-        bzip_istream bin(&file);
-        bin.read((char*) data.data_ptr(), size * size * sizeof(T));
-        bin.close();
-        file.close();
-    }
-    else
-    {
-        std::stringstream msg;
-        msg << "Cannot open file: ";
-        msg << filename;
-        log_warning(msg.str());
-    }
+    mem.set(size_t(size) * size * sizeof(T));
+    read_file(filename, size);
 }
 
 template<class T>
@@ -80,10 +75,38 @@ void tile<T>::load(const char* filename, vector2i& _bottom_left, unsigned size)
     data.resize(size, -200);
     bottom_left = _bottom_left;
     last_access = SYS().millisec();
+    mem.set(size_t(size) * size * sizeof(T));
+    read_file(filename, size);
+}
 
-    std::ifstream file;
-    file.open(filename);
+template<class T>
+void tile<T>::read_file(const std::string& filename, unsigned size)
+{
+    std::ifstream file(filename + tile_codec::extension, std::ios::binary);
+    if (file.is_open())
+    {
+        tile_codec tc(file);
+        if (tc.get_size() != size)
+        {
+            THROW(
+                file_context_error,
+                "terrain tile has wrong size",
+                filename + tile_codec::extension);
+        }
+        if constexpr (std::is_same_v<T, int16_t>)
+        {
+            tc.decode(data.data_ptr());
+        }
+        else
+        {
+            std::vector<int16_t> heights(size * size);
+            tc.decode(&heights[0]);
+            std::copy(heights.begin(), heights.end(), data.data_ptr());
+        }
+        return;
+    }
 
+    file.open(filename + ".bz2", std::ios::binary);
     if (file.is_open())
     {
         bzip_istream bin(&file);
@@ -103,7 +126,7 @@ void tile<T>::load(const char* filename, vector2i& _bottom_left, unsigned size)
 template<class T>
 tile<T>::tile(const tile<T>& other) :
     data(other.get_data()), bottom_left(other.get_bottom_left()),
-    last_access(other.get_last_access())
+    last_access(other.get_last_access()), mem(other.mem)
 {
 }
 
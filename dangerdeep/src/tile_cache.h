@@ -156,7 +156,6 @@ T tile_cache<T>::get_value(vector2i coord)
         filename << tile_coord.y;
         filename << "_";
         filename << tile_coord.x;
-        filename << ".bz2";
 
         std::pair<tile_list_iterator, bool> p = tile_list.insert(
             std::pair<vector2i, tile<T>>(tile_coord, tile<T>()));
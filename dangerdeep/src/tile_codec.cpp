@@ -0,0 +1,379 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// seekable codec for terrain height tiles
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "tile_codec.h"
+
+#include "binstream.h"
+#include "error.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+
+const std::string tile_codec::extension = ".dtt";
+
+namespace
+{
+const uint32_t TILE_CODEC_MAGIC   = 0x54544644; // "DFTT"
+const uint32_t TILE_CODEC_VERSION = 1;
+/// unary codes longer than that are replaced by the raw value
+const unsigned RICE_ESCAPE = 24;
+/// residuals of 16bit values need 17 bits after zigzag coding
+const unsigned RAW_BITS  = 17;
+const unsigned PARAM_BITS = 5;
+
+/// spread bits of value to the even bits, as in morton order
+inline uint32_t spread_bits(uint32_t v)
+{
+    uint32_t r = 0;
+    for (unsigned b = 0; b < 16; ++b)
+    {
+        r |= ((v >> b) & 1) << (2 * b);
+    }
+    return r;
+}
+
+/// median edge detector of LOCO-I
+inline int32_t predict(int32_t left, int32_t up, int32_t upleft)
+{
+    if (upleft >= std::max(left, up))
+    {
+        return std::min(left, up);
+    }
+    if (upleft <= std::min(left, up))
+    {
+        return std::max(left, up);
+    }
+    return left + up - upleft;
+}
+
+inline uint32_t zigzag(int32_t v)
+{
+    return (uint32_t(v) << 1) ^ uint32_t(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v)
+{
+    return int32_t(v >> 1) ^ -int32_t(v & 1);
+}
+
+/// iterate the values of a block in raster order, func(index, prediction)
+/// returns the value at index.
+template<typename F>
+void for_each_block_value(
+    unsigned block_size,
+    const std::vector<uint32_t>& spread,
+    int16_t* values,
+    F func)
+{
+    for (unsigned y = 0; y < block_size; ++y)
+    {
+        const uint32_t sy = spread[y] << 1;
+        for (unsigned x = 0; x < block_size; ++x)
+        {
+            const uint32_t idx = spread[x] | sy;
+            int32_t pred       = 0;
+            if (y == 0)
+            {
+                pred = (x == 0) ? 0 : values[spread[x - 1]];
+            }
+            else if (x == 0)
+            {
+                pred = values[spread[y - 1] << 1];
+            }
+            else
+            {
+                const uint32_t sy1 = spread[y - 1] << 1;
+                pred               = predict(
+                    values[spread[x - 1] | sy],
+                    values[spread[x] | sy1],
+                    values[spread[x - 1] | sy1]);
+            }
+            values[idx] = func(idx, pred);
+        }
+    }
+}
+
+class bit_writer
+{
+  public:
+    bit_writer(std::vector<uint8_t>& out_) : out(out_) { }
+    void put(uint32_t bits, unsigned nr)
+    {
+        acc |= uint64_t(bits) << nbits;
+        nbits += nr;
+        while (nbits >= 8)
+        {
+            out.push_back(uint8_t(acc));
+            acc >>= 8;
+            nbits -= 8;
+        }
+    }
+    /// write remaining bits, next block starts at byte boundary
+    void flush()
+    {
+        if (nbits > 0)
+        {
+            out.push_back(uint8_t(acc));
+        }
+        acc   = 0;
+        nbits = 0;
+    }
+
+  protected:
+    std::vector<uint8_t>& out;
+    uint64_t acc{0};
+    unsigned nbits{0};
+};
+
+class bit_reader
+{
+  public:
+    bit_reader(const uint8_t* begin, const uint8_t* end_) :
+        ptr(begin), end(end_)
+    {
+    }
+    uint32_t get(unsigned nr)
+    {
+        refill(nr);
+        const uint32_t v = uint32_t(acc & ((uint64_t(1) << nr) - 1));
+        acc >>= nr;
+        nbits -= nr;
+        return v;
+    }
+    /// count one bits up to limit, consumes the terminating zero if found
+    unsigned get_unary(unsigned limit)
+    {
+        unsigned q = 0;
+        while (q < limit)
+        {
+            if (nbits == 0)
+            {
+                refill(1);
+            }
+            const bool one = (acc & 1) != 0;
+            acc >>= 1;
+            --nbits;
+            if (!one)
+            {
+                break;
+            }
+            ++q;
+        }
+        return q;
+    }
+
+  protected:
+    const uint8_t* ptr;
+    const uint8_t* end;
+    uint64_t acc{0};
+    unsigned nbits{0};
+
+    void refill(unsigned needed)
+    {
+        while (nbits <= 56 && ptr < end)
+        {
+            acc |= uint64_t(*ptr++) << nbits;
+            nbits += 8;
+        }
+        if (nbits < needed)
+        {
+            THROW(error, "tile_codec: unexpected end of block data");
+        }
+    }
+};
+} // namespace
+
+void tile_codec::encode(
+    std::ostream& out,
+    const int16_t* values,
+    unsigned size,
+    unsigned block_size)
+{
+    if (size == 0 || (size & (size - 1)) != 0 || block_size == 0
+        || (block_size & (block_size - 1)) != 0)
+    {
+        THROW(error, "tile_codec: sizes must be powers of two");
+    }
+    block_size = std::min(block_size, size);
+    const unsigned block_values = block_size * block_size;
+    const unsigned nr_blocks    = (size / block_size) * (size / block_size);
+    std::vector<uint32_t> spread(block_size);
+    for (unsigned i = 0; i < block_size; ++i)
+    {
+        spread[i] = spread_bits(i);
+    }
+
+    std::vector<uint8_t> coded;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> residuals(block_values);
+    std::vector<int16_t> block(block_values);
+    bit_writer bw(coded);
+    for (unsigned b = 0; b < nr_blocks; ++b)
+    {
+        offsets.push_back(uint32_t(coded.size()));
+        const int16_t* src = values + b * block_values;
+        // compute residuals, walking like the decoder does
+        for_each_block_value(
+            block_size, spread, &block[0], [&](uint32_t idx, int32_t pred) {
+                residuals[idx] = zigzag(int32_t(src[idx]) - pred);
+                return src[idx];
+            });
+        // choose best Rice parameter
+        unsigned best_k = 0;
+        uint64_t best_cost = ~uint64_t(0);
+        for (unsigned k = 0; k <= RAW_BITS; ++k)
+        {
+            uint64_t cost = 0;
+            for (uint32_t r : residuals)
+            {
+                const uint32_t q = r >> k;
+                cost += (q < RICE_ESCAPE) ? q + 1 + k : RICE_ESCAPE + RAW_BITS;
+            }
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_k    = k;
+            }
+        }
+        bw.put(best_k, PARAM_BITS);
+        // write in decoding order
+        for (unsigned y = 0; y < block_size; ++y)
+        {
+            for (unsigned x = 0; x < block_size; ++x)
+            {
+                const uint32_t r = residuals[spread[x] | (spread[y] << 1)];
+                const uint32_t q = r >> best_k;
+                if (q < RICE_ESCAPE)
+                {
+                    bw.put((1U << q) - 1, q + 1); // q ones, one zero
+                    if (best_k > 0)
+                    {
+                        bw.put(r & ((1U << best_k) - 1), best_k);
+                    }
+                }
+                else
+                {
+                    bw.put((1U << RICE_ESCAPE) - 1, RICE_ESCAPE);
+                    bw.put(r, RAW_BITS);
+                }
+            }
+        }
+        bw.flush();
+    }
+    offsets.push_back(uint32_t(coded.size()));
+
+    write_u32(out, TILE_CODEC_MAGIC);
+    write_u32(out, TILE_CODEC_VERSION);
+    write_u32(out, size);
+    write_u32(out, block_size);
+    write_u32(out, nr_blocks);
+    for (uint32_t o : offsets)
+    {
+        write_u32(out, o);
+    }
+    out.write(reinterpret_cast<const char*>(coded.data()), coded.size());
+}
+
+tile_codec::tile_codec(std::istream& in)
+{
+    if (read_u32(in) != TILE_CODEC_MAGIC)
+    {
+        THROW(error, "tile_codec: no terrain tile data");
+    }
+    if (read_u32(in) != TILE_CODEC_VERSION)
+    {
+        THROW(error, "tile_codec: unsupported version");
+    }
+    size                     = read_u32(in);
+    block_size               = read_u32(in);
+    const uint32_t nr_blocks = read_u32(in);
+    if (block_size == 0 || size == 0 || block_size > size
+        || nr_blocks != (size / block_size) * (size / block_size))
+    {
+        THROW(error, "tile_codec: invalid header");
+    }
+    spread.resize(block_size);
+    for (unsigned i = 0; i < block_size; ++i)
+    {
+        spread[i] = spread_bits(i);
+    }
+    block_offsets.resize(nr_blocks + 1);
+    for (auto& o : block_offsets)
+    {
+        o = read_u32(in);
+    }
+    data.resize(block_offsets.back());
+    in.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (!in.good() && !in.eof())
+    {
+        THROW(error, "tile_codec: read error");
+    }
+    if (size_t(in.gcount()) != data.size())
+    {
+        THROW(error, "tile_codec: file truncated");
+    }
+}
+
+void tile_codec::decode_block(unsigned block, int16_t* dest) const
+{
+    if (block >= get_nr_of_blocks())
+    {
+        THROW(error, "tile_codec: invalid block number");
+    }
+    bit_reader br(
+        data.data() + block_offsets[block],
+        data.data() + block_offsets[block + 1]);
+    const unsigned k = br.get(PARAM_BITS);
+    if (k > RAW_BITS)
+    {
+        THROW(error, "tile_codec: corrupt block data");
+    }
+    for_each_block_value(
+        block_size, spread, dest, [&](uint32_t, int32_t pred) {
+            const unsigned q = br.get_unary(RICE_ESCAPE);
+            uint32_t r       = 0;
+            if (q < RICE_ESCAPE)
+            {
+                r = (q << k) | ((k > 0) ? br.get(k) : 0);
+            }
+            else
+            {
+                r = br.get(RAW_BITS);
+            }
+            return int16_t(pred + unzigzag(r));
+        });
+}
+
+void tile_codec::decode(int16_t* dest, unsigned nr_threads) const
+{
+    const unsigned block_values = block_size * block_size;
+    parallel_for(
+        0,
+        get_nr_of_blocks(),
+        [this, dest, block_values](unsigned first, unsigned last) {
+            for (unsigned b = first; b < last; ++b)
+            {
+                decode_block(b, dest + b * block_values);
+            }
+        },
+        nr_threads);
+}
@@ -0,0 +1,80 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// seekable codec for terrain height tiles
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+///\brief Lossless codec for square terrain height tiles.
+/** Tiles hold size*size 16bit heights in morton order (like
+    morton_bivector). A tile is split into square blocks that are aligned to
+    the block size, so each block is a contiguous range of the morton data.
+    Every block is coded on its own: heights are predicted from their left,
+    upper and upper left neighbours (median edge detector) and the residuals
+    are Rice coded with the best parameter for that block. An index of block
+    offsets follows the header, so single blocks can be decoded without
+    touching the rest and all blocks can be decoded in parallel.
+*/
+class tile_codec
+{
+  public:
+    /// file name extension of encoded tiles
+    static const std::string extension;
+
+    /// read encoded tile from stream
+    tile_codec(std::istream& in);
+
+    /// encode a tile
+    ///@param data - size*size heights in morton order
+    ///@param block_size - edge length of blocks, power of two, limited to
+    ///                     size
+    static void encode(
+        std::ostream& out,
+        const int16_t* data,
+        unsigned size,
+        unsigned block_size = 64);
+
+    [[nodiscard]] unsigned get_size() const { return size; }
+    [[nodiscard]] unsigned get_block_size() const { return block_size; }
+    [[nodiscard]] unsigned get_nr_of_blocks() const
+    {
+        return unsigned(block_offsets.size()) - 1;
+    }
+
+    /// decode one block, writes block_size^2 heights in morton order.
+    /// Block n covers the morton indices n*block_size^2 ... (n+1)*b^2-1.
+    void decode_block(unsigned block, int16_t* dest) const;
+
+    /// decode the whole tile (size*size heights) in parallel, split in
+    /// nr_threads parts, 0 means automatic, 1 decodes in calling thread.
+    void decode(int16_t* dest, unsigned nr_threads = 0) const;
+
+  protected:
+    unsigned size{0};
+    unsigned block_size{0};
+    std::vector<uint32_t> block_offsets; ///< into data, one extra at end
+    std::vector<uint32_t> spread;        ///< coordinate to morton bits
+    std::vector<uint8_t> data;
+};
@@ -0,0 +1,244 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// terrain tile codec benchmark, compares against bzip2 compressed tiles
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "bzip.h"
+#include "mymain.cpp"
+#include "tile_codec.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point t0)
+{
+    return std::chrono::duration<double>(clock_type::now() - t0).count();
+}
+
+/// synthetic terrain in morton order: a few octaves of smooth hills plus
+/// some noise, similar in statistics to ETOPO data.
+vector<int16_t> make_synthetic_tile(unsigned size, unsigned seed)
+{
+    vector<int16_t> heights(size * size);
+    srand(seed);
+    for (unsigned y = 0; y < size; ++y)
+    {
+        for (unsigned x = 0; x < size; ++x)
+        {
+            double h = -2000.0;
+            double f = 0.005 * (seed + 1);
+            for (double a = 2500.0; a > 10.0; a *= 0.4, f *= 2.3)
+            {
+                h += a * std::sin(x * f + seed) * std::cos(y * f * 1.3);
+            }
+            h += rand() % 9 - 4;
+            uint32_t m = 0;
+            for (unsigned b = 0; b < 16; ++b)
+            {
+                m |= ((x >> b) & 1) << (2 * b);
+                m |= ((y >> b) & 1) << (2 * b + 1);
+            }
+            heights[m] = int16_t(h);
+        }
+    }
+    return heights;
+}
+
+std::string bzip_encode(const vector<int16_t>& heights)
+{
+    std::ostringstream oss;
+    bzip_ostream bout(&oss);
+    bout.write((const char*) &heights[0], heights.size() * sizeof(int16_t));
+    bout.close();
+    return oss.str();
+}
+
+void bzip_decode(const std::string& coded, vector<int16_t>& heights)
+{
+    std::istringstream iss(coded);
+    bzip_istream bin(&iss);
+    bin.read((char*) &heights[0], heights.size() * sizeof(int16_t));
+    bin.close();
+}
+
+std::string codec_encode(const vector<int16_t>& heights, unsigned size)
+{
+    std::ostringstream oss;
+    tile_codec::encode(oss, &heights[0], size);
+    return oss.str();
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    unsigned tile_size  = 512;
+    unsigned nr_rounds  = 5;
+    unsigned nr_threads = 0;
+    vector<std::string> files;
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        if (*it == "--help")
+        {
+            std::cout << "Usage: tilecodectest [--tile_size n] [--rounds n] "
+                         "[--threads n] [tile.bz2 ...]\n"
+                      << "Decodes the given bzip2 terrain tiles (or synthetic "
+                         "ones), converts them\nto the tile codec and compares "
+                         "decoding speed and size on disk.\n";
+            return 0;
+        }
+        if (*it == "--tile_size" && it + 1 != args.end())
+        {
+            tile_size = atoi((++it)->c_str());
+        }
+        else if (*it == "--rounds" && it + 1 != args.end())
+        {
+            nr_rounds = std::max(1, atoi((++it)->c_str()));
+        }
+        else if (*it == "--threads" && it + 1 != args.end())
+        {
+            nr_threads = atoi((++it)->c_str());
+        }
+        else
+        {
+            files.push_back(*it);
+        }
+    }
+    if (nr_threads == 0)
+    {
+        nr_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // collect the encoded tiles in both formats
+    const unsigned nr_values = tile_size * tile_size;
+    vector<std::string> bzip_tiles, codec_tiles;
+    vector<vector<int16_t>> reference;
+    if (files.empty())
+    {
+        std::cout << "No tiles given, using 16 synthetic tiles\n";
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            reference.push_back(make_synthetic_tile(tile_size, i));
+            bzip_tiles.push_back(bzip_encode(reference.back()));
+        }
+    }
+    else
+    {
+        for (const auto& fn : files)
+        {
+            std::ifstream in(fn, std::ios::binary);
+            if (!in.is_open())
+            {
+                std::cout << "Can't open " << fn << "\n";
+                return -1;
+            }
+            std::ostringstream oss;
+            oss << in.rdbuf();
+            bzip_tiles.push_back(oss.str());
+            reference.emplace_back(nr_values);
+            bzip_decode(bzip_tiles.back(), reference.back());
+        }
+    }
+    const unsigned nr_tiles = unsigned(reference.size());
+    size_t bzip_bytes = 0, codec_bytes = 0;
+    auto t0 = clock_type::now();
+    for (unsigned i = 0; i < nr_tiles; ++i)
+    {
+        codec_tiles.push_back(codec_encode(reference[i], tile_size));
+        bzip_bytes += bzip_tiles[i].size();
+        codec_bytes += codec_tiles[i].size();
+    }
+    const double encode_time = seconds_since(t0);
+
+    // decode and verify
+    vector<int16_t> heights(nr_values);
+    unsigned nr_errors = 0;
+    auto decode_all    = [&](unsigned mode) {
+        auto t0 = clock_type::now();
+        for (unsigned r = 0; r < nr_rounds; ++r)
+        {
+            for (unsigned i = 0; i < nr_tiles; ++i)
+            {
+                if (mode == 0)
+                {
+                    bzip_decode(bzip_tiles[i], heights);
+                }
+                else
+                {
+                    std::istringstream iss(codec_tiles[i]);
+                    tile_codec tc(iss);
+                    tc.decode(&heights[0], mode == 1 ? 1 : nr_threads);
+                }
+                if (heights != reference[i])
+                {
+                    ++nr_errors;
+                }
+            }
+        }
+        return nr_tiles * nr_rounds / seconds_since(t0);
+    };
+    const double bzip_rate    = decode_all(0);
+    const double codec_rate   = decode_all(1);
+    const double codec_rate_n = decode_all(2);
+
+    // random access of a single block, as used for partial tile loading
+    std::istringstream iss(codec_tiles[0]);
+    tile_codec tc(iss);
+    vector<int16_t> block(tc.get_block_size() * tc.get_block_size());
+    t0 = clock_type::now();
+    const unsigned nr_block_decodes = 1000;
+    for (unsigned i = 0; i < nr_block_decodes; ++i)
+    {
+        tc.decode_block(i % tc.get_nr_of_blocks(), &block[0]);
+    }
+    const double block_time = seconds_since(t0) / nr_block_decodes;
+
+    std::cout << nr_tiles << " tiles of " << tile_size << "x" << tile_size
+              << ", raw " << nr_tiles * nr_values * sizeof(int16_t) / 1024
+              << " kB\n"
+              << "bzip2: " << bzip_bytes / 1024 << " kB on disk, " << bzip_rate
+              << " tiles/s\n"
+              << "tile codec: " << codec_bytes / 1024 << " kB on disk ("
+              << 100.0 * codec_bytes / bzip_bytes << "% of bzip2), "
+              << codec_rate << " tiles/s with 1 thread, " << codec_rate_n
+              << " tiles/s with " << nr_threads << " threads, speedup "
+              << codec_rate_n / bzip_rate << "x\n"
+              << "encoding took " << encode_time * 1000.0 / nr_tiles
+              << "ms per tile, single block decode "
+              << block_time * 1000000.0 << "us\n";
+    if (nr_errors > 0)
+    {
+        std::cout << "ERROR: " << nr_errors << " tiles decoded wrong!\n";
+        return -1;
+    }
+    return 0;
+}
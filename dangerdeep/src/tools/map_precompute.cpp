@@ -23,6 +23,7 @@
 #include "../morton_bivector.h"
 #include "../mymain.cpp"
 #include "../terrain.h"
+#include "../tile_codec.h"
 #include "../vector2.h"
 
 #include <SDL.h>
@@ -84,6 +85,7 @@ int mymain(std::vector<string>& args)
     long cols     = 21600;
     long sqr_size = 512;
     bool clip     = false;
+    bool use_bzip = false;
     vector2i clip_tl, clip_br;
 
     for (auto it = args.begin(); it != args.end(); ++it)
@@ -111,6 +113,12 @@ int mymain(std::vector<string>& args)
                    "second pair are the bottom right coords."
                 << std::endl
                 << "\t\t\t\tNOTE: the coordinates have to fit the tile size!"
+                << std::endl
+                << "\t--format dtt|bz2\toutput format of tiles, dtt is the "
+                   "seekable tile codec,"
+                << std::endl
+                << "\t\t\t\tbz2 the old bzip2 compressed raw data. "
+                   "Default: dtt"
                 << std::endl;
             return 0;
         }
@@ -160,6 +168,23 @@ int mymain(std::vector<string>& args)
                 sqr_size = atol((*it2).c_str());
             }
         }
+        if (*it == "--format")
+        {
+            auto it2 = it;
+            ++it2;
+            if (it2 != args.end())
+            {
+                if (*it2 == "bz2")
+                {
+                    use_bzip = true;
+                }
+                else if (*it2 != "dtt")
+                {
+                    std::cout << "Wrong value for --format" << std::endl;
+                    return -1;
+                }
+            }
+        }
         if (*it == "--clip")
         {
             auto it2 = it;
@@ -248,6 +273,7 @@ int mymain(std::vector<string>& args)
     std::cout << "\tcols: " << padded_cols << std::endl;
     std::cout << "\trows: " << padded_rows << std::endl;
     std::cout << "\ttile_size: " << sqr_size << std::endl;
+    std::cout << "\tformat: " << (use_bzip ? "bz2" : "dtt") << std::endl;
     std::cout << "\tclip: " << clip << std::endl;
     std::cout << "\tclip_tl: " << clip_tl << std::endl;
     std::cout << "\tclip_br: " << clip_br << std::endl;
@@ -277,11 +303,12 @@ int mymain(std::vector<string>& args)
             filename << padded_rows - sqr_size - sqr_y;
             filename << "_";
             filename << sqr_x;
-            filename << ".bz2";
+            filename
+                << (use_bzip ? std::string(".bz2") : tile_codec::extension);
 
             std::cout << filename.str() << std::endl;
 
-            file.open(filename.str().c_str());
+            file.open(filename.str().c_str(), std::ios::binary);
             if (file.fail())
             {
                 std::cerr << "Can't open " << filename.str() << " for output"
@@ -289,11 +316,18 @@ int mymain(std::vector<string>& args)
                 return (-1);
             }
 
-            bzip_ostream bout(&file);
-            bout.write(
-                (char*) tile.data_ptr(),
-                tile.size() * tile.size() * sizeof(Sint16));
-            bout.close();
+            if (use_bzip)
+            {
+                bzip_ostream bout(&file);
+                bout.write(
+                    (char*) tile.data_ptr(),
+                    tile.size() * tile.size() * sizeof(Sint16));
+                bout.close();
+            }
+            else
+            {
+                tile_codec::encode(file, tile.data_ptr(), tile.size());
+            }
 
             file.close();
         }
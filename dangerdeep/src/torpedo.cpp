@@ -35,12 +35,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 using std::string;
 using std::vector;
 
+torpedo::dynamics_types torpedo::default_dynamics = torpedo::PHYSICS;
+bool torpedo::use_homing_sensors                 = false;
+
 torpedo::fuse::fuse(const xml_elem& parent, date equipdate)
 {
     string modelstr = parent.attr("type");
-    xml_doc doc(get_data_dir() + "objects/torpedoes/fuses.data");
-    doc.load();
-    xml_elem fs = doc.child("dftd-torpedo-fuses");
+    xml_elem fs = data_file()
+                      .get_document("objects/torpedoes/fuses.data")
+                      .child("dftd-torpedo-fuses");
     if (!fs.has_child(modelstr))
     {
         THROW(xml_error, "unknown fuse type!", parent.doc_name());
@@ -272,6 +275,23 @@ torpedo::torpedo(
     {
         steering_device = STRAIGHT;
     }
+    dynamics = default_dynamics;
+    if (emotion.has_attr("dynamics"))
+    {
+        string dynamicsstr = emotion.attr("dynamics");
+        if (dynamicsstr == "physics")
+        {
+            dynamics = PHYSICS;
+        }
+        else if (dynamicsstr == "analytic")
+        {
+            dynamics = ANALYTIC;
+        }
+        else
+        {
+            THROW(xml_error, "unknown dynamics type!", parent.doc_name());
+        }
+    }
     // ------------ power and check of validity of torpspeed setting
     xml_elem epower  = parent.child("power");
     string powertype = epower.attr("type");
@@ -301,7 +321,35 @@ torpedo::torpedo(
         THROW(xml_error, "unknown power type!", parent.doc_name());
     }
 
-    // ------------ sensors, fixme
+    // ------------ sensors
+    for (auto esensor : parent.child("sensors").iterate("sensor"))
+    {
+        if (!use_homing_sensors)
+        {
+            break;
+        }
+        string typestr = esensor.attr("type");
+        auto pst       = passive_sonar_sensor::passive_sonar_type_default;
+        if (typestr == "passivesonar_t4" || typestr == "passivesonar_t5")
+        {
+            // fixme: T4 has no own type yet
+            pst = passive_sonar_sensor::passive_sonar_type_tt_t5;
+        }
+        else if (typestr == "passivesonar_t11")
+        {
+            pst = passive_sonar_sensor::passive_sonar_type_tt_t11;
+        }
+        else
+        {
+            continue;
+        }
+        set_sensor(
+            passive_sonar_system, std::make_unique<passive_sonar_sensor>(pst));
+        if (esensor.has_attr("activation"))
+        {
+            sensor_activation_distance = esensor.attrf("activation");
+        }
+    }
     // ------------ ranges
     xml_elem eranges = parent.child("ranges");
     range[SLOW] = range[MEDIUM] = range[FAST] = 0.0;
@@ -421,8 +469,15 @@ void torpedo::simulate(double delta_time, game& gm)
           << " velo " << velocity << " turnvelo " << turn_velocity << "\n"
           << " delta t "<< delta_time << "linear_mom " << linear_momentum);
     */
-    redetect_time = 1.0;
-    ship::simulate(delta_time, gm);
+    const vector3 oldpos = position;
+    if (dynamics == ANALYTIC)
+    {
+        simulate_analytic(delta_time, gm);
+    }
+    else
+    {
+        ship::simulate(delta_time, gm);
+    }
 
     depth_steering_logic();
     dive_planes.simulate(delta_time);
@@ -442,10 +497,20 @@ void torpedo::simulate(double delta_time, game& gm)
     // distance for the warhead is passed.
     if (!sensors.empty() && run_length >= sensor_activation_distance)
     {
-        auto* target = gm.sonar_acoustical_torpedo_target(this);
-        if (target)
+        // Searching the loudest target tests all ships, so it is done only
+        // from time to time. In between the torpedo follows its target.
+        homing_update_time -= delta_time;
+        if (homing_update_time <= 0)
         {
-            angle targetang(target->get_engine_noise_source() - get_pos().xy());
+            const auto* tgt = gm.sonar_acoustical_torpedo_target(this);
+            target          = tgt ? gm.get_id(*tgt) : sea_object_id{};
+            homing_update_time = homing_update_interval;
+        }
+        if (gm.is_valid(target))
+        {
+            angle targetang(
+                gm.get_object(target).get_engine_noise_source()
+                - get_pos().xy());
             bool turnright = get_heading().is_clockwise_nearer(targetang);
             head_to_course(targetang, !turnright);
         }
@@ -556,39 +621,126 @@ void torpedo::simulate(double delta_time, game& gm)
     if (run_length > 10)
     { // avoid collision with parent after initial creation
         bool runlengthfailure = (run_length < arming_distance);
-        if (gm.check_torpedo_hit(this, runlengthfailure))
+        if (gm.check_torpedo_hit(this, oldpos, runlengthfailure))
         {
             kill();
         }
     }
 }
 
+void torpedo::simulate_analytic(double delta_time, game& gm)
+{
+    // bookkeeping of sea_object::simulate, torpedoes do not detect objects
+    if (!gm.is_valid(target))
+    {
+        target = sea_object_id{};
+    }
+
+    // the torpedo runs level, so heading is all that matters of orientation
+    torpedo_dynamics::state s;
+    s.position       = position;
+    s.heading        = get_heading().value();
+    s.speed          = local_velocity.y;
+    s.side_speed     = local_velocity.x;
+    s.yaw_velocity   = turn_velocity * M_PI / 180.0;
+    s.vertical_speed = local_velocity.z;
+    const torpedo_dynamics::state r =
+        torpedo_dynamics(get_dynamics_parameters())
+            .step(
+                s,
+                delta_time,
+                get_throttle_accel(),
+                rudder.angle,
+                dive_planes.angle);
+
+    // set state as the physics would have it, see ship::simulate_kinematic
+    position        = r.position;
+    orientation     = quaternion::rot(-r.heading, 0, 0, 1);
+    linear_momentum =
+        orientation.rotate(vector3(r.side_speed, r.speed, r.vertical_speed))
+        * mass;
+    angular_momentum =
+        orientation.rotate(inertia_tensor * vector3(0, 0, r.yaw_velocity));
+    compute_helper_values();
+
+    // screw and rudder animation
+    if (throttle != 0)
+    {
+        double screw_ang =
+            myfrac(gm.get_time() * get_throttle_speed() * 0.5) * 360.0;
+        mymodel->set_object_angle(propeller_1_id, screw_ang);
+    }
+    if (rudder_1_id >= 0)
+    {
+        mymodel->set_object_angle(rudder_1_id, rudder.angle);
+    }
+
+    steering_logic();
+    rudder.simulate(delta_time);
+}
+
+auto torpedo::get_dynamics_parameters() const -> torpedo_dynamics::parameters
+{
+    torpedo_dynamics::parameters p;
+    p.mass             = mass;
+    p.yaw_inertia      = inertia_tensor.elem(2, 2);
+    p.length           = size3d.y;
+    p.max_speed        = max_speed_forward;
+    p.max_accel        = max_accel_forward;
+    p.rudder_area      = rudder.area;
+    p.rudder_pos       = rudder.pos.y;
+    p.dive_planes_area = dive_planes.area;
+    p.turn_drag_area   = get_turn_drag_area();
+    p.turn_drag_coeff  = get_turn_drag_coeff();
+    return p;
+}
+
 void torpedo::compute_force_and_torque(vector3& F, vector3& T, game& gm) const
 {
     ship::compute_force_and_torque(F, T, gm);
 
+    vector3 Fdr, Tdr;
+    compute_dive_planes_force_and_torque(
+        mass,
+        get_throttle_accel(),
+        rudder,
+        dive_planes,
+        get_local_velocity(),
+        Fdr,
+        Tdr);
+    F += orientation.rotate(Fdr);
+    T += orientation.rotate(Tdr);
+}
+
+void torpedo::compute_dive_planes_force_and_torque(
+    double mass,
+    double throttle_accel,
+    const generic_rudder& rudder,
+    const generic_rudder& dive_planes,
+    const vector3& local_velocity,
+    vector3& F,
+    vector3& T)
+{
     // drag by stern dive rudder
     const double water_density = 1000.0;
 
-    vector3 Fdr, Tdr;
-    double flowforce = get_throttle_accel() * mass * rudder.deflect_factor();
+    F                     = vector3();
+    T                     = vector3();
+    double flowforce      = throttle_accel * mass * rudder.deflect_factor();
     double finalflowforce = dive_planes.compute_force_and_torque(
-        Fdr, Tdr, get_local_velocity(), water_density, flowforce);
+        F, T, local_velocity, water_density, flowforce);
     // we limit torque here to avoid too much turning of the torpedo.
     // Otherwise small dive plane movements would cause large turning, not only
     // depth changes (by the laws of physics). This trick simulates
     // the stabilizing work of fins
-    Tdr.x = 0.01;
+    T.x = 0.01;
 
     // when stern rudder is not at angle 0, some force points orthogonal to the
     // rudder (stern_depth_rudder.deflect_factor), so less force is available
     // for forward movement of torpedo. So subtract from forward force what does
     // not bypass the rudder.
-    // log_debug("Fdr=" << Fdr << " Tdr=" << Tdr);
-    Fdr.y += finalflowforce - flowforce;
-
-    F += orientation.rotate(Fdr);
-    T += orientation.rotate(Tdr);
+    // log_debug("F=" << F << " T=" << T);
+    F.y += finalflowforce - flowforce;
 }
 
 void torpedo::depth_steering_logic()
@@ -662,28 +814,6 @@ void torpedo::launch(const vector3& launchpos, angle parenthdg)
     turn_velocity = 0;
 }
 
-#if 0
-//fixme beim laden mitbenutzen
-void torpedo::create_sensor_array ( types t )
-{
-	switch ( t )
-	{
-		case T4:	// fixme
-			set_sensor ( passive_sonar_system, new passive_sonar_sensor (
-				passive_sonar_sensor::passive_sonar_type_tt_t5 ) );
-			break;
-		case T5:
-			set_sensor ( passive_sonar_system, new passive_sonar_sensor (
-				passive_sonar_sensor::passive_sonar_type_tt_t5 ) );
-			break;
-		case T11:
-			set_sensor ( passive_sonar_system, new passive_sonar_sensor (
-				passive_sonar_sensor::passive_sonar_type_tt_t11 ) );
-			break;
-	}
-}
-#endif
-
 auto torpedo::get_hit_points() const
     -> unsigned // awful, useless, replace, fixme
 {
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "ship.h"
+#include "torpedo_dynamics.h"
 
 /*
 description and info is per language and class-wide.
@@ -157,6 +158,30 @@ class torpedo : public ship
         NR_SPEEDRANGE_TYPES = 3
     };
 
+    /// how the motion of the torpedo is computed
+    enum dynamics_types
+    {
+        PHYSICS, ///< full physics of ships with voxel buoyancy
+        ANALYTIC ///< simplified model of a submerged torpedo, much faster
+    };
+
+    /// motion model of torpedoes whose spec file does not select one
+    static dynamics_types default_dynamics;
+    /// create the homing sensors of the spec files, without them homing
+    /// torpedoes run straight
+    static bool use_homing_sensors;
+
+    /// compute force and torque of the dive planes in local space, they are
+    /// added to the hull forces of ship. Static, so tests can use it.
+    static void compute_dive_planes_force_and_torque(
+        double mass,
+        double throttle_accel,
+        const generic_rudder& rudder,
+        const generic_rudder& dive_planes,
+        const vector3& local_velocity,
+        vector3& F,
+        vector3& T);
+
   protected:
     friend class sub_torpsetup_display; // to set up values... maybe add get/set
                                         // functions for them
@@ -172,7 +197,9 @@ class torpedo : public ship
     steering_devices steering_device;
     double hp; // horse power of engine
     propulsion_types propulsion_type;
-    double sensor_activation_distance; // meters. unused if torp has no sensors.
+    double sensor_activation_distance{
+        0.0}; // meters. unused if torp has no sensors.
+    dynamics_types dynamics{PHYSICS};
 
     // ------------- configured by the player ------------------
     setup_data setup; // [SAVE]
@@ -183,15 +210,19 @@ class torpedo : public ship
                                             // [SAVE]
     double run_length;              // how long the torpedo has run, [SAVE]
     unsigned steering_device_phase; // [SAVE]
+    double homing_update_time{0.0}; // time until next search for target
 
     /// Vertically acting depth rudder
     generic_rudder dive_planes;
 
-    // specific damage here:
-    //	virtual void create_sensor_array ( types t );
+    /// time between searches for the loudest target of homing torpedoes
+    static constexpr double homing_update_interval = 1.0;
 
     void
     compute_force_and_torque(vector3& F, vector3& T, game& gm) const override;
+    void simulate_analytic(double delta_time, game& gm);
+    [[nodiscard]] torpedo_dynamics::parameters
+    get_dynamics_parameters() const;
     void depth_steering_logic();
     [[nodiscard]] double get_turn_accel_factor() const override
     {
@@ -0,0 +1,105 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// analytic motion of torpedoes
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "torpedo_dynamics.h"
+
+#include "vector2.h"
+
+#include <algorithm>
+#include <cmath>
+
+auto torpedo_dynamics::step(
+    const state& s,
+    double delta_time,
+    double throttle_accel,
+    double rudder_angle,
+    double dive_planes_angle) const -> state
+{
+    const double water_density = 1000.0;
+    // like ship::generic_rudder::deflect_factor/bypass_factor
+    const double rudder_deflect = -sin(rudder_angle * M_PI / 180);
+    const double rudder_bypass  = cos(rudder_angle * M_PI / 180);
+    const double planes_deflect = -sin(dive_planes_angle * M_PI / 180);
+    const double planes_bypass  = cos(dive_planes_angle * M_PI / 180);
+    const double drag_factor =
+        param.max_accel / (param.max_speed * param.max_speed);
+    const double half_length = param.length * 0.5;
+    const double turn_drag   = param.turn_drag_area * half_length
+                             * half_length * half_length * param.turn_drag_coeff
+                             * water_density * 0.125;
+    const double flowforce       = throttle_accel * param.mass;
+    const double planes_flowforce = flowforce * rudder_deflect;
+
+    state result = s;
+    const auto nr_of_steps =
+        unsigned(std::ceil(delta_time / max_step_time - 1e-6));
+    const double h = delta_time / std::max(nr_of_steps, 1U);
+    for (unsigned i = 0; i < nr_of_steps; ++i)
+    {
+        const double vx = result.side_speed;
+        const double vy = result.speed;
+        const double vz = result.vertical_speed;
+        const double w  = result.yaw_velocity;
+        // local force: engine reduced by rudders, rudders and drag
+        const double vy2 =
+            (fabs(vy) < 1.0) ? vy * param.max_speed : vy * fabs(vy);
+        const double rudder_force =
+            (param.rudder_area * water_density * vy * vy + flowforce)
+            * rudder_deflect;
+        const vector3 force(
+            rudder_force - vx * fabs(vx) * param.mass,
+            flowforce * rudder_bypass + planes_flowforce * (planes_bypass - 1.0)
+                - vy2 * drag_factor * param.mass,
+            (param.dive_planes_area * water_density * vy * vy
+             + planes_flowforce)
+                    * planes_deflect
+                - vz * fabs(vz) * 0.2 * param.mass);
+        // torque of rudder and turn drag
+        const double drag_torque = (w * w + fabs(w) * 0.2) * turn_drag;
+        const double torque = -param.rudder_pos * rudder_force
+                              + ((w > 0.0) ? -drag_torque : drag_torque);
+
+        // momenta first, then positions with new velocities. Velocity is
+        // integrated in world space, so turning changes local velocity.
+        const double hr = result.heading * M_PI / 180;
+        const vector2 forward(sin(hr), cos(hr));
+        const vector2 right(forward.y, -forward.x);
+        const vector2 v = forward * (vy + force.y / param.mass * h)
+                          + right * (vx + force.x / param.mass * h);
+        result.vertical_speed += force.z / param.mass * h;
+        result.yaw_velocity += torque / param.yaw_inertia * h;
+        // heading is clockwise, angular velocity is mathematical. The physics
+        // rotates by twice the angle of w (see body_integrator).
+        result.heading -= result.yaw_velocity * h * 360.0 / M_PI;
+        result.position += vector3(v.x, v.y, result.vertical_speed) * h;
+        const double nhr = result.heading * M_PI / 180;
+        const vector2 new_forward(sin(nhr), cos(nhr));
+        result.speed      = v * new_forward;
+        result.side_speed = v * vector2(new_forward.y, -new_forward.x);
+    }
+    result.heading = fmod(result.heading, 360.0);
+    if (result.heading < 0.0)
+    {
+        result.heading += 360.0;
+    }
+    return result;
+}
@@ -0,0 +1,84 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// analytic motion of torpedoes
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "vector3.h"
+
+///\brief Computes torpedo motion without voxel physics.
+/** A torpedo runs fully submerged and is neutrally buoyant, its mass is
+    computed from its volume. So buoyancy and gravity cancel out and only
+    the motion in the horizontal plane and the depth change: thrust and drag
+    drive the speed, the rudder turns the torpedo against turn drag and
+    pushes it sideways, and the dive planes change depth against
+    drag. The forces are the ones of ship::compute_hull_force_and_torque
+    and torpedo::compute_dive_planes_force_and_torque for a torpedo running
+    level, torpedotest compares both. The cost per step is constant.
+*/
+class torpedo_dynamics
+{
+  public:
+    /// run-time constants of a torpedo
+    struct parameters
+    {
+        double mass{1.0};
+        double yaw_inertia{1.0};    ///< moment of inertia around z-axis
+        double length{7.0};         ///< in meters
+        double max_speed{1.0};      ///< in m/s
+        double max_accel{1.0};      ///< in m/s^2
+        double rudder_area{0.0};    ///< in m^2
+        double rudder_pos{0.0};     ///< y-position of rudder, negative
+        double dive_planes_area{0}; ///< in m^2
+        double turn_drag_area{0.0}; ///< side cross section in m^2
+        double turn_drag_coeff{10.0};
+    };
+
+    /// state of torpedo that changes over time
+    struct state
+    {
+        vector3 position;
+        double heading{0.0};        ///< in degrees, clockwise, 0 is north
+        double speed{0.0};          ///< forward speed in m/s
+        double side_speed{0.0};     ///< to the right in m/s, by the rudder
+        double yaw_velocity{0.0};   ///< around z-axis, mathematical, rad/s
+        double vertical_speed{0.0}; ///< in m/s
+    };
+
+    torpedo_dynamics(const parameters& p) : param(p) { }
+
+    /// compute state after delta_time
+    ///@param throttle_accel - acceleration by engine, see get_throttle_accel
+    ///@param rudder_angle - in degrees
+    ///@param dive_planes_angle - in degrees
+    [[nodiscard]] state step(
+        const state& s,
+        double delta_time,
+        double throttle_accel,
+        double rudder_angle,
+        double dive_planes_angle) const;
+
+  protected:
+    parameters param;
+
+    /// longest time step, longer steps are divided
+    static constexpr double max_step_time = 1.0 / 20.0;
+};
@@ -0,0 +1,278 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// analytic torpedo motion compared against rigid body physics
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "body_integrator.h"
+#include "mymain.cpp"
+#include "torpedo.h"
+#include "torpedo_dynamics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const double water_density = 1000.0;
+const double frame_time    = 1.0 / 30.0;
+
+/// values of a G7e torpedo as set up by torpedo::torpedo
+struct test_torpedo
+{
+    double radius         = 0.533 * 0.5;
+    double length         = 7.0;
+    double mass           = M_PI * radius * radius * length * water_density;
+    double max_speed      = 15.4;
+    double max_accel      = 1.0;
+    double rudder_area    = 0.25 * 0.1 * 0.5;
+    double planes_area    = 0.25 * 0.1;
+    double rudder_pos     = -3.5;
+    double max_angle      = 20.0;
+    double max_turn_speed = 40.0;
+    double drag_coeff     = 10.0; ///< torpedo::get_turn_drag_coeff
+
+    [[nodiscard]] matrix3 inertia_tensor() const
+    {
+        // solid cylinder along y-axis
+        const double ixz = mass * (3 * radius * radius + length * length) / 12;
+        return matrix3(ixz, 0, 0, 0, mass * radius * radius / 2, 0, 0, 0, ixz);
+    }
+
+    [[nodiscard]] torpedo_dynamics::parameters parameters() const
+    {
+        torpedo_dynamics::parameters p;
+        p.mass             = mass;
+        p.yaw_inertia      = inertia_tensor().elem(2, 2);
+        p.length           = length;
+        p.max_speed        = max_speed;
+        p.max_accel        = max_accel;
+        p.rudder_area      = rudder_area;
+        p.rudder_pos       = rudder_pos;
+        p.dive_planes_area = planes_area;
+        p.turn_drag_area   = radius * 2 * length;
+        p.turn_drag_coeff  = drag_coeff;
+        return p;
+    }
+
+    [[nodiscard]] ship::hull_parameters hull_parameters() const
+    {
+        ship::hull_parameters hp;
+        hp.mass            = mass;
+        hp.max_speed       = max_speed;
+        hp.max_accel       = max_accel;
+        hp.size            = vector3(radius * 2, length, radius * 2);
+        hp.turn_drag_area  = radius * 2 * length;
+        hp.turn_drag_coeff = drag_coeff;
+        return hp;
+    }
+};
+
+/// a run of a torpedo, commands are given by the steering like in the game
+struct scenario
+{
+    std::string name;
+    double start_speed;
+    double start_depth;
+    double run_depth;
+    double turn_at;    ///< time when the torpedo turns
+    double turn_angle; ///< clockwise, in degrees
+    double duration;
+};
+
+/// what the steering of the torpedo sees
+struct observed_state
+{
+    vector3 position;
+    double heading;        ///< degrees, clockwise
+    double turn_velocity;  ///< degrees per second, mathematical
+    double vertical_speed; ///< local
+};
+
+/// rudder and dive planes as torpedo::torpedo sets them up
+struct controls
+{
+    ship::generic_rudder rudder, planes;
+
+    controls(const test_torpedo& t) :
+        rudder(
+            vector3(0, t.rudder_pos, 0),
+            0,
+            t.max_angle,
+            t.rudder_area,
+            t.max_turn_speed),
+        planes(
+            vector3(0, t.rudder_pos, 0),
+            1,
+            t.max_angle,
+            t.planes_area,
+            t.max_turn_speed)
+    {
+    }
+
+    void steer(
+        const test_torpedo& t,
+        const scenario& sc,
+        double time,
+        const observed_state& o)
+    {
+        // head to course, simplified ship::steering_logic
+        double course = (time >= sc.turn_at) ? sc.turn_angle : 0.0;
+        double error  = fmod(o.heading - course + 540.0, 360.0) - 180.0;
+        rudder.to_angle =
+            t.max_angle
+            * std::clamp(error / 10.0 + o.turn_velocity / 20.0, -1.0, 1.0);
+        // torpedo::depth_steering_logic
+        const double e = o.position.z + sc.run_depth
+                         + t.max_angle / t.max_turn_speed * o.vertical_speed;
+        planes.to_angle = t.max_angle * std::clamp(e, -5.0, 5.0) / 5.0;
+    }
+
+    void simulate(double delta_time)
+    {
+        rudder.simulate(delta_time);
+        planes.simulate(delta_time);
+    }
+};
+
+/// torpedo::compute_force_and_torque for a fully submerged torpedo, where
+/// buoyancy and gravity of the voxels cancel out. Uses the same functions
+/// as the game, so differences between the models are found.
+void compute_force(
+    const test_torpedo& t,
+    const matrix3& inertia_tensor_inv,
+    const controls& c,
+    const body_integrator::state& s,
+    vector3& force,
+    vector3& torque)
+{
+    const quaternion& q = s.orientation;
+    const vector3 v     = q.conj().rotate(s.linear_momentum * (1.0 / t.mass));
+    // like ship::compute_force_and_torque computes it
+    const vector3 w = inertia_tensor_inv * q.conj().rotate(s.angular_momentum);
+    vector3 f, tq, fd, tqd;
+    ship::compute_hull_force_and_torque(
+        t.hull_parameters(), c.rudder, v, w, t.max_accel, f, tq);
+    torpedo::compute_dive_planes_force_and_torque(
+        t.mass, t.max_accel, c.rudder, c.planes, v, fd, tqd);
+    force  = q.rotate(f + fd);
+    torque = q.rotate(tq + tqd);
+}
+
+/// positions at every frame with full rigid body physics, fine steps
+std::vector<vector3> run_physics(const test_torpedo& t, const scenario& sc)
+{
+    const matrix3 inertia_tensor_inv = t.inertia_tensor().inverse();
+    const body_integrator bi(1.0 / t.mass, inertia_tensor_inv);
+    body_integrator::state s;
+    s.position        = vector3(0, 0, -sc.start_depth);
+    s.linear_momentum = vector3(0, sc.start_speed * t.mass, 0);
+    controls c(t);
+    std::vector<vector3> result;
+    const unsigned substeps = 10;
+    for (double time = 0; time < sc.duration; time += frame_time)
+    {
+        for (unsigned i = 0; i < substeps; ++i)
+        {
+            s = bi.step(
+                body_integrator::rk4,
+                s,
+                frame_time / substeps,
+                [&](const body_integrator::state& st, vector3& f, vector3& tq) {
+                    compute_force(t, inertia_tensor_inv, c, st, f, tq);
+                });
+        }
+        const vector3 fw = s.orientation.rotate(vector3(0, 1, 0));
+        const vector3 w  = s.orientation.conj().rotate(bi.angular_velocity(s));
+        observed_state o;
+        o.position      = s.position;
+        o.heading       = atan2(fw.x, fw.y) * 180.0 / M_PI;
+        o.turn_velocity = w.z * 180.0 / M_PI;
+        o.vertical_speed =
+            s.orientation.conj().rotate(s.linear_momentum).z / t.mass;
+        c.steer(t, sc, time, o);
+        c.simulate(frame_time);
+        result.push_back(s.position);
+    }
+    return result;
+}
+
+/// positions at every frame with torpedo_dynamics
+std::vector<vector3> run_analytic(const test_torpedo& t, const scenario& sc)
+{
+    const torpedo_dynamics td(t.parameters());
+    torpedo_dynamics::state s;
+    s.position = vector3(0, 0, -sc.start_depth);
+    s.speed    = sc.start_speed;
+    controls c(t);
+    std::vector<vector3> result;
+    for (double time = 0; time < sc.duration; time += frame_time)
+    {
+        s = td.step(
+            s, frame_time, t.max_accel, c.rudder.angle, c.planes.angle);
+        observed_state o;
+        o.position       = s.position;
+        o.heading        = s.heading;
+        o.turn_velocity  = s.yaw_velocity * 180.0 / M_PI;
+        o.vertical_speed = s.vertical_speed;
+        c.steer(t, sc, time, o);
+        c.simulate(frame_time);
+        result.push_back(s.position);
+    }
+    return result;
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    const test_torpedo t;
+    const scenario scenarios[] = {
+        {"straight run", t.max_speed, 3.0, 3.0, 1e10, 0.0, 60.0},
+        {"acceleration", 2.0, 3.0, 3.0, 1e10, 0.0, 30.0},
+        {"depth change", t.max_speed, 12.0, 3.0, 1e10, 0.0, 30.0},
+        {"FAT turn", t.max_speed, 3.0, 3.0, 20.0, 180.0, 60.0},
+        {"angled shot", t.max_speed, 3.0, 6.0, 0.0, 300.0, 30.0},
+    };
+    // deviation allowed in meters, relative to run length
+    const double tolerance = 0.01;
+    bool ok                = true;
+    for (const auto& sc : scenarios)
+    {
+        const auto p = run_physics(t, sc);
+        const auto a = run_analytic(t, sc);
+        double max_dist = 0, max_depth = 0, run = 0;
+        for (unsigned i = 0; i < p.size(); ++i)
+        {
+            max_dist  = std::max(max_dist, p[i].xy().distance(a[i].xy()));
+            max_depth = std::max(max_depth, fabs(p[i].z - a[i].z));
+            run += (i > 0) ? p[i].distance(p[i - 1]) : 0.0;
+        }
+        const bool good =
+            max_dist <= run * tolerance && max_depth <= run * tolerance;
+        std::cout << sc.name << ": run " << run
+                  << "m, max deviation horizontal " << max_dist
+                  << "m, depth " << max_depth << "m"
+                  << (good ? "" : ", TOO LARGE!") << "\n";
+        ok = ok && good;
+    }
+    return ok ? 0 : -1;
+}
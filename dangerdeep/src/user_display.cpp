@@ -22,6 +22,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "user_display.h"
 
+#include "display_asset_cache.h"
+#include "log.h"
 #include "system_interface.h"
 #include "user_interface.h"
 #include "xml.h"
@@ -237,6 +239,11 @@ void user_display::elem2D::draw() const
 {
     if (!tex.empty() && visible)
     {
+        update_textures();
+        if (!tex[phase])
+        {
+            return; // still loading
+        }
         if (rotateable)
         {
             // rotation around pixel center (offset +0.5) could be sensible but
@@ -276,9 +283,10 @@ auto user_display::elem2D::is_mouse_over(const vector2i& pos, int tolerance)
             pos.x + tolerance >= center.x - click_radius
             && pos.y + tolerance >= center.y - click_radius
             && pos.x - tolerance
-                   < center.x + click_radius + int(tex[phase]->get_width())
+                   < center.x + click_radius + int(get_texture().get_width())
             && pos.y - tolerance
-                   < center.y + click_radius + int(tex[phase]->get_height()));
+                   < center.y + click_radius
+                         + int(get_texture().get_height()));
     }
     else if (tex.empty())
     {
@@ -291,32 +299,95 @@ auto user_display::elem2D::is_mouse_over(const vector2i& pos, int tolerance)
     {
         return (
             pos.x + tolerance >= position.x && pos.y + tolerance >= position.y
-            && pos.x - tolerance < position.x + int(tex[phase]->get_width())
-            && pos.y - tolerance < position.y + int(tex[phase]->get_height()));
+            && pos.x - tolerance < position.x + int(get_texture().get_width())
+            && pos.y - tolerance
+                   < position.y + int(get_texture().get_height()));
     }
 }
 
 void user_display::elem2D::init(bool is_day)
 {
-    // init all textures
+    // request all textures, the ones not in the cache are loaded in background
+    tex_filenames = get_filenames(is_day);
+    auto& cache   = display_asset_cache::instance();
     for (auto i = 0U; i < nr_of_phases(); ++i)
     {
-        tex[i] = std::make_unique<texture>(
-            (is_day || !has_night || filenames_night[i].empty())
-                ? filenames_day[i]
-                : filenames_night[i],
-            texture::LINEAR);
+        tex[i] = cache.try_get(tex_filenames[i]);
     }
     // Determine size from image if there is one (only use first phase for size)
-    if (!tex.empty())
+    size_from_texture = !tex.empty();
+    update_textures();
+}
+
+auto user_display::elem2D::get_filenames(bool is_day) const
+    -> std::vector<std::string>
+{
+    std::vector<std::string> result(nr_of_phases());
+    for (auto i = 0U; i < nr_of_phases(); ++i)
+    {
+        result[i] = (is_day || !has_night || filenames_night[i].empty())
+                        ? filenames_day[i]
+                        : filenames_night[i];
+    }
+    return result;
+}
+
+void user_display::elem2D::update_textures() const
+{
+    for (auto i = 0U; i < nr_of_phases(); ++i)
+    {
+        if (!tex[i] && i < tex_filenames.size() && !tex_filenames[i].empty())
+        {
+            try
+            {
+                tex[i] =
+                    display_asset_cache::instance().try_get(tex_filenames[i]);
+            }
+            catch (std::exception& e)
+            {
+                // Missing files are reported by init(), so only images that
+                // could not be decoded come here, while drawing. Do not try
+                // them again every frame.
+                log_warning("Display image not shown: " << e.what());
+                tex_filenames[i].clear();
+            }
+        }
+    }
+    if (size_from_texture && tex[0])
     {
         size = {int(tex[0]->get_width()), int(tex[0]->get_height())};
+        size_from_texture = false;
+    }
+}
+
+void user_display::elem2D::wait_for_texture(unsigned phase_) const
+{
+    if (!tex[phase_])
+    {
+        tex[phase_] =
+            display_asset_cache::instance().get(tex_filenames[phase_]);
+        update_textures();
+    }
+}
+
+auto user_display::elem2D::get_texture() const -> const texture&
+{
+    wait_for_texture(phase);
+    return *tex[phase];
+}
+
+auto user_display::elem2D::get_size() const -> vector2i
+{
+    if (size_from_texture)
+    {
+        wait_for_texture(0);
     }
+    return size;
 }
 
 void user_display::elem2D::deinit()
 {
-    // delete all textures
+    // release all textures, they stay in the cache for later use
     for (auto i = 0U; i < nr_of_phases(); ++i)
     {
         tex[i] = nullptr;
@@ -441,3 +512,14 @@ void user_display::leave()
         e.deinit();
     }
 }
+
+void user_display::prefetch(bool is_day) const
+{
+    std::vector<std::string> filenames;
+    for (auto& e : elements)
+    {
+        auto fns = e.get_filenames(is_day);
+        filenames.insert(filenames.end(), fns.begin(), fns.end());
+    }
+    display_asset_cache::instance().prefetch(filenames);
+}
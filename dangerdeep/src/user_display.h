@@ -51,13 +51,17 @@ class user_display : public input_event_handler
         void set_phase(unsigned phase_) const;
         /// Draw element (rotated/phased if defined)
         void draw() const;
-        /// Get texture for user defined drawing
-        auto& get_texture() const { return *tex[phase]; }
+        /// Get texture for user defined drawing, waits for image loading
+        const texture& get_texture() const;
         /// Is Mouse over element? Does not check for rotation, just uses 2D
         /// area.
         bool is_mouse_over(const vector2i& mpos, int tolerance = 0) const;
-        /// Initialize texture
+        /// Initialize texture, images that are not cached yet are loaded in
+        /// background and drawn when ready. Throws file_read_error if an
+        /// image file does not exist.
         void init(bool is_day);
+        /// Get file names of images used for day or night
+        std::vector<std::string> get_filenames(bool is_day) const;
         /// Deinitialize texture
         void deinit();
         /// Get position
@@ -97,15 +101,16 @@ class user_display : public input_event_handler
             bool day       = true,
             unsigned phase = 0);
         /// Get size - only valid after initialization or when defined in
-        /// layout!
-        auto get_size() const { return size; }
+        /// layout! Waits for image loading.
+        vector2i get_size() const;
 
       protected:
         int id{-1};        ///< ID for manipulation
         vector2i position; ///< Position (left/top) of the element on screen
         vector2i
             center;    ///< Center of the element on screen (used for rotation)
-        vector2i size; ///< Size used when no image exists (click only)
+        mutable vector2i
+            size; ///< Size used when no image exists (click only)
         bool rotateable{false};    ///< Is this a rotateable element?
         bool clockwise{true};      ///< Is rotation clockwise (default)?
         bool has_night{false};     ///< Does night image data exist?
@@ -134,9 +139,20 @@ class user_display : public input_event_handler
         // std::vector<image> data_night;		///< Image data for night
         // (optional) std::vector<gpu::texture> tex;		///< Texture data
         // (only used when display is active!)
-        std::vector<std::unique_ptr<texture>>
-            tex; ///< Texture data (only used when display is active!) //
-                 ///< obsolete with new gpu interface
+        mutable std::vector<std::shared_ptr<texture>>
+            tex; ///< Texture data (only used when display is active!), empty
+                 ///< entries are still loading // obsolete with new gpu
+                 ///< interface
+        mutable std::vector<std::string>
+            tex_filenames; ///< Files of textures in use, set by init, cleared
+                           ///< for images that failed to load
+        mutable bool size_from_texture{false}; ///< size must be taken from
+                                               ///< first texture when ready
+
+        /// Fetch textures that are loaded by now
+        void update_textures() const;
+        /// Wait for texture of phase to be loaded
+        void wait_for_texture(unsigned phase) const;
 
         double get_angle_range()
             const; ///< Compute range of angles between start and end
@@ -155,6 +171,10 @@ class user_display : public input_event_handler
     /// images
     virtual void leave();
 
+    /// start loading images of this display in background, called when the
+    /// display is likely to be entered soon
+    virtual void prefetch(bool is_day) const;
+
   protected:
     // common functions: draw_infopanel(class game& gm)
     user_display(
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "airplane.h"
 #include "depth_charge.h"
+#include "display_asset_cache.h"
 #include "game.h"
 #include "gun_shell.h"
 #include "model.h"
@@ -39,6 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "vector3.h"
 #include "widget.h"
 
+#include <algorithm>
 #include <glu.h>
 #include <iomanip>
 #include <iostream>
@@ -52,9 +54,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "keys.h"
 #include "log.h"
 #include "matrix4.h"
+#include "memory_usage.h"
 #include "music.h"
 #include "particle.h"
 #include "primitives.h"
+#include "profiler.h"
 #include "sky.h"
 #include "water.h"
 using namespace std;
@@ -67,6 +71,8 @@ const double message_fadeout_time = 2;
 
 #define MAX_PANEL_SIZE 256
 
+bool user_interface::show_memory_usage = false;
+
 /*
     a note on our coordinate system (11/10/2003):
     We simulate earth by projecting objects according to curvature from earth
@@ -445,6 +451,8 @@ auto user_interface::create(game& gm) -> std::shared_ptr<user_interface>
 user_interface::~user_interface()
 {
     particle::deinit();
+    // free cached display images while OpenGL is still available
+    display_asset_cache::destroy_instance();
 }
 
 auto user_interface::get_water() const -> const water&
@@ -487,6 +495,7 @@ void user_interface::add_elevation(angle a)
 
 void user_interface::display() const
 {
+    PROFILE_ZONE("user_interface::display");
     // fixme: brightness needs sun_pos, so compute_sun_pos() is called multiple
     // times per frame but is very costly. we could cache it.
     mygame->get_water().set_refraction_color(
@@ -522,6 +531,32 @@ void user_interface::display() const
         main_menu->draw();
         SYS().unprepare_2d_drawing();
     }
+
+    // draw memory usage if requested
+    if (show_memory_usage)
+    {
+        SYS().prepare_2d_drawing();
+        int y = 64;
+        for (const auto& line : memory_usage::get_report_lines())
+        {
+            font_vtremington12->print(704, y, line, color::white(), true);
+            y += int(font_vtremington12->get_height());
+        }
+        SYS().unprepare_2d_drawing();
+    }
+
+    // draw profiler statistics if measuring
+    if (profiler::is_enabled())
+    {
+        SYS().prepare_2d_drawing();
+        int y = 64;
+        for (const auto& line : profiler::instance().get_overlay_lines())
+        {
+            font_vtremington12->print(8, y, line, color::white(), true);
+            y += int(font_vtremington12->get_height());
+        }
+        SYS().unprepare_2d_drawing();
+    }
 }
 
 void user_interface::set_time(double tm)
@@ -934,6 +969,19 @@ void user_interface::draw_infopanel(bool onlytexts) const
         panel->draw();
     }
 
+    // object culling statistics for tuning
+    if (cfg::instance().getb("debug"))
+    {
+        ostringstream os;
+        os << "objects drawn " << objects_drawn << " culled "
+           << objects_culled;
+        const int x = int(SYS().get_res_x_2d())
+                      - font_vtremington12->get_size(os.str()).x;
+        const int y = (onlytexts ? SYS().get_res_y_2d() : panel->get_pos().y)
+                      - font_vtremington12->get_height();
+        font_vtremington12->print(x, y, os.str(), color::white(), true);
+    }
+
     // draw messages: fixme later move to separate function ?
     double vanish_time = mygame->get_time() - message_vanish_time;
     int y              = (onlytexts ? SYS().get_res_y_2d() : panel->get_pos().y)
@@ -1023,7 +1071,8 @@ void user_interface::set_current_display(unsigned curdis)
         mygame->freeze_time();
     }
     displays[current_display]->leave();
-    current_display = curdis;
+    const unsigned previous_display = current_display;
+    current_display                 = curdis;
 
     // clear both screen buffers
     glClearColor(0, 0, 0, 0);
@@ -1033,6 +1082,7 @@ void user_interface::set_current_display(unsigned curdis)
     SYS().finish_frame();
 
     displays[current_display]->enter(daymode);
+    prefetch_likely_displays(previous_display);
     if (mygame)
     {
         mygame->unfreeze_time();
@@ -1050,6 +1100,59 @@ void user_interface::set_current_display(unsigned curdis)
     }
 }
 
+void user_interface::prefetch_likely_displays(unsigned previous_display)
+{
+    // number of displays to prefetch besides the previous one
+    const unsigned nr_candidates = 2;
+    if (display_switch_counts.size() != displays.size())
+    {
+        display_switch_counts.assign(
+            displays.size(), std::vector<unsigned>(displays.size(), 0));
+    }
+    ++display_switch_counts[previous_display][current_display];
+
+    // going back is likely, then the displays most often chosen from here.
+    // Without statistics yet, neighbours in display order are taken.
+    std::vector<unsigned> candidates(1, previous_display);
+    const auto& counts = display_switch_counts[current_display];
+    std::vector<unsigned> order(displays.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return counts[a] > counts[b];
+    });
+    for (unsigned i : order)
+    {
+        if (candidates.size() > nr_candidates || counts[i] == 0)
+        {
+            break;
+        }
+        if (i != current_display && i != previous_display)
+        {
+            candidates.push_back(i);
+        }
+    }
+    for (unsigned d = 1;
+         candidates.size() <= nr_candidates && d < displays.size();
+         ++d)
+    {
+        const unsigned i = (current_display + d) % unsigned(displays.size());
+        if (i != previous_display)
+        {
+            candidates.push_back(i);
+        }
+    }
+    for (unsigned i : candidates)
+    {
+        if (displays[i])
+        {
+            displays[i]->prefetch(daymode);
+        }
+    }
+}
+
 void user_interface::playlist_mode_changed()
 {
     if (playlist_repeat_checkbox->is_checked())
@@ -84,6 +84,10 @@ class user_interface : public input_event_handler
     /// out over time.
     std::list<std::pair<double, std::string>> messages;
 
+    /// number of 3d objects drawn/culled in last frame, shown in debug mode
+    unsigned objects_drawn{0};
+    unsigned objects_culled{0};
+
     // used in various screens
     angle bearing;
     angle elevation;          // -90...90 deg (look down ... up)
@@ -98,6 +102,10 @@ class user_interface : public input_event_handler
     // fixme must be std::vector<std::shared_ptr<user_display>> displays to
     // register them as input event handlers!
 
+    // how often the user switched from one display to another, used to
+    // guess which displays will be entered next and prefetch their images.
+    std::vector<std::vector<unsigned>> display_switch_counts;
+
     // which popup is shown (0 = none)
     unsigned current_popup;
 
@@ -145,6 +153,9 @@ class user_interface : public input_event_handler
     // performed autom.
     void set_current_display(unsigned curdis);
 
+    // let likely next displays load their images in background
+    void prefetch_likely_displays(unsigned previous_display);
+
     virtual void playlist_mode_changed();
     virtual void playlist_mute();
 
@@ -170,6 +181,9 @@ class user_interface : public input_event_handler
     // create ui matching to player type (requested from game)
     static std::shared_ptr<user_interface> create(game& gm);
 
+    /// show memory used by subsystems over the display
+    static bool show_memory_usage;
+
     [[nodiscard]] const sky& get_sky() const { return *(mysky.get()); }
     [[nodiscard]] const caustics& get_caustics() const { return mycaustics; }
     [[nodiscard]] const water& get_water() const;
@@ -186,6 +200,12 @@ class user_interface : public input_event_handler
 
     // 2d drawing must be on for this
     void draw_infopanel(bool onlytexts = false) const;
+    /// set statistics of 3d object culling for display in info panel
+    void set_object_culling_counts(unsigned drawn, unsigned culled)
+    {
+        objects_drawn  = drawn;
+        objects_culled = culled;
+    }
 
     // render red triangle for target in view. give viewport coordinates.
     virtual void
@@ -1,13 +1,16 @@
 
 #pragma once
 
-#define DANGERDEEP_VERSION_MAJOR        0
-#define DANGERDEEP_VERSION_MINOR        4
-#define DANGERDEEP_VERSION_PATCH        0
-#define DANGERDEEP_VERSION_RELEASE_TYPE dev
+#define DANGERDEEP_VERSION_MAJOR            0
+#define DANGERDEEP_VERSION_MINOR            4
+#define DANGERDEEP_VERSION_PATCH            0
+#define DANGERDEEP_VERSION_RELEASE_TYPE     dev
 
-#define DANGERDEEP_VERSION                                                     \
-    DANGERDEEP_VERSION_MAJOR * 10000 + DANGERDEEP_VERSION_MINOR * 100          \
-        + DANGERDEEP_VERSION_PATCH
+#define DANGERDEEP_VERSION                  \
+    DANGERDEEP_VERSION_MAJOR * 10000 +      \
+    DANGERDEEP_VERSION_MINOR * 100 +        \
+    DANGERDEEP_VERSION_PATCH
+
+#define DANGERDEEP_VERSION_STRING           \
+    "0.4.0.dev"
 
-#define DANGERDEEP_VERSION_STRING "0.4.0.dev"
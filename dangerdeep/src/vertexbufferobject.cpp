@@ -30,7 +30,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 vertexbufferobject::vertexbufferobject(bool indexbuffer) :
     target(indexbuffer ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER)
 {
-    glGenBuffers(1, &id);
+    // the buffer is created with its data, so objects can be constructed
+    // without OpenGL context when they are never displayed.
 }
 
 vertexbufferobject::~vertexbufferobject()
@@ -39,11 +40,18 @@ vertexbufferobject::~vertexbufferobject()
     {
         unmap();
     }
-    glDeleteBuffers(1, &id);
+    if (id != 0)
+    {
+        glDeleteBuffers(1, &id);
+    }
 }
 
 void vertexbufferobject::init_data(unsigned size_, const void* data, int usage)
 {
+    if (id == 0)
+    {
+        glGenBuffers(1, &id);
+    }
     size = size_;
     bind();
     glBufferData(target, size, data, usage);
@@ -0,0 +1,129 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// traversal of voxel grids along line segments
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "vector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///\brief Visits all voxels of a grid that a line segment crosses, in order.
+/** This is the exact traversal of Amanatides and Woo ("A Fast Voxel
+    Traversal Algorithm for Ray Tracing"). Coordinates are given in voxel
+    space, where voxel (x,y,z) covers [x,x+1)*[y,y+1)*[z,z+1) and the grid
+    covers [0,resolution). The segment is clipped to the grid first, then
+    every step moves to the neighbour voxel where the segment leaves the
+    current one, so no voxel is tested twice and none is missed.
+    @param start - start of segment in voxel space
+    @param end - end of segment in voxel space
+    @param resolution - number of voxels of grid per axis
+    @param visit - called as visit(vector3i voxel, double t) with t in [0,1]
+           where the segment enters the voxel. Return true to stop.
+    @returns true if visit stopped the traversal
+*/
+template<typename F>
+bool traverse_voxels(
+    const vector3& start,
+    const vector3& end,
+    const vector3i& resolution,
+    F visit)
+{
+    const double p[3] = {start.x, start.y, start.z};
+    const double d[3] = {end.x - start.x, end.y - start.y, end.z - start.z};
+    const int res[3]  = {resolution.x, resolution.y, resolution.z};
+    const double inf  = std::numeric_limits<double>::infinity();
+
+    double tmin = 0.0, tmax = 1.0;
+    // clip segment with grid box
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (d[i] == 0.0)
+        {
+            if (p[i] < 0.0 || p[i] >= res[i])
+            {
+                return false;
+            }
+            continue;
+        }
+        const double t0 = -p[i] / d[i];
+        const double t1 = (res[i] - p[i]) / d[i];
+        tmin            = std::max(tmin, std::min(t0, t1));
+        tmax            = std::min(tmax, std::max(t0, t1));
+    }
+    if (tmin > tmax)
+    {
+        return false;
+    }
+
+    // entry voxel and per axis: step direction, t of next voxel border and
+    // t to cross a whole voxel.
+    int v[3], step[3];
+    double tnext[3], tdelta[3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        // the entry point can lie on the upper border because of clipping
+        v[i] = std::clamp(int(std::floor(p[i] + d[i] * tmin)), 0, res[i] - 1);
+        if (d[i] > 0.0)
+        {
+            step[i]   = 1;
+            tnext[i]  = (v[i] + 1 - p[i]) / d[i];
+            tdelta[i] = 1.0 / d[i];
+        }
+        else if (d[i] < 0.0)
+        {
+            step[i]   = -1;
+            tnext[i]  = (v[i] - p[i]) / d[i];
+            tdelta[i] = -1.0 / d[i];
+        }
+        else
+        {
+            step[i]   = 0;
+            tnext[i]  = inf;
+            tdelta[i] = inf;
+        }
+    }
+
+    double t = tmin;
+    while (true)
+    {
+        if (visit(vector3i(v[0], v[1], v[2]), t))
+        {
+            return true;
+        }
+        // advance along axis with nearest voxel border
+        unsigned a = (tnext[0] < tnext[1]) ? 0 : 1;
+        a          = (tnext[2] < tnext[a]) ? 2 : a;
+        if (tnext[a] > tmax)
+        {
+            return false;
+        }
+        t = tnext[a];
+        v[a] += step[a];
+        if (v[a] < 0 || v[a] >= res[a])
+        {
+            return false;
+        }
+        tnext[a] += tdelta[a];
+    }
+}
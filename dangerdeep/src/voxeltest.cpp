@@ -0,0 +1,180 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// voxel traversal compared against sampling the segment
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "mymain.cpp"
+#include "voxel_traversal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+const unsigned nr_of_samples = 100000;
+const double tolerance       = 1e-9;
+
+/// a grid with randomly filled voxels, like the voxel data of a model
+struct test_grid
+{
+    vector3i resolution;
+    std::vector<bool> filled;
+
+    [[nodiscard]] unsigned index(const vector3i& v) const
+    {
+        return (v.z * resolution.y + v.y) * resolution.x + v.x;
+    }
+
+    [[nodiscard]] bool is_inside(const vector3i& v) const
+    {
+        return v.x >= 0 && v.y >= 0 && v.z >= 0 && v.x < resolution.x
+               && v.y < resolution.y && v.z < resolution.z;
+    }
+};
+
+/// brute force: sample the segment densely, give visited voxels in order
+std::vector<vector3i> sample_segment(
+    const test_grid& g,
+    const vector3& a,
+    const vector3& b,
+    std::vector<double>& ts)
+{
+    std::vector<vector3i> result;
+    for (unsigned i = 0; i <= nr_of_samples; ++i)
+    {
+        const double t  = double(i) / nr_of_samples;
+        const vector3 p = a + (b - a) * t;
+        const vector3i v(
+            int(std::floor(p.x)), int(std::floor(p.y)), int(std::floor(p.z)));
+        if (g.is_inside(v) && (result.empty() || !(result.back() == v)))
+        {
+            result.push_back(v);
+            ts.push_back(t);
+        }
+    }
+    return result;
+}
+
+/// check if point is inside voxel or on its border
+bool is_in_voxel(const vector3& p, const vector3i& v)
+{
+    return p.x >= v.x - tolerance && p.x <= v.x + 1 + tolerance
+           && p.y >= v.y - tolerance && p.y <= v.y + 1 + tolerance
+           && p.z >= v.z - tolerance && p.z <= v.z + 1 + tolerance;
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    std::mt19937 gen(4711);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    unsigned nr_of_errors = 0, nr_of_hits = 0, nr_of_tests = 0;
+    double max_hit_distance = 0.0;
+    for (unsigned test = 0; test < 2000; ++test)
+    {
+        test_grid g;
+        g.resolution =
+            vector3i(2 + gen() % 30, 2 + gen() % 60, 2 + gen() % 20);
+        g.filled.resize(g.resolution.x * g.resolution.y * g.resolution.z);
+        for (unsigned i = 0; i < g.filled.size(); ++i)
+        {
+            g.filled[i] = unit(gen) < 0.05;
+        }
+        // segments start and end inside or outside of the grid
+        auto random_point = [&]() {
+            return vector3(
+                (unit(gen) * 1.6 - 0.3) * g.resolution.x,
+                (unit(gen) * 1.6 - 0.3) * g.resolution.y,
+                (unit(gen) * 1.6 - 0.3) * g.resolution.z);
+        };
+        vector3 a = random_point(), b = random_point();
+        if (test % 10 == 0)
+        {
+            // axis parallel segments on voxel borders are a special case
+            a.y = b.y = std::floor(a.y);
+            a.z = b.z;
+        }
+        ++nr_of_tests;
+
+        // all voxels, entry points must lie in the voxels
+        std::vector<vector3i> visited;
+        bool ok = true;
+        traverse_voxels(a, b, g.resolution, [&](const vector3i& v, double t) {
+            ok = ok && is_in_voxel(a + (b - a) * t, v);
+            visited.push_back(v);
+            return false;
+        });
+        // every sampled voxel must be visited in the same order, voxels that
+        // are only touched between two samples may be visited additionally.
+        std::vector<double> ts;
+        const auto sampled = sample_segment(g, a, b, ts);
+        unsigned j         = 0;
+        for (const auto& v : visited)
+        {
+            if (j < sampled.size() && sampled[j] == v)
+            {
+                ++j;
+            }
+        }
+        ok = ok && j == sampled.size();
+
+        // first filled voxel and its entry point
+        double hit_t = -1.0;
+        vector3i hit_v;
+        traverse_voxels(a, b, g.resolution, [&](const vector3i& v, double t) {
+            if (!g.filled[g.index(v)])
+            {
+                return false;
+            }
+            hit_t = t;
+            hit_v = v;
+            return true;
+        });
+        for (unsigned i = 0; i < sampled.size(); ++i)
+        {
+            if (g.filled[g.index(sampled[i])])
+            {
+                // sampling finds the hit later than the exact entry point
+                ok = ok && hit_t >= 0.0 && hit_t <= ts[i] + tolerance;
+                if (hit_v == sampled[i])
+                {
+                    const double dist = (b - a).length() * (ts[i] - hit_t);
+                    max_hit_distance  = std::max(max_hit_distance, dist);
+                    ok = ok && dist <= (b - a).length() / nr_of_samples * 1.01;
+                    ++nr_of_hits;
+                }
+                break;
+            }
+        }
+        if (!ok)
+        {
+            std::cout << "Test " << test << " failed, segment " << a << " -> "
+                      << b << " grid " << g.resolution << "\n";
+            ++nr_of_errors;
+        }
+    }
+    std::cout << nr_of_tests << " segments tested, " << nr_of_hits
+              << " hits, max distance of hit position to sampled position "
+              << max_hit_distance << ", " << nr_of_errors << " errors.\n";
+    return nr_of_errors == 0 ? 0 : -1;
+}
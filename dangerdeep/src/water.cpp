@@ -35,7 +35,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "oglext/OglExt.h"
 #include "polygon.h"
 #include "primitives.h"
+#include "profiler.h"
 #include "system_interface.h"
+#include "task_scheduler.h"
 #include "texture.h"
 #include "water.h"
 
@@ -46,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <memory>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using std::list;
 using std::ofstream;
@@ -144,14 +147,17 @@ static auto cmpdtl(int x) -> unsigned
     return nextgteqpow2(unsigned(x));
 }
 
+bool water::use_runtime_synthesis = false;
+
 water::water(double tm) :
     mytime(tm), wave_phases(cfg::instance().geti("wave_phases")),
     wavetile_length(cfg::instance().getf("wavetile_length")),
     wavetile_length_rcp(1.0f / wavetile_length),
     wave_tidecycle_time(cfg::instance().getf("wave_tidecycle_time")),
-    last_light_color(-1, -1, -1),
+    runtime_synthesis(use_runtime_synthesis), last_light_color(-1, -1, -1),
     wave_resolution(nextgteqpow2(cfg::instance().geti("wave_fft_res"))),
-    wave_resolution_shift(ulog2(wave_resolution)), wavetile_data(wave_phases),
+    wave_resolution_shift(ulog2(wave_resolution)),
+    wavetile_data(runtime_synthesis ? 2 : wave_phases),
 
     owg(wave_resolution,
         vector2f(1, 1),          // wind direction
@@ -162,7 +168,7 @@ water::water(double tm) :
                                                  // depends on wave resolution,
                                                  // maybe also on tidecycle time
         wavetile_length,
-        wave_tidecycle_time),
+        runtime_synthesis ? runtime_cycle_time : wave_tidecycle_time),
 
     geoclipmap_resolution(
         cmpdtl(cfg::instance().geti("water_detail"))), // should be power of two
@@ -421,24 +427,53 @@ water::water(double tm) :
       (self-similar noise). With on-the-fly fft we could give a cyclic value of
       1-2 minutes. Just blend the fft coefficients between two levels for
       weather changes, like with the clouds.
+      This is done when use_runtime_synthesis is set.
     */
 
-    // multithreaded construction of water data (faster).
-    // spawn 1 more thread (or 3 on 4-core cpus, but two threads are already
-    // fast enough)
-    thread::ptr<worker> myworker;
-    if (true /* construction multithreaded */)
+    for (float& k : foam_rndtab)
     {
-        myworker.reset(new worker(*this, 1, 2));
-        myworker->start();
-        construction_threaded(owg, 0, 2);
-        myworker.reset();
+        k = rnd();
     }
-    else
+
+    if (runtime_synthesis)
+    {
+        // compute first phase now, the thread computes the next ones
+        synth.reset(new synthesizer(*this));
+        synth->generate(mytime, wavetile_data[0]);
+        curr_wtp = &wavetile_data[0];
+        // the second phase is filled by the thread with the same sizes
+        phase_memory.set(2 * wavetile_data[0].get_memory_used());
+        generate_subdetail_texture();
+        last_time = mytime;
+        synth->start();
+        add_loading_screen("water created");
+        set_time(mytime);
+        return;
+    }
+
+    // multithreaded construction of water data (faster). Every part needs
+    // its own wave generator, they are copied here, because creating FFT
+    // plans is not thread safe.
+    const unsigned nr_of_parts = task_scheduler::instance().get_nr_of_threads();
+    std::vector<ocean_wave_generator<float>> owgs(nr_of_parts, owg);
+    task_group construction;
+    for (unsigned i = 0; i < nr_of_parts; ++i)
     {
-        construction_threaded(owg, 0, 1);
+        construction.run([this, &owgs, i, nr_of_parts]() {
+            generate_wavetiles(
+                owgs[i],
+                wave_phases * i / nr_of_parts,
+                wave_phases * (i + 1) / nr_of_parts);
+        });
     }
+    construction.wait();
     add_loading_screen("water height data computed");
+    size_t bytes = 0;
+    for (const auto& wtp : wavetile_data)
+    {
+        bytes += wtp.get_memory_used();
+    }
+    phase_memory.set(bytes);
 
     // set up curr_wtp and subdetail
     curr_wtp = nullptr;
@@ -451,12 +486,92 @@ water::water(double tm) :
     set_time(mytime);
 }
 
-void water::construction_threaded(
+water::~water()
+{
+    // stop synthesis before the phases are freed
+    synth.reset();
+}
+
+auto water::wavetile_phase::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = 0;
+    for (const auto& m : mipmaps)
+    {
+        bytes += memory_of(m.wavedata) + memory_of(m.normals)
+                 + memory_of(m.amount_of_foam) + memory_of(m.normals_tex);
+    }
+    return bytes;
+}
+
+water::synthesizer::synthesizer(water& w) :
+    thread("watersyn"), wa(w), owg(w.owg), wind_direction(w.wind_direction),
+    wind_speed(w.wind_speed)
+{
+}
+
+void water::synthesizer::loop()
+{
+    double tm          = 0;
+    wavetile_phase* wtp = nullptr;
+    bool wind_changed  = false;
+    {
+        std::unique_lock<std::mutex> ml(wa.synth_mutex);
+        wa.synth_cond.wait(ml, [this]() {
+            return wa.synth_requested || abort_requested();
+        });
+        if (abort_requested())
+        {
+            return;
+        }
+        tm  = wa.synth_time;
+        wtp = &wa.wavetile_data[wa.synth_phase];
+        if (wind_direction != wa.wind_direction
+            || wind_speed != wa.wind_speed)
+        {
+            wind_direction = wa.wind_direction;
+            wind_speed     = wa.wind_speed;
+            wind_changed   = true;
+        }
+    }
+    // compute without holding the lock, the main thread shows the other phase
+    if (wind_changed)
+    {
+        owg.set_wind(wind_direction, wind_speed);
+    }
+    generate(tm, *wtp);
+    std::unique_lock<std::mutex> ml(wa.synth_mutex);
+    wa.synth_requested = false;
+    wa.synth_ready     = true;
+}
+
+void water::synthesizer::request_abort()
+{
+    std::unique_lock<std::mutex> ml(wa.synth_mutex);
+    ::thread::request_abort();
+    wa.synth_cond.notify_all();
+}
+
+void water::synthesizer::generate(double tm, wavetile_phase& wtp)
+{
+    wa.generate_wavetile(owg, helper::mod(tm, runtime_cycle_time), wtp);
+    // foam spawns and decays with time like between precomputed phases
+    double steps = 1.0;
+    if (foam_time >= 0.0)
+    {
+        steps = (tm - foam_time) * wa.wave_phases / wa.wave_tidecycle_time;
+        steps = std::max(0.0, std::min(steps, double(wa.wave_phases)));
+    }
+    foam_time = tm;
+    wa.add_amount_of_foam(foam, wtp.mipmaps[0].wavedata, steps);
+    wa.store_amount_of_foam(foam, wtp);
+}
+
+void water::generate_wavetiles(
     ocean_wave_generator<float>& myowg,
-    unsigned phase_start,
-    unsigned phase_add)
+    unsigned first_phase,
+    unsigned last_phase)
 {
-    for (unsigned i = phase_start; i < wave_phases; i += phase_add)
+    for (unsigned i = first_phase; i < last_phase; ++i)
     {
         generate_wavetile(
             myowg, wave_tidecycle_time * i / wave_phases, wavetile_data[i]);
@@ -627,7 +742,7 @@ void water::draw_foam_for_ship(
     double tm = gm.get_time();
 
     // draw foam caused by trail.
-    const list<ship::prev_pos>& prevposn = shp->get_previous_positions();
+    const ship::trail_buffer& prevposn = shp->get_previous_positions();
     // can render strip of quads only when more than one position is stored.
     if (prevposn.empty())
     {
@@ -812,6 +927,7 @@ void water::display(
     double max_view_dist,
     bool under_water) const
 {
+    PROFILE_ZONE("water::display");
     // get projection and modelview matrix
     matrix4 proj                 = matrix4::get_gl(GL_PROJECTION_MATRIX);
     matrix4 modl                 = matrix4::get_gl(GL_MODELVIEW_MATRIX);
@@ -1220,8 +1336,9 @@ void water::generate_wavetile(
     double tiletime,
     wavetile_phase& wtp)
 {
+    // tiletime is within the cycle time of the generator
     vector<float> heights;
-    myowg.set_time(helper::mod(tiletime, wave_tidecycle_time));
+    myowg.set_time(tiletime);
     myowg.compute_heights(heights);
     wtp.minh = 1e10;
     wtp.maxh = -1e10;
@@ -1316,6 +1433,7 @@ void water::generate_wavetile(
 #endif
 
     unsigned mipmap_levels = wave_resolution_shift;
+    wtp.mipmaps.clear(); // phases are reused with runtime synthesis
     wtp.mipmaps.reserve(mipmap_levels);
     double L = wavetile_length / wave_resolution;
     wtp.mipmaps.emplace_back(displacements, heights, wave_resolution_shift, L);
@@ -1341,115 +1459,15 @@ void water::compute_amount_of_foam()
 {
     // compute amount of foam per vertex sample
     vector<float> aof(wave_resolution * wave_resolution);
-
-    float rndtab[37];
-    for (float& k : rndtab)
-    {
-        k = rnd();
-    }
-
-    // factor to build derivatives correctly
-    const double deriv_fac = wavetile_length_rcp * wave_resolution;
-    const double lambda =
-        1.0; // lambda has already been multiplied with x/y displacements...
-    const double decay          = 4.0 / wave_phases;
-    const double decay_rnd      = 0.25 / wave_phases;
-    const double foam_spawn_fac = 0.25; // 0.125;
     for (unsigned k = 0; k < wave_phases * 2; ++k)
     {
-        const vector<vector3f>& wd =
-            wavetile_data[k % wave_phases].mipmaps[0].wavedata;
-        // compute for each sample how much foam is added (spawned)
-        for (unsigned y = 0; y < wave_resolution; ++y)
-        {
-            unsigned ym1 = (y + wave_resolution - 1) & (wave_resolution - 1);
-            unsigned yp1 = (y + 1) & (wave_resolution - 1);
-            for (unsigned x = 0; x < wave_resolution; ++x)
-            {
-                unsigned xm1 =
-                    (x + wave_resolution - 1) & (wave_resolution - 1);
-                unsigned xp1    = (x + 1) & (wave_resolution - 1);
-                double dispx_dx = (wd[y * wave_resolution + xp1].x
-                                   - wd[y * wave_resolution + xm1].x)
-                                  * deriv_fac;
-                double dispx_dy = (wd[yp1 * wave_resolution + x].x
-                                   - wd[ym1 * wave_resolution + x].x)
-                                  * deriv_fac;
-                double dispy_dx = (wd[y * wave_resolution + xp1].y
-                                   - wd[y * wave_resolution + xm1].y)
-                                  * deriv_fac;
-                double dispy_dy = (wd[yp1 * wave_resolution + x].y
-                                   - wd[ym1 * wave_resolution + x].y)
-                                  * deriv_fac;
-                double Jxx = 1.0 + lambda * dispx_dx;
-                double Jyy = 1.0 + lambda * dispy_dy;
-                double Jxy = lambda * dispy_dx;
-                double Jyx = lambda * dispx_dy;
-                double J   = Jxx * Jyy - Jxy * Jyx;
-                // printf("x,y=%u,%u, Jxx,yy=%f,%f Jxy,yx=%f,%f J=%f\n",
-                //       x,y, Jxx,Jyy, Jxy,Jyx, J);
-                // double foam_add = (J < 0.3) ? ((J < -1.0) ? 1.0 : (J -
-                // 0.3)/-1.3) : 0.0;
-                double foam_add = (J < 0.0) ? ((J < -1.0) ? 1.0 : -J) : 0.0;
-                aof[y * wave_resolution + x] += foam_add * foam_spawn_fac;
-                // spawn foam also on neighbouring fields
-                aof[ym1 * wave_resolution + x] +=
-                    foam_add * foam_spawn_fac * 0.5;
-                aof[yp1 * wave_resolution + x] +=
-                    foam_add * foam_spawn_fac * 0.5;
-                aof[y * wave_resolution + xm1] +=
-                    foam_add * foam_spawn_fac * 0.5;
-                aof[y * wave_resolution + xp1] +=
-                    foam_add * foam_spawn_fac * 0.5;
-            }
-        }
-
-        // compute decay, depends on time with some randomness
-        unsigned ptr = 0;
-        for (unsigned y = 0; y < wave_resolution; ++y)
-        {
-            for (unsigned x = 0; x < wave_resolution; ++x)
-            {
-                aof[ptr] = std::max(
-                    std::min(aof[ptr], 1.0f)
-                        - (decay + decay_rnd * rndtab[(3 * x + 5 * y) % 37]),
-                    0.0);
-                ++ptr;
-            }
-        }
+        add_amount_of_foam(
+            aof, wavetile_data[k % wave_phases].mipmaps[0].wavedata, 1.0);
 
         // store amount of foam data when in second iteration
         if (k >= wave_phases)
         {
-            wavetile_phase::mipmap_level& mm0 =
-                wavetile_data[k - wave_phases].mipmaps[0];
-            mm0.amount_of_foam = aof;
-            for (unsigned j = 1;
-                 j < wavetile_data[k - wave_phases].mipmaps.size();
-                 ++j)
-            {
-                unsigned res = wave_resolution >> j;
-                const wavetile_phase::mipmap_level& mm1 =
-                    wavetile_data[k - wave_phases].mipmaps[j - 1];
-                wavetile_phase::mipmap_level& mm2 =
-                    wavetile_data[k - wave_phases].mipmaps[j];
-                mm2.amount_of_foam.reserve(res * res);
-                unsigned ptr = 0;
-                for (unsigned y = 0; y < res; ++y)
-                {
-                    for (unsigned x = 0; x < res; ++x)
-                    {
-                        float sum = mm1.amount_of_foam[ptr]
-                                    + mm1.amount_of_foam[ptr + 1]
-                                    + mm1.amount_of_foam[ptr + 2 * res]
-                                    + mm1.amount_of_foam[ptr + 1 + 2 * res];
-                        // fixme: maybe let foam vanish on upper mipmap levels
-                        mm2.amount_of_foam.push_back(sum * 0.25f);
-                        ptr += 2;
-                    }
-                    ptr += 2 * res;
-                }
-            }
+            store_amount_of_foam(aof, wavetile_data[k - wave_phases]);
         }
 
 #if 0
@@ -1470,6 +1488,106 @@ void water::compute_amount_of_foam()
     }
 }
 
+void water::add_amount_of_foam(
+    vector<float>& aof,
+    const vector<vector3f>& wd,
+    double steps) const
+{
+    aof.resize(wave_resolution * wave_resolution);
+
+    // factor to build derivatives correctly
+    const double deriv_fac = wavetile_length_rcp * wave_resolution;
+    const double lambda =
+        1.0; // lambda has already been multiplied with x/y displacements...
+    const double decay          = 4.0 / wave_phases * steps;
+    const double decay_rnd      = 0.25 / wave_phases * steps;
+    const double foam_spawn_fac = 0.25 * steps; // 0.125;
+    // compute for each sample how much foam is added (spawned)
+    for (unsigned y = 0; y < wave_resolution; ++y)
+    {
+        unsigned ym1 = (y + wave_resolution - 1) & (wave_resolution - 1);
+        unsigned yp1 = (y + 1) & (wave_resolution - 1);
+        for (unsigned x = 0; x < wave_resolution; ++x)
+        {
+            unsigned xm1    = (x + wave_resolution - 1) & (wave_resolution - 1);
+            unsigned xp1    = (x + 1) & (wave_resolution - 1);
+            double dispx_dx = (wd[y * wave_resolution + xp1].x
+                               - wd[y * wave_resolution + xm1].x)
+                              * deriv_fac;
+            double dispx_dy = (wd[yp1 * wave_resolution + x].x
+                               - wd[ym1 * wave_resolution + x].x)
+                              * deriv_fac;
+            double dispy_dx = (wd[y * wave_resolution + xp1].y
+                               - wd[y * wave_resolution + xm1].y)
+                              * deriv_fac;
+            double dispy_dy = (wd[yp1 * wave_resolution + x].y
+                               - wd[ym1 * wave_resolution + x].y)
+                              * deriv_fac;
+            double Jxx = 1.0 + lambda * dispx_dx;
+            double Jyy = 1.0 + lambda * dispy_dy;
+            double Jxy = lambda * dispy_dx;
+            double Jyx = lambda * dispx_dy;
+            double J   = Jxx * Jyy - Jxy * Jyx;
+            // printf("x,y=%u,%u, Jxx,yy=%f,%f Jxy,yx=%f,%f J=%f\n",
+            //       x,y, Jxx,Jyy, Jxy,Jyx, J);
+            // double foam_add = (J < 0.3) ? ((J < -1.0) ? 1.0 : (J -
+            // 0.3)/-1.3) : 0.0;
+            double foam_add = (J < 0.0) ? ((J < -1.0) ? 1.0 : -J) : 0.0;
+            aof[y * wave_resolution + x] += foam_add * foam_spawn_fac;
+            // spawn foam also on neighbouring fields
+            aof[ym1 * wave_resolution + x] += foam_add * foam_spawn_fac * 0.5;
+            aof[yp1 * wave_resolution + x] += foam_add * foam_spawn_fac * 0.5;
+            aof[y * wave_resolution + xm1] += foam_add * foam_spawn_fac * 0.5;
+            aof[y * wave_resolution + xp1] += foam_add * foam_spawn_fac * 0.5;
+        }
+    }
+
+    // compute decay, depends on time with some randomness
+    unsigned ptr = 0;
+    for (unsigned y = 0; y < wave_resolution; ++y)
+    {
+        for (unsigned x = 0; x < wave_resolution; ++x)
+        {
+            aof[ptr] = std::max(
+                std::min(aof[ptr], 1.0f)
+                    - (decay + decay_rnd * foam_rndtab[(3 * x + 5 * y) % 37]),
+                0.0);
+            ++ptr;
+        }
+    }
+}
+
+void water::store_amount_of_foam(
+    const vector<float>& aof,
+    wavetile_phase& wtp) const
+{
+    wavetile_phase::mipmap_level& mm0 = wtp.mipmaps[0];
+    mm0.amount_of_foam                = aof;
+    for (unsigned j = 1; j < wtp.mipmaps.size(); ++j)
+    {
+        unsigned res                            = wave_resolution >> j;
+        const wavetile_phase::mipmap_level& mm1 = wtp.mipmaps[j - 1];
+        wavetile_phase::mipmap_level& mm2       = wtp.mipmaps[j];
+        mm2.amount_of_foam.clear();
+        mm2.amount_of_foam.reserve(res * res);
+        unsigned ptr = 0;
+        for (unsigned y = 0; y < res; ++y)
+        {
+            for (unsigned x = 0; x < res; ++x)
+            {
+                float sum = mm1.amount_of_foam[ptr]
+                            + mm1.amount_of_foam[ptr + 1]
+                            + mm1.amount_of_foam[ptr + 2 * res]
+                            + mm1.amount_of_foam[ptr + 1 + 2 * res];
+                // fixme: maybe let foam vanish on upper mipmap levels
+                mm2.amount_of_foam.push_back(sum * 0.25f);
+                ptr += 2;
+            }
+            ptr += 2 * res;
+        }
+    }
+}
+
 void water::generate_subdetail_texture()
 {
     // update texture with glTexSubImage2D, that is faster than to re-create the
@@ -1508,6 +1626,40 @@ void water::set_time(double tm)
     // water or noisemaps
     mytime = tm;
 
+    if (runtime_synthesis)
+    {
+        // show the phase computed during the last frame and request the
+        // phase for the next frame. If it is not ready yet, keep the current
+        // one instead of waiting.
+        bool new_phase = false;
+        {
+            std::unique_lock<std::mutex> ml(synth_mutex);
+            if (synth_ready)
+            {
+                curr_wtp    = &wavetile_data[synth_phase];
+                synth_phase = 1 - synth_phase;
+                synth_ready = false;
+                new_phase   = true;
+            }
+            // while the game is paused the phase doesn't change
+            if (!synth_requested && !synth_ready
+                && (tm != last_time || synth_wind_changed))
+            {
+                synth_time         = tm + std::max(tm - last_time, 0.0);
+                synth_requested    = true;
+                synth_wind_changed = false;
+                synth_cond.notify_one();
+            }
+            last_time = tm;
+        }
+        if (new_phase)
+        {
+            rerender_new_wtp = true;
+            generate_subdetail_texture();
+        }
+        return;
+    }
+
     unsigned pn =
         unsigned(wave_phases * myfrac(tm / wave_tidecycle_time)) % wave_phases;
     if (curr_wtp == &wavetile_data[pn])
@@ -1522,6 +1674,21 @@ void water::set_time(double tm)
     }
 }
 
+void water::set_wind(const vector2f& direction, float speed)
+{
+    if (!runtime_synthesis)
+    {
+        return; // precomputed phases can't change
+    }
+    std::unique_lock<std::mutex> ml(synth_mutex);
+    if (direction != wind_direction || speed != wind_speed)
+    {
+        wind_direction     = direction;
+        wind_speed         = speed;
+        synth_wind_changed = true;
+    }
+}
+
 auto water::exact_fresnel(float x) -> float
 {
     // the real formula (recheck it!)
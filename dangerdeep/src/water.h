@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "angle.h"
 #include "color.h"
 #include "framebufferobject.h"
+#include "memory_usage.h"
 #include "ocean_wave_generator.h"
 #include "shader.h"
 #include "ship.h"
@@ -38,7 +39,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "vector3.h"
 #include "vertexbufferobject.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 ///\brief Rendering of ocean water surfaces.
@@ -52,6 +55,8 @@ class water
     const float wavetile_length_rcp;  // reciprocal of former value
     const double wave_tidecycle_time; // depends on fps. with 25fps and 256
                                       // phases, use ~10seconds.
+    /// compute wave phases while running instead of precomputing them
+    const bool runtime_synthesis;
 
     std::unique_ptr<texture> reflectiontex;
     std::unique_ptr<texture> foamtex;
@@ -120,10 +125,14 @@ class water
         float minh{0}, maxh{0};
 
         wavetile_phase() = default;
+
+        /// get memory used by all mipmap levels in bytes
+        [[nodiscard]] std::size_t get_memory_used() const;
     };
 
-    // wave tile data
+    // wave tile data, all phases or two for runtime synthesis
     std::vector<wavetile_phase> wavetile_data;
+    memory_usage::account phase_memory{memory_usage::water};
     const wavetile_phase* curr_wtp{nullptr}; // pointer to current phase
 
     // test
@@ -179,6 +188,17 @@ class water
     vector3f get_wave_normal_at(unsigned x, unsigned y) const;
 
     void compute_amount_of_foam();
+    /// add foam spawned by phase to aof and let it decay, steps is the time
+    /// since the last phase in units of precomputed phases
+    void add_amount_of_foam(
+        std::vector<float>& aof,
+        const std::vector<vector3f>& wd,
+        double steps) const;
+    /// store amount of foam in all mipmap levels of phase
+    void store_amount_of_foam(
+        const std::vector<float>& aof,
+        wavetile_phase& wtp) const;
+    float foam_rndtab[37];
     void generate_wavetile(
         ocean_wave_generator<float>& myowg,
         double tiletime,
@@ -224,37 +244,61 @@ class water
     std::vector<std::unique_ptr<geoclipmap_patch>> patches;
     mutable vertexbufferobject vertices;
 
-    class worker : public ::thread
+    void generate_wavetiles(
+        ocean_wave_generator<float>& myowg,
+        unsigned first_phase,
+        unsigned last_phase);
+
+    // --------------- runtime synthesis
+    /// computes the next wave phase while the current one is displayed
+    class synthesizer : public ::thread
     {
         water& wa;
         ocean_wave_generator<float> owg;
-        unsigned ps, pa;
+        std::vector<float> foam; ///< amount of foam, carried over phases
+        double foam_time{-1.0};  ///< time of last phase added to foam
+        vector2f wind_direction;
+        float wind_speed{0};
 
       public:
-        worker(water& w, unsigned s, unsigned a) :
-            thread("waterwrk"), wa(w), owg(w.owg), ps(s), pa(a)
-        {
-        }
-        void loop() override
-        {
-            wa.construction_threaded(owg, ps, pa);
-            request_abort();
-        }
+        synthesizer(water& w);
+        void loop() override;
+        void request_abort() override;
+        /// compute phase for time directly
+        void generate(double tm, wavetile_phase& wtp);
     };
-
-    void construction_threaded(
-        ocean_wave_generator<float>& myowg,
-        unsigned phase_start,
-        unsigned phase_add);
+    /// time that waves are cyclic with, long enough to be not noticed
+    static constexpr double runtime_cycle_time = 600.0;
+    vector2f wind_direction{1, 1};
+    float wind_speed{12};
+    // synthesis state, guarded by synth_mutex
+    std::mutex synth_mutex;
+    std::condition_variable synth_cond;
+    double synth_time{0};           ///< time of phase that is requested
+    bool synth_requested{false};    ///< true while phase is being computed
+    bool synth_ready{false};        ///< true when computed phase can be shown
+    bool synth_wind_changed{false}; ///< since last request
+    unsigned synth_phase{1};        ///< index of phase that the thread writes
+    double last_time{0};            ///< time of last set_time call
+    // must be destroyed before the data it works on
+    ::thread::ptr<synthesizer> synth;
 
   public:
     water(double tm = 0.0); // give day time in seconds
+    ~water();
+
+    /// compute waves while running instead of precomputing wave_phases
+    /// phases. Needs memory of two phases only and wind can change.
+    static bool use_runtime_synthesis;
 
     /// MUST be called after construction of water and before using it!
     void finish_construction();
 
     void set_time(double tm);
 
+    /// change wind direction and speed (m/s), only with runtime synthesis
+    void set_wind(const vector2f& direction, float speed);
+
     void draw_foam_for_ship(
         const game& gm,
         const ship* shp,
@@ -136,7 +136,7 @@ void water_splash::display() const
     }
 }
 
-void water_splash::display_mirror_clip() const
+void water_splash::display_mirror_clip(unsigned /*lod_level*/) const
 {
     display();
 }
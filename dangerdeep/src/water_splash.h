@@ -58,7 +58,7 @@ class water_splash : public sea_object
         double riseheight = 25.0);
     void simulate(double delta_time, game& gm) override;
     void display() const;
-    void display_mirror_clip() const override;
+    void display_mirror_clip(unsigned lod_level = 0) const override;
     void
     compute_force_and_torque(vector3& F, vector3& T, game& gm) const override
     {
@@ -961,6 +961,7 @@ auto widget::run(
             break;
         }
 
+        w.on_idle();
         if (w.redrawme)
         {
             glClear(GL_COLOR_BUFFER_BIT);
@@ -290,6 +290,8 @@ class widget
     on_drag(vector2i position, vector2i motion, mouse_button_state btnstate)
     {
     }
+    // called once per frame while run() runs this widget
+    virtual void on_idle() { }
 
     // run() always returns 1    - fixme: make own widget classes for them?
     static std::unique_ptr<widget> create_dialogue_ok(
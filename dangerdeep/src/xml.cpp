@@ -23,8 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "xml.h"
 
 #include "tinyxml/tinyxml.h"
+#include "xml_reader.h"
 
+#include <atomic>
+#include <charconv>
 #include <cstdio>
+#include <cstdlib>
 
 #ifdef WIN32
 #ifdef _MSC_VER
@@ -34,8 +38,78 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 using std::string;
 
+namespace
+{
+/// estimate memory used by node and its children, TinyXML has no statistics
+std::size_t estimate_memory(const TiXmlNode* node)
+{
+    std::size_t bytes = sizeof(TiXmlElement) + node->ValueStr().capacity();
+    if (const auto* e = node->ToElement())
+    {
+        for (const auto* a = e->FirstAttribute(); a; a = a->Next())
+        {
+            bytes += sizeof(TiXmlAttribute) + a->NameTStr().capacity()
+                     + a->ValueStr().capacity();
+        }
+    }
+    for (const auto* c = node->FirstChild(); c; c = c->NextSibling())
+    {
+        bytes += estimate_memory(c);
+    }
+    return bytes;
+}
+
+std::atomic<xml_doc::backend> default_backend{xml_doc::backend::tinyxml};
+
+/// skip what atoi/atof skip but from_chars does not
+std::string_view trim_number(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    if (!s.empty() && s.front() == '+')
+    {
+        s.remove_prefix(1);
+    }
+    return s;
+}
+
+/// parse like atoi, but without copying or locale
+int to_int(std::string_view s)
+{
+    s     = trim_number(s);
+    int v = 0;
+    std::from_chars(s.data(), s.data() + s.size(), v);
+    return v;
+}
+
+/// parse like atof, but without copying or locale
+double to_double(std::string_view s)
+{
+    s = trim_number(s);
+#if defined(__cpp_lib_to_chars)
+    double v = 0.0;
+    std::from_chars(s.data(), s.data() + s.size(), v);
+    return v;
+#else
+    // no floating point from_chars in this standard library
+    return std::atof(std::string(s).c_str());
+#endif
+}
+} // namespace
+
 auto xml_elem::child(const std::string& name) const -> xml_elem
 {
+    if (reader)
+    {
+        const auto n = reader->find_child(node, name);
+        if (n == 0)
+        {
+            THROW(xml_elem_error, name, doc_name());
+        }
+        return xml_elem(reader, n);
+    }
     auto* e = elem->FirstChildElement(name);
     if (!e)
     {
@@ -46,12 +120,17 @@ auto xml_elem::child(const std::string& name) const -> xml_elem
 
 auto xml_elem::has_child(const std::string& name) const -> bool
 {
+    if (reader)
+    {
+        return reader->find_child(node, name) != 0;
+    }
     auto* e = elem->FirstChildElement(name);
     return e != nullptr;
 }
 
 auto xml_elem::add_child(const std::string& name) -> xml_elem
 {
+    check_writable();
     auto* e = new TiXmlElement(name);
     elem->LinkEndChild(e);
     return {e};
@@ -59,6 +138,10 @@ auto xml_elem::add_child(const std::string& name) -> xml_elem
 
 auto xml_elem::doc_name() const -> const std::string&
 {
+    if (reader)
+    {
+        return reader->get_filename();
+    }
     auto* doc = elem->GetDocument();
     // extra-Paranoia... should never happen
     if (!doc)
@@ -72,27 +155,50 @@ auto xml_elem::doc_name() const -> const std::string&
     return doc->ValueStr();
 }
 
-auto xml_elem::has_attr(const std::string& name) const -> bool
+auto xml_elem::attr_view(const std::string& name) const
+    -> std::optional<std::string_view>
 {
-    return elem->Attribute(name) != nullptr;
+    if (reader)
+    {
+        const auto* v = reader->find_attribute(node, name);
+        if (v)
+        {
+            return *v;
+        }
+        return {};
+    }
+    const auto* tmp = elem->Attribute(name);
+    if (tmp)
+    {
+        return std::string_view(*tmp);
+    }
+    return {};
 }
 
-auto xml_elem::attr(const std::string& name) const -> std::string
+void xml_elem::check_writable() const
 {
-    const auto* tmp = elem->Attribute(name);
-    if (tmp)
+    if (reader)
     {
-        return *tmp;
+        THROW(xml_error, "document was loaded read-only", doc_name());
     }
-    return std::string();
+}
+
+auto xml_elem::has_attr(const std::string& name) const -> bool
+{
+    return attr_view(name).has_value();
+}
+
+auto xml_elem::attr(const std::string& name) const -> std::string
+{
+    return std::string(attr_view(name).value_or(std::string_view()));
 }
 
 auto xml_elem::attri(const std::string& name) const -> int
 {
-    const auto* tmp = elem->Attribute(name);
+    const auto tmp = attr_view(name);
     if (tmp)
     {
-        return atoi(tmp->c_str());
+        return to_int(*tmp);
     }
     return 0;
 }
@@ -104,10 +210,10 @@ auto xml_elem::attru(const std::string& name) const -> unsigned
 
 auto xml_elem::attrf(const std::string& name) const -> double
 {
-    const auto* tmp = elem->Attribute(name);
+    const auto tmp = attr_view(name);
     if (tmp)
     {
-        return atof(tmp->c_str());
+        return to_double(*tmp);
     }
     return 0.0;
 }
@@ -144,6 +250,7 @@ auto xml_elem::attrb(const std::string& name) const -> bool
 
 void xml_elem::set_attr(const std::string& val, const std::string& name)
 {
+    check_writable();
     elem->SetAttribute(name, val);
 }
 
@@ -154,6 +261,7 @@ void xml_elem::set_attr(unsigned u, const std::string& name)
 
 void xml_elem::set_attr(int i, const std::string& name)
 {
+    check_writable();
     elem->SetAttribute(name, i);
 }
 
@@ -216,16 +324,34 @@ void xml_elem::set_attr(bool b, const std::string& name)
 
 auto xml_elem::get_name() const -> const std::string&
 {
+    if (reader)
+    {
+        return *reader->get(node).name;
+    }
     return elem->ValueStr();
 }
 
 void xml_elem::add_child_text(const std::string& txt)
 {
+    check_writable();
     elem->LinkEndChild(new TiXmlText(txt));
 }
 
 auto xml_elem::child_text() const -> const std::string&
 {
+    if (reader)
+    {
+        const auto* text = reader->get(node).text;
+        if (!text)
+        {
+            THROW(
+                xml_error,
+                std::string("child of ") + get_name()
+                    + std::string(" is no text node"),
+                doc_name());
+        }
+        return *text;
+    }
     auto* ntext = elem->FirstChild();
     if (!ntext)
     {
@@ -240,30 +366,47 @@ auto xml_elem::child_text() const -> const std::string&
 
 auto xml_elem::begin() const -> xml_elem::iterator
 {
+    if (reader)
+    {
+        return iterator(*this, reader->find_child(node), false);
+    }
     return iterator(*this, elem->FirstChildElement(), false);
 }
 
 auto xml_elem::iterator_range_samename::begin() const -> xml_elem::iterator
 {
+    if (parent.reader)
+    {
+        return iterator(
+            parent, parent.reader->find_child(parent.node, childname), true);
+    }
     return iterator(parent, parent.elem->FirstChildElement(childname), true);
 }
 
 auto xml_elem::iterator::operator*() const -> xml_elem
 {
-    if (!e)
+    if (!e && n == 0)
     {
         THROW(xml_error, "elem() on empty iterator", parent.doc_name());
     }
+    if (parent.reader)
+    {
+        return xml_elem(parent.reader, n);
+    }
     return xml_elem(e);
 }
 
 auto xml_elem::iterator::operator++() -> xml_elem::iterator&
 {
-    if (!e)
+    if (!e && n == 0)
     {
         THROW(xml_error, "next() on empty iterator", parent.doc_name());
     }
-    if (samename)
+    if (parent.reader)
+    {
+        n = parent.reader->next_sibling(n, samename);
+    }
+    else if (samename)
     {
         e = e->NextSiblingElement(e->ValueStr());
     }
@@ -281,8 +424,35 @@ xml_doc::~xml_doc()
     // needed to make unique_ptr compile
 }
 
-void xml_doc::load()
+void xml_doc::set_default_backend(backend b)
+{
+    default_backend = b;
+}
+
+auto xml_doc::get_default_backend() -> backend
+{
+    return default_backend;
+}
+
+void xml_doc::load(backend b)
 {
+    reader.reset();
+    if (b == backend::in_situ)
+    {
+        try
+        {
+            reader = std::make_unique<xml_reader>(doc->ValueStr());
+        }
+        catch (file_read_error& e)
+        {
+            THROW(
+                xml_error,
+                std::string("can't load: ") + e.what(),
+                doc->ValueStr());
+        }
+        mem.set(reader->get_memory_used());
+        return;
+    }
     if (!doc->LoadFile())
     {
         THROW(
@@ -290,10 +460,29 @@ void xml_doc::load()
             std::string("can't load: ") + doc->ErrorDesc(),
             doc->ValueStr());
     }
+    mem.set(estimate_memory(doc.get()));
+}
+
+void xml_doc::parse(const std::string& text)
+{
+    reader.reset();
+    doc->Parse(text.c_str());
+    if (doc->Error())
+    {
+        THROW(
+            xml_error,
+            std::string("can't parse: ") + doc->ErrorDesc(),
+            doc->ValueStr());
+    }
+    mem.set(estimate_memory(doc.get()));
 }
 
 void xml_doc::save()
 {
+    if (reader)
+    {
+        THROW(xml_error, "document was loaded read-only", doc->ValueStr());
+    }
     if (!doc->SaveFile())
     {
         THROW(
@@ -301,10 +490,15 @@ void xml_doc::save()
             std::string("can't save: ") + doc->ErrorDesc(),
             doc->ValueStr());
     }
+    mem.set(estimate_memory(doc.get()));
 }
 
 auto xml_doc::first_child() -> xml_elem
 {
+    if (reader)
+    {
+        return {reader.get(), reader->find_child(0)};
+    }
     auto* e = doc->FirstChildElement();
     if (!e)
     {
@@ -315,6 +509,15 @@ auto xml_doc::first_child() -> xml_elem
 
 auto xml_doc::child(const std::string& name) -> xml_elem
 {
+    if (reader)
+    {
+        const auto n = reader->find_child(0, name);
+        if (n == 0)
+        {
+            THROW(xml_elem_error, name, doc->ValueStr());
+        }
+        return {reader.get(), n};
+    }
     auto* e = doc->FirstChildElement(name);
     if (!e)
     {
@@ -325,6 +528,10 @@ auto xml_doc::child(const std::string& name) -> xml_elem
 
 auto xml_doc::add_child(const std::string& name) -> xml_elem
 {
+    if (reader)
+    {
+        THROW(xml_error, "document was loaded read-only", doc->ValueStr());
+    }
     auto* e = new TiXmlElement(name);
     doc->LinkEndChild(e);
     return {e};
@@ -24,14 +24,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "angle.h"
 #include "error.h"
+#include "memory_usage.h"
 #include "quaternion.h"
 #include "vector3.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 class TiXmlElement;
 class TiXmlDocument;
+class xml_reader;
 
 ///\brief General exception for an error while using the XML interface
 class xml_error : public error
@@ -69,11 +74,18 @@ class xml_elem
     xml_elem() = delete;
 
   protected:
-    TiXmlElement* elem;
+    TiXmlElement* elem{nullptr};
+    const xml_reader* reader{nullptr}; ///< set for documents read in situ
+    uint32_t node{0};                  ///< index of element in reader
     xml_elem(TiXmlElement* e) : elem(e) { }
+    xml_elem(const xml_reader* r, uint32_t n) : reader(r), node(n) { }
 
     friend class xml_doc;
 
+    [[nodiscard]] std::optional<std::string_view>
+    attr_view(const std::string& name) const;
+    void check_writable() const;
+
   public:
     [[nodiscard]] bool has_attr(const std::string& name = "value") const;
     [[nodiscard]] std::string attr(const std::string& name = "value") const;
@@ -156,6 +168,7 @@ class xml_elem
       protected:
         const xml_elem& parent;
         TiXmlElement* e;
+        uint32_t n;    // element index for documents read in situ
         bool samename; // iterate over any children or only over children with
                        // same name
       public:
@@ -164,13 +177,20 @@ class xml_elem
             TiXmlElement* elem_ = nullptr,
             bool samename_      = true) :
             parent(parent_),
-            e(elem_), samename(samename_)
+            e(elem_), n(0), samename(samename_)
+        {
+        }
+        iterator(const xml_elem& parent_, uint32_t n_, bool samename_) :
+            parent(parent_), e(nullptr), n(n_), samename(samename_)
         {
         }
 
         xml_elem operator*() const;
         iterator& operator++();
-        bool operator!=(const iterator& it) const { return e != it.e; }
+        bool operator!=(const iterator& it) const
+        {
+            return e != it.e || n != it.n;
+        }
     };
 
     /// Matching iterator range class. Note that the childname MUST NOT be
@@ -218,14 +238,31 @@ class xml_doc
     xml_doc(const xml_doc&) = delete;
     xml_doc& operator=(const xml_doc&) = delete;
 
+  public:
+    /// how documents are loaded
+    enum class backend
+    {
+        tinyxml, ///< DOM that can be changed and saved
+        in_situ  ///< faster and smaller, but read-only, see xml_reader
+    };
+
   protected:
     std::unique_ptr<TiXmlDocument> doc;
+    std::unique_ptr<xml_reader> reader; ///< set when loaded in situ
+    memory_usage::account mem{memory_usage::xml}; ///< estimated after I/O
 
   public:
     xml_doc(const std::string& fn);
     ~xml_doc();
 
-    void load();
+    /// set backend used by load() for all documents
+    static void set_default_backend(backend b);
+    static backend get_default_backend();
+
+    void load() { load(get_default_backend()); }
+    void load(backend b);
+    /// parse document from text instead of loading the file
+    void parse(const std::string& text);
     void save();
 
     xml_elem first_child();
@@ -0,0 +1,477 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// read-only XML parser working in situ on a mapped file
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "xml_reader.h"
+
+#include "xml.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool is_name_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+           || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.'
+           || c == ':' || (c & 0x80) != 0;
+}
+
+inline bool starts_with(const char* p, const char* end, std::string_view s)
+{
+    return std::size_t(end - p) >= s.size()
+           && std::memcmp(p, s.data(), s.size()) == 0;
+}
+
+inline const char* skip_space(const char* p, const char* end)
+{
+    while (p < end && is_space(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skip_name(const char* p, const char* end)
+{
+    while (p < end && is_name_char(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+/// find s, returns end if not found
+const char* find(const char* p, const char* end, std::string_view s)
+{
+    return std::search(p, end, s.begin(), s.end());
+}
+
+void append_utf8(std::string& out, unsigned long c)
+{
+    if (c < 0x80)
+    {
+        out += char(c);
+    }
+    else if (c < 0x800)
+    {
+        out += char(0xC0 | (c >> 6));
+        out += char(0x80 | (c & 0x3F));
+    }
+    else if (c < 0x10000)
+    {
+        out += char(0xE0 | (c >> 12));
+        out += char(0x80 | ((c >> 6) & 0x3F));
+        out += char(0x80 | (c & 0x3F));
+    }
+    else
+    {
+        out += char(0xF0 | (c >> 18));
+        out += char(0x80 | ((c >> 12) & 0x3F));
+        out += char(0x80 | ((c >> 6) & 0x3F));
+        out += char(0x80 | (c & 0x3F));
+    }
+}
+
+/// decode entity at p to out, unknown entities are kept like TinyXML does
+const char* decode_entity(const char* p, const char* end, std::string& out)
+{
+    static const std::pair<std::string_view, char> entities[] = {
+        {"&amp;", '&'},
+        {"&lt;", '<'},
+        {"&gt;", '>'},
+        {"&quot;", '"'},
+        {"&apos;", '\''}};
+    for (const auto& e : entities)
+    {
+        if (starts_with(p, end, e.first))
+        {
+            out += e.second;
+            return p + e.first.size();
+        }
+    }
+    if (starts_with(p, end, "&#"))
+    {
+        const bool hex     = starts_with(p, end, "&#x");
+        const char* digits = p + (hex ? 3 : 2);
+        const char* semi   = std::find(digits, end, ';');
+        if (semi != end && semi != digits)
+        {
+            const std::string number(digits, semi);
+            out.reserve(out.size() + 4);
+            append_utf8(
+                out, std::strtoul(number.c_str(), nullptr, hex ? 16 : 10));
+            return semi + 1;
+        }
+    }
+    out += '&';
+    return p + 1;
+}
+
+/// decode entities of attribute value
+std::string decode_value(std::string_view v)
+{
+    std::string result;
+    result.reserve(v.size());
+    const char* end = v.data() + v.size();
+    for (const char* p = v.data(); p < end;)
+    {
+        if (*p == '&')
+        {
+            p = decode_entity(p, end, result);
+        }
+        else
+        {
+            result += *p++;
+        }
+    }
+    return result;
+}
+
+/// decode text and condense white space like TinyXML, white space at begin
+/// and end is removed and any other is reduced to one space.
+std::string condense_text(const char* p, const char* end)
+{
+    std::string result;
+    bool space = false;
+    for (p = skip_space(p, end); p < end;)
+    {
+        if (is_space(*p))
+        {
+            space = true;
+            ++p;
+            continue;
+        }
+        if (space)
+        {
+            result += ' ';
+            space = false;
+        }
+        if (*p == '&')
+        {
+            p = decode_entity(p, end, result);
+        }
+        else
+        {
+            result += *p++;
+        }
+    }
+    return result;
+}
+} // namespace
+
+xml_reader::xml_reader(const std::string& filename_) :
+    filename(filename_), file(filename_)
+{
+    parse();
+}
+
+void xml_reader::parse()
+{
+    const char* p   = file.data();
+    const char* end = p + file.size();
+    if (p == end)
+    {
+        syntax_error(p, "empty file");
+    }
+    if (starts_with(p, end, "\xEF\xBB\xBF"))
+    {
+        // skip UTF-8 byte order mark
+        p += 3;
+    }
+    elements.emplace_back(); // the document
+    struct open_element
+    {
+        index elem;
+        index last_child;
+    };
+    std::vector<open_element> open{{0, 0}};
+    // set text of element if it is the first child like TinyXML does
+    auto add_text = [this, &open](std::string&& text) {
+        element& e = elements[open.back().elem];
+        if (open.size() > 1 && !e.text && open.back().last_child == 0
+            && !text.empty())
+        {
+            e.text = &strings.emplace_back(std::move(text));
+        }
+    };
+    while (true)
+    {
+        const char* text = p;
+        p = static_cast<const char*>(std::memchr(p, '<', end - p));
+        if (!p)
+        {
+            p = end;
+        }
+        if (p != text && open.size() > 1)
+        {
+            add_text(condense_text(text, p));
+        }
+        if (p == end)
+        {
+            break;
+        }
+        if (starts_with(p, end, "<!--"))
+        {
+            p = find(p + 4, end, "-->");
+            if (p == end)
+            {
+                syntax_error(text, "unterminated comment");
+            }
+            p += 3;
+        }
+        else if (starts_with(p, end, "<![CDATA["))
+        {
+            const char* data = p + 9;
+            p                = find(data, end, "]]>");
+            if (p == end)
+            {
+                syntax_error(text, "unterminated CDATA section");
+            }
+            add_text(std::string(data, p));
+            p += 3;
+        }
+        else if (starts_with(p, end, "<?"))
+        {
+            p = find(p + 2, end, "?>");
+            if (p == end)
+            {
+                syntax_error(text, "unterminated declaration");
+            }
+            p += 2;
+        }
+        else if (starts_with(p, end, "<!"))
+        {
+            // DOCTYPE, skip internal subset in brackets
+            unsigned depth = 0;
+            for (++p; p < end && (*p != '>' || depth > 0); ++p)
+            {
+                depth += (*p == '[') ? 1 : 0;
+                depth -= (*p == ']' && depth > 0) ? 1 : 0;
+            }
+            if (p == end)
+            {
+                syntax_error(text, "unterminated declaration");
+            }
+            ++p;
+        }
+        else if (starts_with(p, end, "</"))
+        {
+            const char* name = p + 2;
+            p                = skip_name(name, end);
+            if (open.size() < 2
+                || *elements[open.back().elem].name
+                       != std::string_view(name, p - name))
+            {
+                syntax_error(name, "end tag does not match start tag");
+            }
+            p = skip_space(p, end);
+            if (p == end || *p != '>')
+            {
+                syntax_error(p, "expected >");
+            }
+            ++p;
+            open.pop_back();
+        }
+        else
+        {
+            const char* name = p + 1;
+            p                = skip_name(name, end);
+            if (p == name)
+            {
+                syntax_error(name, "invalid element name");
+            }
+            const auto i = index(elements.size());
+            elements.emplace_back();
+            elements[i].name            = intern({name, std::size_t(p - name)});
+            elements[i].first_attribute = uint32_t(attributes.size());
+            open_element& parent        = open.back();
+            if (parent.last_child != 0)
+            {
+                elements[parent.last_child].next_sibling = i;
+            }
+            else
+            {
+                elements[parent.elem].first_child = i;
+            }
+            parent.last_child = i;
+            while (true)
+            {
+                p = skip_space(p, end);
+                if (p == end)
+                {
+                    syntax_error(name, "unterminated element");
+                }
+                if (*p == '>')
+                {
+                    ++p;
+                    open.push_back({i, 0});
+                    break;
+                }
+                if (starts_with(p, end, "/>"))
+                {
+                    p += 2;
+                    break;
+                }
+                const char* attr_name = p;
+                p                     = skip_name(p, end);
+                if (p == attr_name)
+                {
+                    syntax_error(p, "invalid attribute name");
+                }
+                attribute a;
+                a.name = {attr_name, std::size_t(p - attr_name)};
+                p      = skip_space(p, end);
+                if (p == end || *p != '=')
+                {
+                    syntax_error(p, "expected =");
+                }
+                p = skip_space(p + 1, end);
+                if (p == end)
+                {
+                    syntax_error(p, "expected attribute value");
+                }
+                const char* value = p;
+                if (*p == '"' || *p == '\'')
+                {
+                    const char quote = *p;
+                    p                = std::find(++value, end, quote);
+                    if (p == end)
+                    {
+                        syntax_error(value, "unterminated attribute value");
+                    }
+                    a.value = {value, std::size_t(p - value)};
+                    ++p;
+                }
+                else
+                {
+                    // TinyXML accepts values without quotes
+                    while (p < end && !is_space(*p) && *p != '/' && *p != '>')
+                    {
+                        ++p;
+                    }
+                    a.value = {value, std::size_t(p - value)};
+                }
+                if (a.value.find('&') != std::string_view::npos)
+                {
+                    a.value = store(decode_value(a.value));
+                }
+                attributes.push_back(a);
+                ++elements[i].nr_of_attributes;
+            }
+        }
+    }
+    if (open.size() > 1)
+    {
+        syntax_error(end, "unterminated element");
+    }
+    if (elements[0].first_child == 0)
+    {
+        syntax_error(end, "no root element");
+    }
+}
+
+auto xml_reader::intern(std::string_view name) -> const std::string*
+{
+    auto it = names.find(name);
+    if (it != names.end())
+    {
+        return it->second;
+    }
+    const std::string* s = &strings.emplace_back(name);
+    names.emplace(*s, s);
+    return s;
+}
+
+auto xml_reader::store(std::string&& s) -> std::string_view
+{
+    return strings.emplace_back(std::move(s));
+}
+
+void xml_reader::syntax_error(const char* pos, const char* msg) const
+{
+    const auto line = 1 + std::count(file.data(), pos, '\n');
+    THROW(
+        xml_error,
+        std::string("line ") + std::to_string(line) + ": " + msg,
+        filename);
+}
+
+auto xml_reader::find_child(index parent, std::string_view name) const -> index
+{
+    for (index i = elements[parent].first_child; i != 0;
+         i       = elements[i].next_sibling)
+    {
+        if (name.empty() || *elements[i].name == name)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+auto xml_reader::next_sibling(index i, bool samename) const -> index
+{
+    const std::string* name = elements[i].name;
+    for (index n = elements[i].next_sibling; n != 0;
+         n       = elements[n].next_sibling)
+    {
+        if (!samename || elements[n].name == name)
+        {
+            return n;
+        }
+    }
+    return 0;
+}
+
+auto xml_reader::find_attribute(index i, std::string_view name) const
+    -> const std::string_view*
+{
+    const element& e = elements[i];
+    for (uint32_t a = 0; a < e.nr_of_attributes; ++a)
+    {
+        const attribute& at = attributes[e.first_attribute + a];
+        if (at.name == name)
+        {
+            return &at.value;
+        }
+    }
+    return nullptr;
+}
+
+auto xml_reader::get_memory_used() const -> std::size_t
+{
+    std::size_t bytes = sizeof(xml_reader) + file.size()
+                        + elements.capacity() * sizeof(element)
+                        + attributes.capacity() * sizeof(attribute)
+                        + names.size() * 4 * sizeof(void*);
+    for (const auto& s : strings)
+    {
+        bytes += sizeof(std::string) + s.capacity();
+    }
+    return bytes;
+}
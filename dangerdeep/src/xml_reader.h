@@ -0,0 +1,100 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// read-only XML parser working in situ on a mapped file
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#pragma once
+
+#include "filehelper.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+///\brief Read-only XML document parsed in situ from a memory mapped file.
+/** Attribute names and values are views into the mapped file, only values
+    with entities are decoded to extra storage. Elements are stored in one
+    array and linked by indices. Element names are interned, so names can
+    be compared by pointer. Text of an element is kept like TinyXML does
+    it, with condensed white space. This is used as backend of xml_doc and
+    is not meant to be used directly.
+*/
+class xml_reader
+{
+  public:
+    /// index of an element, 0 is the document itself and means "none" in
+    /// links, as the document is never a child.
+    using index = uint32_t;
+
+    struct attribute
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    struct element
+    {
+        const std::string* name{nullptr}; ///< interned
+        const std::string* text{nullptr}; ///< first text child or none
+        index first_child{0};
+        index next_sibling{0};
+        uint32_t first_attribute{0};
+        uint32_t nr_of_attributes{0};
+    };
+
+    /// map and parse file, throws xml_error on syntax errors
+    xml_reader(const std::string& filename);
+
+    xml_reader(const xml_reader&) = delete;
+    xml_reader& operator=(const xml_reader&) = delete;
+
+    [[nodiscard]] const std::string& get_filename() const { return filename; }
+    [[nodiscard]] const element& get(index i) const { return elements[i]; }
+
+    /// find first child element, by name or any for empty name
+    [[nodiscard]] index
+    find_child(index parent, std::string_view name = {}) const;
+
+    /// find next sibling, with same name if requested
+    [[nodiscard]] index next_sibling(index i, bool samename) const;
+
+    /// get attribute value or nullptr if there is none
+    [[nodiscard]] const std::string_view*
+    find_attribute(index i, std::string_view name) const;
+
+    /// estimated memory used, including the mapped file
+    [[nodiscard]] std::size_t get_memory_used() const;
+
+  protected:
+    const std::string filename;
+    mapped_file file;
+    std::vector<element> elements;
+    std::vector<attribute> attributes;
+    std::unordered_map<std::string_view, const std::string*> names;
+    std::deque<std::string> strings; ///< interned names, decoded values, texts
+
+    void parse();
+    const std::string* intern(std::string_view name);
+    std::string_view store(std::string&& s);
+    [[noreturn]] void syntax_error(const char* pos, const char* msg) const;
+};
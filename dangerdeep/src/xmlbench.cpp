@@ -0,0 +1,213 @@
+/*
+Danger from the Deep - Open source submarine simulation
+Copyright (C) 2003-2020  Thorsten Jordan, Luis Barrancos and others.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// xml backends compared by loading all data files
+// subsim (C)+(W) Thorsten Jordan. SEE LICENSE
+
+#include "datadirs.h"
+#include "filehelper.h"
+#include "memory_usage.h"
+#include "mymain.cpp"
+#include "xml.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+const char* backend_name(xml_doc::backend b)
+{
+    return b == xml_doc::backend::tinyxml ? "TinyXML" : "in situ";
+}
+
+bool is_xml_file(const std::string& fn)
+{
+    for (const char* ext : {".xml", ".ddxml", ".data", ".dftd"})
+    {
+        const std::string e(ext);
+        if (fn.size() > e.size()
+            && fn.compare(fn.size() - e.size(), e.size(), e) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// visit all elements and read typical attributes, returns a checksum
+double traverse(const xml_elem& e)
+{
+    double sum = e.get_name().size() + e.attrv3().square_length()
+                 + e.attri("value") + e.attr("name").size();
+    for (auto c : e)
+    {
+        sum += traverse(c);
+    }
+    return sum;
+}
+
+/// compare element trees of both backends, print first difference
+bool compare(const xml_elem& a, const xml_elem& b)
+{
+    if (a.get_name() != b.get_name())
+    {
+        std::cout << "Different names " << a.get_name() << " and "
+                  << b.get_name() << " in " << a.doc_name() << "\n";
+        return false;
+    }
+    for (const char* attr : {"x", "y", "z", "value", "name", "type", "id"})
+    {
+        if (a.attr(attr) != b.attr(attr) || a.attrf(attr) != b.attrf(attr))
+        {
+            std::cout << "Different attribute " << attr << " of "
+                      << a.get_name() << " in " << a.doc_name() << "\n";
+            return false;
+        }
+    }
+    try
+    {
+        // TinyXML gives any first child here, so compare only real texts
+        if (b.child_text() != a.child_text())
+        {
+            std::cout << "Different text of " << a.get_name() << " in "
+                      << a.doc_name() << "\n";
+            return false;
+        }
+    }
+    catch (xml_error&)
+    {
+    }
+    auto ib = b.begin();
+    for (auto ca : a)
+    {
+        if (!(ib != b.end()) || !compare(ca, *ib))
+        {
+            std::cout << "Different children of " << a.get_name() << " in "
+                      << a.doc_name() << "\n";
+            return false;
+        }
+        ++ib;
+    }
+    return !(ib != b.end());
+}
+
+/// load all files with a backend, print time and memory
+void measure(
+    const std::vector<std::string>& files,
+    xml_doc::backend b,
+    unsigned nr_rounds)
+{
+    double load_time = 0, traverse_time = 0, checksum = 0;
+    std::size_t memory = 0;
+    for (unsigned r = 0; r < nr_rounds; ++r)
+    {
+        std::vector<std::unique_ptr<xml_doc>> docs;
+        auto start = clock_type::now();
+        for (const auto& fn : files)
+        {
+            docs.push_back(std::make_unique<xml_doc>(fn));
+            docs.back()->load(b);
+        }
+        load_time += seconds_since(start);
+        memory = memory_usage::get_used(memory_usage::xml);
+        start  = clock_type::now();
+        for (auto& d : docs)
+        {
+            checksum += traverse(d->first_child());
+        }
+        traverse_time += seconds_since(start);
+    }
+    std::cout << backend_name(b) << ": load " << load_time * 1000 / nr_rounds
+              << "ms, traverse " << traverse_time * 1000 / nr_rounds
+              << "ms, memory " << memory / 1024 << "KB, checksum "
+              << checksum / nr_rounds << "\n";
+}
+} // namespace
+
+int mymain(std::vector<string>& args)
+{
+    unsigned nr_rounds = 5;
+    std::vector<std::string> paths;
+    for (auto it = args.begin(); it != args.end(); ++it)
+    {
+        if (*it == "--help")
+        {
+            std::cout << "Usage: xmlbench [--rounds n] [path ...]\n"
+                      << "Loads all XML files below the paths (default: data "
+                         "directory) with both\nxml_doc backends, checks that "
+                         "they give the same elements and compares\nload "
+                         "time and memory.\n";
+            return 0;
+        }
+        if (*it == "--rounds" && it + 1 != args.end())
+        {
+            nr_rounds = std::max(1, atoi((++it)->c_str()));
+        }
+        else
+        {
+            paths.push_back(*it);
+        }
+    }
+    if (paths.empty())
+    {
+        paths.push_back(get_data_dir());
+    }
+
+    // use only files TinyXML can read, some data files are no valid XML
+    std::vector<std::string> files;
+    std::size_t bytes = 0;
+    bool ok           = true;
+    for (const auto& path : paths)
+    {
+        directory::walk(path, [&](const std::string& fn) {
+            if (!is_xml_file(fn))
+            {
+                return;
+            }
+            try
+            {
+                xml_doc a(fn), b(fn);
+                a.load(xml_doc::backend::tinyxml);
+                b.load(xml_doc::backend::in_situ);
+                ok = compare(a.first_child(), b.first_child()) && ok;
+                files.push_back(fn);
+                bytes += mapped_file(fn).size();
+            }
+            catch (std::exception& e)
+            {
+                std::cout << "Skipping " << fn << ": " << e.what() << "\n";
+            }
+        });
+    }
+    std::cout << files.size() << " files, " << bytes / 1024 << "KB, "
+              << (ok ? "same" : "DIFFERENT") << " elements\n";
+
+    measure(files, xml_doc::backend::tinyxml, nr_rounds);
+    measure(files, xml_doc::backend::in_situ, nr_rounds);
+    return ok ? 0 : -1;
+}